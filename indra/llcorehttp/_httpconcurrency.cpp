@@ -0,0 +1,231 @@
+/**
+ * @file _httpconcurrency.cpp
+ * @brief Internal definitions of the adaptive in-flight request limit
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "_httpconcurrency.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "llmath.h"
+
+
+namespace
+{
+
+// A window closes once it's at least WINDOW_MIN long and has
+// seen enough completions, or at WINDOW_MAX with any at all.
+const LLCore::HttpTime WINDOW_MIN(500000);			// 0.5 sec
+const LLCore::HttpTime WINDOW_MAX(5000000);			// 5 sec
+const int WINDOW_MIN_SAMPLES(4);
+
+// Overload response
+const double BACKOFF(0.75);
+const int BACKOFF_HOLD_WINDOWS(2);
+
+// Latency gradient.  Latency may inflate this much over the
+// long-term baseline before the limit starts coming down.
+const double LATENCY_TOLERANCE(1.5);
+const double GRADIENT_MIN(0.5);
+const double SHRINK_SMOOTHING(0.2);
+
+// Baseline follows faster windows quickly and slower ones very
+// slowly so that it stays close to the unloaded latency but can
+// still learn a slower route or server.
+const double BASE_FALL(0.5);
+const double BASE_RISE(0.01);
+
+// Growth needs the in-flight count to have reached this fraction
+// of the limit, and an increase has to buy this much throughput
+// before the next one.
+const double UTILIZATION(0.75);
+const double PLATEAU(1.05);
+
+}  // end anonymous namespace
+
+
+namespace LLCore
+{
+
+
+HttpConcurrency::HttpConcurrency()
+	: mLimit(0.0),
+	  mMinLimit(0),
+	  mMaxLimit(0),					// Not running until reset()
+	  mWindowStart(0),
+	  mSamples(0),
+	  mOverloads(0),
+	  mPeakInFlight(0),
+	  mLatencySum(0),
+	  mBytes(0),
+	  mBaseLatency(0.0),
+	  mWindowLatency(0),
+	  mThroughput(0.0),
+	  mLastGrowthThroughput(0.0),
+	  mPreGrowthLimit(0.0),
+	  mHoldWindows(0)
+{}
+
+
+void HttpConcurrency::reset(int initial, int min_limit, int max_limit)
+{
+	mMinLimit = (std::max)(1, min_limit);
+	mMaxLimit = (std::max)(mMinLimit, max_limit);
+	mLimit = llclamp(initial, mMinLimit, mMaxLimit);
+
+	mWindowStart = 0;
+	mSamples = 0;
+	mOverloads = 0;
+	mPeakInFlight = 0;
+	mLatencySum = 0;
+	mBytes = 0;
+
+	mBaseLatency = 0.0;
+	mWindowLatency = 0;
+	mThroughput = 0.0;
+	mLastGrowthThroughput = 0.0;
+	mPreGrowthLimit = mLimit;
+	mHoldWindows = 0;
+}
+
+
+void HttpConcurrency::onDispatch(int in_flight)
+{
+	mPeakInFlight = (std::max)(mPeakInFlight, in_flight);
+}
+
+
+void HttpConcurrency::onComplete(HttpTime latency, size_t bytes, bool overload)
+{
+	if (overload)
+	{
+		++mOverloads;
+	}
+	if (! latency)
+	{
+		// Connect failures and the like, no time to first byte
+		// to learn from and an average with them would look
+		// faster than the server really is.
+		return;
+	}
+	++mSamples;
+	mLatencySum += latency;
+	mBytes += bytes;
+}
+
+
+bool HttpConcurrency::update(HttpTime now)
+{
+	if (! isRunning())
+	{
+		return false;
+	}
+	if (! mWindowStart || now < mWindowStart)
+	{
+		mWindowStart = now;
+		return false;
+	}
+
+	const HttpTime elapsed(now - mWindowStart);
+	const int min_samples((std::max)(WINDOW_MIN_SAMPLES, int(mLimit) / 2));
+	if (! mSamples && ! mOverloads)
+	{
+		if (elapsed >= WINDOW_MAX)
+		{
+			// Idle, nothing to learn from this window
+			mWindowStart = now;
+			mPeakInFlight = 0;
+		}
+		return false;
+	}
+	if (elapsed < WINDOW_MIN || (mSamples + mOverloads < min_samples && elapsed < WINDOW_MAX))
+	{
+		return false;
+	}
+
+	mWindowLatency = mSamples ? mLatencySum / mSamples : 0;
+	mThroughput = double(mBytes) * 1.0e6 / double(elapsed);
+
+	if (mOverloads)
+	{
+		// Server or network is pushing back.  Cut hard and give
+		// it time to drain before probing upward again.
+		mLimit *= BACKOFF;
+		mHoldWindows = BACKOFF_HOLD_WINDOWS;
+		mLastGrowthThroughput = 0.0;
+	}
+	else
+	{
+		const double latency((std::max)(double(mWindowLatency), 1.0));
+		if (mBaseLatency <= 0.0)
+		{
+			mBaseLatency = latency;
+		}
+		else
+		{
+			mBaseLatency += (latency - mBaseLatency) * (latency < mBaseLatency ? BASE_FALL : BASE_RISE);
+		}
+
+		const double gradient(llclamp(mBaseLatency * LATENCY_TOLERANCE / latency, GRADIENT_MIN, 1.0));
+		const bool limited(mPeakInFlight >= mLimit * UTILIZATION);
+		bool grow(gradient >= 1.0 && limited && ! mHoldWindows);
+		if (limited && mLastGrowthThroughput > 0.0 && mThroughput < mLastGrowthThroughput * PLATEAU)
+		{
+			// Last increase didn't buy anything.  Step back, sit
+			// out a window and then probe again.
+			grow = false;
+			mLimit = (std::min)(mLimit, mPreGrowthLimit);
+			mHoldWindows = 1;
+		}
+		else if (mHoldWindows)
+		{
+			--mHoldWindows;
+		}
+		mLastGrowthThroughput = 0.0;
+
+		if (grow)
+		{
+			mLastGrowthThroughput = mThroughput;
+			mPreGrowthLimit = mLimit;
+			mLimit += std::sqrt(mLimit);
+		}
+		else if (gradient < 1.0)
+		{
+			mLimit += (mLimit * gradient - mLimit) * SHRINK_SMOOTHING;
+		}
+	}
+	mLimit = llclamp(mLimit, double(mMinLimit), double(mMaxLimit));
+
+	mWindowStart = now;
+	mSamples = 0;
+	mOverloads = 0;
+	mPeakInFlight = 0;
+	mLatencySum = 0;
+	mBytes = 0;
+	return true;
+}
+
+
+}  // end namespace LLCore
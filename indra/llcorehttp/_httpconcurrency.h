@@ -0,0 +1,135 @@
+/**
+ * @file _httpconcurrency.h
+ * @brief Internal declaration of the adaptive in-flight request limit
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef	_LLCORE_HTTP_CONCURRENCY_H_
+#define	_LLCORE_HTTP_CONCURRENCY_H_
+
+
+#include "httpcommon.h"
+
+
+namespace LLCore
+{
+
+
+/// Picks how many requests a policy class may have in flight from
+/// what completed requests report back.  Works in windows of a
+/// few hundred milliseconds:
+/// - Any 503, 429 or timeout in a window cuts the limit
+///   multiplicatively and holds off growth for a while.
+/// - Otherwise the limit follows a latency gradient, the ratio
+///   of long-term time-to-first-byte to the current window's.
+///   While servers answer as fast as they used to, the limit
+///   grows by about its square root per window.  As queues build
+///   and latency rises, the gradient pulls it back down.
+/// - Growth needs evidence the limit is what's holding us back
+///   (in-flight count near the limit) and pauses if the last
+///   increase bought no extra throughput.
+///
+/// Threading:  called by worker thread only.
+class HttpConcurrency
+{
+public:
+	HttpConcurrency();
+
+	/// Start (or restart) the controller at 'initial', to stay
+	/// within ['min_limit', 'max_limit'].  Forgets all history.
+	void reset(int initial, int min_limit, int max_limit);
+
+	bool isRunning() const
+		{
+			return mMaxLimit > 0;
+		}
+
+	int getLimit() const
+		{
+			return int(mLimit);
+		}
+
+	int getMaxLimit() const
+		{
+			return mMaxLimit;
+		}
+
+	/// Note the current in-flight count after dispatching.
+	void onDispatch(int in_flight);
+
+	/// Note one finished request attempt.  Attempts that failed
+	/// before any reply arrived carry no latency and only count
+	/// toward the window if they were overloads.
+	///
+	/// @param latency		Time to first byte of the reply, 0 if none.
+	/// @param bytes		Size of the reply body.
+	/// @param overload		Server pushed back (503, 429) or the
+	///						request timed out.
+	void onComplete(HttpTime latency, size_t bytes, bool overload);
+
+	/// Close the current window if it's due and adjust the limit.
+	///
+	/// @return			true if a window closed.
+	bool update(HttpTime now);
+
+	/// Results of the last closed window
+	HttpTime getWindowLatency() const
+		{
+			return mWindowLatency;
+		}
+
+	HttpTime getBaseLatency() const
+		{
+			return HttpTime(mBaseLatency);
+		}
+
+	double getThroughput() const
+		{
+			return mThroughput;
+		}
+
+protected:
+	double					mLimit;
+	int						mMinLimit;
+	int						mMaxLimit;
+
+	// Current window
+	HttpTime				mWindowStart;
+	int						mSamples;			// Completions with a latency
+	int						mOverloads;
+	int						mPeakInFlight;
+	HttpTime				mLatencySum;
+	size_t					mBytes;
+
+	// History
+	double					mBaseLatency;		// Long-term time to first byte, mcs
+	HttpTime				mWindowLatency;
+	double					mThroughput;		// Bytes/second in last window
+	double					mLastGrowthThroughput;	// Throughput before the last increase
+	double					mPreGrowthLimit;
+	int						mHoldWindows;
+};  // end class HttpConcurrency
+
+}  // end namespace LLCore
+
+#endif	// _LLCORE_HTTP_CONCURRENCY_H_
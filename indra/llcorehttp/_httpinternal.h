@@ -153,8 +153,19 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 concurrent streams per connection
+const long HTTP_HTTP2_STREAMS_DEFAULT = 0L;
+const long HTTP_HTTP2_STREAMS_MAX = 100L;
+
+// Adaptive in-flight limits
+const long HTTP_ADAPTIVE_CONCURRENCY_DEFAULT = 0L;
+const long HTTP_ADAPTIVE_CONCURRENCY_MIN = 2L;
+const long HTTP_ADAPTIVE_CONCURRENCY_MAX = 1024L;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
+const long HTTP_COALESCE_REQUESTS_DEFAULT = 0L;
+const long HTTP_SHARE_CONNECTIONS_DEFAULT = 0L;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
 
 // Tuning parameters
@@ -166,6 +177,11 @@ const int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
+// Largest response body given a single contiguous reservation
+// when its length is known in advance.  Anything larger is
+// gathered in ordinary blocks.
+const size_t HTTP_REPLY_BODY_RESERVE_MAX = 16 * 1024 * 1024;
+
 }  // end namespace LLCore
 
 #endif	// _LLCORE_HTTP_INTERNAL_H_
@@ -26,12 +26,22 @@
 
 #include "_httplibcurl.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+
+#if ! LL_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "httpheaders.h"
 #include "bufferarray.h"
 #include "_httpoprequest.h"
 #include "_httppolicy.h"
 
 #include "llhttpconstants.h"
+#include "llfile.h"
 
 namespace
 {
@@ -40,6 +50,10 @@ namespace
 void check_curl_multi_code(CURLMcode code);
 void check_curl_multi_code(CURLMcode code, int curl_setopt_option);
 
+// Connection cap for a class carrying 'depth' requests per connection,
+// with room for its adaptive in-flight ceiling if it has one
+long max_total_connections(const LLCore::HttpPolicyClass & options, long depth);
+
 // This is a template because different 'option' values require different
 // types for 'ARG'. Just pass them through unchanged (by value).
 template <typename ARG>
@@ -51,6 +65,10 @@ void check_curl_multi_setopt(CURLM* handle, CURLMoption option, ARG argument)
 
 static const char * const LOG_CORE("CoreHttp");
 
+// Guards against reading a damaged TLS session file
+const U32 TLS_SESSION_FILE_VERSION(1);
+const U32 TLS_SESSION_FIELD_MAX(64 * 1024);
+
 } // end anonymous namespace
 
 
@@ -64,7 +82,9 @@ HttpLibcurl::HttpLibcurl(HttpService * service)
 	  mPolicyCount(0),
 	  mMultiHandles(NULL),
 	  mActiveHandles(NULL),
-	  mDirtyPolicy(NULL)
+	  mDirtyPolicy(NULL),
+	  mHttp2State(NULL),
+	  mShareHandle(NULL)
 {}
 
 
@@ -72,6 +92,15 @@ HttpLibcurl::~HttpLibcurl()
 {
 	shutdown();
 
+	// Every easy handle ever attached to the share has to be gone
+	// before the share can be released.
+	mHandleCache.clear();
+	if (mShareHandle)
+	{
+		curl_share_cleanup(mShareHandle);
+		mShareHandle = NULL;
+	}
+
 	mService = NULL;
 }
 
@@ -88,6 +117,8 @@ void HttpLibcurl::shutdown()
 
 	if (mMultiHandles)
 	{
+		saveTlsSessions();
+
 		for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
 		{
 			if (mMultiHandles[policy_class])
@@ -105,6 +136,9 @@ void HttpLibcurl::shutdown()
 
 		delete [] mDirtyPolicy;
 		mDirtyPolicy = NULL;
+
+		delete [] mHttp2State;
+		mHttp2State = NULL;
 	}
 
 	mPolicyCount = 0;
@@ -120,9 +154,24 @@ void HttpLibcurl::start(int policy_count)
 	mMultiHandles = new CURLM * [mPolicyCount];
 	mActiveHandles = new int [mPolicyCount];
 	mDirtyPolicy = new bool [mPolicyCount];
+	mHttp2State = new EHttp2State [mPolicyCount];
+
+#if LLCORE_HTTP2_MULTIPLEXING
+	const curl_version_info_data * curl_info(curl_version_info(CURLVERSION_NOW));
+	const bool have_http2(curl_info && (curl_info->features & CURL_VERSION_HTTP2));
+#else
+	const bool have_http2(false);
+#endif
+	if (! have_http2)
+	{
+		LL_INFOS(LOG_CORE) << "libcurl has no HTTP/2 support, HTTP/2 multiplexing disabled." << LL_ENDL;
+	}
+
+	startShare();
 	
 	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
 	{
+		mHttp2State[policy_class] = have_http2 ? HTTP2_UNKNOWN : HTTP2_UNAVAILABLE;
 		if (NULL == (mMultiHandles[policy_class] = curl_multi_init()))
 		{
 			LL_ERRS(LOG_CORE) << "Failed to allocate multi handle in libcurl."
@@ -399,6 +448,35 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
         }
 	}
 
+#if LLCORE_HTTP2_MULTIPLEXING
+	// First answer on a class asking for HTTP/2 settles whether the
+	// server speaks it.  If not, reconfigure the class as if HTTP/2
+	// had never been asked for.
+	if (op->mStatus && HTTP2_UNKNOWN == mHttp2State[op->mReqPolicy])
+	{
+		HttpPolicyClass & options(mService->getPolicy().getClassOptions(op->mReqPolicy));
+		long http_version(CURL_HTTP_VERSION_NONE);
+
+		if (options.mHttp2Streams > 1
+			&& CURLE_OK == curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http_version))
+		{
+			if (CURL_HTTP_VERSION_2_0 == http_version)
+			{
+				mHttp2State[op->mReqPolicy] = HTTP2_ACTIVE;
+				LL_INFOS(LOG_CORE) << "HTTP/2 multiplexing active for policy class "
+								   << op->mReqPolicy << LL_ENDL;
+			}
+			else
+			{
+				mHttp2State[op->mReqPolicy] = HTTP2_UNAVAILABLE;
+				LL_INFOS(LOG_CORE) << "Server answered without HTTP/2, policy class "
+								   << op->mReqPolicy << " falling back to HTTP/1.1" << LL_ENDL;
+				policyUpdated(op->mReqPolicy);
+			}
+		}
+	}
+#endif	// LLCORE_HTTP2_MULTIPLEXING
+
 	// <FS:ND> See if the requested URL matches a X-LL-URL header (if present) and the requested range.
 	// If not, we assume http pipelining havng gone out of sync. If yes, yield a 503 status and switch
 	// pipelining off.
@@ -453,6 +531,16 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
 	}
 	// /</FS:ND>
 
+	// Time to first byte for the adaptive concurrency limit.  Includes
+	// any wait for a connection inside libcurl, which is a symptom
+	// of too many requests in flight just like server queueing is.
+	double first_byte(0.0);
+	op->mReplyLatency = 0;
+	if (handle && CURLE_OK == curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &first_byte) && first_byte > 0.0)
+	{
+		op->mReplyLatency = HttpTime(first_byte * 1.0E6);
+	}
+
     if (multi_handle && handle)
     {
         // Detach from multi and recycle handle
@@ -497,6 +585,14 @@ int HttpLibcurl::getActiveCountInClass(int policy_class) const
 	return mActiveHandles ? mActiveHandles[policy_class] : 0;
 }
 
+
+HttpLibcurl::EHttp2State HttpLibcurl::getHttp2StateInClass(int policy_class) const
+{
+	llassert_always(policy_class < mPolicyCount);
+
+	return mHttp2State ? mHttp2State[policy_class] : HTTP2_UNAVAILABLE;
+}
+
 void HttpLibcurl::policyUpdated(int policy_class)
 {
 	if (policy_class < 0 || policy_class >= mPolicyCount || ! mMultiHandles)
@@ -530,6 +626,30 @@ void HttpLibcurl::policyUpdated(int policy_class)
 		policy.stallPolicy(policy_class, false);
 		mDirtyPolicy[policy_class] = false;
 
+#if LLCORE_HTTP2_MULTIPLEXING
+		if (options.mHttp2Streams > 1 && HTTP2_UNAVAILABLE != mHttp2State[policy_class])
+		{
+			// Multiplex streams over HTTP/2 connections.  HTTP/1.1
+			// connections are never pipelined in this mode so the
+			// pipelining depth is ignored.  Per-host limit bounds
+			// connections until we know the server speaks HTTP/2.
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_PIPELINING,
+									 long(CURLPIPE_MULTIPLEX));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_HOST_CONNECTIONS,
+									 long(options.mPerHostConnectionLimit));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+									 max_total_connections(options, options.mHttp2Streams));
+#if LIBCURL_VERSION_NUM >= 0x074300
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_CONCURRENT_STREAMS,
+									 long(options.mHttp2Streams));
+#endif
+		}
+		else
+#endif	// LLCORE_HTTP2_MULTIPLEXING
 		if (options.mPipelining > 1)
 		{
 			// We'll try to do pipelining on this multihandle
@@ -544,7 +664,7 @@ void HttpLibcurl::policyUpdated(int policy_class)
 									 long(options.mPerHostConnectionLimit));
 			check_curl_multi_setopt(multi_handle,
 									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
-									 long(options.mConnectionLimit));
+									 max_total_connections(options, options.mPipelining));
 		}
 		else
 		{
@@ -556,7 +676,7 @@ void HttpLibcurl::policyUpdated(int policy_class)
 									 0L);
 			check_curl_multi_setopt(multi_handle,
 									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
-									 long(options.mConnectionLimit));
+									 max_total_connections(options, 1L));
 		}
 	}
 	else if (! mDirtyPolicy[policy_class])
@@ -571,6 +691,231 @@ void HttpLibcurl::policyUpdated(int policy_class)
 	}
 }
 
+void HttpLibcurl::startShare()
+{
+	if (mShareHandle)
+	{
+		// Restarted, keep what we've learned
+		return;
+	}
+	if (NULL == (mShareHandle = curl_share_init()))
+	{
+		LL_WARNS(LOG_CORE) << "Failed to allocate share handle in libcurl.  "
+						   << "Policy classes will resolve and handshake separately."
+						   << LL_ENDL;
+		return;
+	}
+
+	HttpPolicyGlobal & gpolicy(mService->getPolicy().getGlobalOptions());
+
+	curl_share_setopt(mShareHandle, CURLSHOPT_LOCKFUNC, shareLock);
+	curl_share_setopt(mShareHandle, CURLSHOPT_UNLOCKFUNC, shareUnlock);
+	curl_share_setopt(mShareHandle, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(mShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(mShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	if (gpolicy.mShareConnections)
+	{
+#if LLCORE_HTTP_SHARE_CONNECTIONS
+		curl_share_setopt(mShareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#else
+		LL_INFOS(LOG_CORE) << "libcurl too old to share connections between policy classes."
+						   << LL_ENDL;
+#endif
+	}
+
+	loadTlsSessions();
+}
+
+
+// Session file is a version word followed by records of
+// length-prefixed key, HMAC and session data as libcurl
+// exported them.
+void HttpLibcurl::loadTlsSessions()
+{
+	HttpPolicyGlobal & gpolicy(mService->getPolicy().getGlobalOptions());
+	if (gpolicy.mTlsSessionFile.empty() || ! mShareHandle)
+	{
+		return;
+	}
+#if LLCORE_HTTP_TLS_SESSION_EXPORT
+	llifstream file(gpolicy.mTlsSessionFile.c_str(), std::ios::in | std::ios::binary);
+	if (! file.is_open())
+	{
+		return;
+	}
+	U32 version(0);
+	file.read(reinterpret_cast<char *>(&version), sizeof(version));
+	if (! file || TLS_SESSION_FILE_VERSION != version)
+	{
+		return;
+	}
+
+	CURL * handle(mHandleCache.getHandle());
+	if (! handle)
+	{
+		return;
+	}
+	curl_easy_setopt(handle, CURLOPT_SHARE, mShareHandle);
+
+	int count(0);
+	std::string fields[3];
+	while (file)
+	{
+		int i(0);
+		for (; i < 3; ++i)
+		{
+			U32 len(0);
+			if (! file.read(reinterpret_cast<char *>(&len), sizeof(len)) || len > TLS_SESSION_FIELD_MAX)
+			{
+				break;
+			}
+			fields[i].resize(len);
+			if (len && ! file.read(&fields[i][0], len))
+			{
+				break;
+			}
+		}
+		if (i < 3)
+		{
+			break;
+		}
+		CURLcode code(curl_easy_ssls_import(handle,
+											fields[0].empty() ? NULL : fields[0].c_str(),
+											reinterpret_cast<const unsigned char *>(fields[1].data()),
+											fields[1].size(),
+											reinterpret_cast<const unsigned char *>(fields[2].data()),
+											fields[2].size()));
+		if (CURLE_OK != code)
+		{
+			if (CURLE_NOT_BUILT_IN == code)
+			{
+				LL_INFOS(LOG_CORE) << "libcurl built without TLS session export, sessions not restored."
+								   << LL_ENDL;
+				break;
+			}
+			continue;
+		}
+		++count;
+	}
+	mHandleCache.freeHandle(handle);
+
+	LL_INFOS(LOG_CORE) << "Restored " << count << " TLS sessions from "
+					   << gpolicy.mTlsSessionFile << LL_ENDL;
+#else
+	LL_INFOS(LOG_CORE) << "libcurl too old to save TLS sessions, ignoring "
+					   << gpolicy.mTlsSessionFile << LL_ENDL;
+#endif
+}
+
+
+#if LLCORE_HTTP_TLS_SESSION_EXPORT
+namespace
+{
+
+struct TlsSessionWriter
+{
+	llofstream *	mFile;
+	curl_off_t		mNow;
+	int				mCount;
+};
+
+void write_field(llofstream & file, const void * data, size_t len)
+{
+	const U32 len32(len);
+	file.write(reinterpret_cast<const char *>(&len32), sizeof(len32));
+	file.write(static_cast<const char *>(data), len);
+}
+
+CURLcode write_tls_session(CURL *, void * userptr, const char * session_key,
+						   const unsigned char * shmac, size_t shmac_len,
+						   const unsigned char * sdata, size_t sdata_len,
+						   curl_off_t valid_until, int, const char *, size_t)
+{
+	TlsSessionWriter * writer(static_cast<TlsSessionWriter *>(userptr));
+	if ((valid_until && valid_until <= writer->mNow) || sdata_len > TLS_SESSION_FIELD_MAX)
+	{
+		// Expired or not something we'd read back
+		return CURLE_OK;
+	}
+	write_field(*writer->mFile, session_key, session_key ? strlen(session_key) : 0);
+	write_field(*writer->mFile, shmac, shmac_len);
+	write_field(*writer->mFile, sdata, sdata_len);
+	++writer->mCount;
+	return CURLE_OK;
+}
+
+}  // end anonymous namespace
+#endif	// LLCORE_HTTP_TLS_SESSION_EXPORT
+
+
+void HttpLibcurl::saveTlsSessions()
+{
+#if LLCORE_HTTP_TLS_SESSION_EXPORT
+	HttpPolicyGlobal & gpolicy(mService->getPolicy().getGlobalOptions());
+	if (gpolicy.mTlsSessionFile.empty() || ! mShareHandle)
+	{
+		return;
+	}
+	// Session tickets are secrets, start from a fresh file only the
+	// user can read.  On Windows the user settings directory already
+	// carries a per-user ACL which the new file inherits.
+	LLFile::remove(gpolicy.mTlsSessionFile, ENOENT);
+#if ! LL_WINDOWS
+	int fd(::open(gpolicy.mTlsSessionFile.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600));
+	if (fd < 0)
+	{
+		LL_WARNS(LOG_CORE) << "Unable to create TLS session file "
+						   << gpolicy.mTlsSessionFile << LL_ENDL;
+		return;
+	}
+	::close(fd);
+#endif
+	llofstream file(gpolicy.mTlsSessionFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (! file.is_open())
+	{
+		LL_WARNS(LOG_CORE) << "Unable to write TLS sessions to "
+						   << gpolicy.mTlsSessionFile << LL_ENDL;
+		return;
+	}
+	file.write(reinterpret_cast<const char *>(&TLS_SESSION_FILE_VERSION), sizeof(TLS_SESSION_FILE_VERSION));
+
+	CURL * handle(mHandleCache.getHandle());
+	if (! handle)
+	{
+		return;
+	}
+	curl_easy_setopt(handle, CURLOPT_SHARE, mShareHandle);
+
+	TlsSessionWriter writer = { &file, curl_off_t(time(NULL)), 0 };
+	curl_easy_ssls_export(handle, write_tls_session, &writer);
+	mHandleCache.freeHandle(handle);
+
+	LL_INFOS(LOG_CORE) << "Saved " << writer.mCount << " TLS sessions to "
+					   << gpolicy.mTlsSessionFile << LL_ENDL;
+#endif
+}
+
+
+void HttpLibcurl::shareLock(CURL *, curl_lock_data data, curl_lock_access, void * userptr)
+{
+	HttpLibcurl * self(static_cast<HttpLibcurl *>(userptr));
+	if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+	{
+		self->mShareLocks[data].lock();
+	}
+}
+
+
+void HttpLibcurl::shareUnlock(CURL *, curl_lock_data data, void * userptr)
+{
+	HttpLibcurl * self(static_cast<HttpLibcurl *>(userptr));
+	if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+	{
+		self->mShareLocks[data].unlock();
+	}
+}
+
+
 // ---------------------------------------
 // HttpLibcurl::HandleCache
 // ---------------------------------------
@@ -583,6 +928,12 @@ HttpLibcurl::HandleCache::HandleCache()
 
 
 HttpLibcurl::HandleCache::~HandleCache()
+{
+	clear();
+}
+
+
+void HttpLibcurl::HandleCache::clear()
 {
 	if (mHandleTemplate)
 	{
@@ -697,4 +1048,14 @@ void check_curl_multi_code(CURLMcode code)
 	}
 }
 
+
+long max_total_connections(const LLCore::HttpPolicyClass & options, long depth)
+{
+	// HttpPolicy never lets the adaptive limit past what the
+	// connections can carry, they just have to be allowed to open.
+	const long depth_used((std::max)(1L, depth));
+	const long needed((options.mAdaptiveConcurrency + depth_used - 1L) / depth_used);
+	return (std::max)(long(options.mConnectionLimit), needed);
+}
+
 }  // end anonymous namespace
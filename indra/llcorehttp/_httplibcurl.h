@@ -37,6 +37,31 @@
 #include "httprequest.h"
 #include "_httpservice.h"
 #include "_httpinternal.h"
+#include "_mutex.h"
+
+
+// libcurl 7.50.0 is the first to report the protocol version a
+// transfer actually used, which we need to fall back from HTTP/2
+// cleanly.
+#if LIBCURL_VERSION_NUM >= 0x073200
+#define LLCORE_HTTP2_MULTIPLEXING		1
+#else
+#define LLCORE_HTTP2_MULTIPLEXING		0
+#endif
+
+// Connection pools can be shared between multi handles as of
+// libcurl 7.57.0 and TLS sessions exported to storage as of 8.12.0.
+#if LIBCURL_VERSION_NUM >= 0x073900
+#define LLCORE_HTTP_SHARE_CONNECTIONS	1
+#else
+#define LLCORE_HTTP_SHARE_CONNECTIONS	0
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x080c00
+#define LLCORE_HTTP_TLS_SESSION_EXPORT	1
+#else
+#define LLCORE_HTTP_TLS_SESSION_EXPORT	0
+#endif
 
 
 namespace LLCore
@@ -109,6 +134,20 @@ public:
 	int getActiveCount() const;
 	int getActiveCountInClass(int policy_class) const;
 
+	/// HTTP/2 state of a policy class with PO_HTTP2_STREAMS set.
+	/// Starts out unknown and is settled by the first response.
+	enum EHttp2State
+	{
+		HTTP2_UNKNOWN,
+		HTTP2_ACTIVE,			// Server answered with HTTP/2, multiplexing
+		HTTP2_UNAVAILABLE		// HTTP/1.1 answer or no libcurl support, don't ask again
+	};
+
+	/// Return the HTTP/2 state of the class.
+	///
+	/// Threading:  called by worker thread.
+	EHttp2State getHttp2StateInClass(int policy_class) const;
+
 	/// Attempt to cancel a request identified by handle.
 	///
 	/// Interface shadows HttpService's method.
@@ -143,6 +182,19 @@ public:
 			return mHandleCache.getHandle();
 		}
 
+	/// Share handle holding the DNS, TLS session and (optionally)
+	/// connection caches used by all policy classes.  Requests
+	/// attach their easy handles to it.
+	///
+	/// @return			Libcurl share handle or NULL if libcurl
+	///					couldn't make one.
+	///
+	/// Threading:  called by worker thread.
+	CURLSH * getShareHandle() const
+		{
+			return mShareHandle;
+		}
+
 protected:
 	/// Invoked when libcurl has indicated a request has been processed
 	/// to completion and we need to move the request to a new state.
@@ -151,6 +203,16 @@ protected:
 	/// Invoked to cancel an active request, mainly during shutdown
 	/// and destroy.
     void cancelRequest(const opReqPtr_t &op);
+
+	/// Create the share handle on first start.
+	void startShare();
+
+	/// Read or write the PO_TLS_SESSION_FILE file, if any.
+	void loadTlsSessions();
+	void saveTlsSessions();
+
+	static void shareLock(CURL * handle, curl_lock_data data, curl_lock_access access, void * userptr);
+	static void shareUnlock(CURL * handle, curl_lock_data data, void * userptr);
 	
 protected:
     typedef std::set<opReqPtr_t> active_set_t;
@@ -199,6 +261,11 @@ protected:
 		/// Threading:  Single-thread (worker) only.
 		void freeHandle(CURL * handle);
 
+		/// Release all cached handles.
+		///
+		/// Threading:  Single-thread (worker) only.
+		void clear();
+
 	protected:
 		typedef std::vector<CURL *> handle_cache_t;
 	
@@ -215,6 +282,9 @@ protected:
 	CURLM **			mMultiHandles;		// One handle per policy class
 	int *				mActiveHandles;		// Active count per policy class
 	bool *				mDirtyPolicy;		// Dirty policy update waiting for stall (per pc)
+	EHttp2State *		mHttp2State;		// HTTP/2 negotiation outcome (per pc)
+	CURLSH *			mShareHandle;		// DNS/TLS/connection caches shared by all pcs
+	LLCoreInt::HttpMutex	mShareLocks[CURL_LOCK_DATA_LAST];
 	
 }; // end class HttpLibcurl
 
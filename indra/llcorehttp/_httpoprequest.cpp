@@ -149,6 +149,8 @@ HttpOpRequest::HttpOpRequest()
 	  mReplyLength(0),
 	  mReplyFullLength(0),
 	  mReplyHeaders(),
+	  mReplyRetryAfter(0),
+	  mReplyLatency(0),
 	  mPolicyRetries(0),
 	  mPolicy503Retries(0),
 	  mPolicyRetryAt(HttpTime(0)),
@@ -307,6 +309,116 @@ HttpStatus HttpOpRequest::cancel()
 }
 
 
+bool HttpOpRequest::getCoalesceKey(std::string & key) const
+{
+	if (HOR_GET != mReqMethod || mReqBody)
+	{
+		return false;
+	}
+	if (mReqOptions && mReqOptions->getHeadersOnly())
+	{
+		// Cheap and usually probes or connection warmups that
+		// want their own connection, leave them alone.
+		return false;
+	}
+
+	key = mReqURL;
+	if (mReqHeaders)
+	{
+		for (HttpHeaders::const_iterator it(mReqHeaders->begin()); mReqHeaders->end() != it; ++it)
+		{
+			key += '\n';
+			key += it->first;
+			key += ": ";
+			key += it->second;
+		}
+	}
+	if (mReqOptions)
+	{
+		key += '\n';
+		key += (mReqOptions->getWantHeaders() ? 'W' : '-');
+		key += (mReqOptions->getHeadersOnly() ? 'H' : '-');
+		key += (mReqOptions->getFollowRedirects() ? 'R' : '-');
+		key += (mReqOptions->getSSLVerifyPeer() ? 'P' : '-');
+		key += (mReqOptions->getSSLVerifyHost() ? 'V' : '-');
+		key += std::to_string(mReqOptions->getLastModified());
+	}
+	return true;
+}
+
+
+bool HttpOpRequest::coversRange(const HttpOpRequest & other) const
+{
+	if (mReqOffset > other.mReqOffset)
+	{
+		return false;
+	}
+	if (! mReqLength)
+	{
+		// Open-ended, covers everything after the offset
+		return true;
+	}
+	return (other.mReqLength
+			&& other.mReqOffset + other.mReqLength <= mReqOffset + mReqLength);
+}
+
+
+bool HttpOpRequest::coalesceReply(HttpOpRequest & primary)
+{
+	static const HttpStatus partial_content(HTTP_PARTIAL_CONTENT);
+
+	mStatus = primary.mStatus;
+	mReplyHeaders = primary.mReplyHeaders;
+	mReplyConType = primary.mReplyConType;
+	mReplyRetryAfter = primary.mReplyRetryAfter;
+	mXLLURL = primary.mXLLURL;
+	mPolicyRetries = primary.mPolicyRetries;
+	mPolicy503Retries = primary.mPolicy503Retries;
+
+	if ((mReqOffset == primary.mReqOffset && mReqLength == primary.mReqLength)
+		|| partial_content != primary.mStatus
+		|| ! primary.mReplyBody)
+	{
+		// Same range, a failure or a full (200) body that a
+		// server ignoring our Range would have sent anyway.
+		// Reply is exactly what we would have gotten.
+		mReplyOffset = primary.mReplyOffset;
+		mReplyLength = primary.mReplyLength;
+		mReplyFullLength = primary.mReplyFullLength;
+		mReplyBody = primary.mReplyBody;
+		if (mReplyBody)
+		{
+			mReplyBody->addRef();
+		}
+		return true;
+	}
+
+	// Narrower range out of a 206.  Without a Content-Range, assume
+	// the primary got what it asked for as the mesh code does.
+	const size_t body_start((primary.mReplyOffset || primary.mReplyLength)
+							? size_t(primary.mReplyOffset)
+							: size_t(primary.mReqOffset));
+	const size_t body_end(body_start + primary.mReplyBody->size());
+	const size_t want_start(mReqOffset);
+	if (want_start < body_start || want_start >= body_end)
+	{
+		return false;
+	}
+	const size_t want_end(mReqLength
+						  ? (std::min)(want_start + mReqLength, body_end)
+						  : body_end);
+	const size_t len(want_end - want_start);
+
+	mReplyBody = new BufferArray();
+	void * dst(mReplyBody->appendBufferAlloc(len));
+	primary.mReplyBody->read(want_start - body_start, dst, len);
+	mReplyOffset = want_start;
+	mReplyLength = len;
+	mReplyFullLength = primary.mReplyFullLength;
+	return true;
+}
+
+
 HttpStatus HttpOpRequest::setupGet(HttpRequest::policy_t policy_id,
 								   HttpRequest::priority_t priority,
 								   const std::string & url,
@@ -585,6 +697,14 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	// supposedly curl 7.62.0 can use TTL by default, otherwise default is 60 seconds
 	check_curl_easy_setopt(mCurlHandle, CURLOPT_DNS_CACHE_TIMEOUT, dnsCacheTimeout);
 
+	// Resolutions, TLS sessions and maybe connections are shared
+	// by all policy classes.
+	CURLSH * share(service->getTransport().getShareHandle());
+	if (share)
+	{
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_SHARE, share);
+	}
+
 	if (gpolicy.mUseLLProxy)
 	{
 		// Use the viewer-based thread-safe API which has a
@@ -763,6 +883,25 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 /******************************/
 		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
 	}
+#if LLCORE_HTTP2_MULTIPLEXING
+	if (cpolicy.mHttp2Streams > 1L
+		&& HttpLibcurl::HTTP2_UNAVAILABLE != service->getTransport().getHttp2StateInClass(mReqPolicy))
+	{
+		// Ask for HTTP/2 on TLS, libcurl quietly uses HTTP/1.1 for
+		// plain http: and for servers that don't negotiate it.  Wait
+		// for an existing connection to show whether it can multiplex
+		// rather than racing to open a new one per request.
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+
+		// Streams share the connection's bandwidth so give transfers
+		// the same extra room as pipelined ones.
+		if (cpolicy.mPipelining <= 1L)
+		{
+			xfer_timeout *= 2L;
+		}
+	}
+#endif	// LLCORE_HTTP2_MULTIPLEXING
 	// *DEBUG:  Enable following override for timeout handling and "[curl:bugs] #1420" tests
     //if (cpolicy.mPipelining)
     //{
@@ -801,6 +940,31 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
 	if (! op->mReplyBody)
 	{
 		op->mReplyBody = new BufferArray();
+
+		// Headers are complete by the first body write.  When the
+		// length is known, give the body one contiguous block so
+		// consumers can decode it where it lands.
+		size_t expected(op->mReplyLength);
+#if LIBCURL_VERSION_NUM >= 0x073700
+		curl_off_t content_length(-1);
+		if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length)
+			&& content_length > 0)
+#else
+		double content_length(-1.0);
+		if (CURLE_OK == curl_easy_getinfo(op->mCurlHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &content_length)
+			&& content_length > 0.0)
+#endif
+		{
+			expected = size_t(content_length);
+		}
+		else if (! expected)
+		{
+			expected = op->mReqLength;
+		}
+		if (expected && expected <= HTTP_REPLY_BODY_RESERVE_MAX)
+		{
+			op->mReplyBody->reserve(expected);
+		}
 	}
 	const size_t req_size(size * nmemb);
 	const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
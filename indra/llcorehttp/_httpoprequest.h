@@ -31,6 +31,7 @@
 #include "linden_common.h"		// Modifies curl/curl.h interfaces
 
 #include <string>
+#include <vector>
 #include <curl/curl.h>
 
 #include <openssl/x509_vfy.h>
@@ -166,6 +167,34 @@ public:
 	
 	virtual HttpStatus cancel();
 
+	// Request coalescing support.  A GET may be answered from the
+	// reply to an identical (or covering) GET already in flight.
+	//
+	// Threading:  called by worker thread
+	//
+
+	/// Builds the key identifying requests that would get the same
+	/// reply apart from range:  URL, request headers and the options
+	/// that change what comes back.
+	///
+	/// @return			false if the request can't be coalesced
+	///					(not a GET or carries a body).
+	bool getCoalesceKey(std::string & key) const;
+
+	/// @return			true if this request's byte range
+	///					contains all of 'other's.
+	bool coversRange(const HttpOpRequest & other) const;
+
+	/// Fills in this request's reply from the finished reply of
+	/// the request it was coalesced with.  Identical ranges share
+	/// the reply body, narrower ranges get a copy of their slice
+	/// of a 206 reply.
+	///
+	/// @return			false if the reply doesn't contain the
+	///					range wanted here and the request needs
+	///					to be issued on its own.
+	bool coalesceReply(HttpOpRequest & primary);
+
 protected:
 	// Common setup for all the request methods.
 	//
@@ -227,6 +256,7 @@ public:
 	HttpHeaders::ptr_t	mReplyHeaders;
 	std::string			mReplyConType;
 	int					mReplyRetryAfter;
+	HttpTime			mReplyLatency;			// Time to first byte of last attempt
 	std::string mXLLURL; // <FS:ND/> If we get a x-ll-url header, save it here, even if mReplyHeaders is not filled.
 	// Policy data
 	int					mPolicyRetries;
@@ -235,6 +265,11 @@ public:
 	int					mPolicyRetryLimit;
 	HttpTime			mPolicyMinRetryBackoff; // initial delay between retries (mcs)
 	HttpTime			mPolicyMaxRetryBackoff;
+
+	// Coalescing data
+	typedef std::vector<ptr_t> coalesced_t;
+	std::string			mCoalesceKey;			// Non-empty while registered as in flight
+	coalesced_t			mCoalesced;				// Requests waiting on our reply
 };  // end class HttpOpRequest
 
 
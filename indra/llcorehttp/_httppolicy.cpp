@@ -32,8 +32,11 @@
 #include "_httpservice.h"
 #include "_httplibcurl.h"
 #include "_httppolicyclass.h"
+#include "_httpconcurrency.h"
 
 #include "lltimer.h"
+#include "llhttpconstants.h"
+#include "bufferarray.h"
 #include "httpstats.h"
 
 namespace
@@ -60,17 +63,20 @@ public:
 		: mThrottleEnd(0),
 		  mThrottleLeft(0L),
 		  mRequestCount(0L),
-		  mStallStaging(false)
+		  mStallStaging(false),
+		  mConcurrencyHttp2(HttpLibcurl::HTTP2_UNKNOWN)
 		{}
 	
 	HttpReadyQueue		mReadyQueue;
 	HttpRetryQueue		mRetryQueue;
 
 	HttpPolicyClass		mOptions;
+	HttpConcurrency		mConcurrency;
 	HttpTime			mThrottleEnd;
 	long				mThrottleLeft;
 	long				mRequestCount;
 	bool				mStallStaging;
+	HttpLibcurl::EHttp2State mConcurrencyHttp2;	// HTTP/2 state mConcurrency was seeded for
 };
 
 
@@ -110,6 +116,20 @@ HttpRequest::policy_t HttpPolicy::createPolicyClass()
 
 void HttpPolicy::shutdown()
 {
+	// Requests waiting on another's reply go first so that
+	// canceling the requests they wait on can't re-issue them.
+	for (coalesce_map_t::iterator it(mInFlight.begin()); mInFlight.end() != it; ++it)
+	{
+		HttpOpRequest::coalesced_t waiting;
+		waiting.swap(it->second->mCoalesced);
+		it->second->mCoalesceKey.clear();
+		for (HttpOpRequest::coalesced_t::iterator op(waiting.begin()); waiting.end() != op; ++op)
+		{
+			(*op)->cancel();
+		}
+	}
+	mInFlight.clear();
+
 	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
 	{
 		ClassState & state(*mClasses[policy_class]);
@@ -146,6 +166,11 @@ void HttpPolicy::addOp(const HttpOpRequest::ptr_t &op)
 	
 	op->mPolicyRetries = 0;
 	op->mPolicy503Retries = 0;
+	if (mGlobalOptions.mCoalesceRequests && coalesceOp(op))
+	{
+		// Will be answered from an earlier request's reply
+		return;
+	}
 	mClasses[policy_class]->mReadyQueue.push(op);
 }
 
@@ -248,10 +273,45 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 		}
 
 		int active(transport.getActiveCountInClass(policy_class));
-		int active_limit(state.mOptions.mPipelining > 1L
-						 ? (state.mOptions.mPerHostConnectionLimit
-							* state.mOptions.mPipelining)
-						 : state.mOptions.mConnectionLimit);
+		int active_limit(state.mOptions.mConnectionLimit);
+		// Most an adaptive limit may reach with the current transport.
+		// Without pipelining or HTTP/2 each request gets its own
+		// connection and libcurl is allowed as many as the option asks.
+		int adaptive_ceiling(state.mOptions.mAdaptiveConcurrency);
+		const HttpLibcurl::EHttp2State http2(transport.getHttp2StateInClass(policy_class));
+		if (state.mOptions.mHttp2Streams > 1L && HttpLibcurl::HTTP2_UNAVAILABLE != http2)
+		{
+			// Only open up to the stream count once the server has
+			// shown it speaks HTTP/2, otherwise requests would queue
+			// inside libcurl behind a handful of HTTP/1.1 connections.
+			if (HttpLibcurl::HTTP2_ACTIVE == http2)
+			{
+				active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mHttp2Streams;
+			}
+			adaptive_ceiling = active_limit;
+		}
+		else if (state.mOptions.mPipelining > 1L)
+		{
+			active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mPipelining;
+			adaptive_ceiling = active_limit;
+		}
+		if (state.mOptions.mAdaptiveConcurrency > 0L)
+		{
+			// Fixed limit is just the starting point.  Start over
+			// whenever the transport changes under the controller,
+			// the first time through and once the class learns
+			// whether the server speaks HTTP/2.
+			adaptive_ceiling = llclamp(adaptive_ceiling, 1, int(state.mOptions.mAdaptiveConcurrency));
+			if (http2 != state.mConcurrencyHttp2 || state.mConcurrency.getMaxLimit() != adaptive_ceiling)
+			{
+				state.mConcurrencyHttp2 = http2;
+				state.mConcurrency.reset(active_limit,
+										 (std::min)(int(HTTP_ADAPTIVE_CONCURRENCY_MIN), adaptive_ceiling),
+										 adaptive_ceiling);
+				HTTPStats::instance().recordConcurrencyLimit(policy_class, state.mConcurrency.getLimit());
+			}
+			active_limit = state.mConcurrency.getLimit();
+		}
 		int needed(active_limit - active);		// Expect negatives here
 
 		if (needed > 0)
@@ -319,6 +379,11 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 		}
 
 	throttle_on:
+
+		if (state.mOptions.mAdaptiveConcurrency > 0L)
+		{
+			state.mConcurrency.onDispatch(transport.getActiveCountInClass(policy_class));
+		}
 		
 		if (! readyq.empty() || ! retryq.empty())
 		{
@@ -363,6 +428,39 @@ bool HttpPolicy::changePriority(HttpHandle handle, HttpRequest::priority_t prior
 
 bool HttpPolicy::cancel(HttpHandle handle)
 {
+	for (coalesce_map_t::iterator it(mInFlight.begin()); mInFlight.end() != it; ++it)
+	{
+		HttpOpRequest::ptr_t primary(it->second);
+		HttpOpRequest::coalesced_t & waiting(primary->mCoalesced);
+
+		// Request waiting on another's reply
+		for (HttpOpRequest::coalesced_t::iterator iter(waiting.begin()); waiting.end() != iter; ++iter)
+		{
+			if ((*iter)->getHandle() == handle)
+			{
+				HttpOpRequest::ptr_t op(*iter);
+				waiting.erase(iter);
+				op->cancel();
+				return true;
+			}
+		}
+
+		// Request others are waiting on.  They're re-issued and the
+		// cancel goes ahead in the queues or the transport.
+		if (primary->getHandle() == handle)
+		{
+			HttpOpRequest::coalesced_t orphans;
+			orphans.swap(waiting);
+			mInFlight.erase(it);						// All iterators are now invalidated
+			primary->mCoalesceKey.clear();
+			for (HttpOpRequest::coalesced_t::iterator iter(orphans.begin()); orphans.end() != iter; ++iter)
+			{
+				addOp(*iter);
+			}
+			break;
+		}
+	}
+
 	for (int policy_class(0); policy_class < mClasses.size(); ++policy_class)
 	{
 		ClassState & state(*mClasses[policy_class]);
@@ -404,6 +502,33 @@ bool HttpPolicy::cancel(HttpHandle handle)
 
 bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 {
+	ClassState & state(*mClasses[op->mReqPolicy]);
+	if (state.mOptions.mAdaptiveConcurrency > 0L && state.mConcurrency.isRunning())
+	{
+		static const HttpStatus error_503(HTTP_SERVICE_UNAVAILABLE);
+		static const HttpStatus error_429(HTTP_TOO_MANY_REQUESTS);
+		static const HttpStatus timed_out(HttpStatus::EXT_CURL_EASY, CURLE_OPERATION_TIMEDOUT);
+
+		const bool overload(error_503 == op->mStatus
+							|| error_429 == op->mStatus
+							|| timed_out == op->mStatus);
+		state.mConcurrency.onComplete(op->mReplyLatency,
+									  op->mReplyBody ? op->mReplyBody->size() : 0,
+									  overload);
+		if (state.mConcurrency.update(totalTime()))
+		{
+			HTTPStats::instance().recordConcurrencyLimit(op->mReqPolicy, state.mConcurrency.getLimit());
+			if (op->mTracing > HTTP_TRACE_OFF)
+			{
+				LL_INFOS(LOG_CORE) << "TRACE, ConcurrencyLimit, Class:  " << op->mReqPolicy
+								   << ", Limit:  " << state.mConcurrency.getLimit()
+								   << ", Latency:  " << (state.mConcurrency.getWindowLatency() / HttpTime(1000))
+								   << " mS, Base:  " << (state.mConcurrency.getBaseLatency() / HttpTime(1000))
+								   << " mS" << LL_ENDL;
+			}
+		}
+	}
+
 	// Retry or finalize
 	if (! op->mStatus)
 	{
@@ -444,12 +569,86 @@ bool HttpPolicy::stageAfterCompletion(const HttpOpRequest::ptr_t &op)
 							<< LL_ENDL;
 	}
 
+	completeCoalesced(op);
 	op->stageFromActive(mService);
 
     HTTPStats::instance().recordResultCode(op->mStatus.getType());
 	return false;						// not active
 }
 
+
+bool HttpPolicy::coalesceOp(const HttpOpRequest::ptr_t & op)
+{
+	std::string key;
+	if (! op->getCoalesceKey(key))
+	{
+		return false;
+	}
+
+	std::pair<coalesce_map_t::iterator, coalesce_map_t::iterator> range(mInFlight.equal_range(key));
+	for (coalesce_map_t::iterator it(range.first); range.second != it; ++it)
+	{
+		const HttpOpRequest::ptr_t & primary(it->second);
+		if (primary->coversRange(*op))
+		{
+			primary->mCoalesced.push_back(op);
+			if (op->mTracing > HTTP_TRACE_OFF)
+			{
+				LL_INFOS(LOG_CORE) << "TRACE, Coalesced, Handle:  "
+								   << op->getHandle()
+								   << ", With:  " << primary->getHandle()
+								   << LL_ENDL;
+			}
+			return true;
+		}
+	}
+
+	op->mCoalesceKey = key;
+	mInFlight.insert(range.second, coalesce_map_t::value_type(key, op));
+	return false;
+}
+
+
+void HttpPolicy::removeInFlight(const HttpOpRequest::ptr_t & op)
+{
+	if (op->mCoalesceKey.empty())
+	{
+		return;
+	}
+
+	std::pair<coalesce_map_t::iterator, coalesce_map_t::iterator> range(mInFlight.equal_range(op->mCoalesceKey));
+	for (coalesce_map_t::iterator it(range.first); range.second != it; ++it)
+	{
+		if (it->second == op)
+		{
+			mInFlight.erase(it);
+			break;
+		}
+	}
+	op->mCoalesceKey.clear();
+}
+
+
+void HttpPolicy::completeCoalesced(const HttpOpRequest::ptr_t & op)
+{
+	removeInFlight(op);
+
+	HttpOpRequest::coalesced_t waiting;
+	waiting.swap(op->mCoalesced);
+	for (HttpOpRequest::coalesced_t::iterator it(waiting.begin()); waiting.end() != it; ++it)
+	{
+		if ((*it)->coalesceReply(*op))
+		{
+			(*it)->stageFromActive(mService);
+		}
+		else
+		{
+			// Reply didn't reach our range, go it alone
+			addOp(*it);
+		}
+	}
+}
+
 	
 HttpPolicyClass & HttpPolicy::getClassOptions(HttpRequest::policy_t pclass)
 {
@@ -28,6 +28,9 @@
 #define	_LLCORE_HTTP_POLICY_H_
 
 
+#include <map>
+#include <string>
+
 #include "httprequest.h"
 #include "_httpservice.h"
 #include "_httpreadyqueue.h"
@@ -168,12 +171,31 @@ public:
 	/// Threading:  called by worker thread
 	bool stallPolicy(HttpRequest::policy_t policy_class, bool stall);
 	
+protected:
+	/// With PO_COALESCE_REQUESTS on, attach the request to an
+	/// earlier one in flight that will answer it.  Otherwise the
+	/// request is recorded as in flight itself.
+	///
+	/// @return			true if the request was attached and
+	///					mustn't be queued.
+	bool coalesceOp(const opReqPtr_t & op);
+
+	/// Drop a request from the in-flight map.  Requests attached
+	/// to it are left with it.
+	void removeInFlight(const opReqPtr_t & op);
+
+	/// Deliver a finished request's reply to the requests attached
+	/// to it, re-issuing any the reply doesn't satisfy.
+	void completeCoalesced(const opReqPtr_t & op);
+
 protected:
 	struct ClassState;
 	typedef std::vector<ClassState *>	class_list_t;
+	typedef std::multimap<std::string, opReqPtr_t> coalesce_map_t;
 	
 	HttpPolicyGlobal					mGlobalOptions;
 	class_list_t						mClasses;
+	coalesce_map_t						mInFlight;				// Coalescable requests not yet finished, by key
 	HttpService *						mService;				// Naked pointer, not refcounted, not owner
 };  // end class HttpPolicy
 
@@ -37,7 +37,9 @@ HttpPolicyClass::HttpPolicyClass()
 	: mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPerHostConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPipelining(HTTP_PIPELINING_DEFAULT),
-	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT)
+	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT),
+	  mHttp2Streams(HTTP_HTTP2_STREAMS_DEFAULT),
+	  mAdaptiveConcurrency(HTTP_ADAPTIVE_CONCURRENCY_DEFAULT)
 {}
 
 
@@ -53,6 +55,8 @@ HttpPolicyClass & HttpPolicyClass::operator=(const HttpPolicyClass & other)
 		mPerHostConnectionLimit = other.mPerHostConnectionLimit;
 		mPipelining = other.mPipelining;
 		mThrottleRate = other.mThrottleRate;
+		mHttp2Streams = other.mHttp2Streams;
+		mAdaptiveConcurrency = other.mAdaptiveConcurrency;
 	}
 	return *this;
 }
@@ -62,7 +66,9 @@ HttpPolicyClass::HttpPolicyClass(const HttpPolicyClass & other)
 	: mConnectionLimit(other.mConnectionLimit),
 	  mPerHostConnectionLimit(other.mPerHostConnectionLimit),
 	  mPipelining(other.mPipelining),
-	  mThrottleRate(other.mThrottleRate)
+	  mThrottleRate(other.mThrottleRate),
+	  mHttp2Streams(other.mHttp2Streams),
+	  mAdaptiveConcurrency(other.mAdaptiveConcurrency)
 {}
 
 
@@ -86,6 +92,16 @@ HttpStatus HttpPolicyClass::set(HttpRequest::EPolicyOption opt, long value)
 		mThrottleRate = llclamp(value, 0L, 1000000L);
 		break;
 
+	case HttpRequest::PO_HTTP2_STREAMS:
+		mHttp2Streams = llclamp(value, 0L, HTTP_HTTP2_STREAMS_MAX);
+		break;
+
+	case HttpRequest::PO_ADAPTIVE_CONCURRENCY:
+		mAdaptiveConcurrency = value > 0L
+			? llclamp(value, HTTP_ADAPTIVE_CONCURRENCY_MIN, HTTP_ADAPTIVE_CONCURRENCY_MAX)
+			: 0L;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -114,6 +130,14 @@ HttpStatus HttpPolicyClass::get(HttpRequest::EPolicyOption opt, long * value) co
 		*value = mThrottleRate;
 		break;
 
+	case HttpRequest::PO_HTTP2_STREAMS:
+		*value = mHttp2Streams;
+		break;
+
+	case HttpRequest::PO_ADAPTIVE_CONCURRENCY:
+		*value = mAdaptiveConcurrency;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
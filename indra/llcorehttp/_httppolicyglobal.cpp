@@ -36,7 +36,9 @@ namespace LLCore
 HttpPolicyGlobal::HttpPolicyGlobal()
 	: mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mTrace(HTTP_TRACE_OFF),
-	  mUseLLProxy(0)
+	  mUseLLProxy(0),
+	  mCoalesceRequests(HTTP_COALESCE_REQUESTS_DEFAULT),
+	  mShareConnections(HTTP_SHARE_CONNECTIONS_DEFAULT)
 {}
 
 
@@ -54,6 +56,9 @@ HttpPolicyGlobal & HttpPolicyGlobal::operator=(const HttpPolicyGlobal & other)
 		mHttpProxy = other.mHttpProxy;
 		mTrace = other.mTrace;
 		mUseLLProxy = other.mUseLLProxy;
+		mCoalesceRequests = other.mCoalesceRequests;
+		mShareConnections = other.mShareConnections;
+		mTlsSessionFile = other.mTlsSessionFile;
 	}
 	return *this;
 }
@@ -75,6 +80,14 @@ HttpStatus HttpPolicyGlobal::set(HttpRequest::EPolicyOption opt, long value)
 		mUseLLProxy = llclamp(value, 0L, 1L);
 		break;
 
+	case HttpRequest::PO_COALESCE_REQUESTS:
+		mCoalesceRequests = llclamp(value, 0L, 1L);
+		break;
+
+	case HttpRequest::PO_SHARE_CONNECTIONS:
+		mShareConnections = llclamp(value, 0L, 1L);
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -102,6 +115,11 @@ HttpStatus HttpPolicyGlobal::set(HttpRequest::EPolicyOption opt, const std::stri
 		mHttpProxy = value;
 		break;
 
+	case HttpRequest::PO_TLS_SESSION_FILE:
+        LL_DEBUGS("CoreHttp") << "Setting global TLS session file to " << value << LL_ENDL;
+		mTlsSessionFile = value;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -140,6 +158,14 @@ HttpStatus HttpPolicyGlobal::get(HttpRequest::EPolicyOption opt, long * value) c
 		*value = mUseLLProxy;
 		break;
 
+	case HttpRequest::PO_COALESCE_REQUESTS:
+		*value = mCoalesceRequests;
+		break;
+
+	case HttpRequest::PO_SHARE_CONNECTIONS:
+		*value = mShareConnections;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -164,6 +190,10 @@ HttpStatus HttpPolicyGlobal::get(HttpRequest::EPolicyOption opt, std::string * v
 		*value = mHttpProxy;
 		break;
 
+	case HttpRequest::PO_TLS_SESSION_FILE:
+		*value = mTlsSessionFile;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -72,6 +72,9 @@ public:
 	std::string			mHttpProxy;
 	long				mTrace;
 	long				mUseLLProxy;
+	long				mCoalesceRequests;
+	long				mShareConnections;
+	std::string			mTlsSessionFile;
 	HttpRequest::policyCallback_t	mSslCtxCallback;
 };  // end class HttpPolicyGlobal
 
@@ -177,6 +177,7 @@ void * BufferArray::appendBufferAlloc(size_t len)
 		mBlocks.reserve(mBlocks.size() + 5);
 	}
 	Block * block = Block::alloc((std::max)(BLOCK_ALLOC_SIZE, len));
+	memset(block->mData, 0, len);
 	block->mUsed = len;
 	mBlocks.push_back(block);
 	mLen += len;
@@ -184,6 +185,50 @@ void * BufferArray::appendBufferAlloc(size_t len)
 }
 
 
+bool BufferArray::reserve(size_t len)
+{
+	if (mLen || ! mBlocks.empty())
+	{
+		return false;
+	}
+	if (len <= BLOCK_ALLOC_SIZE)
+	{
+		// First block allocated by append() will hold it
+		return true;
+	}
+
+	Block * block;
+	try
+	{
+		block = Block::alloc(len);
+	}
+	catch (std::bad_alloc&)
+	{
+		LL_WARNS() << "Unable to reserve " << len << " bytes for BufferArray" << LL_ENDL;
+		return false;
+	}
+	mBlocks.push_back(block);
+	return true;
+}
+
+
+void * BufferArray::getContiguous(size_t pos, size_t len)
+{
+	size_t offset(0);
+	int block(findBlock(pos, &offset));
+	if (block < 0 || 0 == len)
+		return NULL;
+
+	Block & b(*mBlocks[block]);
+	if (b.mUsed - offset < len)
+	{
+		// Spans a block boundary
+		return NULL;
+	}
+	return &b.mData[offset];
+}
+
+
 size_t BufferArray::read(size_t pos, void * dst, size_t len)
 {
 	char * c_dst(static_cast<char *>(dst));
@@ -326,9 +371,7 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
 BufferArray::Block::Block(size_t len)
 	: mUsed(0),
 	  mAlloced(len)
-{
-	memset(mData, 0, len);
-}
+{}
 			
 
 BufferArray::Block::~Block()
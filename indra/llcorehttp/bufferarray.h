@@ -104,6 +104,27 @@ public:
 	///					of BufferArray of 'len' size.
 	void * appendBufferAlloc(size_t len);
 
+	/// Pre-sizes an empty BufferArray so that the next 'len'
+	/// bytes of append() or write() calls land in a single
+	/// contiguous block.  Intended for response bodies whose
+	/// length is known up front (Content-Length or a Range
+	/// request) so that consumers can decode them in place.
+	/// Data beyond the reservation spills into ordinary
+	/// blocks.  Doesn't change size() or the position.
+	///
+	/// @return			true if the reservation was made,
+	///					false if the instance already has
+	///					data or the allocation failed.
+	bool reserve(size_t len);
+
+	/// Returns a pointer to 'len' bytes of data starting at
+	/// 'pos' if that range lies entirely within one block
+	/// (always the case for a body that fit its reservation),
+	/// NULL otherwise.  Callers fall back to read() when NULL
+	/// is returned.  The pointer is valid until the next
+	/// modifying operation on the instance.
+	void * getContiguous(size_t pos, size_t len);
+
 	/// Current count of bytes in BufferArray instance.
 	size_t size() const
 		{
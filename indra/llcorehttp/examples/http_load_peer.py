@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""\
+@file   http_load_peer.py
+@brief  Runs the executable (with args) specified on the command line
+        against a local stand-in for the texture and mesh asset servers,
+        returning its result code.  Used with http_texture_load's
+        synthetic mode ('-s') to get repeatable llcorehttp load numbers
+        without a live grid.
+
+$LicenseInfo:firstyear=2022&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2022, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+import os
+import re
+import sys
+import time
+import random
+import hashlib
+import argparse
+import threading
+from http.server import HTTPServer, BaseHTTPRequestHandler
+from socketserver import ThreadingMixIn
+
+# we're in llcorehttp/examples ; testrunner.py is found in llmessage/tests
+sys.path.append(os.path.join(os.path.dirname(__file__), os.pardir, os.pardir,
+                             "llmessage", "tests"))
+
+from testrunner import freeport, run, debug, VERBOSE
+
+# Asset sizes are log-uniform between these bounds, picked from a
+# hash of the asset id so every run serves the same corpus.
+SIZES = {
+    "texture": (20 * 1024, 1024 * 1024),
+    "mesh": (8 * 1024, 512 * 1024),
+    }
+
+# Bodies are slices of one block of filler so that serving doesn't
+# cost more than the client's side of the transfer.
+FILLER = bytes(range(256)) * (4 * 1024)
+CHUNK_SIZE = 16 * 1024
+
+RANGE_RE = re.compile(r"bytes=(\d+)-(\d*)$")
+
+
+class AssetHTTPRequestHandler(BaseHTTPRequestHandler):
+    """Serves GETs for '/texture/<id>' and '/mesh/<id>' from a synthetic
+    corpus, honoring single 'Range:' headers the way the asset servers
+    do.  Server options (latency, per-connection bandwidth, error
+    injection) come from the command line and are held on the server
+    instance.
+    """
+    protocol_version = "HTTP/1.1"       # keep-alive, like the real thing
+
+    def do_GET(self):
+        server = self.server
+        parts = self.path.strip("/").split("/")
+        if len(parts) != 2 or parts[0] not in SIZES:
+            self.reply_error(404)
+            return
+
+        with server.lock:
+            server.active += 1
+            overloaded = server.capacity and server.active > server.capacity
+            roll = server.rng.random()
+            jitter = server.rng.uniform(-server.jitter, server.jitter)
+        try:
+            if server.latency:
+                time.sleep(max(0.0, server.latency + jitter) / 1000.0)
+            if overloaded or roll < server.error_503:
+                self.reply_error(503, retry_after=1)
+                return
+            roll -= server.error_503
+            if roll < server.error_500:
+                self.reply_error(500)
+                return
+            roll -= server.error_500
+            self.reply_asset(parts[0], parts[1], truncate=roll < server.drop)
+        finally:
+            with server.lock:
+                server.active -= 1
+
+    def asset_size(self, kind, asset_id):
+        low, high = SIZES[kind]
+        digest = hashlib.md5((kind + asset_id).encode("utf-8")).digest()
+        fraction = int.from_bytes(digest[:4], "little") / float(1 << 32)
+        return int(low * (float(high) / low) ** fraction)
+
+    def reply_asset(self, kind, asset_id, truncate):
+        size = self.asset_size(kind, asset_id)
+        start, end = 0, size - 1
+        partial = False
+        ranges = self.headers.get("Range")
+        if ranges:
+            match = RANGE_RE.match(ranges.strip())
+            if match:
+                start = int(match.group(1))
+                if match.group(2):
+                    end = min(end, int(match.group(2)))
+                if start >= size:
+                    self.send_response(416)
+                    self.send_header("Content-Range", "bytes */%d" % size)
+                    self.send_header("Content-Length", "0")
+                    self.end_headers()
+                    return
+                partial = True
+
+        length = end - start + 1
+        self.send_response(206 if partial else 200)
+        if partial:
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, end, size))
+        self.send_header("Content-Type",
+                         "image/x-j2c" if kind == "texture" else "application/vnd.ll.mesh")
+        self.send_header("Content-Length", str(length))
+        self.end_headers()
+
+        if truncate:
+            # Hang up partway through, libcurl should see a short body
+            length //= 2
+            self.close_connection = True
+
+        sent = 0
+        bandwidth = self.server.bandwidth
+        while sent < length:
+            count = min(CHUNK_SIZE, length - sent)
+            offset = (start + sent) % (len(FILLER) - CHUNK_SIZE)
+            self.wfile.write(FILLER[offset:offset + count])
+            sent += count
+            if bandwidth:
+                time.sleep(count / bandwidth)
+
+    def reply_error(self, status, retry_after=None):
+        body = ("%d from local asset stand-in\n" % status).encode("utf-8")
+        self.send_response(status)
+        if retry_after is not None:
+            self.send_header("Retry-After", str(retry_after))
+        self.send_header("Content-Type", "text/plain")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    if not VERBOSE:
+        # When VERBOSE is set, skip both these overrides because they exist to
+        # suppress output.
+
+        def log_request(self, code, size=None):
+            pass
+
+        def log_error(self, format, *args):
+            pass
+
+
+class Server(ThreadingMixIn, HTTPServer):
+    # See test_llcorehttp_peer.py, freeport() depends on this being off.
+    allow_reuse_address = False
+    daemon_threads = True
+
+    def handle_error(self, request, client_address):
+        # Clients hanging up mid-reply are expected here
+        pass
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Run a program against a local texture/mesh asset server.  "
+                    "The server's port is passed in $LL_TEST_PORT.")
+    parser.add_argument("--latency", type=float, default=0.0,
+                        help="milliseconds before each reply starts (default %(default)s)")
+    parser.add_argument("--jitter", type=float, default=0.0,
+                        help="+/- milliseconds of random latency (default %(default)s)")
+    parser.add_argument("--bandwidth", type=float, default=0.0,
+                        help="KB/s per connection, 0 for unlimited (default %(default)s)")
+    parser.add_argument("--capacity", type=int, default=0,
+                        help="requests served at once before 503s, 0 for unlimited "
+                             "(default %(default)s)")
+    parser.add_argument("--error-503", type=float, default=0.0,
+                        help="fraction of requests answered with 503 and Retry-After "
+                             "(default %(default)s)")
+    parser.add_argument("--error-500", type=float, default=0.0,
+                        help="fraction of requests answered with 500 (default %(default)s)")
+    parser.add_argument("--drop", type=float, default=0.0,
+                        help="fraction of replies cut off halfway (default %(default)s)")
+    parser.add_argument("--seed", type=int, default=1,
+                        help="seed for latency jitter and error injection (default %(default)s)")
+    parser.add_argument("command", nargs=argparse.REMAINDER,
+                        help="program and arguments to run")
+    options = parser.parse_args()
+    if not options.command:
+        parser.error("no program to run")
+
+    def make_server(port):
+        server = Server(('127.0.0.1', port), AssetHTTPRequestHandler)
+        server.lock = threading.Lock()
+        server.rng = random.Random(options.seed)
+        server.active = 0
+        server.latency = options.latency
+        server.jitter = options.jitter
+        server.bandwidth = options.bandwidth * 1024.0
+        server.capacity = options.capacity
+        server.error_503 = options.error_503
+        server.error_500 = options.error_500
+        server.drop = options.drop
+        return server
+
+    if not sys.platform.startswith("win"):
+        httpd = make_server(0)
+    else:
+        httpd, port = freeport(range(8000, 8020), make_server)
+
+    os.environ["LL_TEST_PORT"] = str(httpd.server_port)
+    debug("$LL_TEST_PORT = %s", httpd.server_port)
+    sys.exit(run(server_inst=httpd, *options.command))
@@ -29,6 +29,8 @@
 #include <cstdlib>
 #include <set>
 #include <map>
+#include <vector>
+#include <algorithm>
 #if !defined(WIN32)
 #include <pthread.h>
 #endif
@@ -62,6 +64,9 @@ static int highwater(100);
 static int pipeline_depth(0);
 static int tracing(0);
 static char url_format[1024] = "http://example.com/some/path?texture_id=%s.texture";
+static int synthetic_count(0);
+static int mesh_percent(0);
+static unsigned int random_seed(1);
 
 #if defined(WIN32)
 
@@ -88,6 +93,7 @@ public:
 	virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response);
 
 	void loadAssetUuids(FILE * in);
+	void makeSyntheticAssets(int count, int mesh_percent);
 	
 public:
 	struct Spec
@@ -95,8 +101,10 @@ public:
 		std::string		mUuid;
 		int				mOffset;
 		int				mLength;
+		bool			mMesh;
 	};
-	typedef std::set<LLCore::HttpHandle> handle_set_t;
+	typedef std::map<LLCore::HttpHandle, U64> handle_map_t;	// Handle -> issue time
+	typedef std::vector<U64> latency_list_t;
 	typedef std::vector<Spec> asset_list_t;
 	
 public:
@@ -105,12 +113,14 @@ public:
 	bool						mNoRange;
 	int							mRequestLowWater;
 	int							mRequestHighWater;
-	handle_set_t				mHandles;
+	handle_map_t				mHandles;
 	int							mRemaining;
 	int							mLimit;
 	int							mAt;
 	std::string					mUrl;
+	std::string					mMeshUrl;
 	asset_list_t				mAssets;
+	latency_list_t				mLatencies;
 	int							mErrorsApi;
 	int							mErrorsHttp;
 	int							mErrorsHttp404;
@@ -165,15 +175,62 @@ int main(int argc, char** argv)
 	bool do_random(false);
 	bool do_whole(false);
 	bool do_verbose(false);
+	bool have_url(false);
 	
 	int option(-1);
-	while (-1 != (option = getopt(argc, argv, "u:c:h?RwvH:p:t:")))
+	while (-1 != (option = getopt(argc, argv, "u:c:h?RwvH:p:t:s:m:S:")))
 	{
 		switch (option)
 		{
 		case 'u':
 			strncpy(url_format, optarg, sizeof(url_format));
 			url_format[sizeof(url_format) - 1] = '\0';
+			have_url = true;
+			break;
+
+		case 's':
+		    {
+				unsigned long value;
+				char * end;
+
+				value = strtoul(optarg, &end, 10);
+				if (value < 1 || value > 1000000 || *end != '\0')
+				{
+					usage(std::cerr);
+					return 1;
+				}
+				synthetic_count = value;
+			}
+			break;
+
+		case 'm':
+		    {
+				unsigned long value;
+				char * end;
+
+				value = strtoul(optarg, &end, 10);
+				if (value > 100 || *end != '\0')
+				{
+					usage(std::cerr);
+					return 1;
+				}
+				mesh_percent = value;
+			}
+			break;
+
+		case 'S':
+		    {
+				unsigned long value;
+				char * end;
+
+				value = strtoul(optarg, &end, 10);
+				if (*end != '\0')
+				{
+					usage(std::cerr);
+					return 1;
+				}
+				random_seed = value;
+			}
 			break;
 
 		case 'c':
@@ -257,21 +314,48 @@ int main(int argc, char** argv)
 		}
 	}
 
-	if ((optind + 1) != argc)
+	if ((optind + (synthetic_count ? 0 : 1)) != argc)
 	{
 		usage(std::cerr);
 		return 1;
 	}
 
-	FILE * uuids(fopen(argv[optind], "r"));
-	if (! uuids)
+	FILE * uuids(NULL);
+	std::string mesh_url_format;
+	if (synthetic_count)
 	{
-		const char * errstr(strerror(errno));
+		// Synthetic corpus served by examples/http_load_peer.py
+		// which passes its port in the environment.
+		const char * port(getenv("LL_TEST_PORT"));
+		if (! have_url)
+		{
+			if (! port)
+			{
+				std::cerr << "Synthetic mode needs -u or LL_TEST_PORT from http_load_peer.py." << std::endl;
+				return 1;
+			}
+			snprintf(url_format, sizeof(url_format), "http://127.0.0.1:%s/texture/%%s", port);
+		}
+		mesh_url_format = url_format;
+		std::string::size_type pos(mesh_url_format.find("texture"));
+		if (std::string::npos != pos)
+		{
+			mesh_url_format.replace(pos, 7, "mesh");
+		}
+	}
+	else
+	{
+		uuids = fopen(argv[optind], "r");
+		if (! uuids)
+		{
+			const char * errstr(strerror(errno));
 		
-		std::cerr << "Couldn't open UUID file '" << argv[optind] << "'.  Reason:  "
-				  << errstr << std::endl;
-		return 1;
+			std::cerr << "Couldn't open UUID file '" << argv[optind] << "'.  Reason:  "
+					  << errstr << std::endl;
+			return 1;
+		}
 	}
+	srand(random_seed);
 	
 	// Initialization
 	init_curl();
@@ -313,7 +397,16 @@ int main(int argc, char** argv)
 
 	// Fill the working set with work
 	ws.mUrl = url_format;
-	ws.loadAssetUuids(uuids);
+	ws.mMeshUrl = mesh_url_format;
+	if (uuids)
+	{
+		ws.loadAssetUuids(uuids);
+		fclose(uuids);
+	}
+	else
+	{
+		ws.makeSyntheticAssets(synthetic_count, mesh_percent);
+	}
 	ws.mRandomRange = do_random;
 	ws.mNoRange = do_whole;
 	ws.mVerbose = do_verbose;
@@ -325,6 +418,7 @@ int main(int argc, char** argv)
 		std::cerr << "No UUIDs found in file '" << argv[optind] << "'." << std::endl;
 		return 1;
 	}
+	ws.mLatencies.reserve(ws.mAssets.size());
 
 	// Setup metrics
 	Metrics metrics;
@@ -360,6 +454,25 @@ int main(int argc, char** argv)
 			  << " Bytes  Minimum VSZ: " << metrics.mMinVSZ << " Bytes"
 			  << std::endl;
 
+	// Load figures.  Latency is issue to completion as seen by this
+	// program so includes queueing in llcorehttp and the 2mS poll.
+	const U64 wall_time((std::max)(metrics.mEndWallTime - metrics.mStartWallTime, U64(1)));
+	const U64 cpu_time((metrics.mEndUTime - metrics.mStartUTime) + (metrics.mEndSTime - metrics.mStartSTime));
+	const size_t completed(ws.mLatencies.size());
+	std::cout << "Requests/S: " << (completed * 1000000.0 / wall_time)
+			  << "  Throughput: " << (ws.mByteCount * 1000000.0 / wall_time / 1024.0) << " KB/S"
+			  << "  CPU per request: " << (completed ? cpu_time / completed : U64(0)) << " uS"
+			  << std::endl;
+	if (completed)
+	{
+		std::sort(ws.mLatencies.begin(), ws.mLatencies.end());
+		std::cout << "Latency p50: " << ws.mLatencies[completed / 2]
+				  << " uS  p90: " << ws.mLatencies[(std::min)(completed - 1, completed * 90 / 100)]
+				  << " uS  p99: " << ws.mLatencies[(std::min)(completed - 1, completed * 99 / 100)]
+				  << " uS  Max: " << ws.mLatencies[completed - 1] << " uS"
+				  << std::endl;
+	}
+
 	// Clean up
 	hr->requestStopThread(LLCore::HttpHandler::ptr_t());
 	ms_sleep(1000);
@@ -376,6 +489,7 @@ void usage(std::ostream & out)
 {
 	out << "\n"
 		"usage:\thttp_texture_load [options]  uuid_file\n"
+		"\thttp_load_peer.py [server options] http_texture_load -s <count> [options]\n"
 		"\n"
 		"This is a standalone program to drive the New Platform HTTP Library.\n"
 		"The program is supplied with a file of texture UUIDs, one per line\n"
@@ -384,6 +498,10 @@ void usage(std::ostream & out)
 		"within Linden Lab but this can be overriden with a printf-style\n"
 		"URL formatting string on the command line.\n"
 		"\n"
+		"With '-s', the UUID file is replaced by a synthetic texture and mesh\n"
+		"corpus served by examples/http_load_peer.py, which sets up latency,\n"
+		"bandwidth and error injection and runs this program against it.\n"
+		"\n"
 		"Options:\n"
 		"\n"
 		" -u <url_format>       printf-style format string for URL generation\n"
@@ -398,6 +516,12 @@ void usage(std::ostream & out)
 		"                       depth on HTTP requests.  Default:  " << pipeline_depth << "\n"
 		" -t <level>            If <level> is positive ([1..3]), enables and sets HTTP\n"
 		"                       tracing on HTTP requests.  Default:  " << tracing << "\n"
+		" -s <count>            Fetch <count> assets from the synthetic corpus.\n"
+		"                       Range:  [1..1000000]\n"
+		" -m <percent>          Percentage of synthetic requests that are meshes.\n"
+		"                       Range:  [0..100]  Default:  " << mesh_percent << "\n"
+		" -S <seed>             Random seed for ranges and the synthetic mix.\n"
+		"                       Default:  " << random_seed << "\n"
 		" -v                    Verbose mode.  Issue some chatter while running\n"
 		" -h                    print this help\n"
 		"\n"
@@ -453,11 +577,12 @@ bool WorkingSet::reload(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & o
 
 	for (int i(0); i < to_do; ++i)
 	{
+		const std::string & url(mAssets[mAt].mMesh ? mMeshUrl : mUrl);
 		char buffer[1024];
 #if	defined(WIN32)
-		_snprintf_s(buffer, sizeof(buffer), sizeof(buffer) - 1, mUrl.c_str(), mAssets[mAt].mUuid.c_str());
+		_snprintf_s(buffer, sizeof(buffer), sizeof(buffer) - 1, url.c_str(), mAssets[mAt].mUuid.c_str());
 #else
-		snprintf(buffer, sizeof(buffer), mUrl.c_str(), mAssets[mAt].mUuid.c_str());
+		snprintf(buffer, sizeof(buffer), url.c_str(), mAssets[mAt].mUuid.c_str());
 #endif
 		int offset(mNoRange
 				   ? 0
@@ -484,7 +609,7 @@ bool WorkingSet::reload(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & o
 		}
 		else
 		{
-			mHandles.insert(handle);
+			mHandles[handle] = totalTime();
 		}
 		mAt++;
 		mRemaining--;
@@ -505,7 +630,7 @@ bool WorkingSet::reload(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & o
 
 void WorkingSet::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response)
 {
-	handle_set_t::iterator it(mHandles.find(handle));
+	handle_map_t::iterator it(mHandles.find(handle));
 	if (mHandles.end() == it)
 	{
 		// Wha?
@@ -514,6 +639,7 @@ void WorkingSet::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * r
 	}
 	else
 	{
+		mLatencies.push_back(totalTime() - (*it).second);
 		LLCore::HttpStatus status(response->getStatus());
 		if (status)
 		{
@@ -587,6 +713,7 @@ void WorkingSet::loadAssetUuids(FILE * in)
 			asset.mUuid = token;
 			asset.mOffset = 0;
 			asset.mLength = 0;
+			asset.mMesh = false;
 			token = strtok_r(buffer, " \t\n,", &state);
 			if (token)
 			{
@@ -606,6 +733,58 @@ void WorkingSet::loadAssetUuids(FILE * in)
 }
 
 
+// A rough copy of what the viewer asks for.  Textures mostly come
+// in as a first discard level followed later by the rest, meshes as
+// a header probe followed by one LOD.  Whole-asset fetches round it
+// out.
+void WorkingSet::makeSyntheticAssets(int count, int mesh_percent)
+{
+	static const int texture_ranges[][2] =
+		{
+			{ 0, 2048 },
+			{ 0, 16384 },
+			{ 0, 16384 },
+			{ 16384, 0 },
+			{ 0, 0 }
+		};
+	static const int mesh_ranges[][2] =
+		{
+			{ 0, 4096 },
+			{ 0, 4096 },
+			{ 4096, 65536 },
+			{ 4096, 0 }
+		};
+	
+	mAssets.reserve(count);
+	for (int i(0); i < count; ++i)
+	{
+		WorkingSet::Spec asset;
+		char buffer[64];
+
+		// A small set of ids repeated across requests, the way
+		// several objects share a texture or mesh.
+		const int id(rand() % (std::max)(1, count / 4));
+		snprintf(buffer, sizeof(buffer), "%08x-0000-4000-8000-%012x", id, id);
+		asset.mUuid = buffer;
+		asset.mMesh = (rand() % 100) < mesh_percent;
+		if (asset.mMesh)
+		{
+			const int which(rand() % LL_ARRAY_SIZE(mesh_ranges));
+			asset.mOffset = mesh_ranges[which][0];
+			asset.mLength = mesh_ranges[which][1];
+		}
+		else
+		{
+			const int which(rand() % LL_ARRAY_SIZE(texture_ranges));
+			asset.mOffset = texture_ranges[which][0];
+			asset.mLength = texture_ranges[which][1];
+		}
+		mAssets.push_back(asset);
+	}
+	mRemaining = mLimit = mAssets.size();
+}
+
+
 int ssl_mutex_count(0);
 LLCoreInt::HttpMutex ** ssl_mutex_list = NULL;
 
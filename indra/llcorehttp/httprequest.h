@@ -233,6 +233,65 @@ public:
 		/// Global only
 		PO_SSL_VERIFY_CALLBACK,
 
+		/// If greater than 1, requests in this class ask for HTTP/2
+		/// on TLS connections and libcurl multiplexes up to this many
+		/// concurrent streams on each connection to a host.  This
+		/// takes the place of PO_PIPELINING_DEPTH for the class.
+		/// Until a server has answered with HTTP/2, and for good if
+		/// it answers with HTTP/1.1 or libcurl lacks HTTP/2 support,
+		/// the class runs as if the option were 0 and
+		/// PO_CONNECTION_LIMIT governs in-flight requests.  Once
+		/// HTTP/2 is confirmed, the in-flight limit becomes
+		/// PO_PER_HOST_CONNECTION_LIMIT times this value.  Classes
+		/// have their own connections so the relative values act
+		/// as a priority hint between classes sharing a server.
+		///
+		/// Per-class only
+		PO_HTTP2_STREAMS,
+
+		/// If non-zero, a GET issued while an identical GET (same
+		/// URL, headers and reply-affecting options) is still
+		/// queued or in flight doesn't go to the network.  It
+		/// waits for the earlier request and is answered from its
+		/// reply.  A byte range contained in the earlier request's
+		/// range counts as identical.  Each request is still
+		/// notified through its own handler.  Headers-only
+		/// requests are never coalesced.
+		///
+		/// Global only
+		PO_COALESCE_REQUESTS,
+
+		/// If non-zero, the class's in-flight request limit is no
+		/// longer fixed.  It starts from the limit the other options
+		/// give and is adjusted from observed time-to-first-byte,
+		/// throughput and 503/429/timeout rates, never going above
+		/// this value.  Zero, the default, keeps the fixed limit.
+		///
+		/// Per-class only
+		PO_ADAPTIVE_CONCURRENCY,
+
+		/// All policy classes always share one DNS cache and one
+		/// TLS session cache so a host resolved or handshaken by
+		/// one class is cheap for the others.  If this is non-zero,
+		/// they also share one pool of open connections.  Limits
+		/// are still enforced per class but idle connections left
+		/// by one class can be picked up by another.  Requires
+		/// libcurl 7.57.0 or later, ignored otherwise.
+		///
+		/// Global only
+		PO_SHARE_CONNECTIONS,
+
+		/// String giving a full path to a file where TLS sessions
+		/// are saved when the service shuts down and read back when
+		/// it starts.  Lets the first connection to a known host
+		/// after a restart resume its TLS session instead of doing a
+		/// full handshake.  Empty, the default, keeps sessions in
+		/// memory only.  Requires libcurl 8.12.0 or later built with
+		/// session export, ignored otherwise.
+		///
+		/// Global only
+		PO_TLS_SESSION_FILE,
+
 		PO_LAST  // Always at end
 	};
 
@@ -42,6 +42,7 @@ HTTPStats::~HTTPStats()
 void HTTPStats::resetStats()
 {
     mResutCodes.clear();
+    mConcurrencyLimits.clear();
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
@@ -61,6 +62,32 @@ void HTTPStats::recordResultCode(S32 code)
 
 }
 
+void HTTPStats::recordConcurrencyLimit(S32 policy_class, S32 limit)
+{
+    std::map<S32, ConcurrencyLimit>::iterator it = mConcurrencyLimits.find(policy_class);
+
+    if (it == mConcurrencyLimits.end())
+    {
+        ConcurrencyLimit entry = { limit, limit, limit, 0 };
+        mConcurrencyLimits[policy_class] = entry;
+    }
+    else if ((*it).second.mCurrent != limit)
+    {
+        ConcurrencyLimit & entry = (*it).second;
+        entry.mCurrent = limit;
+        entry.mLow = llmin(entry.mLow, limit);
+        entry.mHigh = llmax(entry.mHigh, limit);
+        ++entry.mChanges;
+    }
+}
+
+S32 HTTPStats::getConcurrencyLimit(S32 policy_class) const
+{
+    std::map<S32, ConcurrencyLimit>::const_iterator it = mConcurrencyLimits.find(policy_class);
+
+    return (it == mConcurrencyLimits.end()) ? 0 : (*it).second.mCurrent;
+}
+
 namespace
 {
     std::string byte_count_converter(F32 bytes)
@@ -101,6 +128,18 @@ void HTTPStats::dumpStats()
         out << (*it).first << " " << (*it).second << std::endl;
     }
 
+    if (!mConcurrencyLimits.empty())
+    {
+        out << std::endl;
+        out << "Adaptive Concurrency (class current low high changes):" << std::endl;
+        for (std::map<S32, ConcurrencyLimit>::iterator it = mConcurrencyLimits.begin(); it != mConcurrencyLimits.end(); ++it)
+        {
+            const ConcurrencyLimit & entry = (*it).second;
+            out << (*it).first << " " << entry.mCurrent << " " << entry.mLow
+                << " " << entry.mHigh << " " << entry.mChanges << std::endl;
+        }
+    }
+
     LL_WARNS("HTTPCore") << out.str() << LL_ENDL;
 }
 
@@ -59,6 +59,12 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        /// In-flight limit chosen for a policy class by its adaptive
+        /// concurrency controller.  Classes with fixed limits don't
+        /// report.
+        void    recordConcurrencyLimit(S32 policy_class, S32 limit);
+        S32     getConcurrencyLimit(S32 policy_class) const;
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
@@ -67,6 +73,15 @@ namespace LLCore
         S32              mRequests;
 
         std::map<S32, S32> mResutCodes;
+
+        struct ConcurrencyLimit
+        {
+            S32 mCurrent;
+            S32 mLow;
+            S32 mHigh;
+            S32 mChanges;
+        };
+        std::map<S32, ConcurrencyLimit> mConcurrencyLimits;
     };
 
 
@@ -73,6 +73,7 @@ const S32 HTTP_REQUEST_URI_TOO_LARGE = 414;
 const S32 HTTP_UNSUPPORTED_MEDIA_TYPE = 415;
 const S32 HTTP_REQUESTED_RANGE_NOT_SATISFIABLE = 416;
 const S32 HTTP_EXPECTATION_FAILED = 417;
+const S32 HTTP_TOO_MANY_REQUESTS = 429;
 
 // Server Error
 const S32 HTTP_INTERNAL_SERVER_ERROR = 500;
@@ -29,6 +29,7 @@
 #include "bufferarray.h"
 
 #include <iostream>
+#include <algorithm>
 
 
 using namespace LLCore;
@@ -374,6 +375,67 @@ void BufferArrayTestObjectType::test<8>()
 	ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+	set_test_name("BufferArray reserve and getContiguous");
+
+	// create a new ref counted object with an implicit reference
+	BufferArray * ba = new BufferArray();
+
+	// Reserve room for a body larger than a single block
+	const size_t body_len(BufferArray::BLOCK_ALLOC_SIZE * 3 + 17);
+	ensure("Reservation made", ba->reserve(body_len));
+	ensure("Reservation doesn't change size", 0 == ba->size());
+	ensure("Nothing contiguous yet", NULL == ba->getContiguous(0, 1));
+
+	// Fill it in odd-sized pieces the way curl would
+	char chunk[16384 + 3];
+	size_t written(0);
+	while (written < body_len)
+	{
+		const size_t len((std::min)(sizeof(chunk), body_len - written));
+		for (size_t i(0); i < len; ++i)
+		{
+			chunk[i] = char((written + i) % 251);
+		}
+		ensure("Append whole chunk", len == ba->append(chunk, len));
+		written += len;
+	}
+	ensure("Body length correct", body_len == ba->size());
+	ensure("Second reservation refused", ! ba->reserve(body_len));
+
+	// Whole body is addressable in place
+	const char * body(static_cast<const char *>(ba->getContiguous(0, body_len)));
+	ensure("Body is contiguous", NULL != body);
+	bool same(true);
+	for (size_t i(0); same && i < body_len; ++i)
+	{
+		same = (char(i % 251) == body[i]);
+	}
+	ensure("Contiguous content correct", same);
+	ensure("Offset view correct", body + 100 == ba->getContiguous(100, body_len - 100));
+	ensure("Range past the end refused", NULL == ba->getContiguous(100, body_len));
+
+	// Overflow spills into an ordinary block
+	ensure("Overflow appended", 10 == ba->append(chunk, 10));
+	ensure("Overflow not contiguous with body", NULL == ba->getContiguous(0, body_len + 10));
+	ensure("Overflow addressable alone", NULL != ba->getContiguous(body_len, 10));
+
+	// release the implicit reference, causing the object to be released
+	ba->release();
+
+	// Without a reservation, block boundaries still split the data
+	ba = new BufferArray();
+	for (size_t i(0); i < 5; ++i)
+	{
+		ba->append(chunk, sizeof(chunk));
+	}
+	ensure("Unreserved body split", NULL == ba->getContiguous(0, ba->size()));
+	ensure("Unreserved first block addressable", NULL != ba->getContiguous(0, BufferArray::BLOCK_ALLOC_SIZE));
+	ba->release();
+}
+
 }  // end namespace tut
 
 
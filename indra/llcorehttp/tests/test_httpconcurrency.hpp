@@ -0,0 +1,182 @@
+/**
+ * @file test_httpconcurrency.hpp
+ * @brief unit tests for the LLCore::HttpConcurrency class
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#ifndef TEST_LLCORE_HTTP_CONCURRENCY_H_
+#define TEST_LLCORE_HTTP_CONCURRENCY_H_
+
+#include "_httpconcurrency.h"
+
+#include <iostream>
+
+
+using namespace LLCore;
+
+
+namespace tut
+{
+
+struct HttpConcurrencyTestData
+{
+	// the test objects inherit from this so the member functions and variables
+	// can be referenced directly inside of the test functions.
+
+	// A server that handles 'mCapacity' requests at a time in
+	// 'mLatency' microseconds each and queues anything beyond that.
+	// Returns 503s once 'mOverloadAt' requests are outstanding.
+	struct SimulatedServer
+	{
+		int mCapacity;
+		HttpTime mLatency;
+		int mOverloadAt;
+		HttpTime mNow;
+
+		SimulatedServer(int capacity, HttpTime latency, int overload_at)
+			: mCapacity(capacity),
+			  mLatency(latency),
+			  mOverloadAt(overload_at),
+			  mNow(1000000)
+			{}
+
+		// Run the controller for 'windows' half-second steps with
+		// 'demand' requests waiting.  Returns the final limit.
+		int run(HttpConcurrency & ctl, int windows, int demand)
+			{
+				const HttpTime step(500000);
+				ctl.update(mNow);
+				for (int i(0); i < windows; ++i)
+				{
+					const int in_flight((std::min)(demand, ctl.getLimit()));
+					const HttpTime latency(mLatency * (std::max)(1, (in_flight + mCapacity - 1) / mCapacity));
+					const int completed(int(in_flight * step / latency));
+					const bool overload(in_flight >= mOverloadAt);
+
+					ctl.onDispatch(in_flight);
+					for (int c(0); c < completed; ++c)
+					{
+						ctl.onComplete(latency, 16384, overload);
+					}
+					mNow += step;
+					ctl.update(mNow);
+				}
+				return ctl.getLimit();
+			}
+	};
+};
+
+typedef test_group<HttpConcurrencyTestData> HttpConcurrencyTestGroupType;
+typedef HttpConcurrencyTestGroupType::object HttpConcurrencyTestObjectType;
+HttpConcurrencyTestGroupType HttpConcurrencyTestGroup("HttpConcurrency Tests");
+
+template <> template <>
+void HttpConcurrencyTestObjectType::test<1>()
+{
+	set_test_name("HttpConcurrency construction and reset");
+
+	HttpConcurrency ctl;
+	ensure("Not running until reset", ! ctl.isRunning());
+	ensure("Idle update does nothing", ! ctl.update(2000000));
+
+	ctl.reset(500, 2, 64);
+	ensure("Running after reset", ctl.isRunning());
+	ensure_equals("Initial limit clamped to max", ctl.getLimit(), 64);
+	ensure_equals("Max limit retained", ctl.getMaxLimit(), 64);
+
+	ctl.reset(0, 2, 64);
+	ensure_equals("Initial limit clamped to min", ctl.getLimit(), 2);
+}
+
+template <> template <>
+void HttpConcurrencyTestObjectType::test<2>()
+{
+	set_test_name("HttpConcurrency grows toward server capacity");
+
+	HttpConcurrency ctl;
+	SimulatedServer server(16, 50000, 1000);
+	ctl.reset(4, 2, 256);
+
+	const int limit(server.run(ctl, 120, 1000));
+	ensure("Limit grew past the initial value", limit >= 12);
+	ensure("Limit stays near capacity", limit <= 40);
+}
+
+template <> template <>
+void HttpConcurrencyTestObjectType::test<3>()
+{
+	set_test_name("HttpConcurrency backs off on overload");
+
+	HttpConcurrency ctl;
+	SimulatedServer server(64, 50000, 24);
+	ctl.reset(48, 2, 256);
+
+	server.run(ctl, 1, 1000);
+	ensure("Single overloaded window cuts the limit", ctl.getLimit() < 48);
+
+	const int limit(server.run(ctl, 120, 1000));
+	ensure("Limit settles below the overload point", limit < 24 * 1.34);
+	ensure("Limit doesn't collapse", limit >= 8);
+}
+
+template <> template <>
+void HttpConcurrencyTestObjectType::test<4>()
+{
+	set_test_name("HttpConcurrency doesn't grow without demand");
+
+	HttpConcurrency ctl;
+	SimulatedServer server(64, 50000, 1000);
+	ctl.reset(16, 2, 256);
+
+	const int limit(server.run(ctl, 60, 4));
+	ensure_equals("Limit held with little demand", limit, 16);
+}
+
+template <> template <>
+void HttpConcurrencyTestObjectType::test<5>()
+{
+	set_test_name("HttpConcurrency ignores failures without a reply");
+
+	HttpConcurrency ctl;
+	ctl.reset(16, 2, 256);
+	HttpTime now(1000000);
+	ctl.update(now);
+
+	for (int i(0); i < 8; ++i)
+	{
+		ctl.onComplete(0, 0, false);
+	}
+	now += 600000;
+	ensure("Failures alone don't close a window", ! ctl.update(now));
+
+	for (int i(0); i < 8; ++i)
+	{
+		ctl.onComplete(40000, 16384, false);
+	}
+	now += 100000;
+	ensure("Window closes on replies", ctl.update(now));
+	ensure_equals("Latency from replies only", ctl.getWindowLatency(), HttpTime(40000));
+}
+
+}  // end namespace tut
+
+#endif  // TEST_LLCORE_HTTP_CONCURRENCY_H_
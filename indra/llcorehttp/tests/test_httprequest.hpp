@@ -3056,6 +3056,417 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+	ScopedCurlInit ready;
+
+	std::string url_base(get_base_url());
+
+	set_test_name("HttpRequest GETs with HTTP/2 multiplexing against an HTTP/1.1 server");
+
+	// The test server only speaks HTTP/1.1 over plain http: so this
+	// exercises the fallback path.  Every request must still complete
+	// and the class must settle on HTTP/1.1 rather than stalling on
+	// the larger multiplexed in-flight limit.
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	// Create before memory record as the string copy will bump numbers.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+        // Get singletons created
+		HttpRequest::createService();
+
+		// Ask for multiplexing on the default class
+		HttpStatus status;
+		long streams(0);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS,
+													HttpRequest::DEFAULT_POLICY_ID,
+													8,
+													&streams);
+		ensure("HTTP/2 streams option accepted", bool(status));
+		ensure_equals("HTTP/2 streams option value", streams, 8L);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS,
+													HttpRequest::GLOBAL_POLICY_ID,
+													8,
+													NULL);
+		ensure("HTTP/2 streams option is per-class only", ! status);
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Issue a batch of GETs, more than the connection limit
+		mStatus = HttpStatus(200);
+		const int url_limit(12);
+		for (int i(0); i < url_limit; ++i)
+		{
+			HttpHandle handle = req->requestGetByteRange(HttpRequest::DEFAULT_POLICY_ID,
+														 0U,
+														 url_base,
+														 0,
+														 0,
+														 HttpOptions::ptr_t(),
+														 HttpHeaders::ptr_t(),
+														 handlerp);
+			ensure("Valid handle returned for ranged request", handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < url_limit)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure("One handler invocation for each request", mHandlerCalls == url_limit);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+template <> template <>
+void HttpRequestTestObjectType::test<25>()
+{
+	ScopedCurlInit ready;
+
+	std::string url_base(get_base_url());
+
+	set_test_name("HttpRequest coalescing of identical GETs");
+
+	// Collects the reply bodies so we can see which requests
+	// were answered from the same reply.
+	class BodyHandler : public LLCore::HttpHandler
+	{
+	public:
+		BodyHandler()
+			: mCalls(0)
+			{}
+
+		~BodyHandler()
+			{
+				for (int i(0); i < mBodies.size(); ++i)
+				{
+					if (mBodies[i])
+					{
+						mBodies[i]->release();
+					}
+				}
+			}
+
+		virtual void onCompleted(HttpHandle handle, HttpResponse * response)
+			{
+				ensure("Coalesced request succeeded", response && response->getStatus() == HttpStatus(200));
+				BufferArray * body(response ? response->getBody() : NULL);
+				if (body)
+				{
+					body->addRef();
+				}
+				mHandles.push_back(handle);
+				mBodies.push_back(body);
+				++mCalls;
+			}
+
+		int mCalls;
+		std::vector<HttpHandle> mHandles;
+		std::vector<BufferArray *> mBodies;
+	};
+
+	BodyHandler handler;
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	TestHandler2 stop_handler(this, "handler");
+    LLCore::HttpHandler::ptr_t stop_handlerp(&stop_handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+        // Get singletons created
+		HttpRequest::createService();
+
+		HttpStatus status;
+		long coalesce(0);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_COALESCE_REQUESTS,
+													HttpRequest::GLOBAL_POLICY_ID,
+													1,
+													&coalesce);
+		ensure("Coalesce option accepted", bool(status));
+		ensure_equals("Coalesce option value", coalesce, 1L);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_COALESCE_REQUESTS,
+													HttpRequest::DEFAULT_POLICY_ID,
+													1,
+													NULL);
+		ensure("Coalesce option is global only", ! status);
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Three identical GETs and one that differs by a header
+		HttpHandle handles[4];
+		for (int i(0); i < 3; ++i)
+		{
+			handles[i] = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+										 0U,
+										 url_base,
+										 HttpOptions::ptr_t(),
+										 HttpHeaders::ptr_t(),
+										 handlerp);
+			ensure("Valid handle returned for GET", handles[i] != LLCORE_HTTP_HANDLE_INVALID);
+		}
+		HttpHeaders::ptr_t headers(new HttpHeaders);
+		headers->append("Accept", "text/plain");
+		handles[3] = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+									 0U,
+									 url_base,
+									 HttpOptions::ptr_t(),
+									 headers,
+									 handlerp);
+		ensure("Valid handle returned for GET with headers", handles[3] != LLCORE_HTTP_HANDLE_INVALID);
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && handler.mCalls < 4)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure_equals("One handler invocation for each request", handler.mCalls, 4);
+
+		BufferArray * bodies[4] = { NULL, NULL, NULL, NULL };
+		for (int i(0); i < handler.mCalls; ++i)
+		{
+			for (int j(0); j < 4; ++j)
+			{
+				if (handler.mHandles[i] == handles[j])
+				{
+					bodies[j] = handler.mBodies[i];
+				}
+			}
+		}
+		ensure("Body received", bodies[0] != NULL && bodies[0]->size() > 0);
+		ensure("Identical GETs share one reply", bodies[0] == bodies[1] && bodies[0] == bodies[2]);
+		ensure("Different headers get their own reply", bodies[3] != NULL && bodies[3] != bodies[0]);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		HttpHandle handle = req->requestStopThread(stop_handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+template <> template <>
+void HttpRequestTestObjectType::test<26>()
+{
+	ScopedCurlInit ready;
+
+	std::string url_base(get_base_url());
+
+	set_test_name("HttpRequest GETs from two classes sharing caches and connections");
+
+	// Handler can be stack-allocated *if* there are no dangling
+	// references to it after completion of this method.
+	// Create before memory record as the string copy will bump numbers.
+	TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+        // Get singletons created
+		HttpRequest::createService();
+
+		HttpStatus status;
+		long share(0);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_SHARE_CONNECTIONS,
+													HttpRequest::GLOBAL_POLICY_ID,
+													1,
+													&share);
+		ensure("Share option accepted", bool(status));
+		ensure_equals("Share option value", share, 1L);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_SHARE_CONNECTIONS,
+													HttpRequest::DEFAULT_POLICY_ID,
+													1,
+													NULL);
+		ensure("Share option is global only", ! status);
+		std::string session_file;
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_TLS_SESSION_FILE,
+													HttpRequest::GLOBAL_POLICY_ID,
+													std::string(),
+													&session_file);
+		ensure("TLS session file option accepted", bool(status));
+		ensure("TLS session file empty", session_file.empty());
+
+		HttpRequest::policy_t second_class(HttpRequest::createPolicyClass());
+		ensure("Second policy class created", second_class != HttpRequest::INVALID_POLICY_ID);
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Alternate classes against the one server so connections
+		// and resolutions get handed back and forth
+		mStatus = HttpStatus(200);
+		const int url_limit(8);
+		for (int i(0); i < url_limit; ++i)
+		{
+			HttpHandle handle = req->requestGet((i & 1) ? second_class : HttpRequest::DEFAULT_POLICY_ID,
+												0U,
+												url_base,
+												HttpOptions::ptr_t(),
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for GET", handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && mHandlerCalls < url_limit)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure("One handler invocation for each request", mHandlerCalls == url_limit);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		mHandlerCalls = 0;
+		HttpHandle handle = req->requestStopThread(handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+	
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
 }  // end namespace tut
 
 namespace
@@ -34,6 +34,13 @@
 
 #define MAX_ENCODED_DISCARD_LEVELS 5
 
+// Internal buffer size for decode streams.  OpenJPEG stages reads
+// smaller than this through its own buffer but hands larger ones
+// (tile-part bodies) straight to opj_read(), so keeping it small
+// lets the codestream be copied once, from the image data into the
+// tile, rather than staged through a buffer the size of the file.
+static const OPJ_SIZE_T DECODE_STREAM_CHUNK_SIZE = 16 * 1024;
+
 // Factory function: see declaration in llimagej2c.cpp
 LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl()
 {
@@ -283,7 +290,7 @@ public:
             opj_stream_destroy(stream);
         }
 
-        stream = opj_stream_create(dataSize, true);
+        stream = opj_stream_create(llmin((OPJ_SIZE_T)dataSize, DECODE_STREAM_CHUNK_SIZE), true);
         if (!stream)
         {
             return false;
@@ -352,7 +359,7 @@ public:
             opj_stream_destroy(stream);
         }
 
-        stream = opj_stream_create(dataSize, true);
+        stream = opj_stream_create(llmin((OPJ_SIZE_T)dataSize, DECODE_STREAM_CHUNK_SIZE), true);
         if (!stream)
         {
             return false;
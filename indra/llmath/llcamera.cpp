@@ -28,6 +28,17 @@
 
 #include "llmath.h"
 #include "llcamera.h"
+#include "llprocessor.h"
+
+#include <immintrin.h>
+
+// GCC and clang only emit AVX instructions in functions that ask for them;
+// MSVC allows the intrinsics anywhere.
+#if LL_GNUC || LL_CLANG
+#define LL_TARGET_AVX __attribute__((target("avx")))
+#else
+#define LL_TARGET_AVX
+#endif
 
 // ---------------- Constructors and destructors ----------------
 
@@ -296,6 +307,259 @@ S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVec
 	return AABBInFrustumNoFarClip(center, radius, mRegionPlanes);
 }
 
+//-----------------------------------------------------------------------------
+// Batch AABB culling
+//
+// The kernels below evaluate the same expressions as AABBInFrustum, in the
+// same order and without fused multiply-adds, for 4 (SSE2) or 8 (AVX) boxes
+// at a time, so the batch and single box tests agree bit for bit.
+
+namespace
+{
+	// A frustum plane splatted for the batch kernels
+	struct BatchPlane
+	{
+		F32 mNormal[3];
+		F32 mNegD;
+		F32 mScale[3];	// sFrustumScaler entry for the plane's octant mask
+	};
+
+	const U32 BATCH_BLOCK = 8;
+
+	typedef void (*cull_block_fn)(const BatchPlane* planes, U32 plane_count,
+								  const F32* const center[3], const F32* const radius[3], U32 offset,
+								  U32& outside_bits, U32& partial_bits);
+
+	void cull_block_sse2(const BatchPlane* planes, U32 plane_count,
+						 const F32* const center[3], const F32* const radius[3], U32 offset,
+						 U32& outside_bits, U32& partial_bits)
+	{
+		outside_bits = 0;
+		partial_bits = 0;
+
+		for (U32 half = 0; half < BATCH_BLOCK; half += 4)
+		{
+			const U32 idx = offset + half;
+			const __m128 cx = _mm_loadu_ps(center[0] + idx);
+			const __m128 cy = _mm_loadu_ps(center[1] + idx);
+			const __m128 cz = _mm_loadu_ps(center[2] + idx);
+			const __m128 rx = _mm_loadu_ps(radius[0] + idx);
+			const __m128 ry = _mm_loadu_ps(radius[1] + idx);
+			const __m128 rz = _mm_loadu_ps(radius[2] + idx);
+
+			__m128 outside = _mm_setzero_ps();
+			__m128 partial = _mm_setzero_ps();
+
+			for (U32 i = 0; i < plane_count; ++i)
+			{
+				const BatchPlane& p = planes[i];
+				const __m128 nx = _mm_set1_ps(p.mNormal[0]);
+				const __m128 ny = _mm_set1_ps(p.mNormal[1]);
+				const __m128 nz = _mm_set1_ps(p.mNormal[2]);
+				const __m128 neg_d = _mm_set1_ps(p.mNegD);
+
+				const __m128 sx = _mm_mul_ps(rx, _mm_set1_ps(p.mScale[0]));
+				const __m128 sy = _mm_mul_ps(ry, _mm_set1_ps(p.mScale[1]));
+				const __m128 sz = _mm_mul_ps(rz, _mm_set1_ps(p.mScale[2]));
+
+				// (x + y) + z, as LLVector4a::dot3
+				__m128 dmin = _mm_add_ps(_mm_mul_ps(nx, _mm_sub_ps(cx, sx)), _mm_mul_ps(ny, _mm_sub_ps(cy, sy)));
+				dmin = _mm_add_ps(dmin, _mm_mul_ps(nz, _mm_sub_ps(cz, sz)));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(dmin, neg_d));
+
+				__m128 dmax = _mm_add_ps(_mm_mul_ps(nx, _mm_add_ps(cx, sx)), _mm_mul_ps(ny, _mm_add_ps(cy, sy)));
+				dmax = _mm_add_ps(dmax, _mm_mul_ps(nz, _mm_add_ps(cz, sz)));
+				partial = _mm_or_ps(partial, _mm_cmpgt_ps(dmax, neg_d));
+			}
+
+			outside_bits |= (U32) _mm_movemask_ps(outside) << half;
+			partial_bits |= (U32) _mm_movemask_ps(partial) << half;
+		}
+	}
+
+	LL_TARGET_AVX void cull_block_avx(const BatchPlane* planes, U32 plane_count,
+									  const F32* const center[3], const F32* const radius[3], U32 offset,
+									  U32& outside_bits, U32& partial_bits)
+	{
+		const __m256 cx = _mm256_loadu_ps(center[0] + offset);
+		const __m256 cy = _mm256_loadu_ps(center[1] + offset);
+		const __m256 cz = _mm256_loadu_ps(center[2] + offset);
+		const __m256 rx = _mm256_loadu_ps(radius[0] + offset);
+		const __m256 ry = _mm256_loadu_ps(radius[1] + offset);
+		const __m256 rz = _mm256_loadu_ps(radius[2] + offset);
+
+		__m256 outside = _mm256_setzero_ps();
+		__m256 partial = _mm256_setzero_ps();
+
+		for (U32 i = 0; i < plane_count; ++i)
+		{
+			const BatchPlane& p = planes[i];
+			const __m256 nx = _mm256_set1_ps(p.mNormal[0]);
+			const __m256 ny = _mm256_set1_ps(p.mNormal[1]);
+			const __m256 nz = _mm256_set1_ps(p.mNormal[2]);
+			const __m256 neg_d = _mm256_set1_ps(p.mNegD);
+
+			const __m256 sx = _mm256_mul_ps(rx, _mm256_set1_ps(p.mScale[0]));
+			const __m256 sy = _mm256_mul_ps(ry, _mm256_set1_ps(p.mScale[1]));
+			const __m256 sz = _mm256_mul_ps(rz, _mm256_set1_ps(p.mScale[2]));
+
+			__m256 dmin = _mm256_add_ps(_mm256_mul_ps(nx, _mm256_sub_ps(cx, sx)), _mm256_mul_ps(ny, _mm256_sub_ps(cy, sy)));
+			dmin = _mm256_add_ps(dmin, _mm256_mul_ps(nz, _mm256_sub_ps(cz, sz)));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(dmin, neg_d, _CMP_GT_OS));
+
+			__m256 dmax = _mm256_add_ps(_mm256_mul_ps(nx, _mm256_add_ps(cx, sx)), _mm256_mul_ps(ny, _mm256_add_ps(cy, sy)));
+			dmax = _mm256_add_ps(dmax, _mm256_mul_ps(nz, _mm256_add_ps(cz, sz)));
+			partial = _mm256_or_ps(partial, _mm256_cmp_ps(dmax, neg_d, _CMP_GT_OS));
+		}
+
+		outside_bits = (U32) _mm256_movemask_ps(outside);
+		partial_bits = (U32) _mm256_movemask_ps(partial);
+	}
+
+	struct BatchCullKernel
+	{
+		bool mAVX;
+		cull_block_fn mCullBlock;
+
+		BatchCullKernel()
+		{
+			LLProcessorInfo info;
+			set(info.hasAVX());
+		}
+
+		void set(bool avx)
+		{
+			mAVX = avx;
+			mCullBlock = avx ? cull_block_avx : cull_block_sse2;
+		}
+	};
+
+	BatchCullKernel& batch_cull_kernel()
+	{
+		static BatchCullKernel kernel;
+		return kernel;
+	}
+}
+
+//static
+bool LLCamera::setBatchCullAVX(bool enable)
+{
+	if (enable)
+	{
+		LLProcessorInfo info;
+		if (!info.hasAVX())
+		{
+			return false;
+		}
+	}
+
+	batch_cull_kernel().set(enable);
+	return true;
+}
+
+//static
+bool LLCamera::getBatchCullAVX()
+{
+	return batch_cull_kernel().mAVX;
+}
+
+void LLCamera::AABBInFrustumBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+								  U32* visible, U32* partial, const LLPlane* planes)
+{
+	AABBInFrustumBatch(center, radius, count, visible, partial, planes, true);
+}
+
+void LLCamera::AABBInFrustumNoFarClipBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+										   U32* visible, U32* partial, const LLPlane* planes)
+{
+	AABBInFrustumBatch(center, radius, count, visible, partial, planes, false);
+}
+
+//exactly same as AABBInFrustumBatch(...) and AABBInFrustumNoFarClipBatch(...)
+//except uses mRegionPlanes instead of mAgentPlanes.
+void LLCamera::AABBInRegionFrustumBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+										U32* visible, U32* partial)
+{
+	AABBInFrustumBatch(center, radius, count, visible, partial, mRegionPlanes, true);
+}
+
+void LLCamera::AABBInRegionFrustumNoFarClipBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+												 U32* visible, U32* partial)
+{
+	AABBInFrustumBatch(center, radius, count, visible, partial, mRegionPlanes, false);
+}
+
+void LLCamera::AABBInFrustumBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+								  U32* visible, U32* partial, const LLPlane* planes, bool far_clip)
+{
+	if(!planes)
+	{
+		//use agent space
+		planes = mAgentPlanes;
+	}
+
+	BatchPlane batch_planes[AGENT_PLANE_USER_CLIP_NUM];
+	U32 plane_count = 0;
+	U32 max_planes = llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM);
+	for (U32 i = 0; i < max_planes; i++)
+	{
+		U8 mask = mPlaneMask[i];
+		if ((far_clip || i != AGENT_PLANE_FAR) && mask < PLANE_MASK_NUM)
+		{
+			BatchPlane& bp = batch_planes[plane_count++];
+			for (U32 j = 0; j < 3; j++)
+			{
+				bp.mNormal[j] = planes[i][j];
+				bp.mScale[j] = sFrustumScaler[mask][j];
+			}
+			bp.mNegD = -planes[i][3];
+		}
+	}
+
+	cull_block_fn cull_block = batch_cull_kernel().mCullBlock;
+
+	U32 words = (count + 31) / 32;
+	for (U32 i = 0; i < words; i++)
+	{
+		visible[i] = 0;
+		partial[i] = 0;
+	}
+
+	U32 outside_bits, partial_bits;
+	U32 full_count = count & ~(BATCH_BLOCK - 1);
+	for (U32 i = 0; i < full_count; i += BATCH_BLOCK)
+	{
+		cull_block(batch_planes, plane_count, center, radius, i, outside_bits, partial_bits);
+
+		U32 shift = i & 31;
+		visible[i >> 5] |= (~outside_bits & 0xff) << shift;
+		partial[i >> 5] |= (partial_bits & ~outside_bits & 0xff) << shift;
+	}
+
+	if (full_count < count)
+	{	// copy the tail into a zero padded block
+		U32 tail = count - full_count;
+		F32 tail_data[6][BATCH_BLOCK];
+		const F32* tail_center[3] = { tail_data[0], tail_data[1], tail_data[2] };
+		const F32* tail_radius[3] = { tail_data[3], tail_data[4], tail_data[5] };
+		for (U32 j = 0; j < 3; j++)
+		{
+			for (U32 k = 0; k < BATCH_BLOCK; k++)
+			{
+				tail_data[j][k] = k < tail ? center[j][full_count + k] : 0.f;
+				tail_data[j + 3][k] = k < tail ? radius[j][full_count + k] : 0.f;
+			}
+		}
+
+		cull_block(batch_planes, plane_count, tail_center, tail_radius, 0, outside_bits, partial_bits);
+
+		U32 tail_mask = (1 << tail) - 1;
+		U32 shift = full_count & 31;
+		visible[full_count >> 5] |= (~outside_bits & tail_mask) << shift;
+		partial[full_count >> 5] |= (partial_bits & ~outside_bits & tail_mask) << shift;
+	}
+}
+
 int LLCamera::sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius) 
 {
 	LLVector3 dist = sphere_center-mFrustCenter;
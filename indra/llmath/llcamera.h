@@ -209,6 +209,27 @@ public:
 	S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
 	S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
 
+	// Batch versions of AABBInFrustum and AABBInFrustumNoFarClip.  Tests
+	// count boxes given as separate x, y and z arrays of centers and radii
+	// (structure of arrays) and writes one bit per box into visible and
+	// partial, which must hold (count + 31) / 32 words.  Bit i of visible is
+	// set if box i is at least partially inside, bit i of partial if it is
+	// also not fully inside, matching the 0/1/2 results of the single box
+	// tests exactly.
+	void AABBInFrustumBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+							U32* visible, U32* partial, const LLPlane* planes = NULL);
+	void AABBInFrustumNoFarClipBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+									 U32* visible, U32* partial, const LLPlane* planes = NULL);
+	void AABBInRegionFrustumBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+								  U32* visible, U32* partial);
+	void AABBInRegionFrustumNoFarClipBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+										   U32* visible, U32* partial);
+
+	// Use the AVX kernels for the batch tests (default where supported).
+	// Returns false if enable is true and the CPU has no AVX.
+	static bool setBatchCullAVX(bool enable);
+	static bool getBatchCullAVX();
+
 	//does a quick 'n dirty sphere-sphere check
 	S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius); 
 
@@ -228,6 +249,8 @@ protected:
 	void calculateFrustumPlanes(F32 left, F32 right, F32 top, F32 bottom);
 	void calculateFrustumPlanesFromWindow(F32 x1, F32 y1, F32 x2, F32 y2);
 	void calculateWorldFrustumPlanes();
+	void AABBInFrustumBatch(const F32* const center[3], const F32* const radius[3], U32 count,
+							U32* visible, U32* partial, const LLPlane* planes, bool far_clip);
 } LL_ALIGN_POSTFIX(16);
 
 
@@ -26,6 +26,194 @@
 
 #include "llmath.h"
 #include "llmatrix4a.h"
+#include "llprocessor.h"
+
+#include <immintrin.h>
+
+// GCC and clang only emit AVX instructions in functions that ask for them;
+// MSVC allows the intrinsics anywhere.
+#if LL_GNUC || LL_CLANG
+#define LL_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#else
+#define LL_TARGET_AVX2_FMA
+#endif
+
+namespace
+{
+	typedef void (*transform_batch_fn)(const LLMatrix4a& mat, const LLVector4a* src, LLVector4a* dst, U32 count);
+	typedef void (*mat_mul_batch_fn)(const LLMatrix4a* a, const LLMatrix4a* b, LLMatrix4a* res, U32 count);
+
+	void affine_transform_sse2(const LLMatrix4a& mat, const LLVector4a* src, LLVector4a* dst, U32 count)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			mat.affineTransformSSE(src[i], dst[i]);
+		}
+	}
+
+	void rotate_sse2(const LLMatrix4a& mat, const LLVector4a* src, LLVector4a* dst, U32 count)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			mat.rotate(src[i], dst[i]);
+		}
+	}
+
+	void mat_mul_sse2(const LLMatrix4a* a, const LLMatrix4a* b, LLMatrix4a* res, U32 count)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			matMulUnsafe(a[i], b[i], res[i]);
+		}
+	}
+
+	// The AVX2 kernels work on two LLVector4a at a time, one per 128 bit
+	// lane, against matrix rows broadcast to both lanes.
+
+	LL_TARGET_AVX2_FMA void affine_transform_avx2(const LLMatrix4a& mat, const LLVector4a* src, LLVector4a* dst, U32 count)
+	{
+		const __m256 row0 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[0]);
+		const __m256 row1 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[1]);
+		const __m256 row2 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[2]);
+		const __m256 row3 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[3]);
+
+		U32 i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m256 v = _mm256_loadu_ps(src[i].getF32ptr());
+			__m256 res = _mm256_fmadd_ps(_mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)), row0, row3);
+			res = _mm256_fmadd_ps(_mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)), row1, res);
+			res = _mm256_fmadd_ps(_mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)), row2, res);
+			_mm256_storeu_ps(dst[i].getF32ptr(), res);
+		}
+
+		if (i < count)
+		{
+			mat.affineTransformSSE(src[i], dst[i]);
+		}
+	}
+
+	LL_TARGET_AVX2_FMA void rotate_avx2(const LLMatrix4a& mat, const LLVector4a* src, LLVector4a* dst, U32 count)
+	{
+		const __m256 row0 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[0]);
+		const __m256 row1 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[1]);
+		const __m256 row2 = _mm256_broadcast_ps((const __m128*) &mat.mMatrix[2]);
+
+		U32 i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m256 v = _mm256_loadu_ps(src[i].getF32ptr());
+			__m256 res = _mm256_mul_ps(_mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+			res = _mm256_fmadd_ps(_mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1)), row1, res);
+			res = _mm256_fmadd_ps(_mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2)), row2, res);
+			_mm256_storeu_ps(dst[i].getF32ptr(), res);
+		}
+
+		if (i < count)
+		{
+			mat.rotate(src[i], dst[i]);
+		}
+	}
+
+	LL_TARGET_AVX2_FMA void mat_mul_avx2(const LLMatrix4a* a, const LLMatrix4a* b, LLMatrix4a* res, U32 count)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			const F32* lhs = a[i].getF32ptr();
+			F32* out = res[i].getF32ptr();
+
+			const __m256 b0 = _mm256_broadcast_ps((const __m128*) &b[i].mMatrix[0]);
+			const __m256 b1 = _mm256_broadcast_ps((const __m128*) &b[i].mMatrix[1]);
+			const __m256 b2 = _mm256_broadcast_ps((const __m128*) &b[i].mMatrix[2]);
+			const __m256 b3 = _mm256_broadcast_ps((const __m128*) &b[i].mMatrix[3]);
+
+			// rows 0 and 1, then rows 2 and 3 of a, each row as in rowMul()
+			for (U32 r = 0; r < 16; r += 8)
+			{
+				const __m256 rows = _mm256_loadu_ps(lhs + r);
+				__m256 m = _mm256_mul_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+				m = _mm256_fmadd_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(1, 1, 1, 1)), b1, m);
+				m = _mm256_fmadd_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(2, 2, 2, 2)), b2, m);
+				m = _mm256_fmadd_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(3, 3, 3, 3)), b3, m);
+				_mm256_storeu_ps(out + r, m);
+			}
+		}
+	}
+
+	struct BatchKernels
+	{
+		LLMatrix4a::EBatchKernel mKernel;
+		transform_batch_fn mAffineTransform;
+		transform_batch_fn mRotate;
+		mat_mul_batch_fn mMatMul;
+
+		BatchKernels()
+		{
+			LLProcessorInfo info;
+			set(info.hasAVX2() && info.hasFMA3() ? LLMatrix4a::KERNEL_AVX2_FMA : LLMatrix4a::KERNEL_SSE2);
+		}
+
+		void set(LLMatrix4a::EBatchKernel kernel)
+		{
+			mKernel = kernel;
+			if (kernel == LLMatrix4a::KERNEL_AVX2_FMA)
+			{
+				mAffineTransform = affine_transform_avx2;
+				mRotate = rotate_avx2;
+				mMatMul = mat_mul_avx2;
+			}
+			else
+			{
+				mAffineTransform = affine_transform_sse2;
+				mRotate = rotate_sse2;
+				mMatMul = mat_mul_sse2;
+			}
+		}
+	};
+
+	BatchKernels& batch_kernels()
+	{
+		static BatchKernels kernels;
+		return kernels;
+	}
+}
+
+void LLMatrix4a::affineTransform(const LLVector4a* src, LLVector4a* dst, U32 count) const
+{
+	batch_kernels().mAffineTransform(*this, src, dst, count);
+}
+
+void LLMatrix4a::rotate(const LLVector4a* src, LLVector4a* dst, U32 count) const
+{
+	batch_kernels().mRotate(*this, src, dst, count);
+}
+
+//static
+LLMatrix4a::EBatchKernel LLMatrix4a::getBatchKernel()
+{
+	return batch_kernels().mKernel;
+}
+
+//static
+bool LLMatrix4a::setBatchKernel(EBatchKernel kernel)
+{
+	if (kernel == KERNEL_AVX2_FMA)
+	{
+		LLProcessorInfo info;
+		if (!info.hasAVX2() || !info.hasFMA3())
+		{
+			return false;
+		}
+	}
+
+	batch_kernels().set(kernel);
+	return true;
+}
+
+void matMulBatch(const LLMatrix4a* a, const LLMatrix4a* b, LLMatrix4a* res, U32 count)
+{
+	batch_kernels().mMatMul(a, b, res, count);
+}
 
 // Convert a bounding box into other coordinate system. Should give
 // the same results as transforming every corner of the bounding box
@@ -64,10 +252,7 @@ void matMulBoundBox(const LLMatrix4a &mat, const LLVector4a *in_extents, LLVecto
 		LLVector4a tv[8];
 
 		//transform bounding box into drawable space
-		for (U32 i = 0; i < 8; ++i)
-		{
-			mat.affineTransform(v[i], tv[i]);
-		}
+		mat.affineTransform(v, tv, 8);
 	
 		//find bounding box
 		out_extents[0] = out_extents[1] = tv[0];
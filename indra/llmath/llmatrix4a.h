@@ -187,6 +187,24 @@ public:
         affineTransformSSE(v,res);
     }
 
+    // Batch versions of affineTransform and rotate for count vectors.  dst
+    // may be the same array as src.  Uses an AVX2/FMA kernel when the CPU
+    // supports it, see setBatchKernel().
+    void affineTransform(const LLVector4a* src, LLVector4a* dst, U32 count) const;
+    void rotate(const LLVector4a* src, LLVector4a* dst, U32 count) const;
+
+    enum EBatchKernel
+    {
+        KERNEL_SSE2,
+        KERNEL_AVX2_FMA
+    };
+
+    // Kernel used by the batch functions.  Picked from LLProcessorInfo on
+    // first use; setBatchKernel() overrides it for tests and benchmarks and
+    // returns false (leaving the kernel unchanged) if the CPU can't run it.
+    static EBatchKernel getBatchKernel();
+    static bool setBatchKernel(EBatchKernel kernel);
+
     const LLVector4a& getTranslation() const { return mMatrix[3]; }
 };
 
@@ -228,6 +246,10 @@ inline std::ostream& operator<<(std::ostream& s, const LLMatrix4a& m)
     return s;
 } 
 
+// Batch matMulUnsafe: res[i] = a[i] * b[i] for count matrices, used for
+// skinning palettes.  res must not overlap a or b.
+void matMulBatch(const LLMatrix4a* a, const LLMatrix4a* b, LLMatrix4a* res, U32 count);
+
 void matMulBoundBox(const LLMatrix4a &a, const LLVector4a *in_extents, LLVector4a *out_extents);
 
 #endif
@@ -890,4 +890,86 @@ void LLOctreeTravelerDepthFirst<T, T_PTR>::traverse(const LLOctreeNode<T, T_PTR>
 	node->accept(this);
 }
 
+//========================
+//		LLOctreeLinear
+//========================
+
+// Read-only snapshot of an octree laid out breadth first in one contiguous
+// node array.  The children of a node are stored back to back and found by
+// index, so a full traversal walks one array front to back instead of chasing
+// child pointers scattered across the heap.  Elements are not copied, culling
+// only needs to know how many a node holds.
+//
+// The snapshot does not track changes to the source tree.  Owners must call
+// build() again after any insertion, removal or restructuring before using it
+// (see LLViewerOctreePartition::getLinearOctree).
+template <class T, typename T_PTR>
+class LLOctreeLinear
+{
+public:
+	typedef LLOctreeNode<T, T_PTR> oct_node;
+
+	struct Node
+	{
+		const oct_node*    mNode;
+		LLTreeListener<T>* mListener;     // first listener of mNode, or NULL
+		U32                mFirstChild;   // index of the first child in the node array
+		U32                mChildCount;
+		U32                mElementCount;
+	};
+
+	LLOctreeLinear() : mElementCount(0) {}
+
+	// (Re)build the snapshot from root and everything below it
+	void build(const oct_node* root);
+	void clear()                                { mNodes.clear(); mElementCount = 0; }
+
+	bool isEmpty() const                        { return mNodes.empty(); }
+	U32 getNodeCount() const                    { return (U32)mNodes.size(); }
+	const Node& getNode(U32 index) const        { return mNodes[index]; }
+	U32 getElementCount() const                 { return mElementCount; }
+
+private:
+	LLOctreeLinear(const LLOctreeLinear& rhs);
+	const LLOctreeLinear& operator=(const LLOctreeLinear& rhs);
+
+	std::vector<Node> mNodes;
+	U32               mElementCount;
+};
+
+template <class T, typename T_PTR>
+void LLOctreeLinear<T, T_PTR>::build(const oct_node* root)
+{
+	// clear() keeps the capacity of the node array, so rebuilding a tree
+	// that has not grown does not allocate
+	clear();
+
+	if (!root)
+	{
+		return;
+	}
+
+	Node root_node = { root, NULL, 0, 0, 0 };
+	mNodes.push_back(root_node);
+
+	// mNodes doubles as the breadth first queue
+	for (U32 i = 0; i < mNodes.size(); ++i)
+	{
+		const oct_node* node = mNodes[i].mNode;
+
+		mNodes[i].mListener = node->getListener(0);
+		mNodes[i].mElementCount = node->getElementCount();
+		mElementCount += mNodes[i].mElementCount;
+
+		const U32 child_count = node->getChildCount();
+		mNodes[i].mFirstChild = (U32)mNodes.size();
+		mNodes[i].mChildCount = child_count;
+		for (U32 c = 0; c < child_count; ++c)
+		{
+			Node child = { node->getChild(c), NULL, 0, 0, 0 };
+			mNodes.push_back(child);
+		}
+	}
+}
+
 #endif
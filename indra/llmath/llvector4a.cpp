@@ -178,3 +178,45 @@ void LLVector4a::quantize16( const LLVector4a& low, const LLVector4a& high )
 		setSelectWithMask( absVal.lessThan( maxError ), F_ZERO_4A, val );
 	}	
 }
+
+void LLVector4a::setDequantized16( const U16* src, const LLVector4a& low, const LLVector4a& high )
+{
+	// Zero extend to 32 bits, which converts to float exactly
+	const __m128i packed = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( src ) );
+	LLVector4a val = _mm_cvtepi32_ps( _mm_unpacklo_epi16( packed, _mm_setzero_si128() ) );
+	LLVector4a delta; delta.setSub( high, low );
+
+	// Same operations in the same order as U16_to_F32()
+	{
+		val.mul(*reinterpret_cast<const LLVector4a*>(F_OOU16MAX_4A));
+		val.mul(delta);
+		val.add(low);
+	}
+
+	// Make sure that zeros come through as zero
+	{
+		LLVector4a maxError; maxError.setMul(delta, *reinterpret_cast<const LLVector4a*>(F_OOU16MAX_4A));
+		LLVector4a absVal; absVal.setAbs( val );
+		setSelectWithMask( absVal.lessThan( maxError ), F_ZERO_4A, val );
+	}
+}
+
+/*static */void LLVector4a::dequantize16( F32* dst, const U16* src, S32 count, const F32* low, const F32* high, S32 range_count )
+{
+	llassert( count % 4 == 0 && range_count % 4 == 0 );
+	ll_assert_aligned( dst, 16 );
+
+	const LLVector4a* low4 = reinterpret_cast<const LLVector4a*>( low );
+	const LLVector4a* high4 = reinterpret_cast<const LLVector4a*>( high );
+	LLVector4a* dst4 = reinterpret_cast<LLVector4a*>( dst );
+	const S32 range_vectors = range_count / 4;
+
+	for ( S32 i = 0, range = 0; i < count / 4; ++i )
+	{
+		dst4[i].setDequantized16( src + i * 4, low4[range], high4[range] );
+		if ( ++range == range_vectors )
+		{
+			range = 0;
+		}
+	}
+}
@@ -282,6 +282,15 @@ public:
 	void quantize8( const LLVector4a& low, const LLVector4a& high );
 	void quantize16( const LLVector4a& low, const LLVector4a& high );
 
+	// Set this vector to the four 16 bit values at src expanded to the component-wise
+	// range low to high, giving exactly what U16_to_F32() gives for each of them
+	void setDequantized16( const U16* src, const LLVector4a& low, const LLVector4a& high );
+
+	// Expand count 16 bit values from src to dst as setDequantized16() does, value i
+	// over the range low[i % range_count] to high[i % range_count].  count and
+	// range_count must be multiples of 4 and dst, low and high 16 byte aligned.
+	static void dequantize16( F32* dst, const U16* src, S32 count, const F32* low, const F32* high, S32 range_count );
+
 	////////////////////////////////////
 	// LOGICAL
 	////////////////////////////////////	
@@ -45,12 +45,14 @@
 #include "lloctree.h"
 #include "llvolume.h"
 #include "llvolumeoctree.h"
+#include "llvolumebvh.h"
 #include "llstl.h"
 #include "llsdserialize.h"
 #include "llvector4a.h"
 #include "llmatrix4a.h"
 #include "llmeshoptimizer.h"
 #include "lltimer.h"
+#include "hbxxh.h"
 
 // <FS:Zi> Use Alchemy's vertex cache optimizer for Linux. Thank you!
 #ifdef LL_LINUX
@@ -2075,6 +2077,7 @@ LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL ge
 	mSculptLevel = -2;
 	mSurfaceArea = 1.f; //only calculated for sculpts, defaults to 1 for all other prims
 	mIsMeshAssetLoaded = FALSE;
+	mContentHash = 0;
 	mLODScaleBias.setVec(1,1,1);
 	mHullPoints = NULL;
 	mHullIndices = NULL;
@@ -2793,6 +2796,9 @@ BOOL LLVolume::isMeshAssetLoaded()
 void LLVolume::setMeshAssetLoaded(BOOL loaded)
 {
 	mIsMeshAssetLoaded = loaded;
+	// The faces were just copied in and don't change while loaded, hash
+	// them now rather than later under LLVolumeMgr's lock
+	mContentHash = loaded && getNumVolumeFaces() > 0 ? hashFaces() : 0;
 }
 
 void LLVolume::copyFacesTo(std::vector<LLVolumeFace> &faces) const 
@@ -3819,6 +3825,46 @@ S32 LLVolume::getNumTriangles(S32* vcount) const
 }
 
 
+size_t LLVolume::getMemoryUsage() const
+{
+	size_t bytes = mMesh.size() * sizeof(LLVector4a);
+	for (S32 i = 0; i < getNumVolumeFaces(); ++i)
+	{
+		bytes += mVolumeFaces[i].getMemoryUsage();
+	}
+	return bytes;
+}
+
+U64 LLVolume::hashFaces() const
+{
+	HBXXH64 hash;
+	S32 num_faces = getNumVolumeFaces();
+	hash.update(&num_faces, sizeof(S32));
+	for (S32 i = 0; i < num_faces; ++i)
+	{
+		const LLVolumeFace& face = mVolumeFaces[i];
+		// counts first so face boundaries can't alias
+		S32 counts[3] = { face.mNumVertices, face.mNumIndices, face.mWeights ? 1 : 0 };
+		hash.update(counts, sizeof(counts));
+		if (face.mNumVertices)
+		{
+			hash.update(face.mPositions, face.mNumVertices * sizeof(LLVector4a));
+			hash.update(face.mNormals, face.mNumVertices * sizeof(LLVector4a));
+			hash.update(face.mTexCoords, face.mNumVertices * sizeof(LLVector2));
+			if (face.mWeights)
+			{
+				hash.update(face.mWeights, face.mNumVertices * sizeof(LLVector4a));
+			}
+		}
+		if (face.mNumIndices)
+		{
+			hash.update(face.mIndices, face.mNumIndices * sizeof(U16));
+		}
+	}
+	return hash.digest();
+}
+
+
 //-----------------------------------------------------------------------------
 // generateSilhouetteVertices()
 //-----------------------------------------------------------------------------
@@ -4086,6 +4132,69 @@ void LLVolume::generateSilhouetteVertices(std::vector<LLVector3> &vertices,
 	}
 }
 
+// Fill in the optional outputs of a raycast hit on triangle (idx0, idx1, idx2) of face
+// with barycentric weights a (idx1) and b (idx2) at parametric distance t
+static void fill_intersection_data(const LLVolumeFace& face, const LLVector4a& start, const LLVector4a& dir,
+								   U16 idx0, U16 idx1, U16 idx2, F32 a, F32 b, F32 t,
+								   LLVector4a* intersection, LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent_out)
+{
+	if (intersection != NULL)
+	{
+		LLVector4a intersect = dir;
+		intersect.mul(t);
+		intersect.add(start);
+		*intersection = intersect;
+	}
+
+	if (tex_coord != NULL)
+	{
+		LLVector2* tc = (LLVector2*) face.mTexCoords;
+		*tex_coord = ((1.f - a - b)  * tc[idx0] +
+			a              * tc[idx1] +
+			b              * tc[idx2]);
+	}
+
+	if (normal!= NULL)
+	{
+		LLVector4a* norm = face.mNormals;
+
+		LLVector4a n1,n2,n3;
+		n1 = norm[idx0];
+		n1.mul(1.f-a-b);
+
+		n2 = norm[idx1];
+		n2.mul(a);
+
+		n3 = norm[idx2];
+		n3.mul(b);
+
+		n1.add(n2);
+		n1.add(n3);
+
+		*normal		= n1; 
+	}
+
+	if (tangent_out != NULL)
+	{
+		LLVector4a* tangents = face.mTangents;
+
+		LLVector4a t1,t2,t3;
+		t1 = tangents[idx0];
+		t1.mul(1.f-a-b);
+
+		t2 = tangents[idx1];
+		t2.mul(a);
+
+		t3 = tangents[idx2];
+		t3.mul(b);
+
+		t1.add(t2);
+		t1.add(t3);
+
+		*tangent_out = t1; 
+	}
+}
+
 S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& end, 
 								   S32 face,
 								   LLVector4a* intersection,LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent_out)
@@ -4132,7 +4241,7 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 			}
 
 			if (isUnique())
-			{ //don't bother with an octree for flexi volumes
+			{ //don't bother with an acceleration structure for flexi volumes
 				U32 tri_count = face.mNumIndices/3;
 
 				for (U32 j = 0; j < tri_count; ++j)
@@ -4157,79 +4266,26 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 							closest_t = t;
 							hit_face = i;
 
-							if (intersection != NULL)
-							{
-								LLVector4a intersect = dir;
-								intersect.mul(closest_t);
-								intersect.add(start);
-								*intersection = intersect;
-							}
-
-
-							if (tex_coord != NULL)
-							{
-								LLVector2* tc = (LLVector2*) face.mTexCoords;
-								*tex_coord = ((1.f - a - b)  * tc[idx0] +
-									a              * tc[idx1] +
-									b              * tc[idx2]);
-
-							}
-
-							if (normal!= NULL)
-							{
-								LLVector4a* norm = face.mNormals;
-								
-								LLVector4a n1,n2,n3;
-								n1 = norm[idx0];
-								n1.mul(1.f-a-b);
-								
-								n2 = norm[idx1];
-								n2.mul(a);
-								
-								n3 = norm[idx2];
-								n3.mul(b);
-
-								n1.add(n2);
-								n1.add(n3);
-								
-								*normal		= n1; 
-							}
-
-							if (tangent_out != NULL)
-							{
-								LLVector4a* tangents = face.mTangents;
-								
-								LLVector4a t1,t2,t3;
-								t1 = tangents[idx0];
-								t1.mul(1.f-a-b);
-								
-								t2 = tangents[idx1];
-								t2.mul(a);
-								
-								t3 = tangents[idx2];
-								t3.mul(b);
-
-								t1.add(t2);
-								t1.add(t3);
-								
-								*tangent_out = t1; 
-							}
+							fill_intersection_data(face, start, dir, idx0, idx1, idx2, a, b, t,
+												   intersection, tex_coord, normal, tangent_out);
 						}
 					}
 				}
 			}
 			else
 			{
-                if (!face.getOctree())
+                if (!face.getBVH())
 				{
-					face.createOctree();
+					face.createBVH();
 				}
-			
-				LLOctreeTriangleRayIntersect intersect(start, dir, &face, &closest_t, intersection, tex_coord, normal, tangent_out);
-                intersect.traverse(face.getOctree());
-				if (intersect.mHitFace)
+
+				LLVolumeBVH::Hit hit;
+				if (face.getBVH()->intersect(face, start, dir, closest_t, hit))
 				{
 					hit_face = i;
+
+					fill_intersection_data(face, start, dir, hit.mIndex[0], hit.mIndex[1], hit.mIndex[2], hit.mA, hit.mB, hit.mT,
+										   intersection, tex_coord, normal, tangent_out);
 				}
 			}
 		}		
@@ -4782,6 +4838,7 @@ LLVolumeFace::LLVolumeFace() :
     mWeightsScrubbed(FALSE),
 	mOctree(NULL),
     mOctreeTriangles(NULL),
+    mBVH(NULL),
 	mOptimized(FALSE)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
@@ -4812,7 +4869,8 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
 #endif
     mWeightsScrubbed(FALSE),
     mOctree(NULL),
-    mOctreeTriangles(NULL)
+    mOctreeTriangles(NULL),
+    mBVH(NULL)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mCenter = mExtents+2;
@@ -4954,6 +5012,7 @@ void LLVolumeFace::freeData()
 #endif
 
     destroyOctree();
+    destroyBVH();
 }
 
 BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
@@ -4962,6 +5021,7 @@ BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
 
 	//tree for this face is no longer valid
     destroyOctree();
+    destroyBVH();
 
 	LL_CHECK_MEMORY
 	BOOL ret = FALSE ;
@@ -6000,6 +6060,69 @@ const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* LLVolumeFace::getOctree
     return mOctree;
 }
 
+void LLVolumeFace::createBVH()
+{
+    if (mBVH)
+    {
+        return;
+    }
+
+    mBVH = new LLVolumeBVH();
+    mBVH->build(*this);
+}
+
+void LLVolumeFace::destroyBVH()
+{
+    delete mBVH;
+    mBVH = NULL;
+}
+
+const LLVolumeBVH* LLVolumeFace::getBVH() const
+{
+    return mBVH;
+}
+
+size_t LLVolumeFace::getMemoryUsage() const
+{
+	size_t bytes = sizeof(LLVector4a) * 3; // mExtents and mCenter
+
+	if (mPositions)
+	{ // positions, normals and padded texture coordinates share one block
+		bytes += sizeof(LLVector4a) * 2 * mNumAllocatedVertices + (((mNumAllocatedVertices * sizeof(LLVector2)) + 0xF) & ~0xF);
+	}
+	if (mIndices)
+	{
+		bytes += ((mNumIndices * sizeof(U16)) + 0xF) & ~0xF;
+	}
+	if (mTangents)
+	{
+		bytes += sizeof(LLVector4a) * mNumVertices;
+	}
+	if (mWeights)
+	{
+		bytes += sizeof(LLVector4a) * mNumVertices;
+	}
+#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
+	if (mJointIndices)
+	{
+		bytes += sizeof(U8) * 4 * mNumVertices;
+	}
+	if (mJustWeights)
+	{
+		bytes += sizeof(LLVector4a) * mNumVertices;
+	}
+#endif
+	if (mOctreeTriangles)
+	{
+		bytes += sizeof(LLVolumeTriangle) * (mNumIndices / 3);
+	}
+	if (mBVH)
+	{
+		bytes += mBVH->getMemoryUsage();
+	}
+	return bytes;
+}
+
 
 void LLVolumeFace::swapData(LLVolumeFace& rhs)
 {
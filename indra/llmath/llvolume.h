@@ -41,6 +41,7 @@ template <class T, typename T_PTR> class LLOctreeNode;
 class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
+class LLVolumeBVH;
 
 #include "lluuid.h"
 #include "v4color.h"
@@ -918,6 +919,16 @@ public:
     // Get a reference to the octree, which may be null
     const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* getOctree() const;
 
+    // Flattened BVH used for raycasts, see llvolumebvh.h
+    void createBVH();
+    void destroyBVH();
+    // Get a reference to the BVH, which may be null
+    const LLVolumeBVH* getBVH() const;
+
+    // Bytes allocated for this face's geometry buffers, extents and raycast
+    // acceleration data (octree nodes are not counted, the triangles are)
+    size_t getMemoryUsage() const;
+
 	enum
 	{
 		SINGLE_MASK =	0x0001,
@@ -991,6 +1002,7 @@ public:
 private:
     LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* mOctree;
     LLVolumeTriangle* mOctreeTriangles;
+    LLVolumeBVH* mBVH;
 
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
@@ -1055,6 +1067,16 @@ public:
 
 	S32 getNumTriangles(S32* vcount = NULL) const;
 
+	// Bytes allocated for the faces, mesh points and hull of this volume
+	size_t getMemoryUsage() const;
+
+	// 64 bit hash of the face geometry (positions, normals, texture
+	// coordinates, indices and skin weights).  Volumes with identical faces
+	// hash the same regardless of their LLVolumeParams.  Only taken for
+	// loaded mesh assets, when setMeshAssetLoaded(TRUE) is called, 0 for
+	// anything else.
+	U64 getContentHash() const { return mContentHash; }
+
 	void generateSilhouetteVertices(std::vector<LLVector3> &vertices, 
 									std::vector<LLVector3> &normals, 
 									const LLVector3& view_vec,
@@ -1118,6 +1140,9 @@ public:
 private:
 	bool unpackVolumeFacesInternal(const LLSD& mdl);
 
+protected:
+	U64 hashFaces() const;
+
 public:
 	virtual void setMeshAssetLoaded(BOOL loaded);
 	virtual BOOL isMeshAssetLoaded();
@@ -1128,6 +1153,7 @@ public:
 	S32 mSculptLevel;
 	F32 mSurfaceArea; //unscaled surface area
 	BOOL mIsMeshAssetLoaded;
+	U64 mContentHash;
 	
 	const LLVolumeParams mParams;
 	LLPath *mPathp;
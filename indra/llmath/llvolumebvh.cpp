@@ -0,0 +1,454 @@
+/**
+ * @file llvolumebvh.cpp
+ * @brief Flattened bounding volume hierarchy for LLVolumeFace raycasts.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumebvh.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "llvolume.h"
+
+namespace
+{
+	// Number of buckets used to evaluate the surface area heuristic
+	const U32 SAH_BIN_COUNT = 12;
+
+	// Past this depth fall back to median splits so that the tree depth (and
+	// the traversal stack) stays bounded for pathological inputs
+	const U32 MAX_SAH_DEPTH = 32;
+
+	// Deepest possible tree: MAX_SAH_DEPTH SAH levels followed by at most 32
+	// median splits of a 32 bit triangle count
+	const U32 MAX_TRAVERSAL_DEPTH = MAX_SAH_DEPTH + 33;
+
+	struct BuildTask
+	{
+		U32 mNode;
+		U32 mBegin;
+		U32 mEnd;
+		U32 mDepth;
+	};
+
+	// Half the surface area of the box (min, max)
+	inline F32 half_area(const LLVector4a& min, const LLVector4a& max)
+	{
+		LLVector4a size;
+		size.setSub(max, min);
+		const F32 x = size[0];
+		const F32 y = size[1];
+		const F32 z = size[2];
+		return x * y + y * z + z * x;
+	}
+
+	// Slab test of the segment start + t*dir against box (min, max), where
+	// inv_dir is 1/dir.  Returns true and the entry distance in near_t if the
+	// segment enters the box somewhere in [0, max_t].
+	inline bool segment_box_intersect(const LLVector4a& min, const LLVector4a& max,
+									  const LLVector4a& start, const LLVector4a& inv_dir,
+									  F32 max_t, F32& near_t)
+	{
+		LLVector4a t0;
+		t0.setSub(min, start);
+		t0.mul(inv_dir);
+
+		LLVector4a t1;
+		t1.setSub(max, start);
+		t1.mul(inv_dir);
+
+		__m128 tnear = _mm_min_ps(t0, t1);
+		__m128 tfar = _mm_max_ps(t0, t1);
+
+		// reduce x, y and z into lane 0, ignoring w
+		tnear = _mm_max_ss(_mm_max_ss(tnear, _mm_shuffle_ps(tnear, tnear, _MM_SHUFFLE(1, 1, 1, 1))),
+						   _mm_shuffle_ps(tnear, tnear, _MM_SHUFFLE(2, 2, 2, 2)));
+		tfar = _mm_min_ss(_mm_min_ss(tfar, _mm_shuffle_ps(tfar, tfar, _MM_SHUFFLE(1, 1, 1, 1))),
+						  _mm_shuffle_ps(tfar, tfar, _MM_SHUFFLE(2, 2, 2, 2)));
+
+		// clamp to the segment
+		tnear = _mm_max_ss(tnear, _mm_setzero_ps());
+		tfar = _mm_min_ss(tfar, _mm_set_ss(max_t));
+
+		near_t = _mm_cvtss_f32(tnear);
+		return _mm_comile_ss(tnear, tfar) != 0;
+	}
+}
+
+LLVolumeBVH::LLVolumeBVH()
+:	mNodes(NULL),
+	mNodeCount(0),
+	mTriangles(NULL),
+	mTriangleCount(0)
+{
+}
+
+LLVolumeBVH::~LLVolumeBVH()
+{
+	clear();
+}
+
+void LLVolumeBVH::clear()
+{
+	ll_aligned_free_16(mNodes);
+	mNodes = NULL;
+	mNodeCount = 0;
+
+	ll_aligned_free_16(mTriangles);
+	mTriangles = NULL;
+	mTriangleCount = 0;
+}
+
+void LLVolumeBVH::build(const LLVolumeFace& face)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
+	clear();
+
+	llassert(face.mNumIndices % 3 == 0);
+	const U32 tri_count = face.mNumIndices / 3;
+	if (tri_count == 0 || !face.mPositions || !face.mIndices)
+	{
+		return;
+	}
+
+	// per triangle bounds and centroids, consumed by the binning below
+	LLVector4a* tri_bounds = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * tri_count * 3);
+	LLVector4a* tri_min = tri_bounds;
+	LLVector4a* tri_max = tri_bounds + tri_count;
+	LLVector4a* tri_center = tri_bounds + tri_count * 2;
+
+	std::vector<U32> order(tri_count);
+
+	for (U32 i = 0; i < tri_count; ++i)
+	{
+		const LLVector4a& v0 = face.mPositions[face.mIndices[i * 3 + 0]];
+		const LLVector4a& v1 = face.mPositions[face.mIndices[i * 3 + 1]];
+		const LLVector4a& v2 = face.mPositions[face.mIndices[i * 3 + 2]];
+
+		tri_min[i].setMin(v0, v1);
+		tri_min[i].setMin(tri_min[i], v2);
+		tri_max[i].setMax(v0, v1);
+		tri_max[i].setMax(tri_max[i], v2);
+
+		tri_center[i].setAdd(tri_min[i], tri_max[i]);
+		tri_center[i].mul(0.5f);
+
+		order[i] = i;
+	}
+
+	// a binary tree with at most tri_count leaves has at most 2*tri_count-1 nodes
+	mNodes = (Node*) ll_aligned_malloc_16(sizeof(Node) * tri_count * 2);
+	mNodeCount = 1;
+
+	std::vector<BuildTask> tasks;
+	tasks.reserve(MAX_TRAVERSAL_DEPTH * 2);
+	BuildTask root = { 0, 0, tri_count, 0 };
+	tasks.push_back(root);
+
+	LLVector4a bin_min[SAH_BIN_COUNT];
+	LLVector4a bin_max[SAH_BIN_COUNT];
+	U32 bin_count[SAH_BIN_COUNT];
+	F32 right_area[SAH_BIN_COUNT];
+
+	while (!tasks.empty())
+	{
+		const BuildTask task = tasks.back();
+		tasks.pop_back();
+
+		Node& node = mNodes[task.mNode];
+		const U32 count = task.mEnd - task.mBegin;
+
+		LLVector4a center_min;
+		LLVector4a center_max;
+		node.mMin = tri_min[order[task.mBegin]];
+		node.mMax = tri_max[order[task.mBegin]];
+		center_min = center_max = tri_center[order[task.mBegin]];
+
+		for (U32 i = task.mBegin + 1; i < task.mEnd; ++i)
+		{
+			const U32 tri = order[i];
+			node.mMin.setMin(node.mMin, tri_min[tri]);
+			node.mMax.setMax(node.mMax, tri_max[tri]);
+			center_min.setMin(center_min, tri_center[tri]);
+			center_max.setMax(center_max, tri_center[tri]);
+		}
+
+		if (count <= MAX_LEAF_TRIANGLES)
+		{
+			node.mFirst = task.mBegin;
+			node.mCount = count;
+			continue;
+		}
+
+		// split along the axis with the widest spread of centroids
+		LLVector4a extent;
+		extent.setSub(center_max, center_min);
+		S32 axis = 0;
+		if (extent[1] > extent[axis])
+		{
+			axis = 1;
+		}
+		if (extent[2] > extent[axis])
+		{
+			axis = 2;
+		}
+
+		U32* begin = &order[0] + task.mBegin;
+		U32* end = &order[0] + task.mEnd;
+		U32* mid = NULL;
+
+		if (extent[axis] > 0.f && task.mDepth < MAX_SAH_DEPTH)
+		{
+			const F32 axis_min = center_min[axis];
+			const F32 scale = (F32) SAH_BIN_COUNT / extent[axis];
+
+			for (U32 b = 0; b < SAH_BIN_COUNT; ++b)
+			{
+				bin_count[b] = 0;
+			}
+
+			for (U32* iter = begin; iter != end; ++iter)
+			{
+				const U32 tri = *iter;
+				U32 b = llmin((U32) ((tri_center[tri][axis] - axis_min) * scale), SAH_BIN_COUNT - 1);
+				if (bin_count[b] == 0)
+				{
+					bin_min[b] = tri_min[tri];
+					bin_max[b] = tri_max[tri];
+				}
+				else
+				{
+					bin_min[b].setMin(bin_min[b], tri_min[tri]);
+					bin_max[b].setMax(bin_max[b], tri_max[tri]);
+				}
+				++bin_count[b];
+			}
+
+			// sweep from the right to get the area of every right hand side
+			LLVector4a acc_min;
+			LLVector4a acc_max;
+			U32 acc_count = 0;
+			for (U32 b = SAH_BIN_COUNT - 1; b > 0; --b)
+			{
+				if (bin_count[b])
+				{
+					if (acc_count == 0)
+					{
+						acc_min = bin_min[b];
+						acc_max = bin_max[b];
+					}
+					else
+					{
+						acc_min.setMin(acc_min, bin_min[b]);
+						acc_max.setMax(acc_max, bin_max[b]);
+					}
+					acc_count += bin_count[b];
+				}
+				right_area[b] = acc_count ? half_area(acc_min, acc_max) * acc_count : 0.f;
+			}
+
+			// sweep from the left, pick the cheapest plane between bins
+			F32 best_cost = F32_MAX;
+			U32 best_split = 0;
+			acc_count = 0;
+			for (U32 b = 0; b < SAH_BIN_COUNT - 1; ++b)
+			{
+				if (bin_count[b])
+				{
+					if (acc_count == 0)
+					{
+						acc_min = bin_min[b];
+						acc_max = bin_max[b];
+					}
+					else
+					{
+						acc_min.setMin(acc_min, bin_min[b]);
+						acc_max.setMax(acc_max, bin_max[b]);
+					}
+					acc_count += bin_count[b];
+				}
+
+				if (acc_count == 0 || acc_count == count)
+				{
+					continue;
+				}
+
+				F32 cost = half_area(acc_min, acc_max) * acc_count + right_area[b + 1];
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_split = b + 1;
+				}
+			}
+
+			if (best_split > 0)
+			{
+				mid = std::partition(begin, end, [&](U32 tri)
+					{
+						return llmin((U32) ((tri_center[tri][axis] - axis_min) * scale), SAH_BIN_COUNT - 1) < best_split;
+					});
+			}
+		}
+
+		if (!mid || mid == begin || mid == end)
+		{ // no useful plane (coincident centroids or too deep), split at the median
+			mid = begin + count / 2;
+			std::nth_element(begin, mid, end, [&](U32 lhs, U32 rhs)
+				{
+					return tri_center[lhs][axis] < tri_center[rhs][axis];
+				});
+		}
+
+		const U32 left = mNodeCount;
+		mNodeCount += 2;
+		llassert(mNodeCount <= tri_count * 2);
+
+		node.mFirst = left;
+		node.mCount = 0;
+
+		const U32 split = task.mBegin + (U32) (mid - begin);
+		BuildTask left_task = { left, task.mBegin, split, task.mDepth + 1 };
+		BuildTask right_task = { left + 1, split, task.mEnd, task.mDepth + 1 };
+		tasks.push_back(right_task);
+		tasks.push_back(left_task);
+	}
+
+	// pack vertex indices in leaf order
+	mTriangleCount = tri_count;
+	mTriangles = (U16*) ll_aligned_malloc_16(sizeof(U16) * tri_count * 3);
+	for (U32 i = 0; i < tri_count; ++i)
+	{
+		const U16* src = face.mIndices + order[i] * 3;
+		mTriangles[i * 3 + 0] = src[0];
+		mTriangles[i * 3 + 1] = src[1];
+		mTriangles[i * 3 + 2] = src[2];
+	}
+
+	ll_aligned_free_16(tri_bounds);
+}
+
+bool LLVolumeBVH::intersect(const LLVolumeFace& face, const LLVector4a& start, const LLVector4a& dir,
+							F32& closest_t, Hit& hit) const
+{
+	if (mNodeCount == 0)
+	{
+		return false;
+	}
+
+	// nudge zero direction components so the slab test never sees 0 * inf
+	F32 inv[3];
+	for (U32 i = 0; i < 3; ++i)
+	{
+		F32 d = dir[i];
+		if (fabsf(d) < 1e-20f)
+		{
+			d = d < 0.f ? -1e-20f : 1e-20f;
+		}
+		inv[i] = 1.f / d;
+	}
+	LLVector4a inv_dir(inv[0], inv[1], inv[2], 0.f);
+
+	// segment parameter is [0, 1], and only hits closer than closest_t matter
+	F32 max_t = llmin(closest_t, 1.f);
+	bool hit_face = false;
+
+	U32 stack[MAX_TRAVERSAL_DEPTH + 1];
+	F32 stack_t[MAX_TRAVERSAL_DEPTH + 1];
+	U32 depth = 0;
+
+	F32 near_t;
+	if (!segment_box_intersect(mNodes[0].mMin, mNodes[0].mMax, start, inv_dir, max_t, near_t))
+	{
+		return false;
+	}
+	stack[depth] = 0;
+	stack_t[depth] = near_t;
+	++depth;
+
+	while (depth > 0)
+	{
+		--depth;
+		if (stack_t[depth] > max_t)
+		{ // found something closer since this node was pushed
+			continue;
+		}
+
+		const Node* node = mNodes + stack[depth];
+
+		if (node->isLeaf())
+		{
+			const U16* idx = mTriangles + node->mFirst * 3;
+			for (U32 i = 0; i < node->mCount; ++i, idx += 3)
+			{
+				F32 a, b, t;
+				if (LLTriangleRayIntersect(face.mPositions[idx[0]], face.mPositions[idx[1]], face.mPositions[idx[2]],
+										   start, dir, a, b, t))
+				{
+					if (t >= 0.f && t <= max_t && t < closest_t)
+					{
+						closest_t = t;
+						max_t = t;
+						hit.mT = t;
+						hit.mA = a;
+						hit.mB = b;
+						hit.mIndex[0] = idx[0];
+						hit.mIndex[1] = idx[1];
+						hit.mIndex[2] = idx[2];
+						hit_face = true;
+					}
+				}
+			}
+			continue;
+		}
+
+		const Node* children = mNodes + node->mFirst;
+		F32 t0, t1;
+		bool hit0 = segment_box_intersect(children[0].mMin, children[0].mMax, start, inv_dir, max_t, t0);
+		bool hit1 = segment_box_intersect(children[1].mMin, children[1].mMax, start, inv_dir, max_t, t1);
+
+		// push the far child first so the near one is visited first
+		if (hit0 && hit1)
+		{
+			llassert(depth + 2 <= MAX_TRAVERSAL_DEPTH + 1);
+			const bool left_first = t0 <= t1;
+			stack[depth] = node->mFirst + (left_first ? 1 : 0);
+			stack_t[depth] = left_first ? t1 : t0;
+			++depth;
+			stack[depth] = node->mFirst + (left_first ? 0 : 1);
+			stack_t[depth] = left_first ? t0 : t1;
+			++depth;
+		}
+		else if (hit0 || hit1)
+		{
+			stack[depth] = node->mFirst + (hit0 ? 0 : 1);
+			stack_t[depth] = hit0 ? t0 : t1;
+			++depth;
+		}
+	}
+
+	return hit_face;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file llvolumebvh.h
+ * @brief Flattened bounding volume hierarchy for LLVolumeFace raycasts.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEBVH_H
+#define LL_LLVOLUMEBVH_H
+
+#include "linden_common.h"
+#include "llmemory.h"
+#include "llmath.h"
+
+class LLVolumeFace;
+
+// Binary BVH over the triangles of a single LLVolumeFace, stored as one
+// contiguous array of nodes.  Unlike LLVolumeOctree there is one allocation
+// for all nodes and one for the triangle list, children are found by index
+// and leaf triangles are stored back to back in traversal order, so a
+// raycast touches a handful of cache lines instead of chasing node pointers.
+//
+// The tree only stores bounds and vertex indices; vertex positions are read
+// from the face at query time, so the face must outlive the BVH and the BVH
+// must be rebuilt whenever the face's positions move far enough to
+// invalidate the bounds (see LLVolumeFace::destroyBVH).
+class LLVolumeBVH
+{
+	LL_ALIGN_NEW
+public:
+	// Leaves hold at most this many triangles
+	static const U32 MAX_LEAF_TRIANGLES = 4;
+
+	class alignas(16) Node
+	{
+	public:
+		LL_ALIGN_16(LLVector4a mMin);
+		LL_ALIGN_16(LLVector4a mMax);
+
+		// For leaves, index of the first triangle in mTriangles.
+		// For interior nodes, index of the left child; the right child is
+		// always stored immediately after it.
+		U32 mFirst;
+
+		// Number of triangles in a leaf, 0 for interior nodes
+		U32 mCount;
+
+		bool isLeaf() const { return mCount != 0; }
+	};
+
+	// Result of a successful intersect() call
+	struct Hit
+	{
+		F32 mT;         // parametric distance along the segment, [0, 1]
+		F32 mA;         // barycentric weight of mIndex[1]
+		F32 mB;         // barycentric weight of mIndex[2]
+		U16 mIndex[3];  // vertex indices of the hit triangle
+	};
+
+	LLVolumeBVH();
+	~LLVolumeBVH();
+
+	// (Re)build the hierarchy from face's current positions and indices
+	void build(const LLVolumeFace& face);
+	void clear();
+
+	bool isEmpty() const { return mNodeCount == 0; }
+	U32 getNodeCount() const { return mNodeCount; }
+	U32 getTriangleCount() const { return mTriangleCount; }
+	const Node* getNodes() const { return mNodes; }
+
+	// Bytes allocated for the node pool and the triangle list
+	size_t getMemoryUsage() const { return mTriangleCount * (2 * sizeof(Node) + 3 * sizeof(U16)); }
+
+	// Find the closest triangle of face hit by the segment start + t*dir,
+	// 0 <= t <= 1, that is also closer than closest_t.  On a hit closest_t
+	// and hit are updated and true is returned.  Uses the same (single sided)
+	// triangle test as LLOctreeTriangleRayIntersect.
+	bool intersect(const LLVolumeFace& face, const LLVector4a& start, const LLVector4a& dir,
+				   F32& closest_t, Hit& hit) const;
+
+private:
+	LLVolumeBVH(const LLVolumeBVH& rhs);
+	const LLVolumeBVH& operator=(const LLVolumeBVH& rhs);
+
+	// Node pool, capacity 2*triangles
+	Node* mNodes;
+	U32 mNodeCount;
+
+	// Packed vertex indices, 3 per triangle, in leaf order
+	U16* mTriangles;
+	U32 mTriangleCount;
+};
+
+#endif
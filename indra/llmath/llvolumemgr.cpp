@@ -44,7 +44,14 @@ F32 LLVolumeLODGroup::mDetailScales[NUM_LODS] = {1.f, 1.5f, 2.5f, 4.f};
 //============================================================================
 
 LLVolumeMgr::LLVolumeMgr()
-:	mDataMutex(NULL)
+:	mMemoryBudget(0),
+	mIdleBytes(0),
+	mHits(0),
+	mMisses(0),
+	mEvictions(0),
+	mDedupeHits(0),
+	mDedupeBytes(0),
+	mDataMutex(NULL)
 {
 	// the LLMutex magic interferes with easy unit testing,
 	// so you now must manually call useMutex() to use it
@@ -78,6 +85,9 @@ BOOL LLVolumeMgr::cleanup()
  		delete volgroupp;
 	}
 	mVolumeLODGroups.clear();
+	mIdleLODs.clear();
+	mIdleHashes.clear();
+	mIdleBytes = 0;
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
@@ -105,6 +115,18 @@ LLVolume* LLVolumeMgr::refVolume(const LLVolumeParams &volume_params, const S32
 	{
 		volgroupp = iter->second;
 	}
+	if (volgroupp->hasLOD(detail))
+	{
+		mHits++;
+		if (volgroupp->mIdle[detail])
+		{
+			removeIdleLOD(volgroupp, detail);
+		}
+	}
+	else
+	{
+		mMisses++;
+	}
 	if (mDataMutex)
 	{
 		mDataMutex->unlock();
@@ -159,7 +181,24 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 		LLVolumeLODGroup* volgroupp = iter->second;
 
 		volgroupp->derefLOD(volumep);
-		if (volgroupp->getNumRefs() == 0)
+		if (mMemoryBudget)
+		{
+			// keep the LOD around until the budget runs out instead of
+			// tearing down the group when its last reference goes away
+			for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; i++)
+			{
+				if (volgroupp->mVolumeLODs[i] == volumep)
+				{
+					if (volgroupp->getNumLODRefs(i) == 0)
+					{
+						addIdleLOD(volgroupp, i);
+						trimToBudget();
+					}
+					break;
+				}
+			}
+		}
+		else if (volgroupp->getNumRefs() == 0)
 		{
 			mVolumeLODGroups.erase(params);
 			delete volgroupp;
@@ -186,6 +225,157 @@ LLVolumeLODGroup* LLVolumeMgr::createNewGroup(const LLVolumeParams& volume_param
 	return volgroup;
 }
 
+void LLVolumeMgr::setMemoryBudget(size_t bytes)
+{
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	if (bytes && !mMemoryBudget)
+	{
+		// LODs released while there was no budget are still held by their
+		// groups, hand them over to the LRU so they can be evicted too
+		for (volume_lod_group_map_t::iterator iter = mVolumeLODGroups.begin(),
+				 end = mVolumeLODGroups.end();
+			 iter != end; iter++)
+		{
+			LLVolumeLODGroup* volgroupp = iter->second;
+			for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; i++)
+			{
+				if (volgroupp->hasLOD(i) && volgroupp->getNumLODRefs(i) == 0 && !volgroupp->mIdle[i])
+				{
+					addIdleLOD(volgroupp, i);
+				}
+			}
+		}
+	}
+	mMemoryBudget = bytes;
+	if (mMemoryBudget)
+	{
+		trimToBudget();
+	}
+	else
+	{
+		while (!mIdleLODs.empty())
+		{
+			evictIdleLOD(mIdleLODs.back().first, mIdleLODs.back().second);
+		}
+	}
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+}
+
+void LLVolumeMgr::getStats(Stats& stats) const
+{
+	if (mDataMutex)
+	{
+		mDataMutex->lock();
+	}
+	stats.mNumGroups = (U32)mVolumeLODGroups.size();
+	stats.mNumIdleLODs = (U32)mIdleLODs.size();
+	stats.mTotalBytes = 0;
+	for (volume_lod_group_map_t::const_iterator iter = mVolumeLODGroups.begin(),
+			 end = mVolumeLODGroups.end();
+		 iter != end; iter++)
+	{
+		stats.mTotalBytes += iter->second->getMemoryUsage();
+	}
+	stats.mIdleBytes = mIdleBytes;
+	stats.mHits = mHits;
+	stats.mMisses = mMisses;
+	stats.mEvictions = mEvictions;
+	stats.mDedupeHits = mDedupeHits;
+	stats.mDedupeBytes = mDedupeBytes;
+	if (mDataMutex)
+	{
+		mDataMutex->unlock();
+	}
+}
+
+// protected
+void LLVolumeMgr::addIdleLOD(LLVolumeLODGroup* volgroupp, S32 detail)
+{
+	LLVolume* volumep = volgroupp->mVolumeLODs[detail];
+	size_t bytes = volumep->getMemoryUsage();
+
+	// Only loaded mesh LODs carry a hash: their faces never change once
+	// copied in and the same asset is often referenced through params that
+	// differ in fields a mesh ignores.  The hash was taken when the mesh
+	// loaded, so nothing expensive happens under mDataMutex here.
+	U64& hash = volgroupp->mContentHash[detail];
+	hash = volumep->getContentHash();
+	if (hash)
+	{
+		if (!mIdleHashes.insert(hash).second)
+		{
+			// identical geometry is already retained, don't keep it twice
+			mDedupeHits++;
+			mDedupeBytes += bytes;
+			releaseLOD(volgroupp, detail);
+			return;
+		}
+	}
+
+	volgroupp->mIdleIter[detail] = mIdleLODs.insert(mIdleLODs.begin(), std::make_pair(volgroupp, detail));
+	volgroupp->mIdle[detail] = true;
+	volgroupp->mIdleBytes[detail] = bytes;
+	mIdleBytes += bytes;
+}
+
+// protected
+void LLVolumeMgr::removeIdleLOD(LLVolumeLODGroup* volgroupp, S32 detail)
+{
+	llassert(volgroupp->mIdle[detail]);
+	mIdleLODs.erase(volgroupp->mIdleIter[detail]);
+	if (volgroupp->mContentHash[detail])
+	{
+		mIdleHashes.erase(volgroupp->mContentHash[detail]);
+	}
+	mIdleBytes -= volgroupp->mIdleBytes[detail];
+	volgroupp->mIdleBytes[detail] = 0;
+	volgroupp->mIdle[detail] = false;
+}
+
+// protected
+void LLVolumeMgr::evictIdleLOD(LLVolumeLODGroup* volgroupp, S32 detail)
+{
+	removeIdleLOD(volgroupp, detail);
+	mEvictions++;
+	releaseLOD(volgroupp, detail);
+}
+
+// protected
+void LLVolumeMgr::releaseLOD(LLVolumeLODGroup* volgroupp, S32 detail)
+{
+	volgroupp->mVolumeLODs[detail] = NULL;
+	volgroupp->mContentHash[detail] = 0;
+
+	if (volgroupp->getNumRefs() == 0)
+	{
+		for (S32 i = 0; i < LLVolumeLODGroup::NUM_LODS; i++)
+		{
+			if (volgroupp->hasLOD(i))
+			{
+				return;
+			}
+		}
+		// nothing left in this group
+		mVolumeLODGroups.erase(volgroupp->getVolumeParams());
+		delete volgroupp;
+	}
+}
+
+// protected
+void LLVolumeMgr::trimToBudget()
+{
+	while (mIdleBytes > mMemoryBudget && !mIdleLODs.empty())
+	{
+		evictIdleLOD(mIdleLODs.back().first, mIdleLODs.back().second);
+	}
+}
+
 // virtual
 void LLVolumeMgr::dump()
 {
@@ -208,6 +398,13 @@ void LLVolumeMgr::dump()
 		mDataMutex->unlock();
 	}
 	LL_INFOS() << "Average usage of LODs " << avg << LL_ENDL;
+
+	Stats stats;
+	getStats(stats);
+	LL_INFOS() << "Volume geometry " << stats.mTotalBytes << " bytes in " << stats.mNumGroups << " groups, "
+			   << stats.mIdleBytes << " bytes in " << stats.mNumIdleLODs << " unreferenced LODs, "
+			   << stats.mHits << " hits, " << stats.mMisses << " misses, " << stats.mEvictions << " evictions, "
+			   << stats.mDedupeHits << " duplicates dropped (" << stats.mDedupeBytes << " bytes)" << LL_ENDL;
 }
 
 void LLVolumeMgr::useMutex()
@@ -253,6 +450,9 @@ LLVolumeLODGroup::LLVolumeLODGroup(const LLVolumeParams &params)
 	{
 		mLODRefs[i] = 0;
 		mAccessCount[i] = 0;
+		mIdle[i] = false;
+		mIdleBytes[i] = 0;
+		mContentHash[i] = 0;
 	}
 }
 
@@ -324,6 +524,21 @@ BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 	return FALSE;
 }
 
+size_t LLVolumeLODGroup::getMemoryUsage(const S32 detail) const
+{
+	return mVolumeLODs[detail].notNull() ? mVolumeLODs[detail]->getMemoryUsage() : 0;
+}
+
+size_t LLVolumeLODGroup::getMemoryUsage() const
+{
+	size_t bytes = 0;
+	for (S32 i = 0; i < NUM_LODS; i++)
+	{
+		bytes += getMemoryUsage(i);
+	}
+	return bytes;
+}
+
 S32 LLVolumeLODGroup::getDetailFromTan(const F32 tan_angle)
 {
 	S32 i = 0;
@@ -27,7 +27,9 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <list>
 #include <map>
+#include <set>
 
 #include "llvolume.h"
 #include "llpointer.h"
@@ -58,13 +60,21 @@ public:
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
 	S32 getNumRefs() const { return mRefs; }
+	S32 getNumLODRefs(const S32 detail) const { return mLODRefs[detail]; }
+	bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
 
+	// Bytes allocated for one LOD, or for all LODs of the group
+	size_t getMemoryUsage(const S32 detail) const;
+	size_t getMemoryUsage() const;
+
 	F32	dump();
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeLODGroup& volgroup);
 
 protected:
+	friend class LLVolumeMgr;
+
 	LLVolumeParams mVolumeParams;
 
 	S32 mRefs;
@@ -73,6 +83,12 @@ protected:
 	static F32 mDetailThresholds[NUM_LODS];
 	static F32 mDetailScales[NUM_LODS];
 	S32		mAccessCount[NUM_LODS];
+
+	// Unreferenced LODs retained by LLVolumeMgr, see LLVolumeMgr::setMemoryBudget
+	std::list<std::pair<LLVolumeLODGroup*, S32> >::iterator mIdleIter[NUM_LODS];
+	bool	mIdle[NUM_LODS];
+	size_t	mIdleBytes[NUM_LODS];
+	U64		mContentHash[NUM_LODS];	// entry in LLVolumeMgr::mIdleHashes while idle, or 0
 };
 
 class LLVolumeMgr
@@ -95,6 +111,34 @@ public:
 	// manually call this for mutex magic
 	void useMutex();
 
+	// By default a LOD nobody references stays alive until its whole group
+	// is unreferenced, and the group is then deleted right away.  With a
+	// non zero budget, unreferenced LODs (including every LOD of an
+	// unreferenced group) are kept in a least recently used list instead, so
+	// geometry that is rezzed again is not regenerated or reloaded, and the
+	// oldest ones are freed whenever they add up to more than bytes.
+	// Unreferenced mesh LODs whose faces are identical to an already retained
+	// unreferenced LOD (repeated linksets whose params only differ in fields
+	// meshes ignore) are freed immediately instead of being retained twice.
+	// Referenced LODs are never compared or shared, each keeps its own faces.
+	void setMemoryBudget(size_t bytes);
+	size_t getMemoryBudget() const { return mMemoryBudget; }
+
+	struct Stats
+	{
+		U32		mNumGroups;			// groups in the manager, referenced or not
+		U32		mNumIdleLODs;		// unreferenced LODs retained for reuse
+		size_t	mTotalBytes;		// geometry owned by all groups
+		size_t	mIdleBytes;			// part of mTotalBytes held by unreferenced LODs
+		U64		mHits;				// refVolume() calls that found the LOD built
+		U64		mMisses;			// refVolume() calls that had to build a new LLVolume
+		U64		mEvictions;			// unreferenced LODs freed to stay within budget
+		U64		mDedupeHits;		// unreferenced LODs dropped as duplicates
+		size_t	mDedupeBytes;		// bytes freed by those
+	};
+	// Walks every group to total their memory, do not call every frame
+	void getStats(Stats& stats) const;
+
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
@@ -102,10 +146,33 @@ protected:
 	// Overridden in llphysics/abstract/utils/llphysicsvolumemanager.h
 	virtual LLVolumeLODGroup* createNewGroup(const LLVolumeParams& volume_params);
 
+	// LRU bookkeeping, mDataMutex must be held
+	void addIdleLOD(LLVolumeLODGroup* volgroupp, S32 detail);
+	void removeIdleLOD(LLVolumeLODGroup* volgroupp, S32 detail);
+	void evictIdleLOD(LLVolumeLODGroup* volgroupp, S32 detail);
+	void releaseLOD(LLVolumeLODGroup* volgroupp, S32 detail);
+	void trimToBudget();
+
 protected:
 	typedef std::map<const LLVolumeParams*, LLVolumeLODGroup*, LLVolumeParams::compare> volume_lod_group_map_t;
 	volume_lod_group_map_t mVolumeLODGroups;
 
+	// Unreferenced LODs, most recently released first
+	typedef std::list<std::pair<LLVolumeLODGroup*, S32> > idle_lod_list_t;
+	idle_lod_list_t mIdleLODs;
+
+	// Content hashes of the retained mesh LODs
+	typedef std::set<U64> idle_hash_set_t;
+	idle_hash_set_t mIdleHashes;
+
+	size_t mMemoryBudget;
+	size_t mIdleBytes;
+	U64 mHits;
+	U64 mMisses;
+	U64 mEvictions;
+	U64 mDedupeHits;
+	size_t mDedupeBytes;
+
 	LLMutex* mDataMutex;
 };
 
@@ -0,0 +1,203 @@
+/**
+ * @file   llcamera_test.cpp
+ * @brief  Test for the LLCamera batch frustum culling.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "../test/testrand.h"
+
+#include "../llcamera.h"
+
+namespace tut
+{
+	// not a multiple of 8 so the zero padded tail block is exercised
+	const U32 BOX_COUNT = 1001;
+
+	struct LLCameraBatchData
+	{
+		LLCamera mCamera;
+		std::vector<F32> mData[6];
+		const F32* mCenter[3];
+		const F32* mRadius[3];
+		bool mDefaultAVX;
+		LLTestRand mRand;
+
+		LLCameraBatchData()
+		:	mRand(1)
+		{
+			mDefaultAVX = LLCamera::getBatchCullAVX();
+
+			// frustum looking down +X from the origin, near plane at 1m and
+			// far plane at 100m, corners in the order LLViewerCamera uses
+			LLVector3 frust[8];
+			frust[0].set(1.f, 1.f, -0.75f);
+			frust[1].set(1.f, -1.f, -0.75f);
+			frust[2].set(1.f, -1.f, 0.75f);
+			frust[3].set(1.f, 1.f, 0.75f);
+			for (U32 i = 0; i < 4; ++i)
+			{
+				frust[i + 4] = frust[i] * 100.f;
+			}
+			mCamera.calcAgentFrustumPlanes(frust);
+			mCamera.calcRegionFrustumPlanes(LLVector3(10.f, -20.f, 5.f), 100.f);
+
+			// boxes scattered around the frustum, many crossing its planes
+			for (U32 i = 0; i < 3; ++i)
+			{
+				mData[i].resize(BOX_COUNT);
+				mData[i + 3].resize(BOX_COUNT);
+				for (U32 j = 0; j < BOX_COUNT; ++j)
+				{
+					mData[i][j] = i == 0 ? mRand.frand(70.f) + 50.f : mRand.frand(90.f);
+					mData[i + 3][j] = (mRand.frand() + 1.f) * 8.f;
+				}
+				mCenter[i] = &mData[i][0];
+				mRadius[i] = &mData[i + 3][0];
+			}
+		}
+
+		~LLCameraBatchData()
+		{
+			LLCamera::setBatchCullAVX(mDefaultAVX);
+		}
+
+		S32 batchResult(const U32* visible, const U32* partial, U32 i)
+		{
+			U32 bit = 1 << (i & 31);
+			if (!(visible[i >> 5] & bit))
+			{
+				return 0;
+			}
+			return (partial[i >> 5] & bit) ? 1 : 2;
+		}
+
+		void checkBatch()
+		{
+			U32 visible[(BOX_COUNT + 31) / 32];
+			U32 partial[(BOX_COUNT + 31) / 32];
+			U32 counts[3] = { 0, 0, 0 };
+
+			for (U32 mode = 0; mode < 4; ++mode)
+			{
+				switch (mode)
+				{
+				case 0: mCamera.AABBInFrustumBatch(mCenter, mRadius, BOX_COUNT, visible, partial); break;
+				case 1: mCamera.AABBInFrustumNoFarClipBatch(mCenter, mRadius, BOX_COUNT, visible, partial); break;
+				case 2: mCamera.AABBInRegionFrustumBatch(mCenter, mRadius, BOX_COUNT, visible, partial); break;
+				default: mCamera.AABBInRegionFrustumNoFarClipBatch(mCenter, mRadius, BOX_COUNT, visible, partial); break;
+				}
+
+				for (U32 i = 0; i < BOX_COUNT; ++i)
+				{
+					LLVector4a center(mCenter[0][i], mCenter[1][i], mCenter[2][i]);
+					LLVector4a radius(mRadius[0][i], mRadius[1][i], mRadius[2][i]);
+
+					S32 expected;
+					switch (mode)
+					{
+					case 0: expected = mCamera.AABBInFrustum(center, radius); break;
+					case 1: expected = mCamera.AABBInFrustumNoFarClip(center, radius); break;
+					case 2: expected = mCamera.AABBInRegionFrustum(center, radius); break;
+					default: expected = mCamera.AABBInRegionFrustumNoFarClip(center, radius); break;
+					}
+
+					ensure_equals("batch matches single box test", batchResult(visible, partial, i), expected);
+					counts[expected]++;
+				}
+
+				// padding bits past the last box stay clear
+				ensure_equals("tail visible bits", visible[BOX_COUNT >> 5] >> (BOX_COUNT & 31), 0U);
+				ensure_equals("tail partial bits", partial[BOX_COUNT >> 5] >> (BOX_COUNT & 31), 0U);
+			}
+
+			// the data set must actually cover all three outcomes
+			ensure("some boxes outside", counts[0] > 0);
+			ensure("some boxes partially inside", counts[1] > 0);
+			ensure("some boxes fully inside", counts[2] > 0);
+		}
+	};
+
+	typedef test_group<LLCameraBatchData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llcamera_test_factory("LLCamera");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("frustum orientation");
+		LLVector4a radius(0.5f, 0.5f, 0.5f);
+		ensure_equals("inside", mCamera.AABBInFrustum(LLVector4a(50.f, 0.f, 0.f), radius), 2);
+		ensure_equals("crossing near plane", mCamera.AABBInFrustum(LLVector4a(1.f, 0.f, 0.f), radius), 1);
+		ensure_equals("behind", mCamera.AABBInFrustum(LLVector4a(-50.f, 0.f, 0.f), radius), 0);
+		ensure_equals("past far plane", mCamera.AABBInFrustum(LLVector4a(150.f, 0.f, 0.f), radius), 0);
+		ensure_equals("past far plane, no far clip", mCamera.AABBInFrustumNoFarClip(LLVector4a(150.f, 0.f, 0.f), radius), 2);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("SSE2 batch matches AABBInFrustum");
+		LLCamera::setBatchCullAVX(false);
+		checkBatch();
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("AVX batch matches AABBInFrustum");
+		if (LLCamera::setBatchCullAVX(true))
+		{
+			checkBatch();
+		}
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("ignored planes");
+		mCamera.ignoreAgentFrustumPlane(LLCamera::AGENT_PLANE_LEFT);
+		mCamera.ignoreAgentFrustumPlane(LLCamera::AGENT_PLANE_TOP);
+		checkBatch();
+	}
+
+	template<> template<>
+	void object::test<5>()
+	{
+		set_test_name("empty batch");
+		U32 visible = 0xffffffff;
+		U32 partial = 0xffffffff;
+		mCamera.AABBInFrustumBatch(mCenter, mRadius, 0, &visible, &partial);
+		ensure_equals("visible untouched", visible, 0xffffffffU);
+		ensure_equals("partial untouched", partial, 0xffffffffU);
+	}
+}
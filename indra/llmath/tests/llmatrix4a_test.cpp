@@ -0,0 +1,216 @@
+/**
+ * @file   llmatrix4a_test.cpp
+ * @brief  Test and microbenchmark for the LLMatrix4a batch kernels.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "../test/testrand.h"
+
+#include "llmath.h"
+#include "llmatrix4a.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	// odd so the AVX2 kernels also run their single vector tail
+	const U32 VECTOR_COUNT = 1025;
+	const U32 MATRIX_COUNT = 65;
+	const U32 BENCHMARK_COUNT = 1 << 16;
+	const U32 BENCHMARK_PASSES = 200;
+
+	struct LLMatrix4aData
+	{
+		LLMatrix4a mMat;
+		LLVector4a* mSrc;
+		LLVector4a* mDst;
+		LLMatrix4a::EBatchKernel mDefaultKernel;
+		LLTestRand mRand;
+
+		LLMatrix4aData()
+		:	mRand(1)
+		{
+			mDefaultKernel = LLMatrix4a::getBatchKernel();
+			mSrc = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * BENCHMARK_COUNT);
+			mDst = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * BENCHMARK_COUNT);
+			for (U32 i = 0; i < BENCHMARK_COUNT; ++i)
+			{
+				mSrc[i].set(mRand.frand(2.f), mRand.frand(2.f), mRand.frand(2.f), mRand.frand(2.f));
+			}
+			for (U32 i = 0; i < 4; ++i)
+			{
+				mMat.mMatrix[i].set(mRand.frand(2.f), mRand.frand(2.f), mRand.frand(2.f), mRand.frand(2.f));
+			}
+		}
+
+		~LLMatrix4aData()
+		{
+			LLMatrix4a::setBatchKernel(mDefaultKernel);
+			ll_aligned_free_16(mSrc);
+			ll_aligned_free_16(mDst);
+		}
+
+		void ensureClose(const std::string& msg, const LLVector4a& actual, const LLVector4a& expected)
+		{
+			for (S32 i = 0; i < 4; ++i)
+			{
+				// FMA rounds once instead of twice, allow a few ulps
+				ensure_approximately_equals_range(msg.c_str(), actual[i], expected[i], 1e-4f);
+			}
+		}
+
+		void checkKernel(LLMatrix4a::EBatchKernel kernel)
+		{
+			if (!LLMatrix4a::setBatchKernel(kernel))
+			{
+				ensure("SSE2 kernel is always available", kernel != LLMatrix4a::KERNEL_SSE2);
+				return;
+			}
+
+			mMat.affineTransform(mSrc, mDst, VECTOR_COUNT);
+			for (U32 i = 0; i < VECTOR_COUNT; ++i)
+			{
+				LLVector4a expected;
+				mMat.affineTransformSSE(mSrc[i], expected);
+				ensureClose("affineTransform", mDst[i], expected);
+			}
+
+			mMat.rotate(mSrc, mDst, VECTOR_COUNT);
+			for (U32 i = 0; i < VECTOR_COUNT; ++i)
+			{
+				LLVector4a expected;
+				mMat.rotate(mSrc[i], expected);
+				ensureClose("rotate", mDst[i], expected);
+			}
+
+			// in place
+			memcpy(mDst, mSrc, sizeof(LLVector4a) * VECTOR_COUNT);
+			mMat.affineTransform(mDst, mDst, VECTOR_COUNT);
+			for (U32 i = 0; i < VECTOR_COUNT; ++i)
+			{
+				LLVector4a expected;
+				mMat.affineTransformSSE(mSrc[i], expected);
+				ensureClose("in place affineTransform", mDst[i], expected);
+			}
+
+			// palette multiply, reusing the vector arrays as matrices
+			const LLMatrix4a* a = (const LLMatrix4a*) mSrc;
+			const LLMatrix4a* b = a + MATRIX_COUNT;
+			LLMatrix4a* res = (LLMatrix4a*) mDst;
+			matMulBatch(a, b, res, MATRIX_COUNT);
+			for (U32 i = 0; i < MATRIX_COUNT; ++i)
+			{
+				LLMatrix4a expected;
+				matMulUnsafe(a[i], b[i], expected);
+				for (U32 row = 0; row < 4; ++row)
+				{
+					ensureClose("matMulBatch", res[i].mMatrix[row], expected.mMatrix[row]);
+				}
+			}
+		}
+
+		F64 benchmark(LLMatrix4a::EBatchKernel kernel)
+		{
+			LLMatrix4a::setBatchKernel(kernel);
+			LLTimer timer;
+			for (U32 pass = 0; pass < BENCHMARK_PASSES; ++pass)
+			{
+				mMat.affineTransform(mSrc, mDst, BENCHMARK_COUNT);
+			}
+			return timer.getElapsedTimeF64();
+		}
+	};
+
+	typedef test_group<LLMatrix4aData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llmatrix4a_test_factory("LLMatrix4a");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("SSE2 batch kernels");
+		checkKernel(LLMatrix4a::KERNEL_SSE2);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("AVX2/FMA batch kernels");
+		checkKernel(LLMatrix4a::KERNEL_AVX2_FMA);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("matMulBoundBox");
+		LLVector4a in_extents[2];
+		in_extents[0].set(-1.f, -2.f, -3.f);
+		in_extents[1].set(3.f, 2.f, 1.f);
+
+		LLVector4a out_extents[2];
+		matMulBoundBox(mMat, in_extents, out_extents);
+
+		// brute force over the eight corners
+		LLVector4a min, max;
+		for (U32 i = 0; i < 8; ++i)
+		{
+			LLVector4a corner(in_extents[i & 1][0], in_extents[(i >> 1) & 1][1], in_extents[(i >> 2) & 1][2]);
+			LLVector4a v;
+			mMat.affineTransformSSE(corner, v);
+			if (i == 0)
+			{
+				min = max = v;
+			}
+			min.setMin(min, v);
+			max.setMax(max, v);
+		}
+
+		ensureClose("bound box min", out_extents[0], min);
+		ensureClose("bound box max", out_extents[1], max);
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("batch affineTransform throughput");
+		F64 sse2 = benchmark(LLMatrix4a::KERNEL_SSE2);
+		LL_INFOS() << "SSE2 affineTransform: " << (BENCHMARK_COUNT * BENCHMARK_PASSES) / sse2 / 1e6
+				   << " Mvec/s" << LL_ENDL;
+
+		if (LLMatrix4a::setBatchKernel(LLMatrix4a::KERNEL_AVX2_FMA))
+		{
+			F64 avx2 = benchmark(LLMatrix4a::KERNEL_AVX2_FMA);
+			LL_INFOS() << "AVX2/FMA affineTransform: " << (BENCHMARK_COUNT * BENCHMARK_PASSES) / avx2 / 1e6
+					   << " Mvec/s" << LL_ENDL;
+		}
+	}
+}
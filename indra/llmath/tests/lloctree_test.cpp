@@ -0,0 +1,208 @@
+/**
+ * @file   lloctree_test.cpp
+ * @brief  Test for the LLOctreeLinear snapshot in lloctree.h.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "../test/testrand.h"
+
+#include "llmath.h"
+#include "llmemory.h"
+#include "../lloctree.h"
+
+namespace
+{
+	// minimal element type satisfying LLOctreeNode's requirements
+	class TestEntry
+	{
+		LL_ALIGN_NEW
+	public:
+		TestEntry(F32 x, F32 y, F32 z, F32 radius)
+		:	mRadius(radius),
+			mBinIndex(-1)
+		{
+			mPosition.set(x, y, z);
+		}
+
+		const LLVector4a& getPositionGroup() const	{ return mPosition; }
+		F32 getBinRadius() const					{ return mRadius; }
+		S32 getBinIndex() const						{ return mBinIndex; }
+		void setBinIndex(S32 index)					{ mBinIndex = index; }
+
+	private:
+		LL_ALIGN_16(LLVector4a mPosition);
+		F32 mRadius;
+		S32 mBinIndex;
+	};
+
+	typedef LLOctreeNode<TestEntry, TestEntry*> TestNode;
+	typedef LLOctreeRoot<TestEntry, TestEntry*> TestRoot;
+	typedef LLOctreeLinear<TestEntry, TestEntry*> TestLinear;
+}
+
+namespace tut
+{
+	struct LLOctreeLinearData
+	{
+		TestRoot* mRoot;
+		std::vector<TestEntry*> mEntries;
+		U32 mSavedCapacity;
+		F32 mSavedMinSize;
+		LLTestRand mRand;
+
+		LLOctreeLinearData()
+		:	mRand(1)
+		{
+			mSavedCapacity = gOctreeMaxCapacity;
+			mSavedMinSize = gOctreeMinSize;
+			gOctreeMaxCapacity = 8;
+			gOctreeMinSize = 0.01f;
+
+			LLVector4a center, size;
+			center.splat(0.f);
+			size.splat(64.f);
+			mRoot = new TestRoot(center, size, NULL);
+		}
+
+		~LLOctreeLinearData()
+		{
+			delete mRoot;
+			for (U32 i = 0; i < mEntries.size(); ++i)
+			{
+				delete mEntries[i];
+			}
+			gOctreeMaxCapacity = mSavedCapacity;
+			gOctreeMinSize = mSavedMinSize;
+		}
+
+		void insert(U32 count)
+		{
+			for (U32 i = 0; i < count; ++i)
+			{
+				TestEntry* entry = new TestEntry(mRand.frand(50.f), mRand.frand(50.f), mRand.frand(50.f), 0.1f);
+				mEntries.push_back(entry);
+				mRoot->insert(entry);
+			}
+		}
+
+		// number of nodes at or below node
+		U32 countNodes(const TestNode* node)
+		{
+			U32 count = 1;
+			for (U32 i = 0; i < node->getChildCount(); ++i)
+			{
+				count += countNodes(node->getChild(i));
+			}
+			return count;
+		}
+
+		// every snapshot node must mirror its source node exactly
+		void checkSnapshot(const TestLinear& linear)
+		{
+			ensure_equals("node count", linear.getNodeCount(), countNodes(mRoot));
+			ensure("root first", linear.getNode(0).mNode == mRoot);
+
+			U32 element_total = 0;
+			for (U32 i = 0; i < linear.getNodeCount(); ++i)
+			{
+				const TestLinear::Node& node = linear.getNode(i);
+				ensure_equals("child count", node.mChildCount, node.mNode->getChildCount());
+				ensure_equals("element count", node.mElementCount, node.mNode->getElementCount());
+				ensure("children follow their parent", node.mChildCount == 0 || node.mFirstChild > i);
+
+				for (U32 c = 0; c < node.mChildCount; ++c)
+				{
+					ensure("child order", linear.getNode(node.mFirstChild + c).mNode == node.mNode->getChild(c));
+				}
+
+				element_total += node.mElementCount;
+			}
+			ensure_equals("all elements counted", linear.getElementCount(), element_total);
+		}
+	};
+
+	typedef test_group<LLOctreeLinearData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory lloctree_test_factory("LLOctreeLinear");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("empty snapshot");
+		TestLinear linear;
+		ensure("default empty", linear.isEmpty());
+
+		linear.build(NULL);
+		ensure("null root", linear.isEmpty());
+
+		linear.build(mRoot);
+		ensure_equals("root only", linear.getNodeCount(), 1U);
+		ensure_equals("no elements", linear.getElementCount(), 0U);
+		ensure_equals("no children", linear.getNode(0).mChildCount, 0U);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("snapshot mirrors the tree");
+		insert(1000);
+
+		TestLinear linear;
+		linear.build(mRoot);
+		ensure("tree subdivided", linear.getNodeCount() > 1);
+		ensure_equals("element count", linear.getElementCount(), 1000U);
+		checkSnapshot(linear);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("rebuild after removal");
+		insert(1000);
+
+		TestLinear linear;
+		linear.build(mRoot);
+
+		for (U32 i = 0; i < mEntries.size(); i += 2)
+		{
+			mRoot->remove(mEntries[i]);
+		}
+
+		linear.build(mRoot);
+		ensure_equals("element count", linear.getElementCount(), 500U);
+		checkSnapshot(linear);
+
+		linear.clear();
+		ensure("cleared", linear.isEmpty());
+	}
+}
@@ -0,0 +1,165 @@
+/**
+ * @file   llvolumebvh_test.cpp
+ * @brief  Test for llvolumebvh.cpp.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "../test/testrand.h"
+
+#include "../llvolume.h"
+#include "../llvolumebvh.h"
+
+namespace tut
+{
+	struct LLVolumeBVHData
+	{
+		LLVolumeFace mFace;
+		LLTestRand mRand;
+
+		LLVolumeBVHData() : mRand(12345) {}
+
+		// fill mFace with tri_count random, disjoint triangles
+		void makeFace(S32 tri_count)
+		{
+			mFace.resizeVertices(tri_count * 3);
+			mFace.resizeIndices(tri_count * 3);
+			for (S32 i = 0; i < tri_count * 3; ++i)
+			{
+				mFace.mPositions[i].set(mRand.frand(), mRand.frand(), mRand.frand());
+				mFace.mIndices[i] = i;
+			}
+		}
+
+		// reference result: test every triangle
+		bool bruteForce(const LLVector4a& start, const LLVector4a& dir, F32& closest_t)
+		{
+			bool hit = false;
+			for (S32 i = 0; i < mFace.mNumIndices; i += 3)
+			{
+				F32 a, b, t;
+				if (LLTriangleRayIntersect(mFace.mPositions[mFace.mIndices[i]],
+										   mFace.mPositions[mFace.mIndices[i + 1]],
+										   mFace.mPositions[mFace.mIndices[i + 2]],
+										   start, dir, a, b, t) &&
+					t >= 0.f && t <= 1.f && t < closest_t)
+				{
+					closest_t = t;
+					hit = true;
+				}
+			}
+			return hit;
+		}
+	};
+
+	typedef test_group<LLVolumeBVHData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llvolumebvh_test_factory("LLVolumeBVH");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		// empty face builds an empty tree that never hits
+		LLVolumeBVH bvh;
+		bvh.build(mFace);
+		ensure("empty tree", bvh.isEmpty());
+
+		F32 closest_t = 2.f;
+		LLVolumeBVH::Hit hit;
+		ensure("no hit on empty tree", !bvh.intersect(mFace, LLVector4a(0, 0, -1), LLVector4a(0, 0, 2), closest_t, hit));
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		// single triangle, hit from the front face
+		mFace.resizeVertices(3);
+		mFace.resizeIndices(3);
+		mFace.mPositions[0].set(-1.f, -1.f, 0.f);
+		mFace.mPositions[1].set(1.f, -1.f, 0.f);
+		mFace.mPositions[2].set(0.f, 1.f, 0.f);
+		mFace.mIndices[0] = 0;
+		mFace.mIndices[1] = 1;
+		mFace.mIndices[2] = 2;
+
+		LLVolumeBVH bvh;
+		bvh.build(mFace);
+		ensure_equals("node count", bvh.getNodeCount(), 1U);
+		ensure_equals("triangle count", bvh.getTriangleCount(), 1U);
+
+		F32 closest_t = 2.f;
+		LLVolumeBVH::Hit hit;
+		ensure("hit", bvh.intersect(mFace, LLVector4a(0.f, 0.f, 1.f), LLVector4a(0.f, 0.f, -2.f), closest_t, hit));
+		ensure_approximately_equals("t", closest_t, 0.5f, 16);
+		ensure_equals("index 0", hit.mIndex[0], 0);
+		ensure_equals("index 1", hit.mIndex[1], 1);
+		ensure_equals("index 2", hit.mIndex[2], 2);
+
+		closest_t = 2.f;
+		ensure("segment too short", !bvh.intersect(mFace, LLVector4a(0.f, 0.f, 1.f), LLVector4a(0.f, 0.f, -0.5f), closest_t, hit));
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		// many triangles, must agree with testing every triangle
+		makeFace(2000);
+
+		LLVolumeBVH bvh;
+		bvh.build(mFace);
+		ensure_equals("triangle count", bvh.getTriangleCount(), 2000U);
+		ensure("node count", bvh.getNodeCount() < 2000U * 2);
+
+		for (S32 i = 0; i < 2000; ++i)
+		{
+			LLVector4a start(mRand.frand(2.f), mRand.frand(2.f), mRand.frand(2.f));
+			LLVector4a dir(mRand.frand(4.f), mRand.frand(4.f), mRand.frand(4.f));
+			if (i % 4 == 0)
+			{ // axis aligned rays exercise the zero direction handling
+				dir.set(0.f, 0.f, mRand.frand(4.f));
+			}
+
+			F32 expected_t = 2.f;
+			bool expected = bruteForce(start, dir, expected_t);
+
+			F32 closest_t = 2.f;
+			LLVolumeBVH::Hit hit;
+			bool result = bvh.intersect(mFace, start, dir, closest_t, hit);
+
+			ensure_equals("hit matches brute force", result, expected);
+			if (result)
+			{
+				ensure_equals("closest t matches brute force", closest_t, expected_t);
+			}
+		}
+	}
+}
@@ -0,0 +1,218 @@
+/**
+ * @file   llvolumemgr_test.cpp
+ * @brief  Test for the LLVolumeMgr memory budget and LRU.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "lluuid.h"
+#include "../llvolume.h"
+#include "../llvolumemgr.h"
+
+namespace tut
+{
+	struct LLVolumeMgrData
+	{
+		LLVolumeMgr mMgr;
+
+		// box cut down to a different length for each index
+		LLVolumeParams boxParams(S32 index)
+		{
+			LLVolumeParams params;
+			params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+			params.setBeginAndEndS(0.f, 1.f - index * 0.05f);
+			return params;
+		}
+
+		// mesh params that only differ in the (ignored) path cut
+		LLVolumeParams meshParams(S32 index)
+		{
+			LLVolumeParams params = boxParams(index);
+			params.setSculptID(LLUUID("6ecbbcd4-7c8b-4a43-9a2b-b5ea0e4a3d2e"), LL_SCULPT_TYPE_MESH);
+			return params;
+		}
+
+		// stand in for LLMeshRepository::notifyMeshLoaded
+		void loadMesh(LLVolume* volumep)
+		{
+			LLVolume::face_list_t& faces = volumep->getVolumeFaces();
+			faces.resize(1);
+			faces[0].resizeVertices(3);
+			faces[0].resizeIndices(3);
+			for (S32 i = 0; i < 3; ++i)
+			{
+				faces[0].mPositions[i].set((F32) i, (F32) (i & 1), 0.f);
+				faces[0].mNormals[i].set(0.f, 0.f, 1.f);
+				faces[0].mTexCoords[i].set((F32) i, 0.f);
+				faces[0].mIndices[i] = i;
+			}
+			volumep->setMeshAssetLoaded(TRUE);
+		}
+
+		LLVolumeMgr::Stats getStats()
+		{
+			LLVolumeMgr::Stats stats;
+			mMgr.getStats(stats);
+			return stats;
+		}
+	};
+
+	typedef test_group<LLVolumeMgrData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llvolumemgr_test_factory("LLVolumeMgr");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("no budget frees unreferenced groups");
+		LLVolumeParams params = boxParams(0);
+		LLPointer<LLVolume> volumep = mMgr.refVolume(params, 0);
+		ensure("group created", mMgr.getGroup(params) != NULL);
+		ensure("memory accounted", getStats().mTotalBytes >= volumep->getMemoryUsage());
+		ensure("face bytes counted", volumep->getMemoryUsage() > 0);
+
+		mMgr.unrefVolume(volumep);
+		ensure("group deleted", mMgr.getGroup(params) == NULL);
+		ensure_equals("nothing retained", getStats().mIdleBytes, (size_t) 0);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("budget retains unreferenced LODs");
+		mMgr.setMemoryBudget(64 * 1024 * 1024);
+		LLVolumeParams params = boxParams(0);
+
+		LLPointer<LLVolume> volumep = mMgr.refVolume(params, 1);
+		size_t bytes = volumep->getMemoryUsage();
+		mMgr.unrefVolume(volumep);
+		ensure("group kept", mMgr.getGroup(params) != NULL);
+
+		LLVolumeMgr::Stats stats = getStats();
+		ensure_equals("idle LODs", stats.mNumIdleLODs, 1U);
+		ensure_equals("idle bytes", stats.mIdleBytes, bytes);
+		ensure_equals("misses", stats.mMisses, (U64) 1);
+
+		// rezzing again reuses the same volume
+		LLVolume* again = mMgr.refVolume(params, 1);
+		ensure("same volume", again == volumep.get());
+		stats = getStats();
+		ensure_equals("hits", stats.mHits, (U64) 1);
+		ensure_equals("no longer idle", stats.mNumIdleLODs, 0U);
+		ensure_equals("no idle bytes", stats.mIdleBytes, (size_t) 0);
+		mMgr.unrefVolume(again);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("least recently released LODs are evicted first");
+		mMgr.setMemoryBudget(64 * 1024 * 1024);
+
+		size_t bytes[3];
+		for (S32 i = 0; i < 3; ++i)
+		{
+			LLPointer<LLVolume> volumep = mMgr.refVolume(boxParams(i), 0);
+			bytes[i] = volumep->getMemoryUsage();
+			mMgr.unrefVolume(volumep);
+		}
+		ensure_equals("all retained", getStats().mIdleBytes, bytes[0] + bytes[1] + bytes[2]);
+
+		mMgr.setMemoryBudget(bytes[1] + bytes[2]);
+		ensure("oldest evicted", mMgr.getGroup(boxParams(0)) == NULL);
+		ensure("second kept", mMgr.getGroup(boxParams(1)) != NULL);
+		ensure("newest kept", mMgr.getGroup(boxParams(2)) != NULL);
+		ensure_equals("evictions", getStats().mEvictions, (U64) 1);
+
+		// dropping the budget flushes everything unreferenced
+		mMgr.setMemoryBudget(0);
+		LLVolumeMgr::Stats stats = getStats();
+		ensure_equals("all groups gone", stats.mNumGroups, 0U);
+		ensure_equals("evictions after flush", stats.mEvictions, (U64) 3);
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("unreferenced LOD of a referenced group");
+		mMgr.setMemoryBudget(1);
+		LLVolumeParams params = boxParams(0);
+
+		LLPointer<LLVolume> high = mMgr.refVolume(params, 3);
+		LLPointer<LLVolume> low = mMgr.refVolume(params, 0);
+		mMgr.unrefVolume(low);
+
+		// over budget, the unused LOD goes but the group stays
+		LLVolumeLODGroup* volgroupp = mMgr.getGroup(params);
+		ensure("group kept", volgroupp != NULL);
+		ensure("unused LOD freed", !volgroupp->hasLOD(0));
+		ensure("used LOD kept", volgroupp->hasLOD(3));
+		ensure_equals("group bytes", volgroupp->getMemoryUsage(), high->getMemoryUsage());
+
+		mMgr.unrefVolume(high);
+		ensure("group deleted", mMgr.getGroup(params) == NULL);
+	}
+
+	template<> template<>
+	void object::test<5>()
+	{
+		set_test_name("duplicate mesh LODs are not retained twice");
+		mMgr.setMemoryBudget(64 * 1024 * 1024);
+
+		LLPointer<LLVolume> first = mMgr.refVolume(meshParams(0), 2);
+		LLPointer<LLVolume> second = mMgr.refVolume(meshParams(1), 2);
+		ensure("separate volumes", first.get() != second.get());
+		loadMesh(first);
+		loadMesh(second);
+		ensure_equals("same content", first->getContentHash(), second->getContentHash());
+		size_t bytes = second->getMemoryUsage();
+
+		mMgr.unrefVolume(first);
+		mMgr.unrefVolume(second);
+
+		LLVolumeMgr::Stats stats = getStats();
+		ensure_equals("dedupe hits", stats.mDedupeHits, (U64) 1);
+		ensure_equals("dedupe bytes", stats.mDedupeBytes, bytes);
+		ensure_equals("one copy retained", stats.mNumIdleLODs, 1U);
+		ensure("first kept", mMgr.getGroup(meshParams(0)) != NULL);
+		ensure("duplicate freed", mMgr.getGroup(meshParams(1)) == NULL);
+
+		// different geometry is not a duplicate
+		LLPointer<LLVolume> third = mMgr.refVolume(meshParams(2), 2);
+		loadMesh(third);
+		third->getVolumeFace(0).mPositions[0].set(5.f, 5.f, 5.f);
+		ensure("different content", third->getContentHash() != first->getContentHash());
+		mMgr.unrefVolume(third);
+		ensure_equals("two copies retained", getStats().mNumIdleLODs, 2U);
+	}
+}
@@ -35,7 +35,9 @@
 
 #include "../llline.h"
 #include "../llmath.h"
+#include "../llquantize.h"
 #include "../llsphere.h"
+#include "../llvector4a.h"
 #include "../v3math.h"
 
 namespace tut
@@ -721,3 +723,41 @@ namespace tut
 	}
 }
 
+
+
+namespace tut
+{
+	struct quantize_data
+	{
+	};
+	typedef test_group<quantize_data> quantize_test;
+	typedef quantize_test::object quantize_object;
+	tut::quantize_test tquantize("LLQuantize");
+
+	template<> template<>
+	void quantize_object::test<1>()
+	{
+		// the batch dequantizer must agree exactly with U16_to_F32() for
+		// every value, including those snapped to zero
+		const S32 COUNT = 65536;
+		LL_ALIGN_16(F32 low[8]) = { -128.f, -64.f, -1.f, 0.f, -0.5f*256.f, -3.f, 20.f, -4096.f };
+		LL_ALIGN_16(F32 high[8]) = { 128.f, 64.f, 1.f, 1.f, 1.5f*256.f, 7.f, 4096.f, 4096.f };
+
+		U16* src = new U16[COUNT];
+		F32* dst = (F32*) ll_aligned_malloc_16(COUNT * sizeof(F32));
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			src[i] = (U16) i;
+		}
+
+		LLVector4a::dequantize16(dst, src, COUNT, low, high, 8);
+		for (S32 i = 0; i < COUNT; ++i)
+		{
+			F32 expected = U16_to_F32(src[i], low[i % 8], high[i % 8]);
+			ensure_equals("dequantize16 matches U16_to_F32", dst[i], expected);
+		}
+
+		ll_aligned_free_16(dst);
+		delete [] src;
+	}
+}
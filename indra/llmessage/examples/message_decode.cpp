@@ -0,0 +1,262 @@
+/**
+ * @file message_decode.cpp
+ * @brief Template message decode benchmark over a recorded packet capture
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "linden_common.h"
+
+#include "llapr.h"
+#include "llerrorcontrol.h"
+#include "llstring.h"
+#include "lltimer.h"
+#include "lltrace.h"
+#include "lltracethreadrecorder.h"
+
+#include "llmessagetemplate.h"
+#include "llmessagetemplateparser.h"
+#include "llpacketcapture.h"
+#include "lltemplatemessagereader.h"
+#include "message.h"
+
+
+namespace
+{
+
+// A packet as the template reader sees it: acks stripped and zero
+// coding expanded, the way checkMessages() hands it over.
+struct DecodePacket
+{
+	LLHost mSender;
+	std::vector<U8> mData;
+};
+
+void usage(std::ostream & out);
+bool load_templates(const std::string & filename, LLMessageSystem::message_template_number_map_t & numbers);
+bool load_capture(const std::string & filename, std::vector<DecodePacket> & packets, S64 & wire_bytes);
+void no_op_handler(LLMessageSystem *, void **)
+{}
+
+}
+
+
+int main(int argc, char** argv)
+{
+	S32 passes(10);
+	int arg(1);
+	for (; arg < argc && argv[arg][0] == '-'; ++arg)
+	{
+		if (! strcmp(argv[arg], "-n") && arg + 1 < argc)
+		{
+			passes = atoi(argv[++arg]);
+			if (passes < 1 || passes > 100000)
+			{
+				usage(std::cerr);
+				return 1;
+			}
+		}
+		else if (! strcmp(argv[arg], "-h") || ! strcmp(argv[arg], "-?"))
+		{
+			usage(std::cout);
+			return 0;
+		}
+		else
+		{
+			usage(std::cerr);
+			return 1;
+		}
+	}
+	if (arg + 2 != argc)
+	{
+		usage(std::cerr);
+		return 1;
+	}
+
+	ll_init_apr();
+	LLError::initForApplication(".", ".", true /* log to stderr */);
+	LLError::setDefaultLevel(LLError::LEVEL_WARN);
+	LLTrace::ThreadRecorder * recorder(new LLTrace::ThreadRecorder());
+	LLTrace::set_master_thread_recorder(recorder);
+
+	LLMessageSystem::message_template_number_map_t numbers;
+	std::vector<DecodePacket> packets;
+	S64 wire_bytes(0);
+	if (! load_templates(argv[arg], numbers) || ! load_capture(argv[arg + 1], packets, wire_bytes))
+	{
+		return 1;
+	}
+	if (packets.empty())
+	{
+		std::cerr << "No packets in " << argv[arg + 1] << std::endl;
+		return 1;
+	}
+
+	S64 decoded_bytes(0);
+	for (std::vector<DecodePacket>::const_iterator iter(packets.begin()); iter != packets.end(); ++iter)
+	{
+		decoded_bytes += iter->mData.size();
+	}
+
+	LLTemplateMessageReader reader(numbers);
+	U64 decoded(0), rejected(0);
+	LLTimer timer;
+	for (S32 pass(0); pass < passes; ++pass)
+	{
+		for (std::vector<DecodePacket>::const_iterator iter(packets.begin()); iter != packets.end(); ++iter)
+		{
+			const U8 * data(&iter->mData[0]);
+			if (reader.validateMessage(data, (S32) iter->mData.size(), iter->mSender, true)
+				&& reader.readMessage(data, iter->mSender))
+			{
+				++decoded;
+			}
+			else
+			{
+				++rejected;
+			}
+		}
+	}
+	const F64 elapsed(llmax((F64) timer.getElapsedTimeF64(), 1e-9));
+
+	std::cout << packets.size() << " packets (" << wire_bytes << " bytes on the wire, "
+			  << decoded_bytes << " decoded), " << passes << " passes\n"
+			  << decoded << " decoded, " << rejected << " rejected in " << elapsed << " seconds\n"
+			  << (F64) decoded / elapsed / 1e6 << " M packets/s, "
+			  << (F64) decoded_bytes * passes / elapsed / 1e6 << " MB/s"
+			  << std::endl;
+
+	LLTrace::set_master_thread_recorder(NULL);
+	delete recorder;
+	for (LLMessageSystem::message_template_number_map_t::iterator iter(numbers.begin());
+		 iter != numbers.end();
+		 ++iter)
+	{
+		delete iter->second;
+	}
+	ll_cleanup_apr();
+	return 0;
+}
+
+
+namespace
+{
+
+void usage(std::ostream & out)
+{
+	out << "\n"
+		"usage:\tmessage_decode [options]  message_template.msg  capture_file\n"
+		"\n"
+		"Decodes every template message in a packet capture with\n"
+		"LLTemplateMessageReader, as checkMessages() would, and reports the\n"
+		"decode rate.  Captures come from the viewer's MessageSystemCaptureFile\n"
+		"setting or LLMessageSystem::startPacketCapture().  Handlers are\n"
+		"no-ops so only the reader is timed.\n"
+		"\n"
+		"Options:\n"
+		"\n"
+		" -n <passes>           Times to decode the whole capture.\n"
+		"                       Range:  [1..100000]  Default:  10\n"
+		" -h                    print this help\n"
+		"\n"
+		<< std::endl;
+}
+
+
+bool load_templates(const std::string & filename, LLMessageSystem::message_template_number_map_t & numbers)
+{
+	std::string template_body;
+	if (! _read_file_into_string(template_body, filename))
+	{
+		std::cerr << "Failed to open template: " << filename << std::endl;
+		return false;
+	}
+
+	LLTemplateTokenizer tokens(template_body);
+	LLTemplateParser parsed(tokens);
+	for (LLTemplateParser::message_iterator iter(parsed.getMessagesBegin());
+		 iter != parsed.getMessagesEnd();
+		 ++iter)
+	{
+		(*iter)->setHandlerFunc(no_op_handler, NULL);
+		numbers[(*iter)->mMessageNumber] = *iter;
+	}
+	return ! numbers.empty();
+}
+
+
+bool load_capture(const std::string & filename, std::vector<DecodePacket> & packets, S64 & wire_bytes)
+{
+	LLPacketCaptureReader capture;
+	if (! capture.open(filename))
+	{
+		std::cerr << "Failed to open capture: " << filename << std::endl;
+		return false;
+	}
+
+	U8 buffer[MAX_BUFFER_SIZE];
+	U8 expanded[MAX_BUFFER_SIZE];
+	while (! capture.isDone())
+	{
+		LLHost sender;
+		S32 size(capture.readPacket(buffer, sender));
+		if (size < LL_MINIMUM_VALID_PACKET_SIZE)
+		{
+			continue;
+		}
+		wire_bytes += size;
+
+		if (buffer[0] & LL_ACK_FLAG)
+		{
+			S32 acks(buffer[--size]);
+			if (size < (S32) (acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE))
+			{
+				continue;
+			}
+			size -= acks * sizeof(TPACKETID);
+		}
+
+		const U8 * data(buffer);
+		if (buffer[0] & LL_ZERO_CODE_FLAG)
+		{
+			size = LLMessageSystem::zeroCodeExpandBuffer(buffer, size, expanded);
+			if (size < LL_MINIMUM_VALID_PACKET_SIZE)
+			{
+				continue;
+			}
+			data = expanded;
+		}
+
+		DecodePacket packet;
+		packet.mSender = sender;
+		packet.mData.assign(data, data + size);
+		packets.push_back(packet);
+	}
+	return true;
+}
+
+}  // end namespace
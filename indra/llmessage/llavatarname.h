@@ -34,6 +34,9 @@ class LLSD;
 
 class LL_COMMON_API LLAvatarName
 {
+	// Reads and writes the private fields in its binary cache file
+	friend class LLAvatarNameCache;
+
 public:
 	LLAvatarName();
 	
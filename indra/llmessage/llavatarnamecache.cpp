@@ -60,6 +60,52 @@ const F64 MAX_UNREFRESHED_TIME = 20.0 * 60.0;
 // Only need per-frame timing resolution.
 static LLFrameTimer sRequestTimer;
 
+// URL format is like:
+// http://pdp60.lindenlab.com:8000/agents/?ids=3941037e-78ab-45f0-b421-bd6e77c1804d&ids=0012809d-7d2d-4c24-9609-af1230a37715&ids=0019aaba-24af-4f0a-aa72-6457953cf7f0
+//
+// Apache can handle URLs of 4096 chars, but let's be conservative
+static const U32 NAME_URL_MAX = 4000;
+
+// 100 ms is the threshold for "user speed" operations, so a partial
+// batch can wait about that long for more IDs to share its request.
+static const F64 NAME_BATCH_WINDOW = 0.1;
+
+// Lookups in flight at once.  A group chat or area list can queue
+// thousands of IDs, these go out as that many full batches.
+static const S32 MAX_NAME_REQUESTS_IN_FLIGHT = 8;
+
+// Binary cache file.  A header, fixed-size records and a pool of
+// the records' strings, laid out to be used in place once read.
+static const char NAME_CACHE_MAGIC[4] = { 'A', 'V', 'N', 'C' };
+static const U32 NAME_CACHE_VERSION = 1;
+// Sanity limits on the header fields, far above anything a real cache holds
+static const U32 NAME_CACHE_MAX_RECORDS = 1 << 20;
+static const U32 NAME_CACHE_MAX_POOL_PER_RECORD = 1024;
+
+struct NameCacheHeader
+{
+	char	mMagic[4];
+	U32		mVersion;
+	U32		mCount;			// records
+	U32		mPoolSize;		// bytes of strings after the records
+};
+
+struct NameCacheRecord
+{
+	enum { USERNAME, DISPLAY_NAME, LEGACY_FIRST_NAME, LEGACY_LAST_NAME, STRING_COUNT };
+	enum { FLAG_DISPLAY_NAME_DEFAULT = 0x1 };
+
+	U8		mID[UUID_BYTES];
+	F64		mExpires;
+	F64		mNextUpdate;
+	U32		mOffsets[STRING_COUNT];		// into the string pool
+	U16		mLengths[STRING_COUNT];
+	U32		mFlags;
+	U32		mPad;
+};
+static_assert(sizeof(NameCacheHeader) == 16, "name cache header layout changed");
+static_assert(sizeof(NameCacheRecord) == 64, "name cache record layout changed");
+
 // static to avoid unnessesary dependencies
 LLCore::HttpRequest::ptr_t		sHttpRequest;
 LLCore::HttpHeaders::ptr_t		sHttpHeaders;
@@ -118,6 +164,10 @@ LLAvatarNameCache::LLAvatarNameCache()
 
     mUsePeopleAPI = true;
 
+    mBatchStart = 0.0;
+    mRequestsInFlight = 0;
+    mLastExpireCheck = 0.0;
+
     sHttpRequest = LLCore::HttpRequest::ptr_t(new LLCore::HttpRequest());
     sHttpHeaders = LLCore::HttpHeaders::ptr_t(new LLCore::HttpHeaders());
     sHttpOptions = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions());
@@ -138,6 +188,18 @@ void LLAvatarNameCache::requestAvatarNameCache_(std::string url, std::vector<LLU
     LL_DEBUGS("AvNameCache") << "Entering coroutine " << LLCoros::getName()
         << " with url '" << url << "', requesting " << agentIds.size() << " Agent Ids" << LL_ENDL;
 
+    // However this ends, make room for the next batch
+    struct InFlight
+    {
+        ~InFlight()
+        {
+            if (LLAvatarNameCache::instanceExists())
+            {
+                --LLAvatarNameCache::getInstance()->mRequestsInFlight;
+            }
+        }
+    } in_flight;
+
     // Check pointer that can be cleaned up by cleanupClass()
     if (!sHttpRequest || !sHttpOptions || !sHttpHeaders)
     {
@@ -285,7 +347,7 @@ void LLAvatarNameCache::handleAvNameCacheSuccess(const LLSD &data, const LLSD &h
 // Provide some fallback for agents that return errors
 void LLAvatarNameCache::handleAgentError(const LLUUID& agent_id)
 {
-	std::map<LLUUID,LLAvatarName>::iterator existing = mCache.find(agent_id);
+	cache_t::iterator existing = mCache.find(agent_id);
 	if (existing == mCache.end())
     {
 		// <FS:Ansariel> Don't re-request names for agents with null uuid.
@@ -329,7 +391,7 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
 
     bool updated_account = true; // assume obsolete value for new arrivals by default
 
-    std::map<LLUUID, LLAvatarName>::iterator it = mCache.find(agent_id);
+    cache_t::iterator it = mCache.find(agent_id);
     if (it != mCache.end()
         && (*it).second.getAccountName() == av_name.getAccountName())
     {
@@ -367,62 +429,55 @@ void LLAvatarNameCache::processName(const LLUUID& agent_id, const LLAvatarName&
 void LLAvatarNameCache::requestNamesViaCapability()
 {
 	F64 now = LLFrameTimer::getTotalSeconds();
+	if (!mBatchStart)
+	{
+		mBatchStart = now;
+	}
 
-	// URL format is like:
-	// http://pdp60.lindenlab.com:8000/agents/?ids=3941037e-78ab-45f0-b421-bd6e77c1804d&ids=0012809d-7d2d-4c24-9609-af1230a37715&ids=0019aaba-24af-4f0a-aa72-6457953cf7f0
-	//
-	// Apache can handle URLs of 4096 chars, but let's be conservative
-	static const U32 NAME_URL_MAX = 4096;
-	static const U32 NAME_URL_SEND_THRESHOLD = 3500;
-
-	std::string url;
-	url.reserve(NAME_URL_MAX);
+	const U32 batch_size = max_ids_per_name_request(mNameLookupURL.size(), NAME_URL_MAX);
 
-	std::vector<LLUUID> agent_ids;
-	agent_ids.reserve(128);
-	
-	U32 ids = 0;
-	ask_queue_t::const_iterator it;
-	while(!mAskQueue.empty())
+	// Full batches go out right away, a partial one once it has waited
+	// out the window for company.
+	while (!mAskQueue.empty() && mRequestsInFlight < MAX_NAME_REQUESTS_IN_FLIGHT)
 	{
-		it = mAskQueue.begin();
-		LLUUID agent_id = *it;
-		mAskQueue.erase(it);
-
-		if (url.empty())
-		{
-			// ...starting new request
-			url += mNameLookupURL;
-			url += "?ids=";
-			ids = 1;
-		}
-		else
+		if (mAskQueue.size() < batch_size && now - mBatchStart < NAME_BATCH_WINDOW)
 		{
-			// ...continuing existing request
-			url += "&ids=";
-			ids++;
+			break;
 		}
-		url += agent_id.asString();
-		agent_ids.push_back(agent_id);
 
-		// mark request as pending
-		mPendingQueue[agent_id] = now;
+		std::string url;
+		url.reserve(NAME_URL_MAX);
+		url += mNameLookupURL;
+
+		std::vector<LLUUID> agent_ids;
+		agent_ids.reserve(llmin(batch_size, (U32)mAskQueue.size()));
 
-		if (url.size() > NAME_URL_SEND_THRESHOLD)
+		while (!mAskQueue.empty() && agent_ids.size() < batch_size)
 		{
-			break;
+			ask_queue_t::iterator it = mAskQueue.begin();
+			LLUUID agent_id = *it;
+			mAskQueue.erase(it);
+
+			url += (agent_ids.empty() ? "?ids=" : "&ids=");
+			url += agent_id.asString();
+			agent_ids.push_back(agent_id);
+
+			// mark request as pending
+			mPendingQueue[agent_id] = now;
 		}
-	}
 
-    if (!url.empty())
-    {
-        LL_DEBUGS("AvNameCache") << "requested " << ids << " ids" << LL_ENDL;
+		LL_DEBUGS("AvNameCache") << "requested " << agent_ids.size() << " ids" << LL_ENDL;
 
-        std::string coroname = 
-            LLCoros::instance().launch("LLAvatarNameCache::requestAvatarNameCache_",
-            boost::bind(&LLAvatarNameCache::requestAvatarNameCache_, url, agent_ids));
-        LL_DEBUGS("AvNameCache") << coroname << " with  url '" << url << "', agent_ids.size()=" << agent_ids.size() << LL_ENDL;
+		++mRequestsInFlight;
+		std::string coroname =
+			LLCoros::instance().launch("LLAvatarNameCache::requestAvatarNameCache_",
+			boost::bind(&LLAvatarNameCache::requestAvatarNameCache_, url, agent_ids));
+		LL_DEBUGS("AvNameCache") << coroname << " with  url '" << url << "', agent_ids.size()=" << agent_ids.size() << LL_ENDL;
+	}
 
+	if (mAskQueue.empty())
+	{
+		mBatchStart = 0.0;
 	}
 }
 
@@ -436,7 +491,7 @@ void LLAvatarNameCache::legacyNameCallback(const LLUUID& agent_id,
 	// Retrieve the name and set it to never (or almost never...) expire: when we are using the legacy
 	// protocol, we do not get an expiration date for each name and there's no reason to ask the 
 	// data again and again so we set the expiration time to the largest value admissible.
-	std::map<LLUUID,LLAvatarName>::iterator av_record = LLAvatarNameCache::getInstance()->mCache.find(agent_id);
+	cache_t::iterator av_record = LLAvatarNameCache::getInstance()->mCache.find(agent_id);
 	LLAvatarName& av_name = av_record->second;
 	av_name.setExpires(MAX_UNREFRESHED_TIME);
 }
@@ -489,6 +544,89 @@ void LLAvatarNameCache::clearCache()
 // </FS:Ansariel>
 
 bool LLAvatarNameCache::importFile(std::istream& istr)
+{
+	NameCacheHeader header;
+	if (!istr.read((char*)&header, sizeof(header))
+		|| memcmp(header.mMagic, NAME_CACHE_MAGIC, sizeof(NAME_CACHE_MAGIC)))
+	{
+		// Cache from before the binary format
+		istr.clear();
+		istr.seekg(0);
+		return importLLSDFile(istr);
+	}
+	if (header.mVersion != NAME_CACHE_VERSION)
+	{
+		LL_WARNS("AvNameCache") << "avatar name cache version " << header.mVersion << " not supported" << LL_ENDL;
+		return false;
+	}
+
+	// Check the sizes in the header against the file before trusting
+	// them with an allocation
+	const std::streampos data_start = istr.tellg();
+	istr.seekg(0, std::ios::end);
+	const std::streampos data_end = istr.tellg();
+	istr.seekg(data_start);
+	const size_t records_size = (size_t)header.mCount * sizeof(NameCacheRecord);
+	if (data_start < 0 || data_end < data_start || !istr
+		|| header.mCount > NAME_CACHE_MAX_RECORDS
+		|| header.mPoolSize > (size_t)header.mCount * NAME_CACHE_MAX_POOL_PER_RECORD
+		|| records_size + header.mPoolSize != (size_t)(data_end - data_start))
+	{
+		LL_WARNS("AvNameCache") << "avatar name cache header does not match the file, "
+			<< header.mCount << " records, " << header.mPoolSize << " bytes of strings" << LL_ENDL;
+		return false;
+	}
+
+	// Read it all in one go and use the records where they land
+	std::vector<char> buffer(records_size + header.mPoolSize);
+	if (!buffer.empty() && !istr.read(&buffer[0], buffer.size()))
+	{
+		LL_WARNS("AvNameCache") << "avatar name cache truncated" << LL_ENDL;
+		return false;
+	}
+	const NameCacheRecord* records = (const NameCacheRecord*)(buffer.empty() ? NULL : &buffer[0]);
+	const char* pool = buffer.empty() ? NULL : &buffer[records_size];
+
+	F64 max_unrefreshed = LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME;
+	mCache.reserve(mCache.size() + header.mCount);
+
+	LLUUID agent_id;
+	LLAvatarName av_name;
+	std::string* strings[NameCacheRecord::STRING_COUNT] =
+		{ &av_name.mUsername, &av_name.mDisplayName, &av_name.mLegacyFirstName, &av_name.mLegacyLastName };
+	U32 expired = 0;
+	for (U32 i = 0; i < header.mCount; ++i)
+	{
+		const NameCacheRecord& record = records[i];
+		if (record.mExpires < max_unrefreshed)
+		{
+			++expired;
+			continue;
+		}
+		for (S32 n = 0; n < NameCacheRecord::STRING_COUNT; ++n)
+		{
+			if ((size_t)record.mOffsets[n] + record.mLengths[n] > header.mPoolSize)
+			{
+				LL_WARNS("AvNameCache") << "avatar name cache string out of range" << LL_ENDL;
+				// start over with an empty cache rather than a partial one
+				mCache.clear();
+				return false;
+			}
+			strings[n]->assign(pool + record.mOffsets[n], record.mLengths[n]);
+		}
+		memcpy(agent_id.mData, record.mID, UUID_BYTES);
+		av_name.mExpires = record.mExpires;
+		av_name.mNextUpdate = record.mNextUpdate;
+		av_name.mIsDisplayNameDefault = (record.mFlags & NameCacheRecord::FLAG_DISPLAY_NAME_DEFAULT) != 0;
+		av_name.mIsTemporaryName = false;
+		mCache[agent_id] = av_name;
+	}
+	LL_INFOS("AvNameCache") << "LLAvatarNameCache loaded " << mCache.size() << ", skipped " << expired << " expired" << LL_ENDL;
+
+	return true;
+}
+
+bool LLAvatarNameCache::importLLSDFile(std::istream& istr)
 {
 	LLSD data;
 	if (LLSDParser::PARSE_FAILURE == LLSDSerialize::fromXMLDocument(data, istr))
@@ -510,7 +648,7 @@ bool LLAvatarNameCache::importFile(std::istream& istr)
 		av_name.fromLLSD( it->second );
 		mCache[agent_id] = av_name;
 	}
-    LL_INFOS("AvNameCache") << "LLAvatarNameCache loaded " << mCache.size() << LL_ENDL;
+    LL_INFOS("AvNameCache") << "LLAvatarNameCache loaded " << mCache.size() << " from LLSD" << LL_ENDL;
 	// Some entries may have expired since the cache was stored,
     // but they will be flushed in the first call to eraseUnrefreshed
     // from LLAvatarNameResponder::idle
@@ -520,25 +658,54 @@ bool LLAvatarNameCache::importFile(std::istream& istr)
 
 void LLAvatarNameCache::exportFile(std::ostream& ostr)
 {
-	LLSD agents;
 	F64 max_unrefreshed = LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME;
     LL_INFOS("AvNameCache") << "LLAvatarNameCache at exit cache has " << mCache.size() << LL_ENDL;
+
+	std::vector<NameCacheRecord> records;
+	records.reserve(mCache.size());
+	std::string pool;
+	pool.reserve(mCache.size() * 48);
+
 	cache_t::const_iterator it = mCache.begin();
 	for ( ; it != mCache.end(); ++it)
 	{
-		const LLUUID& agent_id = it->first;
 		const LLAvatarName& av_name = it->second;
 		// Do not write temporary or expired entries to the stored cache
-		if (av_name.isValidName(max_unrefreshed))
+		if (!av_name.isValidName(max_unrefreshed))
+		{
+			continue;
+		}
+		NameCacheRecord record;
+		memset(&record, 0, sizeof(record));
+		memcpy(record.mID, it->first.mData, UUID_BYTES);
+		record.mExpires = av_name.mExpires;
+		record.mNextUpdate = av_name.mNextUpdate;
+		record.mFlags = av_name.mIsDisplayNameDefault ? NameCacheRecord::FLAG_DISPLAY_NAME_DEFAULT : 0;
+		const std::string* strings[NameCacheRecord::STRING_COUNT] =
+			{ &av_name.mUsername, &av_name.mDisplayName, &av_name.mLegacyFirstName, &av_name.mLegacyLastName };
+		for (S32 n = 0; n < NameCacheRecord::STRING_COUNT; ++n)
 		{
-			// key must be a string
-			agents[agent_id.asString()] = av_name.asLLSD();
+			// Names are far shorter than this, anything else isn't a name
+			const size_t length = llmin(strings[n]->size(), (size_t)U16_MAX);
+			record.mOffsets[n] = (U32)pool.size();
+			record.mLengths[n] = (U16)length;
+			pool.append(*strings[n], 0, length);
 		}
+		records.push_back(record);
 	}
-    LL_INFOS("AvNameCache") << "LLAvatarNameCache returning " << agents.size() << LL_ENDL;
-	LLSD data;
-	data["agents"] = agents;
-	LLSDSerialize::toPrettyXML(data, ostr);
+    LL_INFOS("AvNameCache") << "LLAvatarNameCache returning " << records.size() << LL_ENDL;
+
+	NameCacheHeader header;
+	memcpy(header.mMagic, NAME_CACHE_MAGIC, sizeof(NAME_CACHE_MAGIC));
+	header.mVersion = NAME_CACHE_VERSION;
+	header.mCount = (U32)records.size();
+	header.mPoolSize = (U32)pool.size();
+	ostr.write((const char*)&header, sizeof(header));
+	if (!records.empty())
+	{
+		ostr.write((const char*)&records[0], records.size() * sizeof(NameCacheRecord));
+	}
+	ostr.write(pool.data(), pool.size());
 }
 
 void LLAvatarNameCache::setNameLookupURL(const std::string& name_lookup_url)
@@ -566,32 +733,28 @@ void LLAvatarNameCache::idle()
 	// By convention, start running at first idle() call
 	mRunning = true;
 
-	// *TODO: Possibly re-enabled this based on People API load measurements
-	// 100 ms is the threshold for "user speed" operations, so we can
-	// stall for about that long to batch up requests.
-	const F32 SECS_BETWEEN_REQUESTS = 0.1f;
-	if (!sRequestTimer.hasExpired())
+	if (usePeopleAPI())
 	{
-		return;
+		// Batching window and in-flight limit handled there
+		if (!mAskQueue.empty())
+		{
+			requestNamesViaCapability();
+		}
 	}
-
-	if (!mAskQueue.empty())
+	else if (sRequestTimer.hasExpired())
 	{
-        if (usePeopleAPI())
-        {
-            requestNamesViaCapability();
-        }
-        else
-        {
-            LL_WARNS_ONCE("AvNameCache") << "LLAvatarNameCache still using legacy api" << LL_ENDL;
-            requestNamesViaLegacy();
-        }
-	}
+		const F32 SECS_BETWEEN_REQUESTS = 0.1f;
+		if (!mAskQueue.empty())
+		{
+			LL_WARNS_ONCE("AvNameCache") << "LLAvatarNameCache still using legacy api" << LL_ENDL;
+			requestNamesViaLegacy();
+		}
 
-	if (mAskQueue.empty())
-	{
-		// cleared the list, reset the request timer.
-		sRequestTimer.resetWithExpiry(SECS_BETWEEN_REQUESTS);
+		if (mAskQueue.empty())
+		{
+			// cleared the list, reset the request timer.
+			sRequestTimer.resetWithExpiry(SECS_BETWEEN_REQUESTS);
+		}
 	}
 
     // erase anything that has not been refreshed for more than MAX_UNREFRESHED_TIME
@@ -663,7 +826,7 @@ bool LLAvatarNameCache::getName(const LLUUID& agent_id, LLAvatarName *av_name)
 	if (mRunning)
 	{
 		// ...only do immediate lookups when cache is running
-		std::map<LLUUID,LLAvatarName>::iterator it = mCache.find(agent_id);
+		cache_t::iterator it = mCache.find(agent_id);
 		if (it != mCache.end())
 		{
 			*av_name = it->second;
@@ -727,7 +890,7 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::getNameCallback(cons
 	if (mRunning)
 	{
 		// ...only do immediate lookups when cache is running
-		std::map<LLUUID,LLAvatarName>::iterator it = mCache.find(agent_id);
+		cache_t::iterator it = mCache.find(agent_id);
 		if (it != mCache.end())
 		{
 			LLAvatarName& av_name = it->second;
@@ -839,8 +1002,8 @@ void LLAvatarNameCache::insert(const LLUUID& agent_id, const LLAvatarName& av_na
 
 LLUUID LLAvatarNameCache::findIdByName(const std::string& name)
 {
-    std::map<LLUUID, LLAvatarName>::iterator it;
-    std::map<LLUUID, LLAvatarName>::iterator end = mCache.end();
+    cache_t::iterator it;
+    cache_t::iterator end = mCache.end();
     for (it = mCache.begin(); it != end; ++it)
     {
         if (it->second.getUserName() == name)
@@ -1048,3 +1211,13 @@ bool max_age_from_cache_control(const std::string& cache_control, S32 *max_age)
 	return false;
 }
 
+U32 max_ids_per_name_request(size_t base_url_len, size_t url_limit)
+{
+	// Each ID adds "?ids=" or "&ids=" and its 36 characters
+	const size_t per_id = 5 + (UUID_STR_LENGTH - 1);
+	if (url_limit <= base_url_len + per_id)
+	{
+		return 1;
+	}
+	return (U32)((url_limit - base_url_len) / per_id);
+}
@@ -31,6 +31,7 @@
 #include "llavatarname.h"	// for convenience
 #include "llsingleton.h"
 #include <boost/signals2.hpp>
+#include <boost/unordered_map.hpp>
 #include <set>
 
 class LLSD;
@@ -52,7 +53,9 @@ public:
 	}
 	// </FS:Ansariel>
 
-	// Import/export the name cache to file.
+	// Import/export the name cache to file.  Files are written in a
+	// compact binary form (open streams in binary mode), the older
+	// LLSD XML form is still read.  Expired names are dropped both ways.
 	bool importFile(std::istream& istr);
 	void exportFile(std::ostream& ostr);
 
@@ -66,8 +69,9 @@ public:
 	void setUsePeopleAPI(bool use_api);
 	bool usePeopleAPI();
 	
-	// Periodically makes a batch request for display names not already in
-	// cache. Called once per frame.
+	// Periodically makes batch requests for display names not already in
+	// cache. Full batches go out at once, a partial one after a short
+	// window so that bursts of lookups share requests. Called once per frame.
 	void idle();
 
 	// If name is in cache, returns true and fills in provided LLAvatarName
@@ -134,6 +138,8 @@ private:
 
     void requestNamesViaCapability();
 
+    bool importLLSDFile(std::istream& istr);
+
     // Legacy name system callbacks
     static void legacyNameCallback(const LLUUID& agent_id,
         const std::string& full_name,
@@ -190,6 +196,12 @@ private:
     typedef std::set<LLUUID> ask_queue_t;
     ask_queue_t mAskQueue;
 
+    // Frame time the oldest unsent ID in mAskQueue was seen, 0 if none
+    F64 mBatchStart;
+
+    // Capability requests currently in flight
+    S32 mRequestsInFlight;
+
     // Agent IDs that have been requested, but with no reply.
     // Maps agent ID to frame time request was made.
     typedef std::map<LLUUID, F64> pending_queue_t;
@@ -203,7 +215,7 @@ private:
     signal_map_t mSignalMap;
 
     // The cache at last, i.e. avatar names we know about.
-    typedef std::map<LLUUID, LLAvatarName> cache_t;
+    typedef boost::unordered_map<LLUUID, LLAvatarName> cache_t;
     cache_t mCache;
 
     // Time when unrefreshed cached names were checked last.
@@ -218,4 +230,9 @@ private:
 // Exported here to ease unit testing.
 bool max_age_from_cache_control(const std::string& cache_control, S32 *max_age);
 
+// Number of agent IDs that fit in one name lookup URL of at most
+// url_limit characters built on a base URL of base_url_len.  At least one.
+// Exported here to ease unit testing.
+U32 max_ids_per_name_request(size_t base_url_len, size_t url_limit);
+
 #endif
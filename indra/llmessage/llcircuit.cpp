@@ -63,8 +63,6 @@ const S32 PING_START_BLOCK = 3;		// How many pings behind we have to be to consi
 const S32 PING_RELEASE_BLOCK = 2;	// How many pings behind we have to be to consider ourself unblocked.
 
 const F32Seconds TARGET_PERIOD_LENGTH(5.f);
-const F32Seconds LL_DUPLICATE_SUPPRESSION_TIMEOUT(60.f); //this can be long, as time-based cleanup is
-													// only done when wrapping packetids, now...
 
 LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id, 
 							 const F32Seconds circuit_heartbeat_interval, const F32Seconds circuit_timeout)
@@ -73,6 +71,7 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mPacketsOutID(0), 
 	mPacketsInID(in_id),
 	mHighestPacketID(in_id),
+	mPacketOutSequence(std::make_shared<LLAtomicU32>(0U)),
 	mTimeoutCallback(NULL),
 	mTimeoutUserData(NULL),
 	mTrusted(FALSE),
@@ -124,6 +123,8 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 
 	mLocalEndPointID.generate();
 
+	memset(mReliablePacketSlots, 0, sizeof(mReliablePacketSlots));
+
 	// <FS:ND> Throttle to prevent log spam.
 	mLastPacketLog = 0;
 	mLogMessagesSkipped = 0;
@@ -140,11 +141,9 @@ LLCircuitData::~LLCircuitData()
 
 	// remove all pending reliable messages on this circuit
 	std::vector<TPACKETID> doomed;
-	reliable_iter iter;
-	reliable_iter end = mUnackedPackets.end();
-	for(iter = mUnackedPackets.begin(); iter != end; ++iter)
+	while ((packetp = mUnackedPackets.front()))
 	{
-		packetp = iter->second;
+		mUnackedPackets.erase(packetp);
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -163,10 +162,9 @@ LLCircuitData::~LLCircuitData()
 	}
 
 	// remove all pending final retry reliable messages on this circuit
-	end = mFinalRetryPackets.end();
-	for(iter = mFinalRetryPackets.begin(); iter != end; ++iter)
+	while ((packetp = mFinalRetryPackets.front()))
 	{
-		packetp = iter->second;
+		mFinalRetryPackets.erase(packetp);
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -198,83 +196,117 @@ LLCircuitData::~LLCircuitData()
 
 void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 {
-	reliable_iter iter;
-	LLReliablePacket *packetp;
+	LLReliablePacket *packetp = findReliablePacket(packet_num);
+	if (!packetp)
+	{
+		// Couldn't find this packet on either of the unacked lists.
+		// maybe it's a duplicate ack?
+		return;
+	}
 
-	iter = mUnackedPackets.find(packet_num);
-	if (iter != mUnackedPackets.end())
+	// LL_INFOS() << "Packet " << packet_num << " removed from the pending list" << LL_ENDL;
+	if(gMessageSystem->mVerboseLog)
 	{
-		packetp = iter->second;
+		std::ostringstream str;
+		str << "MSG: <- " << packetp->mHost << "\tRELIABLE ACKED:\t"
+			<< packetp->mPacketID;
+		LL_INFOS() << str.str() << LL_ENDL;
+	}
 
-		if(gMessageSystem->mVerboseLog)
-		{
-			std::ostringstream str;
-			str << "MSG: <- " << packetp->mHost << "\tRELIABLE ACKED:\t"
-				<< packetp->mPacketID;
-			LL_INFOS() << str.str() << LL_ENDL;
-		}
-		if (packetp->mCallback)
-		{
-			if (packetp->mTimeout < F32Seconds(0.f))   // negative timeout will always return timeout even for successful ack, for debugging
-			{
-				packetp->mCallback(packetp->mCallbackData,LL_ERR_TCP_TIMEOUT);					
-			}
-			else
-			{
-				packetp->mCallback(packetp->mCallbackData,LL_ERR_NOERR);
-			}
-		}
+	removeReliablePacketId(packetp);
+	if (packetp->mFinalRetry)
+	{
+		mFinalRetryPackets.erase(packetp);
+	}
+	else
+	{
+		mUnackedPackets.erase(packetp);
+	}
 
-		// Update stats
-		mUnackedPacketCount--;
-		mUnackedPacketBytes -= packetp->mBufferLength;
+	if (packetp->mTimeout < F32Seconds(0.f))   // negative timeout will always return timeout even for successful ack, for debugging
+	{
+		finishReliablePacket(packetp, LL_ERR_TCP_TIMEOUT);
+	}
+	else
+	{
+		finishReliablePacket(packetp, LL_ERR_NOERR);
+	}
+}
 
-		// Cleanup
-		delete packetp;
-		mUnackedPackets.erase(iter);
-		return;
+
+void LLCircuitData::finishReliablePacket(LLReliablePacket* packetp, S32 result)
+{
+	if (packetp->mCallback)
+	{
+		packetp->mCallback(packetp->mCallbackData, result);
 	}
 
-	iter = mFinalRetryPackets.find(packet_num);
-	if (iter != mFinalRetryPackets.end())
+	// Update stats
+	mUnackedPacketCount--;
+	mUnackedPacketBytes -= packetp->mBufferLength;
+
+	// Cleanup
+	delete packetp;
+}
+
+
+void LLCircuitData::addReliablePacketId(LLReliablePacket* packetp)
+{
+	LLReliablePacket*& slot = mReliablePacketSlots[packetp->mPacketID % LL_RELIABLE_PACKET_SLOTS];
+	if (!slot)
 	{
-		packetp = iter->second;
-		// LL_INFOS() << "Packet " << packet_num << " removed from the pending list" << LL_ENDL;
-		if(gMessageSystem->mVerboseLog)
-		{
-			std::ostringstream str;
-			str << "MSG: <- " << packetp->mHost << "\tRELIABLE ACKED:\t"
-				<< packetp->mPacketID;
-			LL_INFOS() << str.str() << LL_ENDL;
-		}
-		if (packetp->mCallback)
+		slot = packetp;
+	}
+	else
+	{
+		// Still waiting on a packet LL_RELIABLE_PACKET_SLOTS or more
+		// ids older, rare enough for a map.
+		mReliablePacketOverflow[packetp->mPacketID] = packetp;
+	}
+}
+
+
+LLReliablePacket* LLCircuitData::findReliablePacket(TPACKETID packet_num) const
+{
+	LLReliablePacket* packetp = mReliablePacketSlots[packet_num % LL_RELIABLE_PACKET_SLOTS];
+	if (packetp && packetp->mPacketID == packet_num)
+	{
+		return packetp;
+	}
+	if (!mReliablePacketOverflow.empty())
+	{
+		reliable_map::const_iterator iter = mReliablePacketOverflow.find(packet_num);
+		if (iter != mReliablePacketOverflow.end())
 		{
-			if (packetp->mTimeout < F32Seconds(0.f))   // negative timeout will always return timeout even for successful ack, for debugging
-			{
-				packetp->mCallback(packetp->mCallbackData,LL_ERR_TCP_TIMEOUT);					
-			}
-			else
-			{
-				packetp->mCallback(packetp->mCallbackData,LL_ERR_NOERR);
-			}
+			return iter->second;
 		}
+	}
+	return NULL;
+}
 
-		// Update stats
-		mUnackedPacketCount--;
-		mUnackedPacketBytes -= packetp->mBufferLength;
 
-		// Cleanup
-		delete packetp;
-		mFinalRetryPackets.erase(iter);
+void LLCircuitData::removeReliablePacketId(LLReliablePacket* packetp)
+{
+	LLReliablePacket*& slot = mReliablePacketSlots[packetp->mPacketID % LL_RELIABLE_PACKET_SLOTS];
+	if (slot == packetp)
+	{
+		slot = NULL;
 	}
 	else
 	{
-		// Couldn't find this packet on either of the unacked lists.
-		// maybe it's a duplicate ack?
+		mReliablePacketOverflow.erase(packetp->mPacketID);
 	}
 }
 
 
+void LLCircuitData::moveToFinalRetry(LLReliablePacket* packetp)
+{
+	mUnackedPackets.erase(packetp);
+	packetp->mFinalRetry = true;
+	mFinalRetryPackets.push_back(packetp);
+}
+
+
 
 S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 {
@@ -288,11 +320,11 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 	// I'm not going to worry about this for now - djs
 	//
 
-	reliable_iter iter;
+	LLReliablePacket *nextp;
 	BOOL have_resend_overflow = FALSE;
-	for (iter = mUnackedPackets.begin(); iter != mUnackedPackets.end();)
+	for (packetp = mUnackedPackets.front(); packetp; packetp = nextp)
 	{
-		packetp = iter->second;
+		nextp = LLReliablePacketList::next(packetp);
 
 		// Only check overflow if we haven't had one yet.
 		if (!have_resend_overflow)
@@ -313,12 +345,7 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 					// This circuit has overflowed.  Do not retry.  Do not pass go.
 					packetp->mRetries = 0;
 					// Remove it from this list and add it to the final list.
-					mUnackedPackets.erase(iter++);
-					mFinalRetryPackets[packetp->mPacketID] = packetp;
-				}
-				else
-				{
-					++iter;
+					moveToFinalRetry(packetp);
 				}
 				// Move on to the next unacked packet.
 				continue;
@@ -373,26 +400,17 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 			if (!packetp->mRetries)
 			{
 				// Last resend, remove it from this list and add it to the final list.
-				mUnackedPackets.erase(iter++);
-				mFinalRetryPackets[packetp->mPacketID] = packetp;
-			}
-			else
-			{
-				// Don't remove it yet, it still gets to try to resend at least once.
-				++iter;
+				moveToFinalRetry(packetp);
 			}
+			// Otherwise don't remove it yet, it still gets to try to resend at least once.
 		}
-		else
-		{
-			// Don't need to do anything with this packet, keep iterating.
-			++iter;
-		}
+		// Otherwise don't need to do anything with this packet, keep iterating.
 	}
 
 
-	for (iter = mFinalRetryPackets.begin(); iter != mFinalRetryPackets.end();)
+	for (packetp = mFinalRetryPackets.front(); packetp; packetp = nextp)
 	{
-		packetp = iter->second;
+		nextp = LLReliablePacketList::next(packetp);
 		if (now > packetp->mExpirationTime)
 		{
 			// fail (too many retries)
@@ -411,21 +429,9 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 				LL_INFOS() << str.str() << LL_ENDL;
 			}
 
-			if (packetp->mCallback)
-			{
-				packetp->mCallback(packetp->mCallbackData,LL_ERR_TCP_TIMEOUT);
-			}
-
-			// Update stats
-			mUnackedPacketCount--;
-			mUnackedPacketBytes -= packetp->mBufferLength;
-
-			mFinalRetryPackets.erase(iter++);
-			delete packetp;
-		}
-		else
-		{
-			++iter;
+			removeReliablePacketId(packetp);
+			mFinalRetryPackets.erase(packetp);
+			finishReliablePacket(packetp, LL_ERR_TCP_TIMEOUT);
 		}
 	}
 
@@ -494,10 +500,24 @@ void LLCircuit::removeCircuitData(const LLHost &host)
 	mLastCircuit = NULL;
 }
 
+void LLCircuit::getAckCircuits(ack_circuit_list_t& circuits) const
+{
+	circuits.clear();
+	for (circuit_data_map::const_iterator iter = mCircuitData.begin(); iter != mCircuitData.end(); ++iter)
+	{
+		const LLCircuitData* cdp = iter->second;
+		if (cdp->isAlive())
+		{
+			circuits.push_back(std::make_pair(cdp->mHost, cdp->mPacketOutSequence));
+		}
+	}
+}
+
 void LLCircuitData::setAlive(BOOL b_alive)
 {
 	if (mbAlive != b_alive)
 	{
+		*mPacketOutSequence = 0;
 		mPacketsOutID = 0;
 		mPacketsInID = 0;
 		mbAlive = b_alive;
@@ -549,6 +569,8 @@ void LLCircuitData::checkPeriodTime()
 		mBytesOutThisPeriod	= S32Bytes(0);
 		mLastPeriodLength	= F32Seconds::convert(period_length);
 
+		mThrottleEstimator.update(mLastPeriodLength.value(), mPacketsLost);
+
 		mPeriodTime = mt_sec;
 	}
 }
@@ -577,13 +599,15 @@ void LLCircuitData::addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLR
 	mUnackedPacketCount++;
 	mUnackedPacketBytes += packet_info->mBufferLength;
 
+	addReliablePacketId(packet_info);
 	if (params && params->mRetries)
 	{
-		mUnackedPackets[packet_info->mPacketID] = packet_info;
+		mUnackedPackets.push_back(packet_info);
 	}
 	else
 	{
-		mFinalRetryPackets[packet_info->mPacketID] = packet_info;
+		packet_info->mFinalRetry = true;
+		mFinalRetryPackets.push_back(packet_info);
 	}
 }
 
@@ -607,7 +631,13 @@ void LLCircuit::resendUnackedPackets(S32& unacked_list_length, S32& unacked_list
 
 BOOL LLCircuitData::isDuplicateResend(TPACKETID packetnum)
 {
-	return (mRecentlyReceivedReliablePackets.find(packetnum) != mRecentlyReceivedReliablePackets.end());
+	return mRecentlyReceivedReliablePackets.contains(packetnum);
+}
+
+
+void LLCircuitData::addRecentlyReceivedReliable(TPACKETID packetnum)
+{
+	mRecentlyReceivedReliablePackets.add(packetnum);
 }
 
 
@@ -885,90 +915,30 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 	// Find the current oldest reliable packetID
 	// This is to handle the case if we actually manage to wrap our
 	// packet IDs - the oldest will actually have a higher packet ID
-	// than the current.
-	BOOL wrapped = FALSE;
-	reliable_iter iter;
-	iter = mUnackedPackets.upper_bound(getPacketOutID());
-	if (iter == mUnackedPackets.end())
-	{
-		// Nothing AFTER this one, so we want the lowest packet ID
-		// then.
-		iter = mUnackedPackets.begin();
-		wrapped = TRUE;
-	}
-
-	TPACKETID packet_id = 0;
-
-	// Check against the "final" packets
-	BOOL wrapped_final = FALSE;
-	reliable_iter iter_final;
-	iter_final = mFinalRetryPackets.upper_bound(getPacketOutID());
-	if (iter_final == mFinalRetryPackets.end())
-	{
-		iter_final = mFinalRetryPackets.begin();
-		wrapped_final = TRUE;
-	}
-
-	//LL_INFOS() << mHost << " - unacked count " << mUnackedPackets.size() << LL_ENDL;
-	//LL_INFOS() << mHost << " - final count " << mFinalRetryPackets.size() << LL_ENDL;
-	if (wrapped != wrapped_final)
+	// than the current, so go by how far each is behind the current.
+	// The unacked list is in the order the packets were sent, but packets
+	// join the final list as they run out of resends, so search that one.
+	TPACKETID out_id = getPacketOutID();
+	TPACKETID packet_id = out_id;
+	U32 oldest_age = 0;
+	LLReliablePacket* packetp = mUnackedPackets.front();
+	if (packetp)
 	{
-		// One of the "unacked" or "final" lists hasn't wrapped.  Whichever one
-		// hasn't has the oldest packet.
-		if (!wrapped)
-		{
-			// Hasn't wrapped, so the one on the
-			// unacked packet list is older
-			packet_id = iter->first;
-			//LL_INFOS() << mHost << ": nowrapped unacked" << LL_ENDL;
-		}
-		else
-		{
-			packet_id = iter_final->first;
-			//LL_INFOS() << mHost << ": nowrapped final" << LL_ENDL;
-		}
+		packet_id = packetp->mPacketID;
+		oldest_age = LLModularMath::subtract<24>(out_id, packet_id);
 	}
-	else
+	for (packetp = mFinalRetryPackets.front(); packetp; packetp = LLReliablePacketList::next(packetp))
 	{
-		// They both wrapped, we can just use the minimum of the two.
-		if ((iter == mUnackedPackets.end()) && (iter_final == mFinalRetryPackets.end()))
-		{
-			// Wow!  No unacked packets at all!
-			// Send the ID of the last packet we sent out.
-			// This will flush all of the destination's
-			// unacked packets, theoretically.
-			//LL_INFOS() << mHost << ": No unacked!" << LL_ENDL;
-			packet_id = getPacketOutID();
-		}
-		else
+		U32 age = LLModularMath::subtract<24>(out_id, packetp->mPacketID);
+		if (age > oldest_age)
 		{
-			BOOL had_unacked = FALSE;
-			if (iter != mUnackedPackets.end())
-			{
-				// Unacked list has the lowest so far
-				packet_id = iter->first;
-				had_unacked = TRUE;
-				//LL_INFOS() << mHost << ": Unacked" << LL_ENDL;
-			}
-
-			if (iter_final != mFinalRetryPackets.end())
-			{
-				// Use the lowest of the unacked list and the final list
-				if (had_unacked)
-				{
-					// Both had a packet, use the lowest.
-					packet_id = llmin(packet_id, iter_final->first);
-					//LL_INFOS() << mHost << ": Min of unacked/final" << LL_ENDL;
-				}
-				else
-				{
-					// Only the final had a packet, use it.
-					packet_id = iter_final->first;
-					//LL_INFOS() << mHost << ": Final!" << LL_ENDL;
-				}
-			}
+			packet_id = packetp->mPacketID;
+			oldest_age = age;
 		}
 	}
+	// With no unacked packets at all, this sends the ID of the last
+	// packet we sent out.  This will flush all of the destination's
+	// unacked packets, theoretically.
 
 	nd::etw::tickTask( L"sendingPing" ); // <FS:ND/> Write an event for each ping we send. Happens every ~5 seconds.
 	// Send off the another ping.
@@ -1016,50 +986,19 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 
 void LLCircuitData::clearDuplicateList(TPACKETID oldest_id)
 {
-	// purge old data from the duplicate suppression queue
+	// purge old data from the duplicate suppression window
 
 	// we want to KEEP all x where oldest_id <= x <= last incoming packet, and delete everything else.
+	// The window compares ids modulo the id range, so entries from before
+	// the ids wrapped go the same way once oldest_id passes them, and any
+	// left behind fall out of the back of the window as packets arrive.
 
 	//LL_INFOS() << mHost << ": clearing before oldest " << oldest_id << LL_ENDL;
-	//LL_INFOS() << "Recent list before: " << mRecentlyReceivedReliablePackets.size() << LL_ENDL;
-	if (oldest_id < mHighestPacketID)
-	{
-		// Clean up everything with a packet ID less than oldest_id.
-		packet_time_map::iterator pit_start;
-		packet_time_map::iterator pit_end;
-		pit_start = mRecentlyReceivedReliablePackets.begin();
-		pit_end = mRecentlyReceivedReliablePackets.lower_bound(oldest_id);
-		mRecentlyReceivedReliablePackets.erase(pit_start, pit_end);
-	}
-
-	// Do timeout checks on everything with an ID > mHighestPacketID.
-	// This should be empty except for wrapping IDs.  Thus, this should be
-	// highly rare.
-	U64Microseconds mt_usec = LLMessageSystem::getMessageTimeUsecs();
-
-	packet_time_map::iterator pit;
-	for(pit = mRecentlyReceivedReliablePackets.upper_bound(mHighestPacketID);
-		pit != mRecentlyReceivedReliablePackets.end(); )
+	U32 behind = LLModularMath::subtract<24>(mHighestPacketID, oldest_id);
+	if (behind && behind < LL_MAX_OUT_PACKET_ID / 2)
 	{
-		// Validate that the packet ID seems far enough away
-		if ((pit->first - mHighestPacketID) < 100)
-		{
-			LL_WARNS() << "Probably incorrectly timing out non-wrapped packets!" << LL_ENDL;
-		}
-		U64Microseconds delta_t_usec = mt_usec - (*pit).second;
-		F64Seconds delta_t_sec = delta_t_usec;
-		if (delta_t_sec > LL_DUPLICATE_SUPPRESSION_TIMEOUT)
-		{
-			// enough time has elapsed we're not likely to get a duplicate on this one
-			LL_INFOS() << "Clearing " << pit->first << " from recent list" << LL_ENDL;
-			mRecentlyReceivedReliablePackets.erase(pit++);
-		}
-		else
-		{
-			++pit;
-		}
+		mRecentlyReceivedReliablePackets.removeBefore(oldest_id);
 	}
-	//LL_INFOS() << "Recent list after: " << mRecentlyReceivedReliablePackets.size() << LL_ENDL;
 }
 
 BOOL LLCircuitData::checkCircuitTimeout()
@@ -1262,7 +1201,7 @@ TPACKETID LLCircuitData::nextPacketOutID()
 	
 	TPACKETID id; 
 
-	id = (mPacketsOutID + 1) % LL_MAX_OUT_PACKET_ID;
+	id = (++(*mPacketOutSequence)) % LL_MAX_OUT_PACKET_ID;
 			
 	if (id < mPacketsOutID)
 	{
@@ -29,14 +29,17 @@
 #define LL_LLCIRCUIT_H
 
 #include <map>
+#include <memory>
 #include <vector>
 
+#include "llatomic.h"
 #include "llerror.h"
 
 #include "lltimer.h"
 #include "net.h"
 #include "llhost.h"
 #include "llpacketack.h"
+#include "llpacketidwindow.h"
 #include "lluuid.h"
 #include "llthrottle.h"
 
@@ -50,6 +53,13 @@ const F32Milliseconds LL_AVERAGED_PING_MIN(100);    // increased to avoid retran
 const U32Milliseconds INITIAL_PING_VALUE_MSEC(1000); // initial value for the ping delay, or for ping delay for an unknown circuit
 
 const TPACKETID LL_MAX_OUT_PACKET_ID = 0x01000000;
+
+// Outgoing packet ID counter of a circuit.  It is shared with the UDP
+// network thread (see LLUDPThread) so that the acks sent from there are
+// numbered in sequence with everything else sent on the circuit.  The
+// counter only ever increments; ids are taken modulo LL_MAX_OUT_PACKET_ID,
+// which divides 2^32, so the sequence survives the U32 wrapping.
+typedef std::shared_ptr<LLAtomicU32> packet_sequence_ptr_t;
 const int LL_ERR_CIRCUIT_GONE   = -23017;
 const int LL_ERR_TCP_TIMEOUT    = -23016;
 
@@ -58,6 +68,10 @@ const int LL_ERR_TCP_TIMEOUT    = -23016;
 // 5 - data offset (after message name)
 const U8 LL_PACKET_ID_SIZE = 6;
 
+// Slots of the ring LLCircuitData finds unacked reliable packets in by id.
+// Packets whose slot is still taken by one this many ids older go in a map.
+const U32 LL_RELIABLE_PACKET_SLOTS = 4096;
+
 const S32 LL_MAX_RESENT_PACKETS_PER_FRAME = 100;
 const S32 LL_MAX_ACKED_PACKETS_PER_FRAME = 200;
 const F32 LL_COLLECT_ACK_TIME_MAX = 2.f;
@@ -122,6 +136,7 @@ public:
 	U32			getPacketsOut() const;
 	U32			getPacketsLost() const;
 	TPACKETID	getPacketOutID() const;
+	const packet_sequence_ptr_t& getPacketOutSequence() const	{ return mPacketOutSequence; }
 	BOOL		getTrusted() const;
 	F32			getAgeInSeconds() const;
 	S32			getUnackedPacketCount() const	{ return mUnackedPacketCount; }
@@ -132,6 +147,7 @@ public:
 	F64Seconds	getLastPacketInTime() const		{ return mLastPacketInTime;	}
 
 	LLThrottleGroup &getThrottleGroup()		{	return mThrottles; }
+	LLThrottleEstimator &getThrottleEstimator()	{	return mThrottleEstimator; }
 
 	class less
 	{
@@ -177,6 +193,9 @@ protected:
 
 	void			addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLReliablePacketParams *params);
 	BOOL			isDuplicateResend(TPACKETID packetnum);
+	// Call this method when a reliable message comes in, so that
+	// resends of it are recognised as duplicates.
+	void			addRecentlyReceivedReliable(TPACKETID packetnum);
 	// Call this method when a reliable message comes in - this will
 	// correctly place the packet in the correct list to be acked
 	// later. RAack = requested ack
@@ -191,20 +210,29 @@ protected:
 	void			setAllowTimeout(BOOL allow);
 
 protected:
+	void				addReliablePacketId(LLReliablePacket* packetp);
+	LLReliablePacket*	findReliablePacket(TPACKETID packet_num) const;
+	void				removeReliablePacketId(LLReliablePacket* packetp);
+	void				moveToFinalRetry(LLReliablePacket* packetp);
+	// Calls back and deletes a packet that is on neither list.
+	void				finishReliablePacket(LLReliablePacket* packetp, S32 result);
+
 	// Identification for this circuit.
 	LLHost mHost;
 	LLUUID mRemoteID;
 	LLUUID mRemoteSessionID;
 
 	LLThrottleGroup	mThrottles;
+	LLThrottleEstimator	mThrottleEstimator;	// Measured downstream capacity, fed once per period
 
 	TPACKETID		mWrapID;
 
 	// Current packet IDs of incoming/outgoing packets
 	// Used for packet sequencing/packet loss detection.
-	TPACKETID		mPacketsOutID;
+	TPACKETID		mPacketsOutID;		// last id returned by nextPacketOutID()
 	TPACKETID		mPacketsInID;
 	TPACKETID		mHighestPacketID;
+	packet_sequence_ptr_t	mPacketOutSequence;
 
 
 	// Callback and data to run in the case of a circuit timeout.
@@ -236,15 +264,21 @@ protected:
 	typedef std::map<TPACKETID, U64Microseconds> packet_time_map;
 
 	packet_time_map							mPotentialLostPackets;
-	packet_time_map							mRecentlyReceivedReliablePackets;
+	LLPacketIdWindow						mRecentlyReceivedReliablePackets;
 	std::vector<TPACKETID> mAcks;
 	F32 mAckCreationTime; // first ack creation time
 
 	typedef std::map<TPACKETID, LLReliablePacket *> reliable_map;
-	typedef reliable_map::iterator					reliable_iter;
 
-	reliable_map							mUnackedPackets;
-	reliable_map							mFinalRetryPackets;
+	// Reliable packets waiting for an ack, in the order they were sent.
+	// Packets move to the final retry list when they have no resends left.
+	LLReliablePacketList					mUnackedPackets;
+	LLReliablePacketList					mFinalRetryPackets;
+
+	// Packets on either list by id: each in the slot of its id modulo
+	// LL_RELIABLE_PACKET_SLOTS, or in the overflow map if that was taken.
+	LLReliablePacket*						mReliablePacketSlots[LL_RELIABLE_PACKET_SLOTS];
+	reliable_map							mReliablePacketOverflow;
 
 	S32										mUnackedPacketCount;
 	S32										mUnackedPacketBytes;
@@ -318,6 +352,10 @@ public:
 
 	typedef std::map<LLHost, LLCircuitData*> circuit_data_map;
 
+	// Host and outgoing packet sequence of every alive circuit, for LLUDPThread
+	typedef std::vector<std::pair<LLHost, packet_sequence_ptr_t> > ack_circuit_list_t;
+	void getAckCircuits(ack_circuit_list_t& circuits) const;
+
 	/**
 	 * @brief This method gets an iterator range starting after key in
 	 * the circuit data map.
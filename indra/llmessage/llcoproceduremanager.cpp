@@ -31,11 +31,18 @@
 
 #include "llcoproceduremanager.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <mutex>
 
 #include <boost/fiber/buffered_channel.hpp>
 
+#include "llcond.h"
 #include "llexception.h"
+#include "lltimer.h"
 #include "stringize.h"
 
 //=========================================================================
@@ -51,6 +58,18 @@ static const U32 DEFAULT_POOL_SIZE = 5;
 // gets absolutely slammed with fetch requests. Make this queue effectively
 // unlimited.
 const U32 LLCoprocedureManager::DEFAULT_QUEUE_SIZE = 1024*1024;
+const F32 LLCoprocedureManager::PRIORITY_AGING = 10.f;
+
+// Concurrency tuning.  Pools run up to their configured size but back
+// off while work is waiting and coprocedures take markedly longer than
+// the same kind of coprocedure used to, the same latency gradient
+// llcorehttp uses for its policy classes.
+static const F64 CONCURRENCY_WINDOW = 1.0;      // seconds
+static const S32 CONCURRENCY_WINDOW_SAMPLES = 4;
+static const F64 LATENCY_TOLERANCE = 1.5;
+static const F64 BASE_FALL = 0.5;
+static const F64 BASE_RISE = 0.01;
+static const F64 MIN_BASE_RUN_TIME = 0.001;     // seconds
 
 //=========================================================================
 class LLCoprocedurePool: private boost::noncopyable
@@ -67,12 +86,19 @@ public:
     /// @param proc Is a bound function to be executed 
     /// 
     /// @return This method returns a UUID that can be used later to cancel execution.
-    LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc);
+    LLUUID enqueueCoprocedure(const std::string &name, CoProcedure_t proc,
+                              LLCoprocedureManager::EPriority priority, F32 max_queue_age);
+
+    /// Removes a coprocedure that hasn't started yet.
+    bool cancelCoprocedure(const LLUUID &id);
+
+    LLSD getStats() const;
 
     /// Returns the number of coprocedures in the queue awaiting processing.
     ///
     inline size_t countPending() const
     {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
         return mPending;
     }
 
@@ -97,21 +123,27 @@ private:
     {
         typedef boost::shared_ptr<QueuedCoproc> ptr_t;
 
-        QueuedCoproc(const std::string &name, const LLUUID &id, CoProcedure_t proc) :
+        QueuedCoproc(const std::string &name, const LLUUID &id, CoProcedure_t proc, F32 max_queue_age) :
             mName(name),
             mId(id),
-            mProc(proc)
+            mProc(proc),
+            mQueued(LLTimer::getTotalSeconds()),
+            mMaxQueueAge(max_queue_age)
         {}
 
         std::string mName;
         LLUUID mId;
         CoProcedure_t mProc;
+        F64 mQueued;
+        F32 mMaxQueueAge;
     };
+    typedef std::deque<QueuedCoproc::ptr_t> PriorityQueue_t;
 
     // we use a buffered_channel here rather than unbuffered_channel since we want to be able to 
     // push values without blocking,even if there's currently no one calling a pop operation (due to
-    // fiber running right now)
-    typedef boost::fibers::buffered_channel<QueuedCoproc::ptr_t>  CoprocQueue_t;
+    // fiber running right now).  It carries one token per queued coprocedure to wake a worker,
+    // the coprocedures themselves wait in mQueues so they can be taken in priority order.
+    typedef boost::fibers::buffered_channel<U8>  CoprocQueue_t;
     // Use shared_ptr to control the lifespan of our CoprocQueue_t instance
     // because the consuming coroutine might outlive this LLCoprocedurePool
     // instance.
@@ -122,13 +154,38 @@ private:
     CoprocQueuePtr  mPendingCoprocs;
     LLTempBoundListener mStatusListener;
 
+    mutable std::mutex mQueueMutex;
+    PriorityQueue_t mQueues[LLCoprocedureManager::PRIORITY_COUNT];
+
+    // Number of workers allowed to run at once, at most mPoolSize
+    mutable LLScalarCond<size_t> mConcurrency;
+    F64             mWindowStart, mWindowSlowdown, mLastSlowdown;
+    S32             mWindowSamples;
+    size_t          mPeakActive;
+    // Typical run time by coprocedure name, so a pool mixing quick and
+    // slow kinds of work measures each against its own kind
+    typedef std::map<std::string, F64> BaseRunTimes_t;
+    BaseRunTimes_t  mBaseRunTimes;
+
+    // Queue metrics
+    F64             mWaitSum, mMaxWait;
+    U32             mDequeued, mCancelled, mExpired;
+
     typedef std::map<std::string, LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t> CoroAdapterMap_t;
     LLCore::HttpRequest::policy_t mHTTPPolicy;
 
     CoroAdapterMap_t mCoroMapping;
 
     void coprocedureInvokerCoro(CoprocQueuePtr pendingCoprocs,
-                                LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter);
+                                LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter,
+                                size_t index);
+
+    /// Takes the coprocedure to run next, dropping any that waited too
+    /// long into 'expired'.  Callers let those go after the lock is
+    /// released, see coprocedureInvokerCoro().
+    QueuedCoproc::ptr_t takeNext(std::vector<QueuedCoproc::ptr_t> &expired);
+
+    void updateConcurrency(const std::string &name, F64 run_time);
 };
 
 //=========================================================================
@@ -188,7 +245,8 @@ void LLCoprocedureManager::initializePool(const std::string &poolName)
 }
 
 //-------------------------------------------------------------------------
-LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc)
+LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc,
+                                                EPriority priority, F32 max_queue_age)
 {
     // Attempt to find the pool and enqueue the procedure.  If the pool does 
     // not exist, create it.
@@ -202,7 +260,19 @@ LLUUID LLCoprocedureManager::enqueueCoprocedure(const std::string &pool, const s
     }
 
     poolPtr_t targetPool = it->second;
-    return targetPool->enqueueCoprocedure(name, proc);
+    return targetPool->enqueueCoprocedure(name, proc, priority, max_queue_age);
+}
+
+bool LLCoprocedureManager::cancelCoprocedure(const LLUUID &id)
+{
+    for (const auto& pair : mPoolMap)
+    {
+        if (pair.second->cancelCoprocedure(id))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 void LLCoprocedureManager::setPropertyMethods(SettingQuery_t queryfn, SettingUpdate_t updatefn)
@@ -278,10 +348,21 @@ size_t LLCoprocedureManager::count(const std::string &pool) const
     return it->second->count();
 }
 
+LLSD LLCoprocedureManager::getStats() const
+{
+    LLSD stats = LLSD::emptyMap();
+    for (const auto& pair : mPoolMap)
+    {
+        stats[pair.first] = pair.second->getStats();
+    }
+    return stats;
+}
+
 void LLCoprocedureManager::close()
 {
     for(auto & poolEntry : mPoolMap)
     {
+        LL_INFOS("CoProcMgr") << "Pool " << poolEntry.first << " stats: " << poolEntry.second->getStats() << LL_ENDL;
         poolEntry.second->close();
     }
 }
@@ -302,6 +383,17 @@ LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size):
     mActiveCoprocsCount(0),
     mPending(0),
     mPendingCoprocs(boost::make_shared<CoprocQueue_t>(LLCoprocedureManager::DEFAULT_QUEUE_SIZE)),
+    mConcurrency(size),
+    mWindowStart(0.0),
+    mWindowSlowdown(0.0),
+    mLastSlowdown(1.0),
+    mWindowSamples(0),
+    mPeakActive(0),
+    mWaitSum(0.0),
+    mMaxWait(0.0),
+    mDequeued(0),
+    mCancelled(0),
+    mExpired(0),
     mHTTPPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
     mCoroMapping()
 {
@@ -347,7 +439,7 @@ LLCoprocedurePool::LLCoprocedurePool(const std::string &poolName, size_t size):
         std::string pooledCoro = LLCoros::instance().launch(
             "LLCoprocedurePool("+mPoolName+")::coprocedureInvokerCoro",
             boost::bind(&LLCoprocedurePool::coprocedureInvokerCoro, this,
-                        mPendingCoprocs, httpAdapter));
+                        mPendingCoprocs, httpAdapter, count));
 
         mCoroMapping.insert(CoroAdapterMap_t::value_type(pooledCoro, httpAdapter));
     }
@@ -360,7 +452,8 @@ LLCoprocedurePool::~LLCoprocedurePool()
 }
 
 //-------------------------------------------------------------------------
-LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoprocedurePool::CoProcedure_t proc)
+LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoprocedurePool::CoProcedure_t proc,
+                                             LLCoprocedureManager::EPriority priority, F32 max_queue_age)
 {
     LLUUID id(LLUUID::generateNewID());
 
@@ -384,13 +477,26 @@ LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoproced
         LL_DEBUGS("CoProcMgr") << "Coprocedure(" << name << ") enqueuing with id=" << id.asString() << " in pool \"" << mPoolName << "\" at "
                               << mPending << LL_ENDL;
     }
-    auto pushed = mPendingCoprocs->try_push(boost::make_shared<QueuedCoproc>(name, id, proc));
-    if (pushed == boost::fibers::channel_op_status::success)
+    QueuedCoproc::ptr_t coproc(boost::make_shared<QueuedCoproc>(name, id, proc, max_queue_age));
+    priority = llclamp(priority, LLCoprocedureManager::PRIORITY_LOW, LLCoprocedureManager::PRIORITY_HIGH);
     {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mQueues[priority].push_back(coproc);
         ++mPending;
+    }
+    auto pushed = mPendingCoprocs->try_push(priority);
+    if (pushed == boost::fibers::channel_op_status::success)
+    {
         return id;
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        PriorityQueue_t &queue(mQueues[priority]);
+        queue.erase(std::find(queue.begin(), queue.end(), coproc));
+        --mPending;
+    }
+
     // Here we didn't succeed in pushing. Shutdown could be the reason.
     if (pushed == boost::fibers::channel_op_status::closed)
     {
@@ -403,13 +509,205 @@ LLUUID LLCoprocedurePool::enqueueCoprocedure(const std::string &name, LLCoproced
     return {};                      // never executed, pacify the compiler
 }
 
+bool LLCoprocedurePool::cancelCoprocedure(const LLUUID &id)
+{
+    // Let go of the coprocedure outside the lock, its bound arguments
+    // may enqueue more work when they are destroyed.
+    QueuedCoproc::ptr_t coproc;
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        for (PriorityQueue_t &queue : mQueues)
+        {
+            for (PriorityQueue_t::iterator it = queue.begin(); it != queue.end(); ++it)
+            {
+                if ((*it)->mId == id)
+                {
+                    coproc = *it;
+                    queue.erase(it);
+                    --mPending;
+                    ++mCancelled;
+                    break;
+                }
+            }
+            if (coproc)
+            {
+                break;
+            }
+        }
+    }
+    if (!coproc)
+    {
+        return false;
+    }
+    // The worker woken by its token will find nothing and go back to waiting
+    LL_DEBUGS("CoProcMgr") << "Cancelled coprocedure(" << coproc->mName << ") in pool \"" << mPoolName << "\"" << LL_ENDL;
+    return true;
+}
+
+LLSD LLCoprocedurePool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    F64 now = LLTimer::getTotalSeconds();
+    F64 oldest = 0.0;
+    for (const PriorityQueue_t &queue : mQueues)
+    {
+        if (!queue.empty())
+        {
+            oldest = llmax(oldest, now - queue.front()->mQueued);
+        }
+    }
+
+    LLSD stats;
+    stats["pending"] = LLSD::Integer(mPending);
+    stats["active"] = LLSD::Integer(mActiveCoprocsCount);
+    stats["size"] = LLSD::Integer(mPoolSize);
+    stats["concurrency"] = LLSD::Integer(mConcurrency.get());
+    stats["oldest_pending"] = oldest;
+    stats["mean_wait"] = mDequeued ? mWaitSum / mDequeued : 0.0;
+    stats["max_wait"] = mMaxWait;
+    stats["slowdown"] = mLastSlowdown;
+    stats["cancelled"] = LLSD::Integer(mCancelled);
+    stats["expired"] = LLSD::Integer(mExpired);
+    return stats;
+}
+
+//-------------------------------------------------------------------------
+LLCoprocedurePool::QueuedCoproc::ptr_t LLCoprocedurePool::takeNext(std::vector<QueuedCoproc::ptr_t> &expired)
+{
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    F64 now = LLTimer::getTotalSeconds();
+
+    // Drop whatever has outlived its max queue age.  Queues are in
+    // arrival order, but ages vary so check every entry.
+    for (PriorityQueue_t &queue : mQueues)
+    {
+        for (PriorityQueue_t::iterator it = queue.begin(); it != queue.end(); )
+        {
+            const QueuedCoproc::ptr_t &coproc(*it);
+            if (coproc->mMaxQueueAge > 0.f && now - coproc->mQueued > coproc->mMaxQueueAge)
+            {
+                expired.push_back(coproc);
+                it = queue.erase(it);
+                --mPending;
+                ++mExpired;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // Highest priority after aging wins, ties go to the longest waiting
+    PriorityQueue_t *best = NULL;
+    F64 best_rank = -1.0;
+    F64 best_wait = 0.0;
+    for (S32 priority = 0; priority < LLCoprocedureManager::PRIORITY_COUNT; ++priority)
+    {
+        PriorityQueue_t &queue(mQueues[priority]);
+        if (queue.empty())
+        {
+            continue;
+        }
+        F64 wait = now - queue.front()->mQueued;
+        F64 rank = priority + std::floor(wait / LLCoprocedureManager::PRIORITY_AGING);
+        if (rank > best_rank || (rank == best_rank && wait > best_wait))
+        {
+            best = &queue;
+            best_rank = rank;
+            best_wait = wait;
+        }
+    }
+    if (!best)
+    {
+        return QueuedCoproc::ptr_t();
+    }
+
+    QueuedCoproc::ptr_t coproc(best->front());
+    best->pop_front();
+    --mPending;
+    ++mDequeued;
+    mWaitSum += best_wait;
+    mMaxWait = llmax(mMaxWait, best_wait);
+    return coproc;
+}
+
+void LLCoprocedurePool::updateConcurrency(const std::string &name, F64 run_time)
+{
+    F64 now = LLTimer::getTotalSeconds();
+    if (mWindowStart <= 0.0)
+    {
+        mWindowStart = now;
+    }
+
+    // How much slower than usual for its kind this one ran
+    F64 &base = mBaseRunTimes[name];
+    F64 slowdown = 1.0;
+    if (base <= 0.0)
+    {
+        base = run_time;
+    }
+    else
+    {
+        slowdown = run_time / llmax(base, MIN_BASE_RUN_TIME);
+        base += (run_time - base) * (run_time < base ? BASE_FALL : BASE_RISE);
+    }
+    mWindowSlowdown += slowdown;
+    ++mWindowSamples;
+    if (now - mWindowStart < CONCURRENCY_WINDOW || mWindowSamples < CONCURRENCY_WINDOW_SAMPLES)
+    {
+        return;
+    }
+
+    mLastSlowdown = mWindowSlowdown / mWindowSamples;
+    bool queued = countPending() > 0;
+
+    size_t limit = mConcurrency.get();
+    size_t new_limit = limit;
+    if (mLastSlowdown > LATENCY_TOLERANCE && queued)
+    {
+        // Work is waiting and taking longer than it used to, something
+        // is queueing up behind us.  Ease off.
+        new_limit = llmax(limit - 1, size_t(1));
+    }
+    else if (mLastSlowdown <= LATENCY_TOLERANCE && mPeakActive >= limit && queued)
+    {
+        // Keeping up and every worker was busy with more waiting
+        new_limit = llmin(limit + 1, mPoolSize);
+    }
+    if (new_limit != limit)
+    {
+        LL_DEBUGS("CoProcMgr") << "Pool \"" << mPoolName << "\" concurrency " << limit << " -> " << new_limit
+                               << " (" << mLastSlowdown << "x usual run time)" << LL_ENDL;
+        mConcurrency.set_all(new_limit);
+    }
+
+    mWindowStart = now;
+    mWindowSlowdown = 0.0;
+    mWindowSamples = 0;
+    mPeakActive = mActiveCoprocsCount;
+}
+
 //-------------------------------------------------------------------------
 void LLCoprocedurePool::coprocedureInvokerCoro(
     CoprocQueuePtr pendingCoprocs,
-    LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter)
+    LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t httpAdapter,
+    size_t index)
 {
     for (;;)
     {
+        // Workers past the current concurrency limit sit out until it rises
+        if (index >= mConcurrency.get())
+        {
+            LLCoros::TempStatus st("waiting for concurrency for 10s");
+            mConcurrency.wait_for(std::chrono::seconds(10), [index](size_t limit) { return index < limit; });
+            if (pendingCoprocs->is_closed())
+            {
+                break;
+            }
+            continue;
+        }
+
         // It is VERY IMPORTANT that we instantiate a new ptr_t just before
         // the pop_wait_for() call below. When this ptr_t was declared at
         // function scope (outside the for loop), NickyD correctly diagnosed a
@@ -428,10 +726,11 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
         // Using a fresh, clean ptr_t ensures that no previous value is
         // destroyed during pop_wait_for().
         QueuedCoproc::ptr_t coproc;
+        U8 token;
         boost::fibers::channel_op_status status;
         {
             LLCoros::TempStatus st("waiting for work for 10s");
-            status = pendingCoprocs->pop_wait_for(coproc, std::chrono::seconds(10));
+            status = pendingCoprocs->pop_wait_for(token, std::chrono::seconds(10));
         }
         if (status == boost::fibers::channel_op_status::closed)
         {
@@ -443,9 +742,24 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
             LL_DEBUGS_ONCE("CoProcMgr") << "pool '" << mPoolName << "' waiting." << LL_ENDL;
             continue;
         }
-        // we actually popped an item
-        --mPending;
+        // we actually popped a token, take the most urgent coprocedure
+        // waiting (not necessarily the one that pushed this token)
+        std::vector<QueuedCoproc::ptr_t> expired;
+        coproc = takeNext(expired);
+        for (const QueuedCoproc::ptr_t &stale : expired)
+        {
+            LL_WARNS("CoProcMgr") << "Dropping coprocedure(" << stale->mName << ") in pool \"" << mPoolName
+                                  << "\" after waiting longer than " << stale->mMaxQueueAge << "s" << LL_ENDL;
+        }
+        expired.clear();
+        if (!coproc)
+        {
+            // Cancelled or expired after its token was pushed
+            continue;
+        }
         mActiveCoprocsCount++;
+        mPeakActive = llmax(mPeakActive, mActiveCoprocsCount);
+        F64 start = LLTimer::getTotalSeconds();
 
         LL_DEBUGS("CoProcMgr") << "Dequeued and invoking coprocedure(" << coproc->mName << ") with id=" << coproc->mId.asString() << " in pool \"" << mPoolName << "\" (" << mPending << " left)" << LL_ENDL;
 
@@ -473,6 +787,7 @@ void LLCoprocedurePool::coprocedureInvokerCoro(
         LL_DEBUGS("CoProcMgr") << "Finished coprocedure(" << coproc->mName << ")" << " in pool \"" << mPoolName << "\"" << LL_ENDL;
 
         mActiveCoprocsCount--;
+        updateConcurrency(coproc->mName, LLTimer::getTotalSeconds() - start);
     }
 }
 
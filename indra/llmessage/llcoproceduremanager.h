@@ -46,18 +46,35 @@ public:
 
     typedef boost::function<void(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, const LLUUID &id)> CoProcedure_t;
 
+    /// A pool runs its highest priority coprocedure first and those of
+    /// equal priority in the order they were queued.  A coprocedure
+    /// gains a level for every PRIORITY_AGING seconds it waits so that
+    /// background work can't starve.
+    enum EPriority
+    {
+        PRIORITY_LOW = 0,       // Background fetches
+        PRIORITY_NORMAL,
+        PRIORITY_HIGH,          // Something the user is waiting on
+        PRIORITY_COUNT
+    };
+
     /// Places the coprocedure on the queue for processing. 
     /// 
     /// @param name Is used for debugging and should identify this coroutine.
     /// @param proc Is a bound function to be executed 
+    /// @param priority Where it goes in the pool's queue.
+    /// @param max_queue_age Seconds it may wait in the queue before being
+    ///        dropped without running, 0 to wait as long as it takes.
     /// 
     /// @return This method returns a UUID that can be used later to cancel execution.
-    LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc);
+    LLUUID enqueueCoprocedure(const std::string &pool, const std::string &name, CoProcedure_t proc,
+                              EPriority priority = PRIORITY_NORMAL, F32 max_queue_age = 0.f);
 
-    /// Cancel a coprocedure. If the coprocedure is already being actively executed 
-    /// this method calls cancelYieldingOperation() on the associated HttpAdapter
-    /// If it has not yet been dequeued it is simply removed from the queue.
-    //void cancelCoprocedure(const LLUUID &id);
+    /// Cancel a coprocedure that is still waiting in its queue.  One
+    /// that has already started runs to completion.
+    ///
+    /// @return true if it was found and removed.
+    bool cancelCoprocedure(const LLUUID &id);
 
     void setPropertyMethods(SettingQuery_t queryfn, SettingUpdate_t updatefn);
 
@@ -76,6 +93,10 @@ public:
     size_t count() const;
     size_t count(const std::string &pool) const;
 
+    /// Returns queue wait times, concurrency and drop counts for each
+    /// pool, keyed by pool name.
+    LLSD getStats() const;
+
     void close();
     void close(const std::string &pool);
 
@@ -93,6 +114,7 @@ private:
 
 public:
     static const U32 DEFAULT_QUEUE_SIZE;
+    static const F32 PRIORITY_AGING;
 };
 
 #endif
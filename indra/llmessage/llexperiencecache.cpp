@@ -83,13 +83,15 @@ const int LLExperienceCache::PROPERTY_SUSPENDED	= 1 << 7;
 
 // default values
 const F64 LLExperienceCache::DEFAULT_EXPIRATION	= 600.0;
+const F64 LLExperienceCache::GROUP_EXPIRATION		= 3600.0;
 const S32 LLExperienceCache::DEFAULT_QUOTA			= 128; // this is megabytes
 const int LLExperienceCache::SEARCH_PAGE_SIZE     = 30;
 
 bool LLExperienceCache::sShutdown = false;
 
 //=========================================================================
-LLExperienceCache::LLExperienceCache()
+LLExperienceCache::LLExperienceCache():
+    mCacheLoaded(false)
 {
 }
 
@@ -103,16 +105,11 @@ void LLExperienceCache::initSingleton()
     //mCacheFileName = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "experience_cache.xml");
     const std::string grid_id_str = LLDir::getScrubbedFileName(LLGridManager::getInstance()->getGridId());
     const std::string& grid_id_lower = utf8str_tolower(grid_id_str);
-    mCacheFileName = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "experience_cache." + grid_id_lower + ".xml");
+    mCacheFileName = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "experience_cache." + grid_id_lower + ".llsd");
+    mLegacyCacheFileName = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "experience_cache." + grid_id_lower + ".xml");
     // </FS:Ansariel>
 
-    LL_INFOS("ExperienceCache") << "Loading " << mCacheFileName << LL_ENDL;
-    llifstream cache_stream(mCacheFileName.c_str());
-
-    if (cache_stream.is_open())
-    {
-        cache_stream >> (*this);
-    }
+    // The cache file itself is read on first use, see loadCache()
 
     LLCoprocedureManager::instance().initializePool("ExpCache");
 
@@ -123,34 +120,67 @@ void LLExperienceCache::initSingleton()
 
 void LLExperienceCache::cleanup()
 {
-    LL_INFOS("ExperienceCache") << "Saving " << mCacheFileName << LL_ENDL;
+    // Never loaded means nothing changed, leave the file as it is
+    if (mCacheLoaded)
+    {
+        LL_INFOS("ExperienceCache") << "Saving " << mCacheFileName << LL_ENDL;
+
+        llofstream cache_stream(mCacheFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (cache_stream.is_open())
+        {
+            cache_stream << (*this);
+            LLFile::remove(mLegacyCacheFileName, ENOENT);
+        }
+    }
+    sShutdown = true;
+}
+
+void LLExperienceCache::loadCache()
+{
+    if (mCacheLoaded)
+    {
+        return;
+    }
+    mCacheLoaded = true;
+
+    std::string filename = LLFile::isfile(mCacheFileName) ? mCacheFileName : mLegacyCacheFileName;
+    LL_INFOS("ExperienceCache") << "Loading " << filename << LL_ENDL;
+    llifstream cache_stream(filename.c_str(), std::ios::in | std::ios::binary);
 
-    llofstream cache_stream(mCacheFileName.c_str());
     if (cache_stream.is_open())
     {
-        cache_stream << (*this);
+        cache_stream >> (*this);
     }
-    sShutdown = true;
 }
 
 //-------------------------------------------------------------------------
 void LLExperienceCache::importFile(std::istream& istr)
 {
+    // Binary since the cache became lazy loaded, XML before that
     LLSD data;
-    S32 parse_count = LLSDSerialize::fromXMLDocument(data, istr);
-    if (parse_count < 1) return;
+    if (!LLSDSerialize::deserialize(data, istr, LLSDSerialize::SIZE_UNLIMITED)) return;
 
     LLSD experiences = data["experiences"];
 
+    // Anything already in the cache is newer than the file
     LLUUID public_key;
     LLSD::map_const_iterator it = experiences.beginMap();
     for (; it != experiences.endMap(); ++it)
     {
         public_key.set(it->first);
-        mCache[public_key] = it->second;
+        mCache.insert(cache_t::value_type(public_key, it->second));
+    }
+
+    LLSD groups = data["group_experiences"];
+    LLUUID group_id;
+    for (it = groups.beginMap(); it != groups.endMap(); ++it)
+    {
+        group_id.set(it->first);
+        mGroupExperiences.insert(group_cache_t::value_type(group_id, it->second));
     }
 
-    LL_DEBUGS("ExperienceCache") << "importFile() loaded " << mCache.size() << LL_ENDL;
+    LL_DEBUGS("ExperienceCache") << "importFile() loaded " << mCache.size() << " experiences, "
+                                 << mGroupExperiences.size() << " group lists" << LL_ENDL;
 }
 
 void LLExperienceCache::exportFile(std::ostream& ostr) const
@@ -167,10 +197,17 @@ void LLExperienceCache::exportFile(std::ostream& ostr) const
         experiences[it->first.asString()] = it->second;
     }
 
+    LLSD groups = LLSD::emptyMap();
+    for (group_cache_t::const_iterator git = mGroupExperiences.begin(); git != mGroupExperiences.end(); ++git)
+    {
+        groups[git->first.asString()] = git->second;
+    }
+
     LLSD data;
     data["experiences"] = experiences;
+    data["group_experiences"] = groups;
 
-    LLSDSerialize::toPrettyXML(data, ostr);
+    LLSDSerialize::serialize(data, ostr, LLSDSerialize::LLSD_BINARY);
 }
 
 // *TODO$: Rider: This method does not seem to be used... it may be useful in testing.
@@ -221,6 +258,7 @@ void LLExperienceCache::processExperience(const LLUUID& public_key, const LLSD&
 {
     LL_INFOS("ExperienceCache") << "Processing experience \"" << experience[NAME] << "\" with key " << public_key.asString() << LL_ENDL;
 
+	loadCache();
 	mCache[public_key]=experience;
 	LLSD & row = mCache[public_key];
 
@@ -247,6 +285,7 @@ void LLExperienceCache::processExperience(const LLUUID& public_key, const LLSD&
 
 const LLExperienceCache::cache_t& LLExperienceCache::getCached()
 {
+	loadCache();
 	return mCache;
 }
 
@@ -438,6 +477,7 @@ void LLExperienceCache::idleCoro()
 
 void LLExperienceCache::erase(const LLUUID& key)
 {
+	loadCache();
 	cache_t::iterator it = mCache.find(key);
 				
 	if(it != mCache.end())
@@ -448,6 +488,11 @@ void LLExperienceCache::erase(const LLUUID& key)
 
 void LLExperienceCache::eraseExpired()
 {
+	if (!mCacheLoaded)
+	{
+		// Nothing looked up yet, stale entries get refreshed on first use
+		return;
+	}
 	F64 now = LLFrameTimer::getTotalSeconds();
 	cache_t::iterator it = mCache.begin();
 	while (it != mCache.end())
@@ -485,6 +530,7 @@ void LLExperienceCache::eraseExpired()
 	
 bool LLExperienceCache::fetch(const LLUUID& key, bool refresh/* = true*/)
 {
+	loadCache();
 	if(!key.isNull() && !isRequestPending(key) && (refresh || mCache.find(key)==mCache.end()))
 	{
 		LL_DEBUGS("ExperienceCache") << " queue request for " << EXPERIENCE_ID << " " << key << LL_ENDL;
@@ -513,10 +559,16 @@ const LLSD& LLExperienceCache::get(const LLUUID& key)
 	
 	if(key.isNull()) 
 		return empty;
+	loadCache();
 	cache_t::const_iterator it = mCache.find(key);
 
 	if (it != mCache.end())
 	{
+		// Serve what we have, refresh it in the background once stale
+		if (it->second.has(EXPIRES) && it->second[EXPIRES].asReal() < LLFrameTimer::getTotalSeconds())
+		{
+			fetch(key, true);
+		}
 		return it->second;
 	}
 	fetch(key);
@@ -529,9 +581,15 @@ void LLExperienceCache::get(const LLUUID& key, LLExperienceCache::ExperienceGetF
 	if(key.isNull()) 
 		return;
 
+	loadCache();
 	cache_t::const_iterator it = mCache.find(key);
 	if (it != mCache.end())
 	{
+		if (it->second.has(EXPIRES) && it->second[EXPIRES].asReal() < LLFrameTimer::getTotalSeconds())
+		{
+			fetch(key, true);
+		}
+
 		// ...name already exists in cache, fire callback now
 		callback_signal_t signal;
 		signal.connect(slot);
@@ -676,11 +734,26 @@ void LLExperienceCache::getGroupExperiences(const LLUUID &groupId, ExperienceGet
         return;
     }
 
+    loadCache();
+    bool answered = false;
+    group_cache_t::const_iterator it = mGroupExperiences.find(groupId);
+    if (it != mGroupExperiences.end())
+    {
+        fn(it->second["ids"]);
+        if (it->second[EXPIRES].asReal() > LLFrameTimer::getTotalSeconds())
+        {
+            return;
+        }
+        answered = true;
+    }
+
+    // Nobody is waiting on a revalidation, let it queue behind other lookups
     LLCoprocedureManager::instance().enqueueCoprocedure("ExpCache", "Group Experiences",
-        boost::bind(&LLExperienceCache::getGroupExperiencesCoro, this, _1, groupId, fn));
+        boost::bind(&LLExperienceCache::getGroupExperiencesCoro, this, _1, groupId, fn, answered),
+        answered ? LLCoprocedureManager::PRIORITY_LOW : LLCoprocedureManager::PRIORITY_NORMAL);
 }
 
-void LLExperienceCache::getGroupExperiencesCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, LLUUID groupId, ExperienceGetFn_t fn)
+void LLExperienceCache::getGroupExperiencesCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, LLUUID groupId, ExperienceGetFn_t fn, bool answered)
 {
     LLCore::HttpRequest::ptr_t httpRequest(new LLCore::HttpRequest());
 
@@ -694,19 +767,73 @@ void LLExperienceCache::getGroupExperiencesCoro(LLCoreHttpUtil::HttpCoroutineAda
 
     url += "?" + groupId.asString();
 
-    LLSD result = httpAdapter->getAndSuspend(httpRequest, url);
+    // Revalidate the list we have rather than fetch it again
+    LLCore::HttpHeaders::ptr_t httpHeaders(new LLCore::HttpHeaders());
+    group_cache_t::const_iterator cached = mGroupExperiences.find(groupId);
+    if (cached != mGroupExperiences.end() && cached->second.has("etag"))
+    {
+        httpHeaders->append(HTTP_OUT_HEADER_IF_NONE_MATCH, cached->second["etag"].asString());
+    }
+
+    LLSD result = httpAdapter->getAndSuspend(httpRequest, url, LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions()), httpHeaders);
 
     LLSD httpResults = result[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS];
     LLCore::HttpStatus status = LLCoreHttpUtil::HttpCoroutineAdapter::getStatusFromLLSD(httpResults);
+    const LLSD& headers = httpResults[LLCoreHttpUtil::HttpCoroutineAdapter::HTTP_RESULTS_HEADERS];
+
+    S32 max_age = 0;
+    F64 expires = LLFrameTimer::getTotalSeconds() +
+        (LLExperienceCacheImpl::maxAgeFromCacheControl(headers["cache-control"].asString(), &max_age) ? F64(max_age) : GROUP_EXPIRATION);
+
+    if (status.getType() == HTTP_NOT_MODIFIED)
+    {
+        // Still current.  The iterator may have moved while suspended.
+        group_cache_t::iterator entry = mGroupExperiences.find(groupId);
+        if (entry != mGroupExperiences.end())
+        {
+            entry->second[EXPIRES] = expires;
+            if (!answered)
+            {
+                fn(entry->second["ids"]);
+            }
+        }
+        else if (!answered)
+        {
+            fn(LLSD());
+        }
+        return;
+    }
 
     if (!status)
     {
-        fn(LLSD());
+        if (!answered)
+        {
+            fn(LLSD());
+        }
         return;
     }
 
     const LLSD& experienceIds = result["experience_ids"];
-    fn(experienceIds);
+
+    LLSD& entry = mGroupExperiences[groupId];
+    bool changed = !answered || entry["ids"].size() != experienceIds.size() ||
+        !std::equal(experienceIds.beginArray(), experienceIds.endArray(), entry["ids"].beginArray(),
+                    [](const LLSD& a, const LLSD& b) { return a.asUUID() == b.asUUID(); });
+    entry["ids"] = experienceIds;
+    entry[EXPIRES] = expires;
+    if (headers.has("etag"))
+    {
+        entry["etag"] = headers["etag"];
+    }
+    else
+    {
+        entry.erase("etag");
+    }
+
+    if (changed)
+    {
+        fn(experienceIds);
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -915,6 +1042,12 @@ void LLExperienceCache::updateExperienceCoro(LLCoreHttpUtil::HttpCoroutineAdapte
 
     LLSD result = httpAdapter->postAndSuspend(httpRequest, url, updateData);
 
+    // The experience may have changed groups, have the group lists revalidate
+    for (group_cache_t::iterator it = mGroupExperiences.begin(); it != mGroupExperiences.end(); ++it)
+    {
+        it->second[EXPIRES] = 0.0;
+    }
+
     fn(result);
 }
 
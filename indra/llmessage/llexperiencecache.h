@@ -66,6 +66,9 @@ public:
     void fetchAssociatedExperience(const LLUUID& objectId, const LLUUID& itemId, ExperienceGetFn_t fn);
     void fetchAssociatedExperience(const LLUUID& objectId, const LLUUID& itemId, std::string url, ExperienceGetFn_t fn);
     void findExperienceByName(const std::string text, int page, ExperienceGetFn_t fn);
+    // Answers from the cache when it can.  A stale list is passed to fn
+    // at once and revalidated in the background, fn is called again if
+    // the list changed.
     void getGroupExperiences(const LLUUID &groupId, ExperienceGetFn_t fn);
 
     // the Get/Set Region Experiences take a CapabilityQuery to get the capability since 
@@ -118,6 +121,8 @@ private:
 	// Avoid copying signals via pointers.
 	typedef std::map<LLUUID, signal_ptr> signal_map_t;
 	typedef std::map<LLUUID, LLSD> cache_t;
+	// Group id -> { ids, etag, expiration }
+	typedef std::map<LLUUID, LLSD> group_cache_t;
 	
 	typedef std::set<LLUUID> RequestQueue_t;
     typedef std::map<LLUUID, F64> PendingQueue_t;
@@ -127,6 +132,7 @@ private:
 	
 	// default values
 	static const F64 DEFAULT_EXPIRATION; 	// 600.0
+	static const F64 GROUP_EXPIRATION;		// 3600.0
 	static const S32 DEFAULT_QUOTA; 		// 128 this is megabytes
     static const int SEARCH_PAGE_SIZE;
 	
@@ -135,6 +141,7 @@ private:
 
 //--------------------------------------------
 	cache_t			mCache;
+	group_cache_t	mGroupExperiences;
 	signal_map_t	mSignalMap;	
 	RequestQueue_t	mRequestQueue;
     PendingQueue_t  mPendingQueue;
@@ -142,6 +149,8 @@ private:
     LLFrameTimer    mEraseExpiredTimer;    // Periodically clean out expired entries from the cache
     CapabilityQuery_t mCapability;
     std::string     mCacheFileName;
+    std::string     mLegacyCacheFileName;   // XML cache from older viewers
+    bool            mCacheLoaded;
     static bool     sShutdown; // control for coroutines, they exist out of LLExperienceCache's scope, so they need a static control
 
     void idleCoro();
@@ -151,13 +160,15 @@ private:
 
     void fetchAssociatedExperienceCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, LLUUID, LLUUID, std::string, ExperienceGetFn_t);
     void findExperienceByNameCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, std::string, int, ExperienceGetFn_t);
-    void getGroupExperiencesCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, LLUUID , ExperienceGetFn_t);
+    void getGroupExperiencesCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &, LLUUID , ExperienceGetFn_t, bool answered);
     void regionExperiencesCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, CapabilityQuery_t regioncaps, bool update, LLSD experiences, ExperienceGetFn_t fn);
     void experiencePermissionCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, permissionInvoker_fn invokerfn, std::string url, ExperienceGetFn_t fn);
     void getExperienceAdminCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, LLUUID experienceId, ExperienceGetFn_t fn);
     void updateExperienceCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t &httpAdapter, LLSD updateData, ExperienceGetFn_t fn);
 
     void bootstrap(const LLSD& legacyKeys, int initialExpiration);
+    // Reads the cache file the first time anything is looked up
+    void loadCache();
     void exportFile(std::ostream& ostr) const;
     void importFile(std::istream& istr);
 
@@ -0,0 +1,387 @@
+/**
+ * @file llmessagefields.cpp
+ * @brief Base of the generated typed accessors for template messages
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmessagefields.h"
+
+#include "llmath.h"
+#include "llmessagetemplate.h"
+#include "llquaternion.h"
+#include "lluuid.h"
+#include "v3dmath.h"
+#include "v3math.h"
+#include "v4math.h"
+#include "message.h"
+
+LLMessageFields::LLMessageFields(LLMessageSystem* msg, const LLMessageFieldLayout& layout)
+:	mMsg(msg),
+	mLayout(layout),
+	mReader(NULL)
+{
+	const LLTemplateMessageReader* reader = msg->getCurrentTemplateReader();
+	if (!reader || !reader->hasFields())
+	{
+		return;
+	}
+
+	// the template is held on to for the lifetime of the message system,
+	// so the result of the check can be kept with it
+	LLMessageTemplate* msg_template = const_cast<LLMessageTemplate*>(reader->getCurrentTemplate());
+	if (!msg_template || msg_template->mName != *layout.mName)
+	{
+		return;
+	}
+	if (msg_template->mFieldLayout != &layout)
+	{
+		msg_template->mFieldLayout = &layout;
+		msg_template->mFieldLayoutMatches = layoutMatches(layout, *msg_template);
+		if (!msg_template->mFieldLayoutMatches)
+		{
+			LL_WARNS("Messaging") << "Generated fields of " << msg_template->mName
+				<< " do not match message_template.msg, regenerate message_fields.cpp"
+				<< LL_ENDL;
+		}
+	}
+	if (msg_template->mFieldLayoutMatches)
+	{
+		mReader = reader;
+	}
+}
+
+// static
+bool LLMessageFields::layoutMatches(const LLMessageFieldLayout& layout, const LLMessageTemplate& msg_template)
+{
+	if ((S32)msg_template.mMemberBlocks.size() != layout.mBlockCount)
+	{
+		return false;
+	}
+
+	S32 block_index = 0;
+	for (LLMessageTemplate::message_block_map_t::const_iterator iter = msg_template.mMemberBlocks.begin();
+		 iter != msg_template.mMemberBlocks.end(); ++iter, ++block_index)
+	{
+		const LLMessageBlock* mbci = *iter;
+		const LLMessageFieldLayout::Block& block = layout.mBlocks[block_index];
+		if (mbci->mName != *block.mName
+			|| (S32)mbci->mMemberVariables.size() != block.mVariableCount)
+		{
+			return false;
+		}
+
+		const LLMessageFieldLayout::Variable* variable = layout.mVariables + block.mFirstVariable;
+		for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = mbci->mMemberVariables.begin();
+			 var_iter != mbci->mMemberVariables.end(); ++var_iter, ++variable)
+		{
+			const LLMessageVariable* mvci = *var_iter;
+			if (mvci->getName() != *variable->mName
+				|| mvci->getType() != variable->mType)
+			{
+				return false;
+			}
+			if ((variable->mType == MVT_FIXED || variable->mType == MVT_VARIABLE)
+				&& mvci->getSize() != variable->mSize)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+const LLTemplateMessageReader::Field* LLMessageFields::getField(S32 block, S32 var, S32 blocknum) const
+{
+	if (!mReader)
+	{
+		return NULL;
+	}
+	const LLTemplateMessageReader::Field* fields = mReader->getFields(block, blocknum);
+	return fields ? fields + var : NULL;
+}
+
+bool LLMessageFields::copyField(S32 block, S32 var, void* datap, S32 size, S32 blocknum) const
+{
+	const LLTemplateMessageReader::Field* field = getField(block, var, blocknum);
+	if (!field || field->mSize != size)
+	{
+		// let the reader complain
+		return false;
+	}
+
+	if (field->mData)
+	{
+		EMsgVariableType type = mLayout.mVariables[mLayout.mBlocks[block].mFirstVariable + var].mType;
+		htolememcpy(datap, field->mData, type, size);
+	}
+	else
+	{
+		memset(datap, 0, size);
+	}
+	return true;
+}
+
+S32 LLMessageFields::getNumberOfBlocks(S32 block) const
+{
+	if (mReader)
+	{
+		return mReader->getFieldBlockCount(block);
+	}
+	return mMsg->getNumberOfBlocksFast(blockName(block));
+}
+
+S32 LLMessageFields::getSize(S32 block, S32 var, S32 blocknum) const
+{
+	const LLTemplateMessageReader::Field* field = getField(block, var, blocknum);
+	if (field)
+	{
+		return field->mSize;
+	}
+	return mMsg->getSizeFast(blockName(block), blocknum, varName(block, var));
+}
+
+void LLMessageFields::getBinaryData(S32 block, S32 var, void* datap, S32 size, S32 blocknum, S32 max_size) const
+{
+	const LLTemplateMessageReader::Field* field = getField(block, var, blocknum);
+	if (!field || (size && size != field->mSize) || max_size < field->mSize)
+	{
+		mMsg->getBinaryDataFast(blockName(block), varName(block, var), datap, size, blocknum, max_size);
+		return;
+	}
+	copyField(block, var, datap, field->mSize, blocknum);
+}
+
+void LLMessageFields::getBOOL(S32 block, S32 var, BOOL& data, S32 blocknum) const
+{
+	U8 value;
+	if (copyField(block, var, &value, sizeof(U8), blocknum))
+	{
+		data = (BOOL)value;
+		return;
+	}
+	mMsg->getBOOLFast(blockName(block), varName(block, var), data, blocknum);
+}
+
+void LLMessageFields::getS8(S32 block, S32 var, S8& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(S8), blocknum))
+	{
+		mMsg->getS8Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getU8(S32 block, S32 var, U8& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(U8), blocknum))
+	{
+		mMsg->getU8Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getS16(S32 block, S32 var, S16& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(S16), blocknum))
+	{
+		mMsg->getS16Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getU16(S32 block, S32 var, U16& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(U16), blocknum))
+	{
+		mMsg->getU16Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getS32(S32 block, S32 var, S32& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(S32), blocknum))
+	{
+		mMsg->getS32Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getU32(S32 block, S32 var, U32& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(U32), blocknum))
+	{
+		mMsg->getU32Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getU64(S32 block, S32 var, U64& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(U64), blocknum))
+	{
+		mMsg->getU64Fast(blockName(block), varName(block, var), data, blocknum);
+	}
+}
+
+void LLMessageFields::getF32(S32 block, S32 var, F32& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(F32), blocknum))
+	{
+		mMsg->getF32Fast(blockName(block), varName(block, var), data, blocknum);
+		return;
+	}
+	if (!llfinite(data))
+	{
+		LL_WARNS() << "non-finite in getF32Fast " << blockName(block) << " " << varName(block, var) << LL_ENDL;
+		data = 0;
+	}
+}
+
+void LLMessageFields::getF64(S32 block, S32 var, F64& data, S32 blocknum) const
+{
+	if (!copyField(block, var, &data, sizeof(F64), blocknum))
+	{
+		mMsg->getF64Fast(blockName(block), varName(block, var), data, blocknum);
+		return;
+	}
+	if (!llfinite(data))
+	{
+		LL_WARNS() << "non-finite in getF64Fast " << blockName(block) << " " << varName(block, var) << LL_ENDL;
+		data = 0;
+	}
+}
+
+void LLMessageFields::getVector3(S32 block, S32 var, LLVector3& vec, S32 blocknum) const
+{
+	if (!copyField(block, var, &vec.mV[0], sizeof(vec.mV), blocknum))
+	{
+		mMsg->getVector3Fast(blockName(block), varName(block, var), vec, blocknum);
+		return;
+	}
+	if (!vec.isFinite())
+	{
+		LL_WARNS() << "non-finite in getVector3Fast " << blockName(block) << " " << varName(block, var) << LL_ENDL;
+		vec.zeroVec();
+	}
+}
+
+void LLMessageFields::getVector4(S32 block, S32 var, LLVector4& vec, S32 blocknum) const
+{
+	if (!copyField(block, var, &vec.mV[0], sizeof(vec.mV), blocknum))
+	{
+		mMsg->getVector4Fast(blockName(block), varName(block, var), vec, blocknum);
+		return;
+	}
+	if (!vec.isFinite())
+	{
+		LL_WARNS() << "non-finite in getVector4Fast " << blockName(block) << " " << varName(block, var) << LL_ENDL;
+		vec.zeroVec();
+	}
+}
+
+void LLMessageFields::getVector3d(S32 block, S32 var, LLVector3d& vec, S32 blocknum) const
+{
+	if (!copyField(block, var, &vec.mdV[0], sizeof(vec.mdV), blocknum))
+	{
+		mMsg->getVector3dFast(blockName(block), varName(block, var), vec, blocknum);
+		return;
+	}
+	if (!vec.isFinite())
+	{
+		LL_WARNS() << "non-finite in getVector3dFast " << blockName(block) << " " << varName(block, var) << LL_ENDL;
+		vec.zeroVec();
+	}
+}
+
+void LLMessageFields::getQuat(S32 block, S32 var, LLQuaternion& q, S32 blocknum) const
+{
+	LLVector3 vec;
+	if (!copyField(block, var, &vec.mV[0], sizeof(vec.mV), blocknum))
+	{
+		mMsg->getQuatFast(blockName(block), varName(block, var), q, blocknum);
+		return;
+	}
+	if (vec.isFinite())
+	{
+		q.unpackFromVector3(vec);
+	}
+	else
+	{
+		LL_WARNS() << "non-finite in getQuatFast " << blockName(block) << " " << varName(block, var) << LL_ENDL;
+		q.loadIdentity();
+	}
+}
+
+void LLMessageFields::getUUID(S32 block, S32 var, LLUUID& uuid, S32 blocknum) const
+{
+	if (!copyField(block, var, &uuid.mData[0], sizeof(uuid.mData), blocknum))
+	{
+		mMsg->getUUIDFast(blockName(block), varName(block, var), uuid, blocknum);
+	}
+}
+
+void LLMessageFields::getIPAddr(S32 block, S32 var, U32& ip, S32 blocknum) const
+{
+	if (!copyField(block, var, &ip, sizeof(U32), blocknum))
+	{
+		mMsg->getIPAddrFast(blockName(block), varName(block, var), ip, blocknum);
+	}
+}
+
+void LLMessageFields::getIPPort(S32 block, S32 var, U16& port, S32 blocknum) const
+{
+	if (!copyField(block, var, &port, sizeof(U16), blocknum))
+	{
+		mMsg->getIPPortFast(blockName(block), varName(block, var), port, blocknum);
+		return;
+	}
+	port = ntohs(port);
+}
+
+void LLMessageFields::getString(S32 block, S32 var, S32 buffer_size, char* buffer, S32 blocknum) const
+{
+	const LLTemplateMessageReader::Field* field = getField(block, var, blocknum);
+	if (!field || buffer_size < field->mSize)
+	{
+		mMsg->getStringFast(blockName(block), varName(block, var), buffer_size, buffer, blocknum);
+		return;
+	}
+	buffer[0] = '\0';
+	copyField(block, var, buffer, field->mSize, blocknum);
+	buffer[buffer_size - 1] = '\0';
+}
+
+void LLMessageFields::getString(S32 block, S32 var, std::string& outstr, S32 blocknum) const
+{
+	const LLTemplateMessageReader::Field* field = getField(block, var, blocknum);
+	if (!field || field->mSize > MTUBYTES)
+	{
+		mMsg->getStringFast(blockName(block), varName(block, var), outstr, blocknum);
+		return;
+	}
+	if (!field->mData)
+	{
+		outstr.clear();
+		return;
+	}
+	// stops at the first nul, as copying into a buffer first does
+	const char* data = (const char*)field->mData;
+	outstr.assign(data, strnlen(data, field->mSize));
+}
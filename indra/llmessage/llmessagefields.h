@@ -0,0 +1,131 @@
+/**
+ * @file llmessagefields.h
+ * @brief Base of the generated typed accessors for template messages
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEFIELDS_H
+#define LL_LLMESSAGEFIELDS_H
+
+#include "llmsgvariabletype.h"
+#include "lltemplatemessagereader.h"
+
+class LLMessageSystem;
+class LLQuaternion;
+class LLUUID;
+class LLVector3;
+class LLVector3d;
+class LLVector4;
+
+// Layout of a message in message_template.msg, as generated into
+// message_fields.cpp.  Names are the addresses of the _PREHASH_ strings,
+// which are not set up until the string table is.
+struct LLMessageFieldLayout
+{
+	struct Variable
+	{
+		const char* const*	mName;
+		EMsgVariableType	mType;
+		S32					mSize;		// for MVT_FIXED and MVT_VARIABLE only
+	};
+
+	struct Block
+	{
+		const char* const*	mName;
+		S32					mFirstVariable;
+		S32					mVariableCount;
+	};
+
+	const char* const*	mName;
+	const Block*		mBlocks;
+	S32					mBlockCount;
+	const Variable*		mVariables;
+};
+
+// Reads the message a handler was called for by block and variable index
+// rather than by name.  The generated classes in message_fields.h derive
+// from this, one per message, with a typed getter for each variable.
+//
+// While the template reader is decoding the message and the template it
+// loaded matches the one the layout was generated from, the getters read
+// the reader's field table directly.  Otherwise, for a message that came
+// in through another reader or a template that has changed since, they
+// fall back to the getters on LLMessageSystem.  Either way they behave as
+// the named getters do, errors included.
+class LLMessageFields
+{
+public:
+	// True if the getters read the fields directly
+	bool isDirect() const						{ return mReader != NULL; }
+
+protected:
+	LLMessageFields(LLMessageSystem* msg, const LLMessageFieldLayout& layout);
+
+	S32 getNumberOfBlocks(S32 block) const;
+	S32 getSize(S32 block, S32 var, S32 blocknum) const;
+
+	void getBinaryData(S32 block, S32 var, void* datap, S32 size, S32 blocknum, S32 max_size) const;
+	void getBOOL(S32 block, S32 var, BOOL& data, S32 blocknum) const;
+	void getS8(S32 block, S32 var, S8& data, S32 blocknum) const;
+	void getU8(S32 block, S32 var, U8& data, S32 blocknum) const;
+	void getS16(S32 block, S32 var, S16& data, S32 blocknum) const;
+	void getU16(S32 block, S32 var, U16& data, S32 blocknum) const;
+	void getS32(S32 block, S32 var, S32& data, S32 blocknum) const;
+	void getU32(S32 block, S32 var, U32& data, S32 blocknum) const;
+	void getU64(S32 block, S32 var, U64& data, S32 blocknum) const;
+	void getF32(S32 block, S32 var, F32& data, S32 blocknum) const;
+	void getF64(S32 block, S32 var, F64& data, S32 blocknum) const;
+	void getVector3(S32 block, S32 var, LLVector3& vec, S32 blocknum) const;
+	void getVector4(S32 block, S32 var, LLVector4& vec, S32 blocknum) const;
+	void getVector3d(S32 block, S32 var, LLVector3d& vec, S32 blocknum) const;
+	void getQuat(S32 block, S32 var, LLQuaternion& q, S32 blocknum) const;
+	void getUUID(S32 block, S32 var, LLUUID& uuid, S32 blocknum) const;
+	void getIPAddr(S32 block, S32 var, U32& ip, S32 blocknum) const;
+	void getIPPort(S32 block, S32 var, U16& port, S32 blocknum) const;
+	void getString(S32 block, S32 var, S32 buffer_size, char* buffer, S32 blocknum) const;
+	void getString(S32 block, S32 var, std::string& outstr, S32 blocknum) const;
+
+private:
+	// The field, or NULL to go through LLMessageSystem
+	const LLTemplateMessageReader::Field* getField(S32 block, S32 var, S32 blocknum) const;
+
+	// Copies a fixed size field of the given size, as
+	// LLTemplateMessageReader::getData() does.  Returns false if the named
+	// getter has to be used instead.
+	bool copyField(S32 block, S32 var, void* datap, S32 size, S32 blocknum) const;
+
+	const char* blockName(S32 block) const		{ return *mLayout.mBlocks[block].mName; }
+	const char* varName(S32 block, S32 var) const
+	{
+		return *mLayout.mVariables[mLayout.mBlocks[block].mFirstVariable + var].mName;
+	}
+
+	static bool layoutMatches(const LLMessageFieldLayout& layout, const LLMessageTemplate& msg_template);
+
+private:
+	LLMessageSystem* mMsg;
+	const LLMessageFieldLayout& mLayout;
+	const LLTemplateMessageReader* mReader;
+};
+
+#endif // LL_LLMESSAGEFIELDS_H
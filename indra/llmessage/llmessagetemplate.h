@@ -33,6 +33,8 @@
 
 #include "nd/ndexceptions.h" // <FS:ND/> For ndxran
 
+struct LLMessageFieldLayout;
+
 class LLMsgVarData
 {
 public:
@@ -288,6 +290,9 @@ public:
 		mMaxDecodeTimePerMsg(0.f),
 		mBanFromTrusted(false),
 		mBanFromUntrusted(false),
+		mThrottleCategory(-1),
+		mFieldLayout(NULL),
+		mFieldLayoutMatches(false),
 		mHandlerFunc(NULL), 
 		mUserData(NULL)
 	{ 
@@ -429,6 +434,15 @@ public:
 	bool									mBanFromTrusted;
 	bool									mBanFromUntrusted;
 
+	// Which AgentThrottle category the sender bills this message to, -1 if
+	// unknown.  Used to measure per-category demand, see LLThrottleEstimator.
+	S32										mThrottleCategory;
+
+	// The generated field layout last checked against this template, see
+	// LLMessageFields
+	const LLMessageFieldLayout*				mFieldLayout;
+	bool									mFieldLayoutMatches;
+
 private:
 	// message handler function (this is set by each application)
 	void									(*mHandlerFunc)(LLMessageSystem *msgsystem, void **user_data);
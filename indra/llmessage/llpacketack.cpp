@@ -43,7 +43,10 @@ LLReliablePacket::LLReliablePacket(
 	S32 buf_len,
 	LLReliablePacketParams* params) :
 	mBuffer(NULL),
-	mBufferLength(0)
+	mBufferLength(0),
+	mFinalRetry(false),
+	mPrev(NULL),
+	mNext(NULL)
 {
 	if (params)
 	{
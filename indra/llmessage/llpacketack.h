@@ -94,6 +94,7 @@ public:
 	};
 
 	friend class LLCircuitData;
+	friend class LLReliablePacketList;
 protected:
 	S32 mSocket;
 	LLHost mHost;
@@ -110,6 +111,76 @@ protected:
 	TPACKETID mPacketID;
 
 	F64Seconds mExpirationTime;
+
+	// on LLCircuitData's final retry list rather than the unacked one
+	bool mFinalRetry;
+
+	// links of the LLReliablePacketList the packet is on
+	LLReliablePacket* mPrev;
+	LLReliablePacket* mNext;
+};
+
+// Intrusive list of reliable packets, in the order they were added.  A
+// packet is on at most one list at a time, and the list does not own it.
+class LLReliablePacketList
+{
+public:
+	LLReliablePacketList()
+	:	mHead(NULL),
+		mTail(NULL),
+		mSize(0)
+	{
+	}
+
+	bool empty() const							{ return mHead == NULL; }
+	S32 size() const							{ return mSize; }
+	LLReliablePacket* front() const				{ return mHead; }
+
+	static LLReliablePacket* next(const LLReliablePacket* packetp)	{ return packetp->mNext; }
+
+	void push_back(LLReliablePacket* packetp)
+	{
+		packetp->mPrev = mTail;
+		packetp->mNext = NULL;
+		if (mTail)
+		{
+			mTail->mNext = packetp;
+		}
+		else
+		{
+			mHead = packetp;
+		}
+		mTail = packetp;
+		++mSize;
+	}
+
+	void erase(LLReliablePacket* packetp)
+	{
+		if (packetp->mPrev)
+		{
+			packetp->mPrev->mNext = packetp->mNext;
+		}
+		else
+		{
+			mHead = packetp->mNext;
+		}
+		if (packetp->mNext)
+		{
+			packetp->mNext->mPrev = packetp->mPrev;
+		}
+		else
+		{
+			mTail = packetp->mPrev;
+		}
+		packetp->mPrev = NULL;
+		packetp->mNext = NULL;
+		--mSize;
+	}
+
+private:
+	LLReliablePacket* mHead;
+	LLReliablePacket* mTail;
+	S32 mSize;
 };
 
 #endif
@@ -0,0 +1,232 @@
+/**
+ * @file llpacketcapture.cpp
+ * @brief Recording of received UDP packets for offline replay
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketcapture.h"
+
+#include "net.h"
+
+namespace
+{
+	const char CAPTURE_MAGIC[8] = { 'L', 'L', 'P', 'K', 'T', 'C', 'A', 'P' };
+	const U32 CAPTURE_VERSION = 1;
+	const S32 PACKET_HEADER_SIZE = 8 + 4 + 2 + 2;
+
+	void put_le(U8* p, U64 value, S32 bytes)
+	{
+		for (S32 i = 0; i < bytes; ++i)
+		{
+			p[i] = (U8)(value >> (8 * i));
+		}
+	}
+
+	U64 get_le(const U8* p, S32 bytes)
+	{
+		U64 value = 0;
+		for (S32 i = 0; i < bytes; ++i)
+		{
+			value |= (U64)p[i] << (8 * i);
+		}
+		return value;
+	}
+}
+
+LLPacketCaptureWriter::LLPacketCaptureWriter()
+:	mFile(NULL),
+	mPacketCount(0)
+{
+}
+
+LLPacketCaptureWriter::~LLPacketCaptureWriter()
+{
+	close();
+}
+
+bool LLPacketCaptureWriter::open(const std::string& filename)
+{
+	close();
+	mFile = LLFile::fopen(filename, "wb");		/* Flawfinder: ignore */
+	if (!mFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture " << filename << LL_ENDL;
+		return false;
+	}
+
+	U8 header[sizeof(CAPTURE_MAGIC) + 4];
+	memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));	/* Flawfinder: ignore */
+	put_le(header + sizeof(CAPTURE_MAGIC), CAPTURE_VERSION, 4);
+	if (fwrite(header, sizeof(header), 1, mFile) != 1)
+	{
+		LL_WARNS("Messaging") << "Unable to write packet capture " << filename << LL_ENDL;
+		close();
+		return false;
+	}
+
+	mTimer.reset();
+	mPacketCount = 0;
+	LL_INFOS("Messaging") << "Capturing received packets to " << filename << LL_ENDL;
+	return true;
+}
+
+void LLPacketCaptureWriter::close()
+{
+	if (mFile)
+	{
+		LL_INFOS("Messaging") << "Captured " << mPacketCount << " packets" << LL_ENDL;
+		fclose(mFile);
+		mFile = NULL;
+	}
+}
+
+void LLPacketCaptureWriter::writePacket(const LLHost& sender, const U8* data, S32 size)
+{
+	if (!mFile || size <= 0 || size > NET_BUFFER_SIZE)
+	{
+		return;
+	}
+
+	U8 header[PACKET_HEADER_SIZE];
+	put_le(header, (U64)(mTimer.getElapsedTimeF64() * 1000000.0), 8);
+	// already in network byte order
+	U32 ip = sender.getAddress();
+	memcpy(header + 8, &ip, 4);		/* Flawfinder: ignore */
+	put_le(header + 12, sender.getPort(), 2);
+	put_le(header + 14, size, 2);
+	if (fwrite(header, sizeof(header), 1, mFile) != 1
+		|| fwrite(data, size, 1, mFile) != 1)
+	{
+		// most likely out of disk, stop rather than warn per packet
+		LL_WARNS("Messaging") << "Packet capture write failed, stopping capture" << LL_ENDL;
+		close();
+		return;
+	}
+	++mPacketCount;
+}
+
+LLPacketCaptureReader::LLPacketCaptureReader()
+:	mFile(NULL),
+	mRealtime(false),
+	mPacketCount(0),
+	mHasNext(false),
+	mNextTime(0),
+	mNextSize(0)
+{
+}
+
+LLPacketCaptureReader::~LLPacketCaptureReader()
+{
+	close();
+}
+
+bool LLPacketCaptureReader::open(const std::string& filename)
+{
+	close();
+	mFile = LLFile::fopen(filename, "rb");		/* Flawfinder: ignore */
+	if (!mFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture " << filename << LL_ENDL;
+		return false;
+	}
+
+	U8 header[sizeof(CAPTURE_MAGIC) + 4];
+	if (fread(header, sizeof(header), 1, mFile) != 1
+		|| memcmp(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)))
+	{
+		LL_WARNS("Messaging") << filename << " is not a packet capture" << LL_ENDL;
+		close();
+		return false;
+	}
+	U32 version = (U32)get_le(header + sizeof(CAPTURE_MAGIC), 4);
+	if (version != CAPTURE_VERSION)
+	{
+		LL_WARNS("Messaging") << "Unknown packet capture version " << version
+			<< " in " << filename << LL_ENDL;
+		close();
+		return false;
+	}
+
+	mTimer.reset();
+	mPacketCount = 0;
+	readHeader();
+	return true;
+}
+
+void LLPacketCaptureReader::close()
+{
+	if (mFile)
+	{
+		fclose(mFile);
+		mFile = NULL;
+	}
+	mHasNext = false;
+}
+
+void LLPacketCaptureReader::readHeader()
+{
+	U8 header[PACKET_HEADER_SIZE];
+	mHasNext = mFile && fread(header, sizeof(header), 1, mFile) == 1;
+	if (!mHasNext)
+	{
+		return;
+	}
+
+	mNextTime = get_le(header, 8);
+	U32 ip;
+	memcpy(&ip, header + 8, 4);		/* Flawfinder: ignore */
+	mNextSender.set(ip, (U32)get_le(header + 12, 2));
+	mNextSize = (S32)get_le(header + 14, 2);
+	if (mNextSize <= 0 || mNextSize > NET_BUFFER_SIZE)
+	{
+		LL_WARNS("Messaging") << "Bad packet size " << mNextSize << " after "
+			<< mPacketCount << " packets, ending the replay" << LL_ENDL;
+		mHasNext = false;
+	}
+}
+
+S32 LLPacketCaptureReader::readPacket(U8* buffer, LLHost& sender)
+{
+	if (!mHasNext)
+	{
+		return 0;
+	}
+	if (mRealtime && (U64)(mTimer.getElapsedTimeF64() * 1000000.0) < mNextTime)
+	{
+		return 0;
+	}
+
+	if (fread(buffer, mNextSize, 1, mFile) != 1)
+	{
+		LL_WARNS("Messaging") << "Packet capture ends in the middle of a packet" << LL_ENDL;
+		mHasNext = false;
+		return 0;
+	}
+	S32 size = mNextSize;
+	sender = mNextSender;
+	++mPacketCount;
+	readHeader();
+	return size;
+}
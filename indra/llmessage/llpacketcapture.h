@@ -0,0 +1,106 @@
+/**
+ * @file llpacketcapture.h
+ * @brief Recording of received UDP packets for offline replay
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETCAPTURE_H
+#define LL_LLPACKETCAPTURE_H
+
+#include "llfile.h"
+#include "llhost.h"
+#include "lltimer.h"
+
+// A capture file holds the packets a message system received, as they came
+// off the socket: before zero code expansion and with any appended acks.
+// After an 8 byte magic and a 32 bit version, each packet is
+//
+//	U64		microseconds since the capture started
+//	U32		sender address, in network byte order as LLHost keeps it
+//	U16		sender port
+//	U16		size
+//	U8		data[size]
+//
+// with the numbers little endian.  See LLMessageSystem::startPacketCapture()
+// and startPacketReplay().
+
+class LLPacketCaptureWriter
+{
+public:
+	LLPacketCaptureWriter();
+	~LLPacketCaptureWriter();
+
+	// Starts a new file, truncating any existing one
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const							{ return mFile != NULL; }
+
+	void writePacket(const LLHost& sender, const U8* data, S32 size);
+	U32 getPacketCount() const					{ return mPacketCount; }
+
+private:
+	LLFILE* mFile;
+	LLTimer mTimer;
+	U32 mPacketCount;
+};
+
+class LLPacketCaptureReader
+{
+public:
+	LLPacketCaptureReader();
+	~LLPacketCaptureReader();
+
+	bool open(const std::string& filename);
+	void close();
+
+	// In real time, readPacket() holds each packet back until as long has
+	// passed since open() as had passed since the start of the capture.
+	// Otherwise packets are read as fast as they are asked for.
+	void setRealtime(bool realtime)				{ mRealtime = realtime; }
+
+	// Reads the next packet into buffer, which must hold MAX_BUFFER_SIZE
+	// bytes.  Returns its size, or 0 at the end of the file or if the next
+	// packet is not due yet.
+	S32 readPacket(U8* buffer, LLHost& sender);
+
+	// True once every packet has been read
+	bool isDone() const							{ return !mHasNext; }
+	U32 getPacketCount() const					{ return mPacketCount; }
+
+private:
+	// Reads the header of the next packet, clearing mHasNext at the end
+	// of the file
+	void readHeader();
+
+	LLFILE* mFile;
+	LLTimer mTimer;
+	bool mRealtime;
+	U32 mPacketCount;
+
+	bool mHasNext;
+	U64 mNextTime;
+	LLHost mNextSender;
+	S32 mNextSize;
+};
+
+#endif // LL_LLPACKETCAPTURE_H
@@ -0,0 +1,159 @@
+/**
+ * @file llpacketidwindow.cpp
+ * @brief Sliding window of received packet ids
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketidwindow.h"
+
+#include "llmodularmath.h"
+
+namespace
+{
+	const U32 ID_MASK = (1 << LLPacketIdWindow::ID_BITS) - 1;
+	const U32 POSITION_MASK = LLPacketIdWindow::WINDOW_SIZE - 1;
+
+	// Ids at least this far ahead of another count as behind it
+	const U32 HALF_RANGE = 1 << (LLPacketIdWindow::ID_BITS - 1);
+}
+
+LLPacketIdWindow::LLPacketIdWindow()
+:	mNewest(0),
+	mOldest(0),
+	mEmpty(true)
+{
+	memset(mBits, 0, sizeof(mBits));
+}
+
+void LLPacketIdWindow::clear()
+{
+	if (!mEmpty)
+	{
+		memset(mBits, 0, sizeof(mBits));
+	}
+	mNewest = 0;
+	mOldest = 0;
+	mEmpty = true;
+}
+
+// static
+U32 LLPacketIdWindow::distance(TPACKETID from, TPACKETID to)
+{
+	return LLModularMath::subtract<ID_BITS>(to, from);
+}
+
+bool LLPacketIdWindow::add(TPACKETID id)
+{
+	id &= ID_MASK;
+	if (mEmpty)
+	{
+		mNewest = id;
+		mOldest = id;
+		mEmpty = false;
+	}
+	else
+	{
+		U32 ahead = distance(mNewest, id);
+		if (ahead && ahead < HALF_RANGE)
+		{
+			// Slide the window up to id.  The positions between the old
+			// newest id and id still hold the ids a window behind them.
+			clearBits(mNewest + 1, llmin(ahead, (U32)WINDOW_SIZE));
+			mNewest = id;
+			if (distance(mOldest, mNewest) >= WINDOW_SIZE)
+			{
+				mOldest = (mNewest - WINDOW_SIZE + 1) & ID_MASK;
+			}
+		}
+		else if (distance(id, mNewest) >= WINDOW_SIZE)
+		{
+			return false;
+		}
+		else if (distance(mOldest, id) > distance(mOldest, mNewest))
+		{
+			// behind everything kept so far, but still within the window
+			mOldest = id;
+		}
+	}
+
+	U32 position = id & POSITION_MASK;
+	mBits[position / WORD_BITS] |= (U64)1 << (position % WORD_BITS);
+	return true;
+}
+
+bool LLPacketIdWindow::contains(TPACKETID id) const
+{
+	id &= ID_MASK;
+	if (mEmpty || distance(id, mNewest) >= WINDOW_SIZE)
+	{
+		return false;
+	}
+	U32 position = id & POSITION_MASK;
+	return (mBits[position / WORD_BITS] >> (position % WORD_BITS)) & 1;
+}
+
+void LLPacketIdWindow::removeBefore(TPACKETID oldest_id)
+{
+	oldest_id &= ID_MASK;
+	if (mEmpty)
+	{
+		return;
+	}
+
+	U32 ahead = distance(mNewest, oldest_id);
+	if (ahead && ahead < HALF_RANGE)
+	{
+		// everything kept is before it
+		clear();
+		return;
+	}
+
+	U32 count = distance(mOldest, oldest_id);
+	if (count && count <= distance(mOldest, mNewest))
+	{
+		clearBits(mOldest, count);
+		mOldest = oldest_id;
+	}
+}
+
+void LLPacketIdWindow::clearBits(TPACKETID first, U32 count)
+{
+	if (count >= WINDOW_SIZE)
+	{
+		memset(mBits, 0, sizeof(mBits));
+		return;
+	}
+
+	U32 position = first & POSITION_MASK;
+	while (count)
+	{
+		U32 bit = position % WORD_BITS;
+		U32 bits = llmin(count, (U32)WORD_BITS - bit);
+		U64 mask = (bits == WORD_BITS) ? ~(U64)0 : (((U64)1 << bits) - 1) << bit;
+		mBits[position / WORD_BITS] &= ~mask;
+		count -= bits;
+		position = (position + bits) & POSITION_MASK;
+	}
+}
@@ -0,0 +1,88 @@
+/**
+ * @file llpacketidwindow.h
+ * @brief Sliding window of received packet ids
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETIDWINDOW_H
+#define LL_LLPACKETIDWINDOW_H
+
+// Set of packet ids, as a bitmap over the WINDOW_SIZE ids up to the newest
+// one added.  Ids are 24 bit and compared modulo 2^24, so the set carries
+// on across the ids wrapping.  Adding an id newer than the newest slides
+// the window along and forgets the ids falling out of the back of it.
+//
+// Used by LLCircuitData for duplicate suppression of reliable packets,
+// where the window only needs to cover the packets the other end may
+// still resend.
+class LLPacketIdWindow
+{
+public:
+	enum
+	{
+		ID_BITS = 24,
+		WINDOW_BITS = 16,
+		WINDOW_SIZE = 1 << WINDOW_BITS
+	};
+
+	LLPacketIdWindow();
+
+	void clear();
+	bool empty() const							{ return mEmpty; }
+
+	// Adds id.  Returns false if it is too far behind the newest id to be
+	// remembered.
+	bool add(TPACKETID id);
+
+	bool contains(TPACKETID id) const;
+
+	// Forgets every id before oldest_id, which should not be newer than
+	// the newest id added.
+	void removeBefore(TPACKETID oldest_id);
+
+	TPACKETID getNewest() const					{ return mNewest; }
+	TPACKETID getOldest() const					{ return mOldest; }
+
+private:
+	// Clears the bits of count ids from first, count <= WINDOW_SIZE.
+	void clearBits(TPACKETID first, U32 count);
+
+	static U32 distance(TPACKETID from, TPACKETID to);
+
+private:
+	enum
+	{
+		WORD_BITS = 64,
+		WORD_COUNT = WINDOW_SIZE / WORD_BITS
+	};
+
+	U64 mBits[WORD_COUNT];
+
+	// Every id added and not forgotten lies in [mOldest, mNewest], and
+	// every bit outside that range is clear.
+	TPACKETID mNewest;
+	TPACKETID mOldest;
+	bool mEmpty;
+};
+
+#endif // LL_LLPACKETIDWINDOW_H
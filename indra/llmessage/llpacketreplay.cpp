@@ -0,0 +1,123 @@
+/**
+ * @file llpacketreplay.cpp
+ * @brief Feeds a packet capture through a message system and times it
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreplay.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "llformat.h"
+#include "lltimer.h"
+#include "message.h"
+
+LLPacketReplay::LLPacketReplay(LLMessageSystem* msg)
+:	mMsg(msg),
+	mMessageCount(0),
+	mElapsedTime(0.0)
+{
+}
+
+bool LLPacketReplay::run(const std::string& filename, bool realtime)
+{
+	mMessageCount = 0;
+	mElapsedTime = 0.0;
+	mTimings.clear();
+
+	if (!mMsg->startPacketReplay(filename, realtime))
+	{
+		return false;
+	}
+
+	LLMessageSystem::msg_timing_callback old_callback = mMsg->getTimingCallback();
+	void* old_data = mMsg->getTimingCallbackData();
+	mMsg->setTimingFunc(timingCallback, this);
+
+	LLTimer timer;
+	while (mMsg->isReplayingPackets())
+	{
+		{
+			LockMessageChecker lmc(mMsg);
+			while (lmc.checkMessages())
+			{
+				++mMessageCount;
+			}
+			lmc.processAcks();
+		}
+		if (realtime)
+		{
+			// waiting for the next packet to be due
+			ms_sleep(1);
+		}
+	}
+	mElapsedTime = timer.getElapsedTimeF64();
+
+	mMsg->setTimingFunc(old_callback, old_data);
+	mMsg->stopPacketReplay();
+	return true;
+}
+
+void LLPacketReplay::logTimings(S32 max_messages) const
+{
+	LL_INFOS("Messaging") << "Replayed " << mMessageCount << " messages in " << mElapsedTime
+		<< " seconds, " << mMessageCount / llmax(mElapsedTime, 1e-9) << " messages/s" << LL_ENDL;
+
+	std::vector<std::pair<F64, std::string> > by_time;
+	for (timing_map_t::const_iterator iter = mTimings.begin(); iter != mTimings.end(); ++iter)
+	{
+		by_time.push_back(std::make_pair(iter->second.mTotalTime, iter->first));
+	}
+	std::sort(by_time.rbegin(), by_time.rend());
+
+	S32 count = llmin((S32)by_time.size(), max_messages);
+	for (S32 i = 0; i < count; ++i)
+	{
+		const MessageTiming& timing = mTimings.find(by_time[i].second)->second;
+		LL_INFOS("Messaging") << llformat("%-32s %8u msgs %10.3f ms total %8.3f us avg %8.3f ms max",
+										  by_time[i].second.c_str(),
+										  timing.mCount,
+										  timing.mTotalTime * 1000.0,
+										  timing.mTotalTime * 1000000.0 / timing.mCount,
+										  timing.mMaxTime * 1000.f) << LL_ENDL;
+	}
+}
+
+//static
+void LLPacketReplay::timingCallback(const char* name, F32 time, void* data)
+{
+	LLPacketReplay* self = (LLPacketReplay*)data;
+	timing_map_t::iterator iter = self->mTimings.find(name);
+	if (iter == self->mTimings.end())
+	{
+		MessageTiming timing = { 0, 0.0, 0.f };
+		iter = self->mTimings.insert(std::make_pair(std::string(name), timing)).first;
+	}
+	MessageTiming& timing = iter->second;
+	++timing.mCount;
+	timing.mTotalTime += time;
+	timing.mMaxTime = llmax(timing.mMaxTime, time);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file llpacketreplay.h
+ * @brief Feeds a packet capture through a message system and times it
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETREPLAY_H
+#define LL_LLPACKETREPLAY_H
+
+#include <map>
+#include <string>
+
+class LLMessageSystem;
+
+// Headless driver for LLMessageSystem::startPacketReplay().  run() pumps
+// checkMessages() and processAcks() as the viewer's main loop does, so the
+// packets go through the circuits, the template reader and whatever
+// handlers are registered, and collects the handler time per message from
+// the message system's timing callback.
+//
+//	LLPacketReplay replay(gMessageSystem);
+//	if (replay.run("session.pcap"))
+//	{
+//		replay.logTimings();
+//	}
+class LLPacketReplay
+{
+public:
+	struct MessageTiming
+	{
+		U32 mCount;
+		F64 mTotalTime;			// seconds in the handler
+		F32 mMaxTime;
+	};
+	typedef std::map<std::string, MessageTiming> timing_map_t;
+
+	LLPacketReplay(LLMessageSystem* msg);
+
+	// Replays the whole capture.  Returns false if it cannot be opened.
+	bool run(const std::string& filename, bool realtime = false);
+
+	// Of the last run()
+	U32 getMessageCount() const					{ return mMessageCount; }
+	F64 getElapsedTime() const					{ return mElapsedTime; }
+	const timing_map_t& getTimings() const		{ return mTimings; }
+
+	// Messages per second overall, then the messages that took longest in
+	// their handlers
+	void logTimings(S32 max_messages = 20) const;
+
+private:
+	static void timingCallback(const char* name, F32 time, void* data);
+
+	LLMessageSystem* mMsg;
+	U32 mMessageCount;
+	F64 mElapsedTime;
+	timing_map_t mTimings;
+};
+
+#endif // LL_LLPACKETREPLAY_H
@@ -43,6 +43,9 @@
 #include "message.h"
 #include "u64.h"
 
+// Room for a full packet plus the SOCKS 5 UDP header in each send slot
+const S32 BATCH_SEND_BUFFER_SIZE = NET_BUFFER_SIZE + SOCKS_HEADER_SIZE;
+
 ///////////////////////////////////////////////////////////
 LLPacketRing::LLPacketRing () :
 	mUseInThrottle(FALSE),
@@ -55,14 +58,27 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mSendEnabled(TRUE),
+	mBlockedSendCount(0),
+	mUseBatching(TRUE),
+	mBatchSlab(NULL),
+	mReceiveBatchCount(0),
+	mReceiveBatchIndex(0),
+	mSendBatchCount(0),
+	mSendBatchDepth(0),
+	mSendBatchSocket(-1),
+	mSendBatchFailures(0)
 {
+	resetBatchStats();
 }
 
 ///////////////////////////////////////////////////////////
 LLPacketRing::~LLPacketRing ()
 {
 	cleanup();
+	delete[] mBatchSlab;
+	mBatchSlab = NULL;
 }
 	
 ///////////////////////////////////////////////////////////
@@ -83,6 +99,32 @@ void LLPacketRing::cleanup ()
 		delete packetp;
 		mSendQueue.pop();
 	}
+
+	mReceiveBatchCount = 0;
+	mReceiveBatchIndex = 0;
+	mSendBatchCount = 0;
+}
+
+void LLPacketRing::allocateBatchSlab()
+{
+	if (mBatchSlab)
+	{
+		return;
+	}
+
+	// One allocation for every buffer, receives first
+	mBatchSlab = new char[NET_MAX_BATCH * (NET_BUFFER_SIZE + BATCH_SEND_BUFFER_SIZE)];
+	char* send_slab = mBatchSlab + NET_MAX_BATCH * NET_BUFFER_SIZE;
+	for (S32 i = 0; i < NET_MAX_BATCH; i++)
+	{
+		mReceiveBatch[i].mData = mBatchSlab + i * NET_BUFFER_SIZE;
+		mSendBatch[i].mData = send_slab + i * BATCH_SEND_BUFFER_SIZE;
+	}
+}
+
+void LLPacketRing::resetBatchStats()
+{
+	memset(&mBatchStats, 0, sizeof(mBatchStats));
 }
 
 ///////////////////////////////////////////////////////////
@@ -224,54 +266,105 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	else
 	{
 		// no delay, pull straight from net
-		if (LLProxy::isSOCKSProxyEnabled())
+		packet_size = receiveFromNet(socket, datap);
+
+		if (packet_size)  // did we actually get a packet?
 		{
-			U8 buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
-			packet_size = receive_packet(socket, static_cast<char*>(static_cast<void*>(buffer)));
-			
-			if (packet_size > SOCKS_HEADER_SIZE)
+			if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
 			{
-				// *FIX We are assuming ATYP is 0x01 (IPv4), not 0x03 (hostname) or 0x04 (IPv6)
-				memcpy(datap, buffer + SOCKS_HEADER_SIZE, packet_size - SOCKS_HEADER_SIZE);
-				proxywrap_t * header = static_cast<proxywrap_t*>(static_cast<void*>(buffer));
-				mLastSender.setAddress(header->addr);
-				mLastSender.setPort(ntohs(header->port));
-
-				packet_size -= SOCKS_HEADER_SIZE; // The unwrapped packet size
+				mPacketsToDrop++;
 			}
-			else
+
+			if (mPacketsToDrop)
 			{
 				packet_size = 0;
+				mPacketsToDrop--;
 			}
 		}
-		else
+	}
+
+	return packet_size;
+}
+
+S32 LLPacketRing::receiveFromNet(S32 socket, char *datap)
+{
+	S32 packet_size = 0;
+
+	// keep handing out a pending batch even if batching was just turned off
+	if (mUseBatching || mReceiveBatchIndex < mReceiveBatchCount)
+	{
+		if (mReceiveBatchIndex >= mReceiveBatchCount)
 		{
-			packet_size = receive_packet(socket, datap);
-			mLastSender = ::get_sender();
-		}
+			allocateBatchSlab();
+			mReceiveBatchCount = receive_packets(socket, mReceiveBatch, NET_MAX_BATCH);
+			mReceiveBatchIndex = 0;
 
-		mLastReceivingIF = ::get_receiving_interface();
+			mBatchStats.mReceiveCalls++;
+			mBatchStats.mReceivedPackets += mReceiveBatchCount;
+			mBatchStats.mMaxReceiveBatch = llmax(mBatchStats.mMaxReceiveBatch, mReceiveBatchCount);
+		}
 
-		if (packet_size)  // did we actually get a packet?
+		if (mReceiveBatchIndex < mReceiveBatchCount)
 		{
-			if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
+			const LLNetDatagram& packet = mReceiveBatch[mReceiveBatchIndex++];
+			if (LLProxy::isSOCKSProxyEnabled())
 			{
-				mPacketsToDrop++;
+				packet_size = unwrapSOCKS(packet.mData, packet.mSize, datap);
 			}
-
-			if (mPacketsToDrop)
+			else
 			{
-				packet_size = 0;
-				mPacketsToDrop--;
+				memcpy(datap, packet.mData, packet.mSize);	/*Flawfinder: ignore*/
+				packet_size = packet.mSize;
+				mLastSender = LLHost(packet.mIP, packet.mPort);
 			}
+			mLastReceivingIF = LLHost(packet.mReceivingIF, INVALID_PORT);
 		}
+		else
+		{
+			mLastReceivingIF = LLHost(INVALID_HOST_IP_ADDRESS, INVALID_PORT);
+		}
+		return packet_size;
 	}
 
+	if (LLProxy::isSOCKSProxyEnabled())
+	{
+		char buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];	/*Flawfinder: ignore*/
+		packet_size = unwrapSOCKS(buffer, receive_packet(socket, buffer), datap);
+	}
+	else
+	{
+		packet_size = receive_packet(socket, datap);
+		mLastSender = ::get_sender();
+	}
+
+	mLastReceivingIF = ::get_receiving_interface();
 	return packet_size;
 }
 
+S32 LLPacketRing::unwrapSOCKS(const char *buffer, S32 size, char *datap)
+{
+	if (size <= SOCKS_HEADER_SIZE)
+	{
+		return 0;
+	}
+
+	// *FIX We are assuming ATYP is 0x01 (IPv4), not 0x03 (hostname) or 0x04 (IPv6)
+	memcpy(datap, buffer + SOCKS_HEADER_SIZE, size - SOCKS_HEADER_SIZE);	/*Flawfinder: ignore*/
+	const proxywrap_t * header = static_cast<const proxywrap_t*>(static_cast<const void*>(buffer));
+	mLastSender.setAddress(header->addr);
+	mLastSender.setPort(ntohs(header->port));
+
+	return size - SOCKS_HEADER_SIZE; // The unwrapped packet size
+}
+
 BOOL LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
 {
+	if (!mSendEnabled)
+	{
+		++mBlockedSendCount;
+		return TRUE;
+	}
+
 	BOOL status = TRUE;
 	if (!mUseOutThrottle)
 	{
@@ -349,7 +442,7 @@ BOOL LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 bu
 	
 	if (!LLProxy::isSOCKSProxyEnabled())
 	{
-		return send_packet(h_socket, send_buffer, buf_size, host.getAddress(), host.getPort());
+		return sendDatagram(h_socket, send_buffer, buf_size, host.getAddress(), host.getPort());
 	}
 
 	char headered_send_buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
@@ -363,9 +456,76 @@ BOOL LLPacketRing::sendPacketImpl(int h_socket, const char * send_buffer, S32 bu
 
 	memcpy(headered_send_buffer + SOCKS_HEADER_SIZE, send_buffer, buf_size);
 
-	return send_packet(	h_socket,
+	return sendDatagram(h_socket,
 						headered_send_buffer,
 						buf_size + SOCKS_HEADER_SIZE,
 						LLProxy::getInstance()->getUDPProxy().getAddress(),
 						LLProxy::getInstance()->getUDPProxy().getPort());
 }
+
+BOOL LLPacketRing::sendDatagram(int h_socket, const char * send_buffer, S32 buf_size, U32 ip, S32 port)
+{
+	if (!mSendBatchDepth || !mUseBatching || buf_size > BATCH_SEND_BUFFER_SIZE)
+	{
+		// keep packets in order
+		flushSendBatch();
+		return send_packet(h_socket, send_buffer, buf_size, ip, port);
+	}
+
+	if (mSendBatchCount == NET_MAX_BATCH || (mSendBatchCount && h_socket != mSendBatchSocket))
+	{
+		flushSendBatch();
+	}
+
+	allocateBatchSlab();
+	LLNetDatagram& packet = mSendBatch[mSendBatchCount++];
+	memcpy(packet.mData, send_buffer, buf_size);	/*Flawfinder: ignore*/
+	packet.mSize = buf_size;
+	packet.mIP = ip;
+	packet.mPort = port;
+	mSendBatchSocket = h_socket;
+
+	// failures are reported by endSendBatch()
+	return TRUE;
+}
+
+void LLPacketRing::beginSendBatch()
+{
+	mSendBatchDepth++;
+}
+
+S32 LLPacketRing::endSendBatch()
+{
+	llassert(mSendBatchDepth > 0);
+	if (mSendBatchDepth <= 0 || --mSendBatchDepth > 0)
+	{
+		return 0;
+	}
+
+	flushSendBatch();
+	S32 failures = mSendBatchFailures;
+	mSendBatchFailures = 0;
+	return failures;
+}
+
+void LLPacketRing::flushSendBatch()
+{
+	S32 sent = 0;
+	while (sent < mSendBatchCount)
+	{
+		S32 count = send_packets(mSendBatchSocket, mSendBatch + sent, mSendBatchCount - sent);
+
+		mBatchStats.mSendCalls++;
+		mBatchStats.mSentPackets += count;
+		mBatchStats.mMaxSendBatch = llmax(mBatchStats.mMaxSendBatch, count);
+
+		sent += count;
+		if (sent < mSendBatchCount)
+		{
+			// skip the packet that could not be sent, like a failed send_packet()
+			mSendBatchFailures++;
+			sent++;
+		}
+	}
+	mSendBatchCount = 0;
+}
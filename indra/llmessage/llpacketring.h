@@ -48,6 +48,7 @@ public:
 	void setDropPercentage (F32 percent_to_drop);
 	void setUseInThrottle(const BOOL use_throttle);
 	void setUseOutThrottle(const BOOL use_throttle);
+	BOOL getUseInThrottle() const					{ return mUseInThrottle; }
 	void setInBandwidth(const F32 bps);
 	void setOutBandwidth(const F32 bps);
 	S32  receivePacket (S32 socket, char *datap);
@@ -55,6 +56,36 @@ public:
 
 	BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
+	// With sending off (packet replay), sendPacket() drops every packet
+	// before it reaches the socket, reports it sent and counts it.
+	void setSendEnabled(const BOOL send_enabled)	{ mSendEnabled = send_enabled; }
+	U32  getBlockedSendCount() const				{ return mBlockedSendCount; }
+
+	// When batching is on, receivePacket() drains the socket up to
+	// NET_MAX_BATCH datagrams per system call and hands them out one at a
+	// time, and packets sent between beginSendBatch() and endSendBatch()
+	// are queued and sent with as few system calls as possible.
+	void setUseBatching(const BOOL use_batching)	{ mUseBatching = use_batching; }
+	BOOL getUseBatching() const						{ return mUseBatching; }
+
+	// Calls nest, packets go out when the outermost batch ends or the
+	// batch fills up.  Since queued packets are reported as sent,
+	// endSendBatch() returns the number of them that actually failed.
+	void beginSendBatch();
+	S32  endSendBatch();
+
+	struct BatchStats
+	{
+		U64 mReceiveCalls;		// batched receives, including ones that found nothing
+		U64 mReceivedPackets;
+		S32 mMaxReceiveBatch;
+		U64 mSendCalls;			// batched sends
+		U64 mSentPackets;
+		S32 mMaxSendBatch;
+	};
+	const BatchStats& getBatchStats() const		{ return mBatchStats; }
+	void resetBatchStats();
+
 	inline LLHost getLastSender();
 	inline LLHost getLastReceivingInterface();
 
@@ -77,14 +108,34 @@ protected:
 	F32 mDropPercentage;			// % of packets to drop
 	U32 mPacketsToDrop;				// drop next n packets
 
+	BOOL mSendEnabled;
+	U32 mBlockedSendCount;			// packets dropped while sending was off
+
 	std::queue<LLPacketBuffer *> mReceiveQueue;
 	std::queue<LLPacketBuffer *> mSendQueue;
 
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
+	BOOL mUseBatching;
+	char* mBatchSlab;				// NET_MAX_BATCH receive buffers followed by NET_MAX_BATCH send buffers
+	LLNetDatagram mReceiveBatch[NET_MAX_BATCH];
+	S32 mReceiveBatchCount;
+	S32 mReceiveBatchIndex;			// next datagram of mReceiveBatch to hand out
+	LLNetDatagram mSendBatch[NET_MAX_BATCH];
+	S32 mSendBatchCount;
+	S32 mSendBatchDepth;
+	S32 mSendBatchSocket;
+	S32 mSendBatchFailures;
+	BatchStats mBatchStats;
+
 private:
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
+	BOOL sendDatagram(int h_socket, const char * send_buffer, S32 buf_size, U32 ip, S32 port);
+	void flushSendBatch();
+	S32  receiveFromNet(S32 socket, char *datap);
+	S32  unwrapSOCKS(const char *buffer, S32 size, char *datap);
+	void allocateBatchSlab();
 };
 
 
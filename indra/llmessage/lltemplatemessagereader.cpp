@@ -44,7 +44,6 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 												 number_template_map) :
 	mReceiveSize(0),
 	mCurrentRMessageTemplate(NULL),
-	mCurrentRMessageData(NULL),
 	mMessageNumbers(number_template_map)
 {
 }
@@ -52,8 +51,6 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 //virtual 
 LLTemplateMessageReader::~LLTemplateMessageReader()
 {
-	delete mCurrentRMessageData;
-	mCurrentRMessageData = NULL;
 }
 
 //virtual
@@ -61,8 +58,36 @@ void LLTemplateMessageReader::clearMessage()
 {
 	mReceiveSize = -1;
 	mCurrentRMessageTemplate = NULL;
-	delete mCurrentRMessageData;
-	mCurrentRMessageData = NULL;
+	mFieldBlocks.clear();
+}
+
+bool LLTemplateMessageReader::hasFields() const
+{
+	return mCurrentRMessageTemplate
+		&& mFieldBlocks.size() == mCurrentRMessageTemplate->mMemberBlocks.size();
+}
+
+S32 LLTemplateMessageReader::findBlock(const char* blockname) const
+{
+	const LLMessageTemplate::message_block_map_t& blocks = mCurrentRMessageTemplate->mMemberBlocks;
+	LLMessageTemplate::message_block_map_t::const_iterator iter = blocks.find((char*)blockname);
+	if (iter == blocks.end())
+	{
+		return -1;
+	}
+	return (S32)(iter - blocks.begin());
+}
+
+S32 LLTemplateMessageReader::findVariable(S32 block_index, const char* varname) const
+{
+	const LLMessageBlock::message_variable_map_t& vars =
+		mCurrentRMessageTemplate->mMemberBlocks.begin()[block_index]->mMemberVariables;
+	LLMessageBlock::message_variable_map_t::const_iterator iter = vars.find(varname);
+	if (iter == vars.end())
+	{
+		return -1;
+	}
+	return (S32)(iter - vars.begin());
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -74,80 +99,86 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 		return;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!hasFields())
 	{
-		LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
+		LL_ERRS() << "Message not decoded in getData!" << LL_ENDL;
 		return;
 	}
 
-	char *bnamep = (char *)blockname + blocknum; // this works because it's just a hash.  The bnamep is never derefference
-	char *vnamep = (char *)varname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block_index = findBlock(blockname);
+	const Field* fields = getFields(block_index, blocknum);
+	if (!fields)
 	{
 		LL_ERRS() << "Block " << blockname << " #" << blocknum
-			<< " not in message " << mCurrentRMessageData->mName << LL_ENDL;
+			<< " not in message " << mCurrentRMessageTemplate->mName << LL_ENDL;
 		return;
 	}
 
-	LLMsgBlkData *msg_block_data = iter->second;
-	LLMsgBlkData::msg_var_data_map_t &var_data_map = msg_block_data->mMemberVarData;
-
-	if (var_data_map.find(vnamep) == var_data_map.end())
+	S32 var_index = findVariable(block_index, varname);
+	if (var_index < 0)
 	{
-		LL_ERRS() << "Variable "<< vnamep << " not in message "
-			<< mCurrentRMessageData->mName<< " block " << bnamep << LL_ENDL;
+		LL_ERRS() << "Variable "<< varname << " not in message "
+			<< mCurrentRMessageTemplate->mName<< " block " << blockname << LL_ENDL;
 		return;
 	}
 
-	LLMsgVarData& vardata = msg_block_data->mMemberVarData[vnamep];
+	const Field& field = fields[var_index];
 
-	if (size && size != vardata.getSize())
+	if (size && size != field.mSize)
 	{
-		LL_ERRS() << "Msg " << mCurrentRMessageData->mName 
-			<< " variable " << vnamep
-			<< " is size " << vardata.getSize()
+		LL_ERRS() << "Msg " << mCurrentRMessageTemplate->mName 
+			<< " variable " << varname
+			<< " is size " << field.mSize
 			<< " but copying into buffer of size " << size
 			<< LL_ENDL;
 		return;
 	}
 
-
-	const S32 vardata_size = vardata.getSize();
-	if( max_size >= vardata_size )
-	{   
-		switch( vardata_size )
-		{ 
-		case 1:
-			*((U8*)datap) = *((U8*)vardata.getData());
-			break;
-		case 2:
-			*((U16*)datap) = *((U16*)vardata.getData());
-			break;
-		case 4:
-			*((U32*)datap) = *((U32*)vardata.getData());
-			break;
-		case 8:
-			((U32*)datap)[0] = ((U32*)vardata.getData())[0];
-			((U32*)datap)[1] = ((U32*)vardata.getData())[1];
-			break;
-		default:
-			memcpy(datap, vardata.getData(), vardata_size);
-			break;
-		}
-	}
-	else
+	S32 copy_size = field.mSize;
+	if (max_size < copy_size)
 	{
-		LL_WARNS() << "Msg " << mCurrentRMessageData->mName 
-			<< " variable " << vnamep
-			<< " is size " << vardata.getSize()
+		LL_WARNS() << "Msg " << mCurrentRMessageTemplate->mName 
+			<< " variable " << varname
+			<< " is size " << field.mSize
 			<< " but truncated to max size of " << max_size
 			<< LL_ENDL;
 
-		memcpy(datap, vardata.getData(), max_size);
+		copy_size = max_size;
 	}
+
+	if (!field.mData)
+	{
+		// ran off the end of the packet, zeros
+		memset(datap, 0, copy_size);
+		return;
+	}
+
+	const LLMessageVariable* mvci =
+		mCurrentRMessageTemplate->mMemberBlocks.begin()[block_index]->mMemberVariables.begin()[var_index];
+	htolememcpy(datap, field.mData, mvci->getType(), copy_size);
+}
+
+const LLTemplateMessageReader::Field* LLTemplateMessageReader::getFields(S32 block_index, S32 blocknum) const
+{
+	if (block_index < 0 || block_index >= (S32)mFieldBlocks.size())
+	{
+		return NULL;
+	}
+	const FieldBlock& block = mFieldBlocks[block_index];
+	if (blocknum < 0 || blocknum >= block.mCount)
+	{
+		return NULL;
+	}
+	return &mFields[block.mFirstField + blocknum * block.mVariableCount];
+}
+
+S32 LLTemplateMessageReader::getFieldBlockCount(S32 block_index) const
+{
+	if (block_index < 0 || block_index >= (S32)mFieldBlocks.size())
+	{
+		return 0;
+	}
+	return mFieldBlocks[block_index].mCount;
 }
 
 S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
@@ -159,22 +190,13 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 		return -1;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!hasFields())
 	{
-		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+		LL_ERRS() << "Message not decoded in getNumberOfBlocks!" << LL_ENDL;
 		return -1;
 	}
 
-	char *bnamep = (char *)blockname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
-	{
-		return 0;
-	}
-
-	return (iter->second)->mBlockNumber;
+	return getFieldBlockCount(findBlock(blockname));
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
@@ -186,43 +208,37 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
 		return LL_MESSAGE_ERROR;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!hasFields())
 	{	// This is a serious error - crash
-		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+		LL_ERRS() << "Message not decoded in getSize!" << LL_ENDL;
 		return LL_MESSAGE_ERROR;
 	}
 
-	char *bnamep = (char *)blockname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block_index = findBlock(blockname);
+	const Field* fields = getFields(block_index, 0);
+	if (!fields)
 	{	// don't crash
-		LL_INFOS() << "Block " << bnamep << " not in message "
-			<< mCurrentRMessageData->mName << LL_ENDL;
+		LL_INFOS() << "Block " << blockname << " not in message "
+			<< mCurrentRMessageTemplate->mName << LL_ENDL;
 		return LL_BLOCK_NOT_IN_MESSAGE;
 	}
 
-	char *vnamep = (char *)varname; 
-
-	LLMsgBlkData* msg_data = iter->second;
-	LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-	
-	if (!vardata.getName())
+	S32 var_index = findVariable(block_index, varname);
+	if (var_index < 0)
 	{	// don't crash
 		LL_INFOS() << "Variable " << varname << " not in message "
-			<< mCurrentRMessageData->mName << " block " << bnamep << LL_ENDL;
+			<< mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
 		return LL_VARIABLE_NOT_IN_BLOCK;
 	}
 
-	if (mCurrentRMessageTemplate->mMemberBlocks[bnamep]->mType != MBT_SINGLE)
+	if (mCurrentRMessageTemplate->mMemberBlocks.begin()[block_index]->mType != MBT_SINGLE)
 	{	// This is a serious error - crash
-		LL_ERRS() << "Block " << bnamep << " isn't type MBT_SINGLE,"
+		LL_ERRS() << "Block " << blockname << " isn't type MBT_SINGLE,"
 			" use getSize with blocknum argument!" << LL_ENDL;
 		return LL_MESSAGE_ERROR;
 	}
 
-	return vardata.getSize();
+	return fields[var_index].mSize;
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const char *varname)
@@ -234,35 +250,30 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
 		return LL_MESSAGE_ERROR;
 	}
 
-	if (!mCurrentRMessageData)
+	if (!hasFields())
 	{	// This is a serious error - crash
-		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
+		LL_ERRS() << "Message not decoded in getSize!" << LL_ENDL;
 		return LL_MESSAGE_ERROR;
 	}
 
-	char *bnamep = (char *)blockname + blocknum; 
-	char *vnamep = (char *)varname; 
-
-	LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-	
-	if (iter == mCurrentRMessageData->mMemberBlocks.end())
+	S32 block_index = findBlock(blockname);
+	const Field* fields = getFields(block_index, blocknum);
+	if (!fields)
 	{	// don't crash
-		LL_INFOS() << "Block " << bnamep << " not in message " 
-			<< mCurrentRMessageData->mName << LL_ENDL;
+		LL_INFOS() << "Block " << blockname << " #" << blocknum << " not in message " 
+			<< mCurrentRMessageTemplate->mName << LL_ENDL;
 		return LL_BLOCK_NOT_IN_MESSAGE;
 	}
 
-	LLMsgBlkData* msg_data = iter->second;
-	LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-	
-	if (!vardata.getName())
+	S32 var_index = findVariable(block_index, varname);
+	if (var_index < 0)
 	{	// don't crash
-		LL_INFOS() << "Variable " << vnamep << " not in message "
-			<<  mCurrentRMessageData->mName << " block " << bnamep << LL_ENDL;
+		LL_INFOS() << "Variable " << varname << " not in message "
+			<<  mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
 		return LL_VARIABLE_NOT_IN_BLOCK;
 	}
 
-	return vardata.getSize();
+	return fields[var_index].mSize;
 }
 
 void LLTemplateMessageReader::getBinaryData(const char *blockname, 
@@ -447,7 +458,7 @@ S32 LLTemplateMessageReader::getMessageSize() const
 // Returns template for the message contained in buffer
 BOOL LLTemplateMessageReader::decodeTemplate(  
 		const U8* buffer, S32 buffer_size,  // inputs
-		LLMessageTemplate** msg_template ) // outputs
+		LLMessageTemplate** msg_template ) const // outputs
 {
 	const U8* header = buffer + LL_PACKET_ID_SIZE;
 
@@ -521,13 +532,18 @@ void LLTemplateMessageReader::logRanOffEndOfPacket( const LLHost& host, const S3
 			<< " bytes at position " << where
 			<< " going past packet end at " << mReceiveSize
 			<< LL_ENDL;
-	if(gMessageSystem->mVerboseLog)
+	LLMessageSystem* msg = gMessageSystem;
+	if (!msg)
+	{
+		return;
+	}
+	if(msg->mVerboseLog)
 	{
 		LL_INFOS() << "MSG: -> " << host << "\tREAD PAST END:\t"
 //				<< mCurrentRecvPacketID << " "
 				<< getMessageName() << LL_ENDL;
 	}
-	gMessageSystem->callExceptionFunc(MX_RAN_OFF_END_OF_PACKET);
+	msg->callExceptionFunc(MX_RAN_OFF_END_OF_PACKET);
 }
 
 static LLTrace::BlockTimerStatHandle FTM_PROCESS_MESSAGES("Process Messages");
@@ -539,16 +555,19 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
 	llassert( mReceiveSize >= 0 );
 	llassert( mCurrentRMessageTemplate);
-	llassert( !mCurrentRMessageData );
-	delete mCurrentRMessageData; // just to make sure
 
 	// The offset tells us how may bytes to skip after the end of the
 	// message name.
 	U8 offset = buffer[PHL_OFFSET];
 	S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
 
-	// create base working data set
-	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
+	// keep our own copy, the caller reuses the packet buffer and the
+	// fields are read up to the next message
+	mBuffer.assign(buffer, buffer + mReceiveSize);
+	buffer = mBuffer.empty() ? NULL : &mBuffer[0];
+	mFields.clear();
+	mFieldBlocks.clear();
+	bool empty = true;
 	
 	// loop through the template building the data structure as we go
 	LLMessageTemplate::message_block_map_t::const_iterator iter;
@@ -559,6 +578,9 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 		LLMessageBlock* mbci = *iter;
 		U8	repeat_number;
 		S32	i;
+		FieldBlock field_block;
+		field_block.mFirstField = (S32)mFields.size();
+		field_block.mVariableCount = (S32)mbci->mMemberVariables.size();
 
 		// how many of this block?
 
@@ -597,26 +619,16 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 			return FALSE;
 		}
 
-		LLMsgBlkData* cur_data_block = NULL;
+		field_block.mCount = repeat_number;
+		mFieldBlocks.push_back(field_block);
+		if (repeat_number)
+		{
+			empty = false;
+		}
 
 		// now loop through the block
 		for (i = 0; i < repeat_number; i++)
 		{
-			if (i)
-			{
-				// build new name to prevent collisions
-				// TODO: This should really change to a vector
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-				cur_data_block->mName = mbci->mName + i;
-			}
-			else
-			{
-				cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-			}
-
-			// add the block to the message
-			mCurrentRMessageData->addBlock(cur_data_block);
-
 			// now read the variables
 			for (LLMessageBlock::message_variable_map_t::const_iterator iter = 
 					 mbci->mMemberVariables.begin();
@@ -624,10 +636,6 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 			{
 				const LLMessageVariable& mvci = **iter;
 
-				// ok, build out the variables
-				// add variable block
-				cur_data_block->addVariable(mvci.getName(), mvci.getType());
-
 				// what type of variable?
 				if (mvci.getType() == MVT_VARIABLE)
 				{
@@ -666,7 +674,16 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 					}
 					decode_pos += data_size;
 
-					cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType());
+					if (tsize && (decode_pos + (S32)tsize) > mReceiveSize)
+					{
+						logRanOffEndOfPacket(sender, decode_pos, tsize);
+
+						// keep what there is
+						tsize = llmax(mReceiveSize - decode_pos, 0);
+					}
+
+					Field field = { tsize ? &buffer[decode_pos] : NULL, (S32)tsize };
+					mFields.push_back(field);
 					decode_pos += tsize;
 				}
 				else
@@ -678,17 +695,13 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 						logRanOffEndOfPacket(sender, decode_pos, mvci.getSize());
 
 						// default to 0s.
-						U32 size = mvci.getSize();
-						std::vector<U8> data(size, 0);
-						cur_data_block->addData(mvci.getName(), &(data[0]), 
-												size, mvci.getType());
+						Field field = { NULL, mvci.getSize() };
+						mFields.push_back(field);
 					}
 					else
 					{
-						cur_data_block->addData(mvci.getName(), 
-												&buffer[decode_pos], 
-												mvci.getSize(), 
-												mvci.getType());
+						Field field = { &buffer[decode_pos], mvci.getSize() };
+						mFields.push_back(field);
 					}
 					decode_pos += mvci.getSize();
 				}
@@ -696,8 +709,7 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 		}
 	}
 
-	if (mCurrentRMessageData->mMemberBlocks.empty()
-		&& !mCurrentRMessageTemplate->mMemberBlocks.empty())
+	if (empty && !mCurrentRMessageTemplate->mMemberBlocks.empty())
 	{
 		LL_DEBUGS() << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << LL_ENDL;
 		return FALSE;
@@ -705,26 +717,29 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
 	{
 		static LLTimer decode_timer;
+		LLMessageSystem* msg = gMessageSystem;
+		LLMessageSystem::msg_timing_callback timing_callback =
+			msg ? msg->getTimingCallback() : NULL;
 
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		if(LLMessageReader::getTimeDecodes() || timing_callback)
 		{
 			decode_timer.reset();
 		}
 
-		if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
+		if( !mCurrentRMessageTemplate->callHandlerFunc(msg) )
 		{
 			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
 		}
 
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		if(LLMessageReader::getTimeDecodes() || timing_callback)
 		{
 			F32 decode_time = decode_timer.getElapsedTimeF32();
 
-			if (gMessageSystem->getTimingCallback())
+			if (timing_callback)
 			{
-				(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
+				timing_callback(mCurrentRMessageTemplate->mName,
 								decode_time,
-								gMessageSystem->getTimingCallbackData());
+								msg->getTimingCallbackData());
 			}
 
 			if (LLMessageReader::getTimeDecodes())
@@ -758,6 +773,7 @@ BOOL LLTemplateMessageReader::validateMessage(const U8* buffer,
 											  bool trusted)
 {
 	mReceiveSize = buffer_size;
+	mFieldBlocks.clear();
 	BOOL valid = decodeTemplate(buffer, buffer_size, &mCurrentRMessageTemplate );
 	if(valid)
 	{
@@ -828,5 +844,50 @@ void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
     {
         return;
     }
-	builder.copyFromMessageData(*mCurrentRMessageData);
+	if (!hasFields())
+	{
+		return;
+	}
+
+	// The builders take the message as LLMsgData, build one from the
+	// fields.  Repeated blocks are named by offsetting the block name
+	// pointer, as the builders expect.
+	LLMsgData data(mCurrentRMessageTemplate->mName);
+	S32 block_index = 0;
+	for (LLMessageTemplate::message_block_map_t::const_iterator iter =
+			 mCurrentRMessageTemplate->mMemberBlocks.begin();
+		 iter != mCurrentRMessageTemplate->mMemberBlocks.end();
+		 ++iter, ++block_index)
+	{
+		const LLMessageBlock* mbci = *iter;
+		S32 count = mFieldBlocks[block_index].mCount;
+		for (S32 i = 0; i < count; ++i)
+		{
+			LLMsgBlkData* block = new LLMsgBlkData(mbci->mName, count);
+			block->mName = mbci->mName + i;
+			data.addBlock(block);
+
+			const Field* fields = getFields(block_index, i);
+			S32 var_index = 0;
+			for (LLMessageBlock::message_variable_map_t::const_iterator var_iter =
+					 mbci->mMemberVariables.begin();
+				 var_iter != mbci->mMemberVariables.end();
+				 ++var_iter, ++var_index)
+			{
+				const LLMessageVariable& mvci = **var_iter;
+				const Field& field = fields[var_index];
+				block->addVariable(mvci.getName(), mvci.getType());
+				if (field.mData || !field.mSize)
+				{
+					block->addData(mvci.getName(), field.mData, field.mSize, mvci.getType());
+				}
+				else
+				{
+					std::vector<U8> zeros(field.mSize, 0);
+					block->addData(mvci.getName(), &zeros[0], field.mSize, mvci.getType());
+				}
+			}
+		}
+	}
+	builder.copyFromMessageData(data);
 }
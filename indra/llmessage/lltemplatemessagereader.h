@@ -30,9 +30,9 @@
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
 class LLMessageTemplate;
-class LLMsgData;
 
 class LLTemplateMessageReader : public LLMessageReader
 {
@@ -105,14 +105,45 @@ public:
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
-	
+
+	// Looks up the template for the message number in buffer without
+	// changing the reader state, so it is safe to call from the UDP thread.
+	BOOL decodeTemplate(const U8* buffer, S32 buffer_size,  // inputs
+						LLMessageTemplate** msg_template ) const; // outputs
+
+	// A variable of the current message.  mData points into the reader's
+	// copy of the message, or is NULL for zeros where the packet ran short.
+	struct Field
+	{
+		const U8*	mData;
+		S32			mSize;
+	};
+
+	// Until the next message or clearMessage(), the variables of block
+	// number blocknum of the block_index'th block of the current template,
+	// in template order.  NULL if there is no such block in the message.
+	// See LLMessageFields.
+	const Field* getFields(S32 block_index, S32 blocknum) const;
+	S32 getFieldBlockCount(S32 block_index) const;
+	// True once the current message has been decoded
+	bool hasFields() const;
+	const LLMessageTemplate* getCurrentTemplate() const	{ return mCurrentRMessageTemplate; }
+
 private:
+	struct FieldBlock
+	{
+		S32 mFirstField;
+		S32 mCount;
+		S32 mVariableCount;
+	};
 
 	void getData(const char *blockname, const char *varname, void *datap, 
 				 S32 size = 0, S32 blocknum = 0, S32 max_size = S32_MAX);
 
-	BOOL decodeTemplate(const U8* buffer, S32 buffer_size,  // inputs
-						LLMessageTemplate** msg_template ); // outputs
+	// Index in the current template, or -1 if it has no such block or
+	// variable
+	S32 findBlock(const char* blockname) const;
+	S32 findVariable(S32 block_index, const char* varname) const;
 
 	void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
@@ -120,8 +151,15 @@ private:
 
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
-	LLMsgData* mCurrentRMessageData;
 	message_template_number_map_t& mMessageNumbers;
+
+	// Decoding copies the message into mBuffer and lays out its variables
+	// in mFields, one FieldBlock per template block.  All three are reused
+	// from message to message so decoding does not allocate once they
+	// have grown to the largest message seen.
+	std::vector<U8> mBuffer;
+	std::vector<Field> mFields;
+	std::vector<FieldBlock> mFieldBlocks;
 };
 
 #endif // LL_LLTEMPLATEMESSAGEREADER_H
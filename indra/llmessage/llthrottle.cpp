@@ -575,3 +575,191 @@ BOOL LLThrottleGroup::dynamicAdjust()
 	}
 	return TRUE;
 }
+
+
+// Smoothing applied to each per-update throughput and loss sample.
+const F32 ESTIMATOR_SAMPLE_WEIGHT = 0.3f;
+// Loss rate above which we assume we're sending faster than the link.
+const F32 ESTIMATOR_LOSS_BACKOFF = 0.02f;
+// How far below what got through we drop when congested.
+const F32 ESTIMATOR_BACKOFF_FRACTION = 0.85f;
+// Growth per update while the link is kept full without congestion.
+const F32 ESTIMATOR_PROBE_FRACTION = 1.1f;
+// Fraction of the estimate that must be in use before we probe upward,
+// unless some category is pinned at its allocation.
+const F32 ESTIMATOR_PROBE_UTILIZATION = 0.8f;
+// Updates to wait after a backoff before probing again.
+const S32 ESTIMATOR_HOLD_UPDATES = 2;
+
+// Share of the estimate every category keeps regardless of demand, so a
+// quiet category can still be heard from when it wakes up.
+//                                                   Resend  Land  Wind Cloud  Task Texture Asset
+const F32 ESTIMATOR_FLOOR_FRACTION[TC_EOF]     = {  0.04f, 0.04f, 0.01f, 0.01f, 0.12f, 0.08f, 0.04f };
+// Split used before any traffic has been seen, roughly the viewer presets.
+const F32 ESTIMATOR_DEFAULT_FRACTION[TC_EOF]   = {  0.10f, 0.10f, 0.02f, 0.02f, 0.31f, 0.31f, 0.14f };
+// Resends arrive in bursts, leave headroom above what we've seen.
+const F32 ESTIMATOR_RESEND_HEADROOM = 1.5f;
+// A category using nearly all of its allocation is likely being held back
+// by it, weight it up so it can grow.
+const F32 ESTIMATOR_SATURATED_FRACTION = 0.9f;
+const F32 ESTIMATOR_SATURATED_BOOST = 1.25f;
+
+
+LLThrottleEstimator::LLThrottleEstimator()
+:	mMinBPS(50.f * 1024.f),
+	mMaxBPS(6000.f * 1024.f)
+{
+	reset(500.f * 1024.f);
+}
+
+
+void LLThrottleEstimator::reset(F32 bps)
+{
+	mEstimatedBPS = llclamp(bps, mMinBPS, mMaxBPS);
+	mDeliveredBPS = 0.f;
+	for (S32 i = 0; i < TC_EOF; i++)
+	{
+		mDemandBPS[i] = 0.f;
+		mBytesIn[i] = 0;
+	}
+	mPacketsIn = 0;
+	mLastPacketsLost = 0;
+	mLossRate = 0.f;
+	mHoldUpdates = 0;
+	mCongested = FALSE;
+	mHaveSample = FALSE;
+	updateSplit();
+}
+
+
+void LLThrottleEstimator::setLimits(F32 min_bps, F32 max_bps)
+{
+	mMinBPS = min_bps;
+	mMaxBPS = llmax(min_bps, max_bps);
+	mEstimatedBPS = llclamp(mEstimatedBPS, mMinBPS, mMaxBPS);
+	updateSplit();
+}
+
+
+void LLThrottleEstimator::addBytesIn(S32 throttle_cat, S32 bytes)
+{
+	if (throttle_cat < 0 || throttle_cat >= TC_EOF)
+	{
+		// Unclassified traffic still uses the link, charge it to tasks.
+		throttle_cat = TC_TASK;
+	}
+	mBytesIn[throttle_cat] += bytes;
+	mPacketsIn++;
+}
+
+
+BOOL LLThrottleEstimator::update(F32 dt, U32 packets_lost)
+{
+	if (dt <= 0.f)
+	{
+		return FALSE;
+	}
+
+	S32 i;
+	F32 delivered_bps = 0.f;
+	BOOL saturated = FALSE;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		F32 cat_bps = (F32)mBytesIn[i] * 8.f / dt;
+		delivered_bps += cat_bps;
+		saturated |= i != TC_RESEND && cat_bps >= mSplitBPS[i] * ESTIMATOR_SATURATED_FRACTION;
+		mDemandBPS[i] = mHaveSample ? lerp(mDemandBPS[i], cat_bps, ESTIMATOR_SAMPLE_WEIGHT) : cat_bps;
+		mBytesIn[i] = 0;
+	}
+	mDeliveredBPS = mHaveSample ? lerp(mDeliveredBPS, delivered_bps, ESTIMATOR_SAMPLE_WEIGHT) : delivered_bps;
+
+	// The circuit's loss counter only goes up, but survive it being reset.
+	U32 lost = packets_lost >= mLastPacketsLost ? packets_lost - mLastPacketsLost : 0;
+	mLastPacketsLost = packets_lost;
+	F32 loss = (mPacketsIn + lost) ? (F32)lost / (F32)(mPacketsIn + lost) : 0.f;
+	mLossRate = mHaveSample ? lerp(mLossRate, loss, ESTIMATOR_SAMPLE_WEIGHT) : loss;
+	mPacketsIn = 0;
+	mHaveSample = TRUE;
+
+	F32 old_bps = mEstimatedBPS;
+	mCongested = mLossRate > ESTIMATOR_LOSS_BACKOFF;
+	if (mCongested)
+	{
+		// Back off to below what actually made it through.  A full link is
+		// the best capacity sample we get, so don't let the smoothing hide
+		// it.  The estimate may already be lower if demand is light.
+		F32 target_bps = llmax(mDeliveredBPS, delivered_bps) * ESTIMATOR_BACKOFF_FRACTION;
+		if (target_bps < mEstimatedBPS)
+		{
+			mEstimatedBPS = target_bps;
+		}
+		mHoldUpdates = ESTIMATOR_HOLD_UPDATES;
+	}
+	else if (mHoldUpdates > 0)
+	{
+		mHoldUpdates--;
+	}
+	else if (saturated || mDeliveredBPS >= mEstimatedBPS * ESTIMATOR_PROBE_UTILIZATION)
+	{
+		// Something is held back by the throttle with no sign of loss,
+		// see if the link has more.
+		mEstimatedBPS *= ESTIMATOR_PROBE_FRACTION;
+	}
+	mEstimatedBPS = llclamp(mEstimatedBPS, mMinBPS, mMaxBPS);
+
+	updateSplit();
+	return mEstimatedBPS != old_bps;
+}
+
+
+void LLThrottleEstimator::updateSplit()
+{
+	S32 i;
+	F32 weight[TC_EOF];
+	F32 weight_sum = 0.f;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		F32 demand = mDemandBPS[i];
+		if (i == TC_RESEND)
+		{
+			demand *= ESTIMATOR_RESEND_HEADROOM;
+		}
+		else if (mHaveSample && demand >= mSplitBPS[i] * ESTIMATOR_SATURATED_FRACTION)
+		{
+			demand *= ESTIMATOR_SATURATED_BOOST;
+		}
+		weight[i] = demand;
+		weight_sum += demand;
+	}
+
+	const F32* fraction = weight_sum > 0.f ? weight : ESTIMATOR_DEFAULT_FRACTION;
+	if (weight_sum <= 0.f)
+	{
+		weight_sum = 0.f;
+		for (i = 0; i < TC_EOF; i++)
+		{
+			weight_sum += ESTIMATOR_DEFAULT_FRACTION[i];
+		}
+	}
+
+	F32 floor_sum = 0.f;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		floor_sum += ESTIMATOR_FLOOR_FRACTION[i];
+	}
+	F32 shared_bps = mEstimatedBPS * (1.f - floor_sum);
+	for (i = 0; i < TC_EOF; i++)
+	{
+		mSplitBPS[i] = mEstimatedBPS * ESTIMATOR_FLOOR_FRACTION[i]
+			+ shared_bps * (fraction[i] / weight_sum);
+	}
+}
+
+
+void LLThrottleEstimator::getThrottleSplit(F32* throttle_vec) const
+{
+	for (S32 i = 0; i < TC_EOF; i++)
+	{
+		throttle_vec[i] = mSplitBPS[i];
+	}
+}
@@ -98,4 +98,48 @@ protected:
 
 };
 
+// Estimates the bandwidth a circuit can actually deliver from what arrives on
+// it, and splits that estimate across the throttle categories by observed
+// demand.  Congestion is read from packet loss only: the viewer's ping times
+// include its own frame time and rise with every stall.  Time is passed in by
+// the caller so the model can be driven by a simulated link.  All rates are
+// bits per second.
+class LLThrottleEstimator
+{
+public:
+	LLThrottleEstimator();
+
+	void	reset(F32 bps);								// Start over from a bandwidth guess, usually the user's setting
+	void	setLimits(F32 min_bps, F32 max_bps);
+
+	void	addBytesIn(S32 throttle_cat, S32 bytes);	// Count a received packet against its category
+	BOOL	update(F32 dt, U32 packets_lost);			// Fold in the last dt seconds, packets_lost is the circuit's running total.  TRUE if the estimate changed.
+
+	F32		getEstimatedBPS() const		{ return mEstimatedBPS; }
+	F32		getDeliveredBPS() const		{ return mDeliveredBPS; }
+	F32		getLossRate() const			{ return mLossRate; }
+	BOOL	isCongested() const			{ return mCongested; }
+	void	getThrottleSplit(F32* throttle_vec) const;	// TC_EOF values summing to the estimate
+
+protected:
+	void	updateSplit();
+
+protected:
+	F32		mMinBPS;
+	F32		mMaxBPS;
+	F32		mEstimatedBPS;			// What we think the link will carry
+	F32		mDeliveredBPS;			// Smoothed throughput actually received
+	F32		mDemandBPS[TC_EOF];		// Smoothed throughput received per category
+	F32		mSplitBPS[TC_EOF];		// Current allocation of mEstimatedBPS
+
+	S32		mBytesIn[TC_EOF];		// Received since the last update
+	U32		mPacketsIn;
+	U32		mLastPacketsLost;
+
+	F32		mLossRate;				// Smoothed fraction of packets lost
+	S32		mHoldUpdates;			// Updates left before probing upward again after a backoff
+	BOOL	mCongested;
+	BOOL	mHaveSample;
+};
+
 #endif
@@ -0,0 +1,296 @@
+/**
+ * @file lludpthread.cpp
+ * @brief Optional network thread receiving packets for the message system
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lludpthread.h"
+
+#include <algorithm>
+
+#include "lltemplatemessagebuilder.h"
+#include "lltemplatemessagereader.h"
+#include "message_prehash.h"
+
+// How long the thread blocks waiting for the socket before checking
+// whether it should quit
+const S32 UDP_THREAD_WAIT_MS = 50;
+
+// Limit of the PacketAck block count, matches LLCircuit::sendAcks()
+const S32 UDP_THREAD_MAX_ACKS_PER_PACKET = 250;
+
+LLUDPThread::LLUDPThread(S32 socket,
+						 const LLMessageSystem::message_template_name_map_t& name_templates,
+						 LLMessageSystem::message_template_number_map_t& number_templates)
+:	LLThread("UDP"),
+	mSocket(socket),
+	mReadIndex(0),
+	mWriteIndex(0),
+	mPacketsReceived(0U),
+	mPacketsAcked(0U),
+	mAckPacketsSent(0U),
+	mQueueFullWaits(0U),
+	mMaxQueued(0U)
+{
+	mMessageReader = new LLTemplateMessageReader(number_templates);
+	mMessageBuilder = new LLTemplateMessageBuilder(name_templates);
+	mQueue = new Packet[QUEUE_SIZE];
+}
+
+LLUDPThread::~LLUDPThread()
+{
+	shutdown();
+
+	delete mMessageReader;
+	mMessageReader = NULL;
+	delete mMessageBuilder;
+	mMessageBuilder = NULL;
+	delete[] mQueue;
+	mQueue = NULL;
+}
+
+LLUDPThread::Packet* LLUDPThread::peekPacket()
+{
+	U32 read_index = mReadIndex.load(std::memory_order_relaxed);
+	if (read_index == mWriteIndex.load(std::memory_order_acquire))
+	{
+		return NULL;
+	}
+	return &mQueue[read_index & (QUEUE_SIZE - 1)];
+}
+
+void LLUDPThread::popPacket()
+{
+	U32 read_index = mReadIndex.load(std::memory_order_relaxed);
+	llassert(read_index != mWriteIndex.load(std::memory_order_acquire));
+	mReadIndex.store(read_index + 1, std::memory_order_release);
+}
+
+U32 LLUDPThread::getQueuedCount() const
+{
+	return mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_acquire);
+}
+
+void LLUDPThread::updateAckCircuits(const LLCircuit& circuits)
+{
+	circuits.getAckCircuits(mScratchAckCircuits);
+	updateAckCircuits(mScratchAckCircuits);
+}
+
+void LLUDPThread::updateAckCircuits(const LLCircuit::ack_circuit_list_t& circuits)
+{
+	if (circuits == mPublishedAckCircuits)
+	{
+		return;
+	}
+
+	mPublishedAckCircuits = circuits;
+	LLMutexLock lock(&mAckCircuitsMutex);
+	mAckCircuits = circuits;
+}
+
+void LLUDPThread::getStats(Stats& stats) const
+{
+	stats.mPacketsReceived = mPacketsReceived.CurrentValue();
+	stats.mPacketsAcked = mPacketsAcked.CurrentValue();
+	stats.mAckPacketsSent = mAckPacketsSent.CurrentValue();
+	stats.mQueueFullWaits = mQueueFullWaits.CurrentValue();
+	stats.mMaxQueued = mMaxQueued.CurrentValue();
+}
+
+void LLUDPThread::run()
+{
+	while (!isQuitting())
+	{
+		if (getQueuedCount() == QUEUE_SIZE)
+		{
+			// The main thread is a full ring behind, let the socket buffer
+			// take up the slack for a moment.
+			mQueueFullWaits++;
+			ms_sleep(1);
+			continue;
+		}
+
+		if (!receivePackets())
+		{
+			wait_for_packets(mSocket, UDP_THREAD_WAIT_MS);
+		}
+	}
+}
+
+// Fills free slots of the ring until the socket is drained, then sends the
+// acks collected on the way.  Returns the number of packets received.
+S32 LLUDPThread::receivePackets()
+{
+	LLMutexLock lock(&mAckCircuitsMutex);
+
+	U32 write_index = mWriteIndex.load(std::memory_order_relaxed);
+	S32 received = 0;
+	while (write_index - mReadIndex.load(std::memory_order_acquire) < QUEUE_SIZE)
+	{
+		Packet& packet = mQueue[write_index & (QUEUE_SIZE - 1)];
+		packet.mTrueSize = mPacketRing.receivePacket(mSocket, (char*)packet.mTrueBuffer);
+		if (packet.mTrueSize <= 0)
+		{
+			break;
+		}
+		packet.mSender = mPacketRing.getLastSender();
+		packet.mReceivingIF = mPacketRing.getLastReceivingInterface();
+		preparePacket(packet);
+
+		// publish the slot to the main thread
+		mWriteIndex.store(++write_index, std::memory_order_release);
+		received++;
+	}
+
+	if (received)
+	{
+		mPacketsReceived += received;
+		U32 queued = getQueuedCount();
+		if (queued > mMaxQueued.CurrentValue())
+		{
+			mMaxQueued = queued;
+		}
+		sendAcks();
+	}
+	return received;
+}
+
+// Does the work of LLMessageSystem::checkMessages() that needs no circuit
+// state.  Packets that fail any of the checks are left with mSize -1 and
+// reported by the main thread as before.
+void LLUDPThread::preparePacket(Packet& packet)
+{
+	packet.mData = packet.mTrueBuffer;
+	packet.mSize = -1;
+	packet.mCompressedSize = 0;
+	packet.mAcked = FALSE;
+
+	S32 size = packet.mTrueSize;
+	if (size < (S32) LL_MINIMUM_VALID_PACKET_SIZE)
+	{
+		return;
+	}
+
+	if (packet.mTrueBuffer[0] & LL_ACK_FLAG)
+	{
+		S32 acks = packet.mTrueBuffer[--size];
+		if (size < (S32)(acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE))
+		{
+			return;
+		}
+		size -= acks * sizeof(TPACKETID);
+	}
+
+	if (packet.mTrueBuffer[0] & LL_ZERO_CODE_FLAG)
+	{
+		S32 expanded_size = LLMessageSystem::zeroCodeExpandBuffer(packet.mTrueBuffer, size, packet.mExpandedBuffer);
+		if (expanded_size < 0)
+		{
+			return;
+		}
+		packet.mData = packet.mExpandedBuffer;
+		packet.mCompressedSize = size;
+		size = expanded_size;
+	}
+	packet.mSize = size;
+
+	if (!(packet.mData[0] & LL_RELIABLE_FLAG))
+	{
+		return;
+	}
+
+	// Only ack messages the main thread will be able to decode
+	LLMessageTemplate* message_template = NULL;
+	if (!mMessageReader->decodeTemplate(packet.mData, size, &message_template))
+	{
+		return;
+	}
+
+	for (U32 i = 0; i < mAckCircuits.size(); ++i)
+	{
+		if (mAckCircuits[i].first == packet.mSender)
+		{
+			TPACKETID packet_id = ntohl(*((U32*)(&packet.mData[PHL_PACKET_ID])));
+			mPendingAcks.push_back(std::make_pair(i, packet_id));
+			packet.mAcked = TRUE;
+			break;
+		}
+	}
+}
+
+// Sends a PacketAck per circuit for the acks collected by preparePacket().
+// Must be called with mAckCircuitsMutex locked.
+void LLUDPThread::sendAcks()
+{
+	if (mPendingAcks.empty())
+	{
+		return;
+	}
+
+	// group by circuit, keeping the arrival order within each
+	std::stable_sort(mPendingAcks.begin(), mPendingAcks.end(),
+					 [](const std::pair<U32, TPACKETID>& a, const std::pair<U32, TPACKETID>& b)
+					 { return a.first < b.first; });
+
+	mPacketRing.beginSendBatch();
+	S32 count = (S32)mPendingAcks.size();
+	S32 first = 0;
+	while (first < count)
+	{
+		U32 circuit = mPendingAcks[first].first;
+		S32 last = first;
+		while (last < count
+			   && mPendingAcks[last].first == circuit
+			   && last - first < UDP_THREAD_MAX_ACKS_PER_PACKET)
+		{
+			last++;
+		}
+
+		mMessageBuilder->newMessage(_PREHASH_PacketAck);
+		for (S32 i = first; i < last; ++i)
+		{
+			mMessageBuilder->nextBlock(_PREHASH_Packets);
+			mMessageBuilder->addU32(_PREHASH_ID, mPendingAcks[i].second);
+		}
+		S32 size = mMessageBuilder->buildMessage(mAckBuffer, MAX_BUFFER_SIZE, 0);
+		mMessageBuilder->clearMessage();
+
+		// same header LLMessageSystem::sendMessage() writes for an
+		// unreliable message, numbered from the circuit's own sequence
+		const LLCircuit::ack_circuit_list_t::value_type& ack_circuit = mAckCircuits[circuit];
+		TPACKETID packet_id = (++(*ack_circuit.second)) % LL_MAX_OUT_PACKET_ID;
+		mAckBuffer[0] = 0;
+		*((S32*)&mAckBuffer[PHL_PACKET_ID]) = htonl(packet_id);
+
+		mPacketRing.sendPacket(mSocket, (char*)mAckBuffer, size, ack_circuit.first);
+		mPacketsAcked += (U32)(last - first);
+		mAckPacketsSent++;
+		first = last;
+	}
+	mPacketRing.endSendBatch();
+
+	mPendingAcks.clear();
+}
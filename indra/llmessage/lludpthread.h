@@ -0,0 +1,134 @@
+/**
+ * @file lludpthread.h
+ * @brief Optional network thread receiving packets for the message system
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUDPTHREAD_H
+#define LL_LLUDPTHREAD_H
+
+#include <atomic>
+#include <vector>
+
+#include "llatomic.h"
+#include "llcircuit.h"
+#include "llmutex.h"
+#include "llpacketring.h"
+#include "llthread.h"
+#include "message.h"
+
+class LLTemplateMessageBuilder;
+class LLTemplateMessageReader;
+
+// Receives the message system's UDP packets on a thread of its own, so a
+// long frame on the main thread neither lets the socket buffer overflow nor
+// holds up the acks the simulator is waiting for.
+//
+// For every packet the thread strips the appended acks, expands the zero
+// coding and looks up the message template.  Reliable messages from an
+// alive circuit are acked right away.  The prepared packets are handed to
+// LLMessageSystem::checkMessages() through a single producer, single
+// consumer ring that needs no locking; circuit bookkeeping, duplicate
+// suppression and dispatch all stay on the main thread.
+class LLUDPThread : public LLThread
+{
+public:
+	// One slot of the handoff ring
+	struct Packet
+	{
+		LLHost	mSender;
+		LLHost	mReceivingIF;
+		S32		mTrueSize;			// bytes received, including appended acks
+		U8*		mData;				// message without appended acks, expanded
+		S32		mSize;				// size of mData, -1 if it could not be prepared
+		S32		mCompressedSize;	// size before expansion, 0 if not zero coded
+		BOOL	mAcked;				// reliable message already acked by the thread
+		U8		mTrueBuffer[MAX_BUFFER_SIZE];
+		U8		mExpandedBuffer[MAX_BUFFER_SIZE];
+	};
+
+	struct Stats
+	{
+		U32 mPacketsReceived;
+		U32 mPacketsAcked;
+		U32 mAckPacketsSent;
+		U32 mQueueFullWaits;		// times the main thread fell a full ring behind
+		U32 mMaxQueued;
+	};
+
+	// Must be a power of two
+	static const U32 QUEUE_SIZE = 128;
+
+	LLUDPThread(S32 socket,
+				const LLMessageSystem::message_template_name_map_t& name_templates,
+				LLMessageSystem::message_template_number_map_t& number_templates);
+	~LLUDPThread();
+
+	// Main thread interface.  The packet returned by peekPacket() stays
+	// valid, and may be modified, until popPacket() is called.
+	Packet*	peekPacket();
+	void	popPacket();
+	U32		getQueuedCount() const;
+
+	// Hands the thread the alive circuits it may ack on, if they changed
+	// since the last call.
+	void	updateAckCircuits(const LLCircuit& circuits);
+	void	updateAckCircuits(const LLCircuit::ack_circuit_list_t& circuits);
+
+	void	getStats(Stats& stats) const;
+
+protected:
+	/*virtual*/ void run();
+
+private:
+	S32		receivePackets();
+	void	preparePacket(Packet& packet);
+	void	sendAcks();
+
+	S32						mSocket;
+	LLPacketRing			mPacketRing;
+	LLTemplateMessageReader* mMessageReader;
+	LLTemplateMessageBuilder* mMessageBuilder;
+	U8						mAckBuffer[MAX_BUFFER_SIZE];
+
+	Packet*					mQueue;
+	std::atomic<U32>		mReadIndex;			// advanced by the main thread only
+	std::atomic<U32>		mWriteIndex;		// advanced by the network thread only
+
+	// Circuits acks may be sent on, published by the main thread
+	LLMutex					mAckCircuitsMutex;
+	LLCircuit::ack_circuit_list_t mAckCircuits;
+	LLCircuit::ack_circuit_list_t mPublishedAckCircuits;	// main thread copy of the above
+	LLCircuit::ack_circuit_list_t mScratchAckCircuits;		// main thread scratch for getAckCircuits()
+
+	// Acks collected during the current burst: index into mAckCircuits, packet id
+	std::vector<std::pair<U32, TPACKETID> > mPendingAcks;
+
+	LLAtomicU32				mPacketsReceived;
+	LLAtomicU32				mPacketsAcked;
+	LLAtomicU32				mAckPacketsSent;
+	LLAtomicU32				mQueueFullWaits;
+	LLAtomicU32				mMaxQueued;
+};
+
+#endif // LL_LLUDPTHREAD_H
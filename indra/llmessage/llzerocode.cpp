@@ -0,0 +1,250 @@
+/**
+ * @file llzerocode.cpp
+ * @brief Zero coding of template message bodies
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llzerocode.h"
+
+#include <emmintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Longest run a single 0 [count] pair encodes
+	const S32 ZERO_CODE_MAX_RUN = 255;
+
+	// Zeros stood for by each extra 0 of the old wrapped encoding
+	const S32 ZERO_CODE_WRAP_RUN = 256;
+
+	const S32 SCAN_WIDTH = 16;
+
+	inline S32 first_set_bit(U32 mask)
+	{
+#if LL_WINDOWS
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (S32)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// Bit i is set if byte i of bytes is zero
+	inline U32 zero_mask(__m128i bytes)
+	{
+		return (U32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+	}
+
+	// Length of the run of non-zero bytes starting at p
+	inline S32 literal_run(const U8* p, const U8* end)
+	{
+		const U8* start = p;
+		while (end - p >= SCAN_WIDTH)
+		{
+			U32 mask = zero_mask(_mm_loadu_si128((const __m128i*)p));
+			if (mask)
+			{
+				return (S32)(p - start) + first_set_bit(mask);
+			}
+			p += SCAN_WIDTH;
+		}
+		while (p < end && *p)
+		{
+			++p;
+		}
+		return (S32)(p - start);
+	}
+
+	// Length of the run of zero bytes starting at p
+	inline S32 zero_run(const U8* p, const U8* end)
+	{
+		const U8* start = p;
+		while (end - p >= SCAN_WIDTH)
+		{
+			U32 mask = ~zero_mask(_mm_loadu_si128((const __m128i*)p)) & 0xffff;
+			if (mask)
+			{
+				return (S32)(p - start) + first_set_bit(mask);
+			}
+			p += SCAN_WIDTH;
+		}
+		while (p < end && !*p)
+		{
+			++p;
+		}
+		return (S32)(p - start);
+	}
+
+	// Copies the run of non-zero bytes starting at in.  While both buffers
+	// have room, whole 16 byte blocks are stored and the end of the run is
+	// found in the same pass, so up to 15 bytes past it get overwritten.
+	// Returns the length of the run, or -1 if it does not fit.
+	inline S32 copy_literal(const U8* in, const U8* in_end, U8* out, const U8* out_end)
+	{
+		S32 length = 0;
+		while (in_end - in - length >= SCAN_WIDTH
+			   && out_end - out - length >= SCAN_WIDTH)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(in + length));
+			_mm_storeu_si128((__m128i*)(out + length), bytes);
+			U32 mask = zero_mask(bytes);
+			if (mask)
+			{
+				return length + first_set_bit(mask);
+			}
+			length += SCAN_WIDTH;
+		}
+
+		S32 rest = literal_run(in + length, in_end);
+		if (rest > out_end - out - length)
+		{
+			return -1;
+		}
+		memcpy(out + length, in + length, rest);		/* Flawfinder: ignore */
+		return length + rest;
+	}
+}
+
+S32 ll_zero_code_expand(const U8* in, S32 in_size, U8* out, S32 out_size)
+{
+	const U8* inptr = in;
+	const U8* in_end = in + in_size;
+	U8* outptr = out;
+	const U8* out_end = out + out_size;
+
+	while (inptr < in_end)
+	{
+		if (outptr >= out_end)
+		{
+			return -1;
+		}
+
+		if (*inptr)
+		{
+			S32 length = copy_literal(inptr, in_end, outptr, out_end);
+			if (length < 0)
+			{
+				return -1;
+			}
+			inptr += length;
+			outptr += length;
+			continue;
+		}
+
+		*outptr++ = 0;
+		++inptr;
+		while (inptr < in_end && !*inptr)
+		{
+			// The old wrapped encoding.  The + 1 matches the limit the
+			// byte at a time decoder always had.
+			if (out_end - outptr < ZERO_CODE_WRAP_RUN + 1)
+			{
+				return -1;
+			}
+			memset(outptr, 0, ZERO_CODE_WRAP_RUN);
+			outptr += ZERO_CODE_WRAP_RUN;
+			++inptr;
+		}
+
+		if (inptr < in_end)
+		{
+			S32 run = *inptr++;
+			if (out_end - outptr < run)
+			{
+				return -1;
+			}
+			if (run <= SCAN_WIDTH && out_end - outptr >= SCAN_WIDTH)
+			{
+				// most runs are short, a single store beats memset()
+				_mm_storeu_si128((__m128i*)outptr, _mm_setzero_si128());
+			}
+			else
+			{
+				memset(outptr, 0, run - 1);
+			}
+			outptr += run - 1;
+		}
+	}
+
+	return (S32)(outptr - out);
+}
+
+S32 ll_zero_code_encode(const U8* in, S32 in_size, U8* out)
+{
+	const U8* inptr = in;
+	const U8* in_end = in + in_size;
+	U8* outptr = out;
+	// Each zero run takes at most twice its length, so the output never
+	// gets ahead of twice the input consumed and copy_literal() always
+	// has room for its 16 byte stores.
+	const U8* out_end = out + 2 * in_size;
+
+	while (inptr < in_end)
+	{
+		if (*inptr)
+		{
+			S32 length = copy_literal(inptr, in_end, outptr, out_end);
+			llassert(length > 0);
+			inptr += length;
+			outptr += length;
+			continue;
+		}
+
+		S32 run = zero_run(inptr, in_end);
+		inptr += run;
+		while (run > 0)
+		{
+			S32 chunk = llmin(run, ZERO_CODE_MAX_RUN);
+			*outptr++ = 0;
+			*outptr++ = (U8)chunk;
+			run -= chunk;
+		}
+	}
+
+	return (S32)(outptr - out);
+}
+
+S32 ll_zero_code_encoded_size(const U8* in, S32 in_size)
+{
+	const U8* inptr = in;
+	const U8* in_end = in + in_size;
+	S32 size = 0;
+
+	while (inptr < in_end)
+	{
+		S32 length = literal_run(inptr, in_end);
+		inptr += length;
+		size += length;
+
+		S32 run = zero_run(inptr, in_end);
+		inptr += run;
+		size += 2 * ((run + ZERO_CODE_MAX_RUN - 1) / ZERO_CODE_MAX_RUN);
+	}
+
+	return size;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file llzerocode.h
+ * @brief Zero coding of template message bodies
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLZEROCODE_H
+#define LL_LLZEROCODE_H
+
+// The body of a zero coded message, everything after the packet header,
+// sends each run of zero bytes as a 0 followed by the length of the run.
+// Runs longer than 255 are split.  On the way in, further zeros after the
+// first also stand for 256 zero bytes each, as older encoders wrapped
+// long runs that way.
+//
+// These work on caller supplied buffers and scan 16 bytes at a time for
+// the ends of runs.
+
+// Expands in into out.  Returns the expanded size, or -1 if it does not
+// fit in out_size bytes.  Bytes of out past the returned size may be
+// overwritten.
+S32 ll_zero_code_expand(const U8* in, S32 in_size, U8* out, S32 out_size);
+
+// Encodes in into out, which must hold 2 * in_size bytes, and returns the
+// encoded size.
+S32 ll_zero_code_encode(const U8* in, S32 in_size, U8* out);
+
+// Returns the size ll_zero_code_encode() would produce.
+S32 ll_zero_code_encoded_size(const U8* in, S32 in_size);
+
+#endif // LL_LLZEROCODE_H
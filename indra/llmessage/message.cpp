@@ -55,11 +55,14 @@
 #include "llmd5.h"
 #include "llmessagebuilder.h"
 #include "llmessageconfig.h"
+#include "llpacketcapture.h"
 #include "lltemplatemessagedispatcher.h"
 #include "llpumpio.h"
 #include "lltemplatemessagebuilder.h"
 #include "lltemplatemessagereader.h"
 #include "lltrustedmessageservice.h"
+#include "lludpthread.h"
+#include "llzerocode.h"
 #include "llmessagetemplate.h"
 #include "llmessagetemplateparser.h"
 #include "llsd.h"
@@ -156,6 +159,10 @@ void LLMessageSystem::init()
 	mErrorCode = 0;
 	mSendReliable = FALSE;
 
+	mUDPThread = NULL;
+	mPacketCapture = NULL;
+	mPacketReplay = NULL;
+
 	mUnackedListDepth = 0;
 	mUnackedListSize = 0;
 	mDSMaxListDepth = 0;
@@ -227,6 +234,7 @@ LLMessageSystem::LLMessageSystem(const std::string& filename, U32 port,
 	mCircuitPrintFreq = F32Seconds(60.f);
 
 	loadTemplateFile(filename, failure_is_fatal);
+	initThrottleCategories();
 
 	mTemplateMessageBuilder = new LLTemplateMessageBuilder(mMessageTemplates);
 	mLLSDMessageBuilder = new LLSDMessageBuilder();
@@ -321,6 +329,13 @@ void LLMessageSystem::loadTemplateFile(const std::string& filename, bool failure
 
 LLMessageSystem::~LLMessageSystem()
 {
+	delete mUDPThread;
+	mUDPThread = NULL;
+	delete mPacketCapture;
+	mPacketCapture = NULL;
+	delete mPacketReplay;
+	mPacketReplay = NULL;
+
 	mMessageTemplates.clear(); // don't delete templates.
 	for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
 	mMessageNumbers.clear();
@@ -364,6 +379,16 @@ void LLMessageSystem::clearReceiveState()
 
 BOOL LLMessageSystem::poll(F32 seconds)
 {
+	if (mUDPThread)
+	{
+		// the socket belongs to the network thread
+		if (!mUDPThread->getQueuedCount())
+		{
+			ms_sleep((U32)(seconds * 1000.f));
+		}
+		return mUDPThread->getQueuedCount() > 0;
+	}
+
 	S32 num_socks;
 	apr_status_t status;
 	status = apr_poll(&(mPollInfop->mPollFD), 1, &num_socks,(U64)(seconds*1000000.f));
@@ -381,6 +406,112 @@ BOOL LLMessageSystem::poll(F32 seconds)
 	}
 }
 
+bool LLMessageSystem::startNetworkThread()
+{
+	if (mUDPThread)
+	{
+		// still running, or stopped with packets left for checkMessages()
+		return !mUDPThread->isStopped();
+	}
+	if (mbError)
+	{
+		return false;
+	}
+	if (mPacketRing.getUseInThrottle())
+	{
+		// the throttle queues packets in mPacketRing, which only the main thread reads
+		LL_WARNS("Messaging") << "Incoming bandwidth throttle is on, not starting the network thread" << LL_ENDL;
+		return false;
+	}
+	if (mPacketReplay)
+	{
+		LL_WARNS("Messaging") << "Replaying packets, not starting the network thread" << LL_ENDL;
+		return false;
+	}
+
+	LL_INFOS("Messaging") << "Starting the network thread" << LL_ENDL;
+	mUDPThread = new LLUDPThread(mSocket, mMessageTemplates, mMessageNumbers);
+	mUDPThread->updateAckCircuits(mCircuitInfo);
+	mUDPThread->start();
+	return true;
+}
+
+// Packets left in the ring, some of which the thread may have acked, are
+// still dispatched by checkMessages(), which deletes the thread once they
+// are all through.
+void LLMessageSystem::stopNetworkThread()
+{
+	if (mUDPThread && !mUDPThread->isStopped())
+	{
+		LL_INFOS("Messaging") << "Stopping the network thread" << LL_ENDL;
+		mUDPThread->shutdown();
+	}
+}
+
+bool LLMessageSystem::hasNetworkThread() const
+{
+	return mUDPThread && !mUDPThread->isStopped();
+}
+
+bool LLMessageSystem::startPacketCapture(const std::string& filename)
+{
+	stopPacketCapture();
+	LLPacketCaptureWriter* capture = new LLPacketCaptureWriter;
+	if (!capture->open(filename))
+	{
+		delete capture;
+		return false;
+	}
+	mPacketCapture = capture;
+	return true;
+}
+
+void LLMessageSystem::stopPacketCapture()
+{
+	delete mPacketCapture;
+	mPacketCapture = NULL;
+}
+
+bool LLMessageSystem::startPacketReplay(const std::string& filename, bool realtime)
+{
+	if (mUDPThread)
+	{
+		LL_WARNS("Messaging") << "Network thread is running, not replaying " << filename << LL_ENDL;
+		return false;
+	}
+
+	stopPacketReplay();
+	LLPacketCaptureReader* replay = new LLPacketCaptureReader;
+	if (!replay->open(filename))
+	{
+		delete replay;
+		return false;
+	}
+	replay->setRealtime(realtime);
+	mPacketReplay = replay;
+	// nothing goes back out to the hosts the capture came from, this
+	// also covers reliable resends and acks sent from the circuits
+	mPacketRing.setSendEnabled(FALSE);
+	LL_INFOS("Messaging") << "Replaying packets from " << filename << LL_ENDL;
+	return true;
+}
+
+void LLMessageSystem::stopPacketReplay()
+{
+	if (mPacketReplay)
+	{
+		LL_INFOS("Messaging") << "Replayed " << mPacketReplay->getPacketCount() << " packets" << LL_ENDL;
+		delete mPacketReplay;
+		mPacketReplay = NULL;
+		mPacketRing.setSendEnabled(TRUE);
+	}
+}
+
+bool LLMessageSystem::isReplayingPackets() const
+{
+	return mPacketReplay && !mPacketReplay->isDone();
+}
+
 bool LLMessageSystem::isTrustedSender(const LLHost& host) const
 {
 	LLCircuitData* cdp = mCircuitInfo.findCircuit(host);
@@ -502,8 +633,15 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 	// loop until either no packets or a valid packet
 	// i.e., burn through packets from unregistered circuits
 	S32 receive_size = 0;
+	LLUDPThread::Packet* packetp = NULL;
 	do
 	{
+		if (packetp)
+		{
+			mUDPThread->popPacket();
+			packetp = NULL;
+		}
+
 		clearReceiveState();
 		
 		BOOL recv_reliable = FALSE;
@@ -511,15 +649,63 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 		S32 acks = 0;
 		S32 true_rcv_size = 0;
 
-		U8* buffer = mTrueReceiveBuffer;
-		
-		mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
-		// If you want to dump all received packets into SecondLife.log, uncomment this
-		//dumpPacketToLog();
+		U8* true_buffer = mTrueReceiveBuffer;
 		
+		if (mUDPThread)
+		{
+			// check before peeking, a running thread may still queue more
+			bool stopped = mUDPThread->isStopped();
+			packetp = mUDPThread->peekPacket();
+			if (!packetp && stopped)
+			{
+				// stopped and drained, the socket is read here again
+				delete mUDPThread;
+				mUDPThread = NULL;
+			}
+		}
+
+		if (packetp)
+		{
+			// Already received, and prepared as far as possible, by the
+			// network thread.  The slot is released on the next pass.
+			true_buffer = packetp->mTrueBuffer;
+			mTrueReceiveSize = packetp->mTrueSize;
+			mLastSender = packetp->mSender;
+			mLastReceivingIF = packetp->mReceivingIF;
+		}
+		else if (mUDPThread)
+		{
+			mTrueReceiveSize = 0;
+		}
+		else if (mPacketReplay)
+		{
+			mTrueReceiveSize = mPacketReplay->readPacket(mTrueReceiveBuffer, mLastSender);
+			mLastReceivingIF = LLHost();
+			if (mTrueReceiveSize > 0 && !mCircuitInfo.findCircuit(mLastSender))
+			{
+				// the captured session had a circuit to every sim it heard from
+				enableCircuit(mLastSender, TRUE);
+			}
+		}
+		else
+		{
+			mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
+			// If you want to dump all received packets into SecondLife.log, uncomment this
+			//dumpPacketToLog();
+
+			mLastSender = mPacketRing.getLastSender();
+			mLastReceivingIF = mPacketRing.getLastReceivingInterface();
+		}
+
+		if (mPacketCapture && mTrueReceiveSize > 0)
+		{
+			mPacketCapture->writePacket(mLastSender, true_buffer, mTrueReceiveSize);
+		}
+
+		U8* buffer = true_buffer;
 		receive_size = mTrueReceiveSize;
-		mLastSender = mPacketRing.getLastSender();
-		mLastReceivingIF = mPacketRing.getLastReceivingInterface();
+		// reliable packets the network thread has already acked
+		BOOL acked = packetp && packetp->mAcked;
 		
 		if (receive_size < (S32) LL_MINIMUM_VALID_PACKET_SIZE)
 		{
@@ -560,7 +746,28 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 			}
 
 			// process the message as normal
-			mIncomingCompressedSize = zeroCodeExpand(&buffer, &receive_size);
+			if (packetp && packetp->mSize >= 0)
+			{
+				// expanded on the network thread, just count it
+				buffer = packetp->mData;
+				receive_size = packetp->mSize;
+				mIncomingCompressedSize = packetp->mCompressedSize;
+				if (mIncomingCompressedSize)
+				{
+					mTotalBytesIn += mIncomingCompressedSize;
+					mCompressedPacketsIn++;
+					mCompressedBytesIn += mIncomingCompressedSize;
+					mUncompressedBytesIn += receive_size;
+				}
+				else
+				{
+					mTotalBytesIn += receive_size;
+				}
+			}
+			else
+			{
+				mIncomingCompressedSize = zeroCodeExpand(&buffer, &receive_size);
+			}
 			mCurrentRecvPacketID = ntohl(*((U32*)(&buffer[1])));
 			host = getSender();
 
@@ -578,7 +785,7 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 				for(S32 i = 0; i < acks; ++i)
 				{
 					true_rcv_size -= sizeof(TPACKETID);
-					memcpy(&mem_id, &mTrueReceiveBuffer[true_rcv_size], /* Flawfinder: ignore*/
+					memcpy(&mem_id, &true_buffer[true_rcv_size], /* Flawfinder: ignore*/
 					     sizeof(TPACKETID));
 					packet_id = ntohl(mem_id);
 					//LL_INFOS("Messaging") << "got ack: " << packet_id << LL_ENDL;
@@ -603,7 +810,7 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 					// We need to ACK here to suppress
 					// further resends of packets we've
 					// already seen.
-					if (recv_reliable)
+					if (recv_reliable && !acked)
 					{
 						//mAckList.addData(new LLPacketAck(host, mCurrentRecvPacketID));
 						// ***************************************
@@ -708,10 +915,13 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 				if (cdp && recv_reliable)
 				{
 					// Add to the recently received list for duplicate suppression
-					cdp->mRecentlyReceivedReliablePackets[mCurrentRecvPacketID] = getMessageTimeUsecs();
+					cdp->addRecentlyReceivedReliable(mCurrentRecvPacketID);
 
 					// Put it onto the list of packets to be acked
-					cdp->collectRAck(mCurrentRecvPacketID);
+					if (!acked)
+					{
+						cdp->collectRAck(mCurrentRecvPacketID);
+					}
 					mReliablePacketsIn++;
 				}
 			}
@@ -730,6 +940,11 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 		}
 	} while (!valid_packet && receive_size > 0);
 
+	if (packetp)
+	{
+		mUDPThread->popPacket();
+	}
+
 	F64Seconds mt_sec = getMessageTimeSeconds();
 	// Check to see if we need to print debug info
 	if ((mt_sec - mCircuitPrintTime) > mCircuitPrintFreq)
@@ -781,12 +996,22 @@ void LLMessageSystem::processAcks(LockMessageChecker&, F32 collect_time)
 		// Check the status of circuits
 		mCircuitInfo.updateWatchDogTimers(this);
 
+		// resends and acks go out together in as few system calls as possible
+		mPacketRing.beginSendBatch();
+
 		//resend any necessary packets
 		mCircuitInfo.resendUnackedPackets(mUnackedListDepth, mUnackedListSize);
 
 		//cycle through ack list for each host we need to send acks to
 		mCircuitInfo.sendAcks(collect_time);
 
+		mSendPacketFailureCount += mPacketRing.endSendBatch();
+
+		if (mUDPThread)
+		{
+			mUDPThread->updateAckCircuits(mCircuitInfo);
+		}
+
 		if (!mDenyTrustedCircuitSet.empty())
 		{
 			LL_INFOS("Messaging") << "Sending queued DenyTrustedCircuit messages." << LL_ENDL;
@@ -1212,15 +1437,20 @@ S32 LLMessageSystem::sendMessage(const LLHost &host)
 	{
 		buf_ptr[0] |= LL_RELIABLE_FLAG;
 
-		if (!cdp->getUnackedPacketCount())
+		// A replayed session never sends, so there is nothing to
+		// resend or wait for an ack on either.
+		if (!mPacketReplay)
 		{
-			// We are adding the first packed onto the unacked packet list(s)
-			// Add this circuit to the list of circuits with unacked packets
-			mCircuitInfo.mUnackedCircuitMap[cdp->mHost] = cdp;
-		}
+			if (!cdp->getUnackedPacketCount())
+			{
+				// We are adding the first packed onto the unacked packet list(s)
+				// Add this circuit to the list of circuits with unacked packets
+				mCircuitInfo.mUnackedCircuitMap[cdp->mHost] = cdp;
+			}
 
-		cdp->addReliablePacket(mSocket,buf_ptr,buffer_length, &mReliablePacketParams);
-		mReliablePacketsOut++;
+			cdp->addReliablePacket(mSocket,buf_ptr,buffer_length, &mReliablePacketParams);
+			mReliablePacketsOut++;
+		}
 	}
 
 	// tack packet acks onto the end of this message
@@ -1281,7 +1511,16 @@ S32 LLMessageSystem::sendMessage(const LLHost &host)
 	}
 
 	BOOL success;
-	success = mPacketRing.sendPacket(mSocket, (char *)buf_ptr, buffer_length, host);
+	if (mPacketReplay)
+	{
+		// a replayed session does not talk back to the hosts it was
+		// captured from
+		success = TRUE;
+	}
+	else
+	{
+		success = mPacketRing.sendPacket(mSocket, (char *)buf_ptr, buffer_length, host);
+	}
 
 	if (!success)
 	{
@@ -1425,6 +1664,14 @@ void LLMessageSystem::logValidMsg(LLCircuitData *cdp, const LLHost& host, BOOL r
 		// update circuit packet ID tracking (missing/out of order packets)
 		cdp->checkPacketInID( mCurrentRecvPacketID, recv_resent );
 		cdp->addBytesIn( (S32Bytes)mTrueReceiveSize );
+
+		S32 throttle_cat = TC_RESEND;
+		if (!recv_resent)
+		{
+			const LLMessageTemplate* msg_template = mTemplateMessageReader->getCurrentTemplate();
+			throttle_cat = msg_template ? msg_template->mThrottleCategory : -1;
+		}
+		cdp->getThrottleEstimator().addBytesIn(throttle_cat, mTrueReceiveSize);
 	}
 
 	if(mVerboseLog)
@@ -2622,6 +2869,30 @@ void LLMessageSystem::summarizeLogs(std::ostream& str)
 	buffer = llformat( "On-circuit invalid packets:   %17d", mInvalidOnCircuitPackets);
 	str << buffer << std::endl << std::endl;
 
+	const LLPacketRing::BatchStats& batch_stats = mPacketRing.getBatchStats();
+	str << "Batched socket I/O: " << (mPacketRing.getUseBatching() ? "on" : "off") << std::endl;
+	tmp_str = U64_to_str(batch_stats.mReceiveCalls);
+	buffer = llformat( "Receive calls:             %20s (%5.2f packets per call, max %d)", tmp_str.c_str(),
+					   (F32) batch_stats.mReceivedPackets / (F32) llmax(batch_stats.mReceiveCalls, (U64) 1), batch_stats.mMaxReceiveBatch);
+	str << buffer << std::endl;
+	tmp_str = U64_to_str(batch_stats.mSendCalls);
+	buffer = llformat( "Send calls:                %20s (%5.2f packets per call, max %d)", tmp_str.c_str(),
+					   (F32) batch_stats.mSentPackets / (F32) llmax(batch_stats.mSendCalls, (U64) 1), batch_stats.mMaxSendBatch);
+	str << buffer << std::endl << std::endl;
+
+	if (mUDPThread)
+	{
+		LLUDPThread::Stats thread_stats;
+		mUDPThread->getStats(thread_stats);
+		str << "Network thread: " << std::endl;
+		buffer = llformat( "Packets received:          %20u", thread_stats.mPacketsReceived);
+		str << buffer << std::endl;
+		buffer = llformat( "Packets acked:             %20u (in %u PacketAck messages)", thread_stats.mPacketsAcked, thread_stats.mAckPacketsSent);
+		str << buffer << std::endl;
+		buffer = llformat( "Max packets queued:        %20u (ring full %u times)", thread_stats.mMaxQueued, thread_stats.mQueueFullWaits);
+		str << buffer << std::endl << std::endl;
+	}
+
 	str << "Decoding: " << std::endl;
 	buffer = llformat( "%35s%10s%10s%10s%10s", "Message", "Count", "Time", "Max", "Avg");
 	str << buffer << std:: endl;	
@@ -2767,54 +3038,13 @@ S32 LLMessageSystem::zeroCodeAdjustCurrentSendTotal()
 	// TODO: babbage: remove this horror
 	mMessageBuilder->setBuilt(FALSE);
 
-	S32 count = mSendSize;
-	
-	S32 net_gain = 0;
-	U8 num_zeroes = 0;
-	
-	U8 *inptr = (U8 *)mSendBuffer;
-
-// skip the packet id field
-
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	// the packet id field is not coded
+	S32 body_size = mSendSize - LL_PACKET_ID_SIZE;
+	if (body_size <= 0)
 	{
-		count--;
-		inptr++;
-	}
-
-// don't actually build, just test
-
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-	while (count--)
-	{
-		if (!(*inptr))   // in a zero count
-		{
-			if (num_zeroes)
-			{
-				if (++num_zeroes > 254)
-				{
-					num_zeroes = 0;
-				}
-				net_gain--;   // subseqent zeroes save one
-			}
-			else
-			{
-				net_gain++;  // starting a zero count adds one
-				num_zeroes = 1;
-			}
-			inptr++;
-		}
-		else
-		{
-			if (num_zeroes)
-			{
-				num_zeroes = 0;
-			}
-			inptr++;
-		}
+		return 0;
 	}
+	S32 net_gain = ll_zero_code_encoded_size(mSendBuffer + LL_PACKET_ID_SIZE, body_size) - body_size;
 	if (net_gain < 0)
 	{
 		return net_gain;
@@ -2849,75 +3079,40 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 	
 	*data[0] &= (~LL_ZERO_CODE_FLAG);
 
-	S32 count = (*data_size);  
-	
-	U8 *inptr = (U8 *)*data;
-	U8 *outptr = (U8 *)mEncodedRecvBuffer;
-
-// skip the packet id field
-
-	for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
+	S32 out_size = zeroCodeExpandBuffer(*data, in_size, mEncodedRecvBuffer);
+	if (out_size < 0)
 	{
-		count--;
-		*outptr++ = *inptr++;
+		LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size" << LL_ENDL;
+		callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
+		out_size = 0;
 	}
 
-// reconstruct encoded packet, keeping track of net size gain
+	*data = mEncodedRecvBuffer;
+	*data_size = out_size;
+	mUncompressedBytesIn += *data_size;
 
-// sequential zero bytes are encoded as 0 [U8 count] 
-// with 0 0 [count] representing wrap (>256 zeroes)
+	return(in_size);
+}
 
-	while (count--)
+// static
+S32 LLMessageSystem::zeroCodeExpandBuffer(const U8* in, S32 in_size, U8* out)
+{
+	if (in_size < LL_PACKET_ID_SIZE)
 	{
-		if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
-		{
-			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
-			callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-			outptr = mEncodedRecvBuffer;					
-			break;
-		}
-		if (!((*outptr++ = *inptr++)))
-		{
-			while (((count--)) && (!(*inptr)))
-			{
-				*outptr++ = *inptr++;
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
-  				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;
-					count = -1;
-					break;
-  				}
-				memset(outptr,0,255);
-				outptr += 255;
-			}
-			
-			if (count < 0)
-			{
-				break;
-			}
-
-			else
-			{
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
-				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;					
-				}
-				memset(outptr,0,(*inptr) - 1);
-				outptr += ((*inptr) - 1);
-				inptr++;
-			}
-		}		
+		return -1;
 	}
-	
-	*data = mEncodedRecvBuffer;
-	*data_size = (S32)(outptr - mEncodedRecvBuffer);
-	mUncompressedBytesIn += *data_size;
 
-	return(in_size);
+	// the packet id field is not coded
+	memcpy(out, in, LL_PACKET_ID_SIZE);		/* Flawfinder: ignore */
+	out[0] &= (~LL_ZERO_CODE_FLAG);
+
+	S32 body_size = ll_zero_code_expand(in + LL_PACKET_ID_SIZE, in_size - LL_PACKET_ID_SIZE,
+										out + LL_PACKET_ID_SIZE, MAX_BUFFER_SIZE - LL_PACKET_ID_SIZE);
+	if (body_size < 0)
+	{
+		return -1;
+	}
+	return LL_PACKET_ID_SIZE + body_size;
 }
 
 
@@ -2946,6 +3141,39 @@ void LLMessageSystem::setHandlerFuncFast(const char *name, void (*handler_func)(
 	}
 }
 
+// The bulk of what a simulator sends, by the throttle category it draws from.
+// Anything not listed is counted as task traffic.
+void LLMessageSystem::initThrottleCategories()
+{
+	static const struct
+	{
+		const char*	mName;
+		S32			mCategory;
+	} categories[] =
+	{
+		{ "LayerData",					TC_LAND },
+		{ "ObjectUpdate",				TC_TASK },
+		{ "ObjectUpdateCompressed",		TC_TASK },
+		{ "ObjectUpdateCached",			TC_TASK },
+		{ "ImprovedTerseObjectUpdate",	TC_TASK },
+		{ "KillObject",					TC_TASK },
+		{ "ImageData",					TC_TEXTURE },
+		{ "ImagePacket",				TC_TEXTURE },
+		{ "TransferPacket",				TC_ASSET },
+		{ "SendXferPacket",				TC_ASSET },
+	};
+
+	for (S32 i = 0; i < (S32)LL_ARRAY_SIZE(categories); i++)
+	{
+		const char* name = LLMessageStringTable::getInstance()->getString(categories[i].mName);
+		LLMessageTemplate* msgtemplate = get_ptr_in_map(mMessageTemplates, name);
+		if (msgtemplate)
+		{
+			msgtemplate->mThrottleCategory = categories[i].mCategory;
+		}
+	}
+}
+
 bool LLMessageSystem::callHandler(const char *name,
 		bool trustedSource, LLMessageSystem* msg)
 {
@@ -3976,6 +4204,15 @@ S32 LLMessageSystem::getReceiveSize() const
 	return mMessageReader->getMessageSize();
 }
 
+const LLTemplateMessageReader* LLMessageSystem::getCurrentTemplateReader() const
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		return mTemplateMessageReader;
+	}
+	return NULL;
+}
+
 //static 
 void LLMessageSystem::setTimeDecodes( BOOL b )
 {
@@ -185,6 +185,9 @@ class LLSDMessageBuilder;
 class LLMessageReader;
 class LLTemplateMessageReader;
 class LLSDMessageReader;
+class LLUDPThread;
+class LLPacketCaptureWriter;
+class LLPacketCaptureReader;
 
 
 
@@ -417,6 +420,28 @@ public:
 	BOOL	checkMessages(LockMessageChecker&, S64 frame_count = 0 );
 	void	processAcks(LockMessageChecker&, F32 collect_time = 0.f);
 
+	// Moves socket reads, zero code expansion and acking of reliable
+	// packets to a network thread; see LLUDPThread.  Returns false if the
+	// thread cannot be used, i.e. when the incoming throttle is on.
+	bool	startNetworkThread();
+	void	stopNetworkThread();
+	bool	hasNetworkThread() const;
+
+	// Writes every packet received to a capture file until stopped; see
+	// LLPacketCaptureWriter.
+	bool	startPacketCapture(const std::string& filename);
+	void	stopPacketCapture();
+	bool	isCapturingPackets() const				{ return mPacketCapture != NULL; }
+
+	// Reads packets from a capture file instead of the socket, opening a
+	// trusted circuit to each captured sender as its first packet comes
+	// in.  Nothing is sent while replaying.  Not available with the
+	// network thread.  See LLPacketReplay.
+	bool	startPacketReplay(const std::string& filename, bool realtime = false);
+	void	stopPacketReplay();
+	// True until every captured packet has been read
+	bool	isReplayingPackets() const;
+
 	BOOL	isMessageFast(const char *msg);
 	BOOL	isMessage(const char *msg)
 	{
@@ -539,6 +564,11 @@ public:
 	S32		zeroCodeExpand(U8 **data, S32 *data_size);
 	S32		zeroCodeAdjustCurrentSendTotal();
 
+	// Expands the zero coded packet in into out, which must hold
+	// MAX_BUFFER_SIZE bytes, clearing LL_ZERO_CODE_FLAG in the copy.
+	// Returns the expanded size, or -1 if it would not fit.
+	static S32 zeroCodeExpandBuffer(const U8* in, S32 in_size, U8* out);
+
 	// Uses ping-based retry
 	S32 sendReliable(const LLHost &host);
 
@@ -749,6 +779,10 @@ public:
 
 	S32		getReceiveSize() const;
 	S32		getReceiveCompressedSize() const { return mIncomingCompressedSize; }
+
+	// The template reader, or NULL if the current message is being read
+	// by another one.
+	const LLTemplateMessageReader* getCurrentTemplateReader() const;
 	S32		getReceiveBytes() const;
 
 	S32		getUnackedListSize() const			{ return mUnackedListSize; }
@@ -847,6 +881,7 @@ private:
 	void		logMsgFromInvalidCircuit( const LLHost& sender, BOOL recv_reliable );
 	void		logTrustedMsgFromUntrustedCircuit( const LLHost& sender );
 	void		logValidMsg(LLCircuitData *cdp, const LLHost& sender, BOOL recv_reliable, BOOL recv_resent, BOOL recv_acks );
+	void		initThrottleCategories();	// Bill known bulk messages to their AgentThrottle category
 	void		logRanOffEndOfPacket( const LLHost& sender );
 
 	class LLMessageCountInfo
@@ -907,6 +942,10 @@ private:
 	LLTemplateMessageReader* mTemplateMessageReader;
 	LLSDMessageReader* mLLSDMessageReader;
 
+	LLUDPThread* mUDPThread;			// NULL when packets are read on the main thread
+	LLPacketCaptureWriter* mPacketCapture;
+	LLPacketCaptureReader* mPacketReplay;	// when set, stands in for the socket
+
 	friend class LLMessageHandlerBridge;
 	friend class LockMessageChecker;
 
@@ -0,0 +1,172 @@
+/**
+ * @file message_fields.cpp
+ * @brief Typed accessors for template messages
+ *
+ * Generated by scripts/generate_message_fields.py from
+ * message_template.msg, do not edit.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "message_fields.h"
+
+#include "message_prehash.h"
+
+namespace
+{
+	const LLMessageFieldLayout::Block OBJECT_UPDATE_BLOCKS[] =
+	{
+		{ &_PREHASH_RegionData, 0, 2 },
+		{ &_PREHASH_ObjectData, 2, 46 }
+	};
+
+	const LLMessageFieldLayout::Variable OBJECT_UPDATE_VARIABLES[] =
+	{
+		{ &_PREHASH_RegionHandle, MVT_U64, 0 },
+		{ &_PREHASH_TimeDilation, MVT_U16, 0 },
+		{ &_PREHASH_ID, MVT_U32, 0 },
+		{ &_PREHASH_State, MVT_U8, 0 },
+		{ &_PREHASH_FullID, MVT_LLUUID, 0 },
+		{ &_PREHASH_CRC, MVT_U32, 0 },
+		{ &_PREHASH_PCode, MVT_U8, 0 },
+		{ &_PREHASH_Material, MVT_U8, 0 },
+		{ &_PREHASH_ClickAction, MVT_U8, 0 },
+		{ &_PREHASH_Scale, MVT_LLVector3, 0 },
+		{ &_PREHASH_ObjectData, MVT_VARIABLE, 1 },
+		{ &_PREHASH_ParentID, MVT_U32, 0 },
+		{ &_PREHASH_UpdateFlags, MVT_U32, 0 },
+		{ &_PREHASH_PathCurve, MVT_U8, 0 },
+		{ &_PREHASH_ProfileCurve, MVT_U8, 0 },
+		{ &_PREHASH_PathBegin, MVT_U16, 0 },
+		{ &_PREHASH_PathEnd, MVT_U16, 0 },
+		{ &_PREHASH_PathScaleX, MVT_U8, 0 },
+		{ &_PREHASH_PathScaleY, MVT_U8, 0 },
+		{ &_PREHASH_PathShearX, MVT_U8, 0 },
+		{ &_PREHASH_PathShearY, MVT_U8, 0 },
+		{ &_PREHASH_PathTwist, MVT_S8, 0 },
+		{ &_PREHASH_PathTwistBegin, MVT_S8, 0 },
+		{ &_PREHASH_PathRadiusOffset, MVT_S8, 0 },
+		{ &_PREHASH_PathTaperX, MVT_S8, 0 },
+		{ &_PREHASH_PathTaperY, MVT_S8, 0 },
+		{ &_PREHASH_PathRevolutions, MVT_U8, 0 },
+		{ &_PREHASH_PathSkew, MVT_S8, 0 },
+		{ &_PREHASH_ProfileBegin, MVT_U16, 0 },
+		{ &_PREHASH_ProfileEnd, MVT_U16, 0 },
+		{ &_PREHASH_ProfileHollow, MVT_U16, 0 },
+		{ &_PREHASH_TextureEntry, MVT_VARIABLE, 2 },
+		{ &_PREHASH_TextureAnim, MVT_VARIABLE, 1 },
+		{ &_PREHASH_NameValue, MVT_VARIABLE, 2 },
+		{ &_PREHASH_Data, MVT_VARIABLE, 2 },
+		{ &_PREHASH_Text, MVT_VARIABLE, 1 },
+		{ &_PREHASH_TextColor, MVT_FIXED, 4 },
+		{ &_PREHASH_MediaURL, MVT_VARIABLE, 1 },
+		{ &_PREHASH_PSBlock, MVT_VARIABLE, 1 },
+		{ &_PREHASH_ExtraParams, MVT_VARIABLE, 1 },
+		{ &_PREHASH_Sound, MVT_LLUUID, 0 },
+		{ &_PREHASH_OwnerID, MVT_LLUUID, 0 },
+		{ &_PREHASH_Gain, MVT_F32, 0 },
+		{ &_PREHASH_Flags, MVT_U8, 0 },
+		{ &_PREHASH_Radius, MVT_F32, 0 },
+		{ &_PREHASH_JointType, MVT_U8, 0 },
+		{ &_PREHASH_JointPivot, MVT_LLVector3, 0 },
+		{ &_PREHASH_JointAxisOrAnchor, MVT_LLVector3, 0 }
+	};
+
+	const LLMessageFieldLayout::Block OBJECT_UPDATE_COMPRESSED_BLOCKS[] =
+	{
+		{ &_PREHASH_RegionData, 0, 2 },
+		{ &_PREHASH_ObjectData, 2, 2 }
+	};
+
+	const LLMessageFieldLayout::Variable OBJECT_UPDATE_COMPRESSED_VARIABLES[] =
+	{
+		{ &_PREHASH_RegionHandle, MVT_U64, 0 },
+		{ &_PREHASH_TimeDilation, MVT_U16, 0 },
+		{ &_PREHASH_UpdateFlags, MVT_U32, 0 },
+		{ &_PREHASH_Data, MVT_VARIABLE, 2 }
+	};
+
+	const LLMessageFieldLayout::Block IMPROVED_TERSE_OBJECT_UPDATE_BLOCKS[] =
+	{
+		{ &_PREHASH_RegionData, 0, 2 },
+		{ &_PREHASH_ObjectData, 2, 2 }
+	};
+
+	const LLMessageFieldLayout::Variable IMPROVED_TERSE_OBJECT_UPDATE_VARIABLES[] =
+	{
+		{ &_PREHASH_RegionHandle, MVT_U64, 0 },
+		{ &_PREHASH_TimeDilation, MVT_U16, 0 },
+		{ &_PREHASH_Data, MVT_VARIABLE, 1 },
+		{ &_PREHASH_TextureEntry, MVT_VARIABLE, 2 }
+	};
+
+	const LLMessageFieldLayout::Block CHAT_FROM_SIMULATOR_BLOCKS[] =
+	{
+		{ &_PREHASH_ChatData, 0, 8 }
+	};
+
+	const LLMessageFieldLayout::Variable CHAT_FROM_SIMULATOR_VARIABLES[] =
+	{
+		{ &_PREHASH_FromName, MVT_VARIABLE, 1 },
+		{ &_PREHASH_SourceID, MVT_LLUUID, 0 },
+		{ &_PREHASH_OwnerID, MVT_LLUUID, 0 },
+		{ &_PREHASH_SourceType, MVT_U8, 0 },
+		{ &_PREHASH_ChatType, MVT_U8, 0 },
+		{ &_PREHASH_Audible, MVT_U8, 0 },
+		{ &_PREHASH_Position, MVT_LLVector3, 0 },
+		{ &_PREHASH_Message, MVT_VARIABLE, 2 }
+	};
+}
+
+const LLMessageFieldLayout LLMsgObjectUpdate::sLayout =
+{
+	&_PREHASH_ObjectUpdate,
+	OBJECT_UPDATE_BLOCKS,
+	2,
+	OBJECT_UPDATE_VARIABLES
+};
+
+const LLMessageFieldLayout LLMsgObjectUpdateCompressed::sLayout =
+{
+	&_PREHASH_ObjectUpdateCompressed,
+	OBJECT_UPDATE_COMPRESSED_BLOCKS,
+	2,
+	OBJECT_UPDATE_COMPRESSED_VARIABLES
+};
+
+const LLMessageFieldLayout LLMsgImprovedTerseObjectUpdate::sLayout =
+{
+	&_PREHASH_ImprovedTerseObjectUpdate,
+	IMPROVED_TERSE_OBJECT_UPDATE_BLOCKS,
+	2,
+	IMPROVED_TERSE_OBJECT_UPDATE_VARIABLES
+};
+
+const LLMessageFieldLayout LLMsgChatFromSimulator::sLayout =
+{
+	&_PREHASH_ChatFromSimulator,
+	CHAT_FROM_SIMULATOR_BLOCKS,
+	1,
+	CHAT_FROM_SIMULATOR_VARIABLES
+};
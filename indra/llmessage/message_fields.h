@@ -0,0 +1,201 @@
+/**
+ * @file message_fields.h
+ * @brief Typed accessors for template messages
+ *
+ * Generated by scripts/generate_message_fields.py from
+ * message_template.msg, do not edit.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_MESSAGE_FIELDS_H
+#define LL_MESSAGE_FIELDS_H
+
+#include "llmessagefields.h"
+
+class LLMsgObjectUpdate : public LLMessageFields
+{
+public:
+	LLMsgObjectUpdate(LLMessageSystem* msg) : LLMessageFields(msg, sLayout) {}
+
+	// RegionData, Single
+	S32 getNumberOfRegionDataBlocks() const { return getNumberOfBlocks(0); }
+	void getRegionDataRegionHandle(U64& value, S32 blocknum = 0) const { getU64(0, 0, value, blocknum); }
+	void getRegionDataTimeDilation(U16& value, S32 blocknum = 0) const { getU16(0, 1, value, blocknum); }
+
+	// ObjectData, Variable
+	S32 getNumberOfObjectDataBlocks() const { return getNumberOfBlocks(1); }
+	void getObjectDataID(U32& value, S32 blocknum = 0) const { getU32(1, 0, value, blocknum); }
+	void getObjectDataState(U8& value, S32 blocknum = 0) const { getU8(1, 1, value, blocknum); }
+	void getObjectDataFullID(LLUUID& value, S32 blocknum = 0) const { getUUID(1, 2, value, blocknum); }
+	void getObjectDataCRC(U32& value, S32 blocknum = 0) const { getU32(1, 3, value, blocknum); }
+	void getObjectDataPCode(U8& value, S32 blocknum = 0) const { getU8(1, 4, value, blocknum); }
+	void getObjectDataMaterial(U8& value, S32 blocknum = 0) const { getU8(1, 5, value, blocknum); }
+	void getObjectDataClickAction(U8& value, S32 blocknum = 0) const { getU8(1, 6, value, blocknum); }
+	void getObjectDataScale(LLVector3& value, S32 blocknum = 0) const { getVector3(1, 7, value, blocknum); }
+	S32 getObjectDataObjectDataSize(S32 blocknum = 0) const { return getSize(1, 8, blocknum); }
+	void getObjectDataObjectData(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 8, datap, size, blocknum, max_size); }
+	void getObjectDataObjectData(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 8, buffer_size, buffer, blocknum); }
+	void getObjectDataObjectData(std::string& value, S32 blocknum = 0) const { getString(1, 8, value, blocknum); }
+	void getObjectDataParentID(U32& value, S32 blocknum = 0) const { getU32(1, 9, value, blocknum); }
+	void getObjectDataUpdateFlags(U32& value, S32 blocknum = 0) const { getU32(1, 10, value, blocknum); }
+	void getObjectDataPathCurve(U8& value, S32 blocknum = 0) const { getU8(1, 11, value, blocknum); }
+	void getObjectDataProfileCurve(U8& value, S32 blocknum = 0) const { getU8(1, 12, value, blocknum); }
+	void getObjectDataPathBegin(U16& value, S32 blocknum = 0) const { getU16(1, 13, value, blocknum); }
+	void getObjectDataPathEnd(U16& value, S32 blocknum = 0) const { getU16(1, 14, value, blocknum); }
+	void getObjectDataPathScaleX(U8& value, S32 blocknum = 0) const { getU8(1, 15, value, blocknum); }
+	void getObjectDataPathScaleY(U8& value, S32 blocknum = 0) const { getU8(1, 16, value, blocknum); }
+	void getObjectDataPathShearX(U8& value, S32 blocknum = 0) const { getU8(1, 17, value, blocknum); }
+	void getObjectDataPathShearY(U8& value, S32 blocknum = 0) const { getU8(1, 18, value, blocknum); }
+	void getObjectDataPathTwist(S8& value, S32 blocknum = 0) const { getS8(1, 19, value, blocknum); }
+	void getObjectDataPathTwistBegin(S8& value, S32 blocknum = 0) const { getS8(1, 20, value, blocknum); }
+	void getObjectDataPathRadiusOffset(S8& value, S32 blocknum = 0) const { getS8(1, 21, value, blocknum); }
+	void getObjectDataPathTaperX(S8& value, S32 blocknum = 0) const { getS8(1, 22, value, blocknum); }
+	void getObjectDataPathTaperY(S8& value, S32 blocknum = 0) const { getS8(1, 23, value, blocknum); }
+	void getObjectDataPathRevolutions(U8& value, S32 blocknum = 0) const { getU8(1, 24, value, blocknum); }
+	void getObjectDataPathSkew(S8& value, S32 blocknum = 0) const { getS8(1, 25, value, blocknum); }
+	void getObjectDataProfileBegin(U16& value, S32 blocknum = 0) const { getU16(1, 26, value, blocknum); }
+	void getObjectDataProfileEnd(U16& value, S32 blocknum = 0) const { getU16(1, 27, value, blocknum); }
+	void getObjectDataProfileHollow(U16& value, S32 blocknum = 0) const { getU16(1, 28, value, blocknum); }
+	S32 getObjectDataTextureEntrySize(S32 blocknum = 0) const { return getSize(1, 29, blocknum); }
+	void getObjectDataTextureEntry(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 29, datap, size, blocknum, max_size); }
+	void getObjectDataTextureEntry(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 29, buffer_size, buffer, blocknum); }
+	void getObjectDataTextureEntry(std::string& value, S32 blocknum = 0) const { getString(1, 29, value, blocknum); }
+	S32 getObjectDataTextureAnimSize(S32 blocknum = 0) const { return getSize(1, 30, blocknum); }
+	void getObjectDataTextureAnim(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 30, datap, size, blocknum, max_size); }
+	void getObjectDataTextureAnim(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 30, buffer_size, buffer, blocknum); }
+	void getObjectDataTextureAnim(std::string& value, S32 blocknum = 0) const { getString(1, 30, value, blocknum); }
+	S32 getObjectDataNameValueSize(S32 blocknum = 0) const { return getSize(1, 31, blocknum); }
+	void getObjectDataNameValue(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 31, datap, size, blocknum, max_size); }
+	void getObjectDataNameValue(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 31, buffer_size, buffer, blocknum); }
+	void getObjectDataNameValue(std::string& value, S32 blocknum = 0) const { getString(1, 31, value, blocknum); }
+	S32 getObjectDataDataSize(S32 blocknum = 0) const { return getSize(1, 32, blocknum); }
+	void getObjectDataData(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 32, datap, size, blocknum, max_size); }
+	void getObjectDataData(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 32, buffer_size, buffer, blocknum); }
+	void getObjectDataData(std::string& value, S32 blocknum = 0) const { getString(1, 32, value, blocknum); }
+	S32 getObjectDataTextSize(S32 blocknum = 0) const { return getSize(1, 33, blocknum); }
+	void getObjectDataText(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 33, datap, size, blocknum, max_size); }
+	void getObjectDataText(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 33, buffer_size, buffer, blocknum); }
+	void getObjectDataText(std::string& value, S32 blocknum = 0) const { getString(1, 33, value, blocknum); }
+	S32 getObjectDataTextColorSize(S32 blocknum = 0) const { return getSize(1, 34, blocknum); }
+	void getObjectDataTextColor(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 34, datap, size, blocknum, max_size); }
+	void getObjectDataTextColor(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 34, buffer_size, buffer, blocknum); }
+	void getObjectDataTextColor(std::string& value, S32 blocknum = 0) const { getString(1, 34, value, blocknum); }
+	S32 getObjectDataMediaURLSize(S32 blocknum = 0) const { return getSize(1, 35, blocknum); }
+	void getObjectDataMediaURL(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 35, datap, size, blocknum, max_size); }
+	void getObjectDataMediaURL(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 35, buffer_size, buffer, blocknum); }
+	void getObjectDataMediaURL(std::string& value, S32 blocknum = 0) const { getString(1, 35, value, blocknum); }
+	S32 getObjectDataPSBlockSize(S32 blocknum = 0) const { return getSize(1, 36, blocknum); }
+	void getObjectDataPSBlock(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 36, datap, size, blocknum, max_size); }
+	void getObjectDataPSBlock(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 36, buffer_size, buffer, blocknum); }
+	void getObjectDataPSBlock(std::string& value, S32 blocknum = 0) const { getString(1, 36, value, blocknum); }
+	S32 getObjectDataExtraParamsSize(S32 blocknum = 0) const { return getSize(1, 37, blocknum); }
+	void getObjectDataExtraParams(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 37, datap, size, blocknum, max_size); }
+	void getObjectDataExtraParams(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 37, buffer_size, buffer, blocknum); }
+	void getObjectDataExtraParams(std::string& value, S32 blocknum = 0) const { getString(1, 37, value, blocknum); }
+	void getObjectDataSound(LLUUID& value, S32 blocknum = 0) const { getUUID(1, 38, value, blocknum); }
+	void getObjectDataOwnerID(LLUUID& value, S32 blocknum = 0) const { getUUID(1, 39, value, blocknum); }
+	void getObjectDataGain(F32& value, S32 blocknum = 0) const { getF32(1, 40, value, blocknum); }
+	void getObjectDataFlags(U8& value, S32 blocknum = 0) const { getU8(1, 41, value, blocknum); }
+	void getObjectDataRadius(F32& value, S32 blocknum = 0) const { getF32(1, 42, value, blocknum); }
+	void getObjectDataJointType(U8& value, S32 blocknum = 0) const { getU8(1, 43, value, blocknum); }
+	void getObjectDataJointPivot(LLVector3& value, S32 blocknum = 0) const { getVector3(1, 44, value, blocknum); }
+	void getObjectDataJointAxisOrAnchor(LLVector3& value, S32 blocknum = 0) const { getVector3(1, 45, value, blocknum); }
+
+private:
+	static const LLMessageFieldLayout sLayout;
+};
+
+class LLMsgObjectUpdateCompressed : public LLMessageFields
+{
+public:
+	LLMsgObjectUpdateCompressed(LLMessageSystem* msg) : LLMessageFields(msg, sLayout) {}
+
+	// RegionData, Single
+	S32 getNumberOfRegionDataBlocks() const { return getNumberOfBlocks(0); }
+	void getRegionDataRegionHandle(U64& value, S32 blocknum = 0) const { getU64(0, 0, value, blocknum); }
+	void getRegionDataTimeDilation(U16& value, S32 blocknum = 0) const { getU16(0, 1, value, blocknum); }
+
+	// ObjectData, Variable
+	S32 getNumberOfObjectDataBlocks() const { return getNumberOfBlocks(1); }
+	void getObjectDataUpdateFlags(U32& value, S32 blocknum = 0) const { getU32(1, 0, value, blocknum); }
+	S32 getObjectDataDataSize(S32 blocknum = 0) const { return getSize(1, 1, blocknum); }
+	void getObjectDataData(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 1, datap, size, blocknum, max_size); }
+	void getObjectDataData(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 1, buffer_size, buffer, blocknum); }
+	void getObjectDataData(std::string& value, S32 blocknum = 0) const { getString(1, 1, value, blocknum); }
+
+private:
+	static const LLMessageFieldLayout sLayout;
+};
+
+class LLMsgImprovedTerseObjectUpdate : public LLMessageFields
+{
+public:
+	LLMsgImprovedTerseObjectUpdate(LLMessageSystem* msg) : LLMessageFields(msg, sLayout) {}
+
+	// RegionData, Single
+	S32 getNumberOfRegionDataBlocks() const { return getNumberOfBlocks(0); }
+	void getRegionDataRegionHandle(U64& value, S32 blocknum = 0) const { getU64(0, 0, value, blocknum); }
+	void getRegionDataTimeDilation(U16& value, S32 blocknum = 0) const { getU16(0, 1, value, blocknum); }
+
+	// ObjectData, Variable
+	S32 getNumberOfObjectDataBlocks() const { return getNumberOfBlocks(1); }
+	S32 getObjectDataDataSize(S32 blocknum = 0) const { return getSize(1, 0, blocknum); }
+	void getObjectDataData(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 0, datap, size, blocknum, max_size); }
+	void getObjectDataData(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 0, buffer_size, buffer, blocknum); }
+	void getObjectDataData(std::string& value, S32 blocknum = 0) const { getString(1, 0, value, blocknum); }
+	S32 getObjectDataTextureEntrySize(S32 blocknum = 0) const { return getSize(1, 1, blocknum); }
+	void getObjectDataTextureEntry(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(1, 1, datap, size, blocknum, max_size); }
+	void getObjectDataTextureEntry(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(1, 1, buffer_size, buffer, blocknum); }
+	void getObjectDataTextureEntry(std::string& value, S32 blocknum = 0) const { getString(1, 1, value, blocknum); }
+
+private:
+	static const LLMessageFieldLayout sLayout;
+};
+
+class LLMsgChatFromSimulator : public LLMessageFields
+{
+public:
+	LLMsgChatFromSimulator(LLMessageSystem* msg) : LLMessageFields(msg, sLayout) {}
+
+	// ChatData, Single
+	S32 getNumberOfChatDataBlocks() const { return getNumberOfBlocks(0); }
+	S32 getChatDataFromNameSize(S32 blocknum = 0) const { return getSize(0, 0, blocknum); }
+	void getChatDataFromName(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(0, 0, datap, size, blocknum, max_size); }
+	void getChatDataFromName(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(0, 0, buffer_size, buffer, blocknum); }
+	void getChatDataFromName(std::string& value, S32 blocknum = 0) const { getString(0, 0, value, blocknum); }
+	void getChatDataSourceID(LLUUID& value, S32 blocknum = 0) const { getUUID(0, 1, value, blocknum); }
+	void getChatDataOwnerID(LLUUID& value, S32 blocknum = 0) const { getUUID(0, 2, value, blocknum); }
+	void getChatDataSourceType(U8& value, S32 blocknum = 0) const { getU8(0, 3, value, blocknum); }
+	void getChatDataChatType(U8& value, S32 blocknum = 0) const { getU8(0, 4, value, blocknum); }
+	void getChatDataAudible(U8& value, S32 blocknum = 0) const { getU8(0, 5, value, blocknum); }
+	void getChatDataPosition(LLVector3& value, S32 blocknum = 0) const { getVector3(0, 6, value, blocknum); }
+	S32 getChatDataMessageSize(S32 blocknum = 0) const { return getSize(0, 7, blocknum); }
+	void getChatDataMessage(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const { getBinaryData(0, 7, datap, size, blocknum, max_size); }
+	void getChatDataMessage(S32 buffer_size, char* buffer, S32 blocknum = 0) const { getString(0, 7, buffer_size, buffer, blocknum); }
+	void getChatDataMessage(std::string& value, S32 blocknum = 0) const { getString(0, 7, value, blocknum); }
+
+private:
+	static const LLMessageFieldLayout sLayout;
+};
+
+#endif // LL_MESSAGE_FIELDS_H
@@ -40,6 +40,7 @@
 	#include <arpa/inet.h>
 	#include <fcntl.h>
 	#include <errno.h>
+	#include <poll.h>
 #endif
 
 // linden library includes
@@ -346,11 +347,13 @@ BOOL send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, i
 	int nRet = 0;
 	U32 last_error = 0;
 
-	stDstAddr.sin_addr.s_addr = recipient;
-	stDstAddr.sin_port = htons(nPort);
+	// Local copy of the destination, packets may be sent from more than one thread
+	struct sockaddr_in dst_addr = stDstAddr;
+	dst_addr.sin_addr.s_addr = recipient;
+	dst_addr.sin_port = htons(nPort);
 	do
 	{
-		nRet = sendto(hSocket, sendBuffer, size, 0, (struct sockaddr*)&stDstAddr, sizeof(stDstAddr));					
+		nRet = sendto(hSocket, sendBuffer, size, 0, (struct sockaddr*)&dst_addr, sizeof(dst_addr));					
 
 		if (nRet == SOCKET_ERROR ) 
 		{
@@ -376,6 +379,18 @@ BOOL send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, i
 	return (nRet != SOCKET_ERROR);
 }
 
+BOOL wait_for_packets(int hSocket, S32 timeout_ms)
+{
+	fd_set read_fds;
+	FD_ZERO(&read_fds);
+	FD_SET((SOCKET) hSocket, &read_fds);
+
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	return select(0, &read_fds, NULL, NULL, &timeout) > 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // Linux Versions
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -523,12 +538,31 @@ void end_net(S32& socket_out)
 }
 
 #if LL_LINUX
+// Destination address of a datagram received with IP_PKTINFO enabled
+static void get_destip(struct msghdr *msg, U32 *dstip)
+{
+	struct cmsghdr *cmsgptr;
+	for (cmsgptr = CMSG_FIRSTHDR(msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR( msg, cmsgptr))
+	{
+		if( cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO )
+		{
+			in_pktinfo *pktinfo = (in_pktinfo *)CMSG_DATA(cmsgptr);
+			if( pktinfo )
+			{
+				// Two choices. routed and specified. ipi_addr is routed, ipi_spec_dst is
+				// routed. We should stay with specified until we go to multiple
+				// interfaces
+				*dstip = pktinfo->ipi_spec_dst.s_addr;
+			}
+		}
+	}
+}
+
 static int recvfrom_destip( int socket, void *buf, int len, struct sockaddr *from, socklen_t *fromlen, U32 *dstip )
 {
 	int size;
 	struct iovec iov[1];
 	char cmsg[CMSG_SPACE(sizeof(struct in_pktinfo))];
-	struct cmsghdr *cmsgptr;
 	struct msghdr msg = {0};
 
 	iov[0].iov_base = buf;
@@ -549,20 +583,7 @@ static int recvfrom_destip( int socket, void *buf, int len, struct sockaddr *fro
 		return -1;
 	}
 
-	for (cmsgptr = CMSG_FIRSTHDR(&msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR( &msg, cmsgptr))
-	{
-		if( cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO )
-		{
-			in_pktinfo *pktinfo = (in_pktinfo *)CMSG_DATA(cmsgptr);
-			if( pktinfo )
-			{
-				// Two choices. routed and specified. ipi_addr is routed, ipi_spec_dst is
-				// routed. We should stay with specified until we go to multiple
-				// interfaces
-				*dstip = pktinfo->ipi_spec_dst.s_addr;
-			}
-		}
-	}
+	get_destip(&msg, dstip);
 
 	return size;
 }
@@ -605,12 +626,14 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 	BOOL	resend;
 	S32		send_attempts = 0;
 
-	stDstAddr.sin_addr.s_addr = recipient;
-	stDstAddr.sin_port = htons(nPort);
+	// Local copy of the destination, packets may be sent from more than one thread
+	struct sockaddr_in dst_addr = stDstAddr;
+	dst_addr.sin_addr.s_addr = recipient;
+	dst_addr.sin_port = htons(nPort);
 
 	do
 	{
-		ret = sendto(hSocket, sendBuffer, size, 0,	(struct sockaddr*)&stDstAddr, sizeof(stDstAddr));
+		ret = sendto(hSocket, sendBuffer, size, 0,	(struct sockaddr*)&dst_addr, sizeof(dst_addr));
 		send_attempts++;
 
 		if (ret >= 0)
@@ -628,21 +651,21 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 			{
 				// say nothing, just repeat send
 				LL_INFOS() << "sendto() reported buffer full, resending (attempt " << send_attempts << ")" << LL_ENDL;
-				LL_INFOS() << inet_ntoa(stDstAddr.sin_addr) << ":" << nPort << LL_ENDL;
+				LL_INFOS() << inet_ntoa(dst_addr.sin_addr) << ":" << nPort << LL_ENDL;
 				resend = TRUE;
 			}
 			else if (errno == ECONNREFUSED)
 			{
 				// response to ICMP connection refused message on earlier send
 				LL_INFOS() << "sendto() reported connection refused, resending (attempt " << send_attempts << ")" << LL_ENDL;
-				LL_INFOS() << inet_ntoa(stDstAddr.sin_addr) << ":" << nPort << LL_ENDL;
+				LL_INFOS() << inet_ntoa(dst_addr.sin_addr) << ":" << nPort << LL_ENDL;
 				resend = TRUE;
 			}
 			else
 			{
 				// some other error
 				LL_INFOS() << "sendto() failed: " << errno << ", " << strerror(errno) << LL_ENDL;
-				LL_INFOS() << inet_ntoa(stDstAddr.sin_addr) << ":" << nPort << LL_ENDL;
+				LL_INFOS() << inet_ntoa(dst_addr.sin_addr) << ":" << nPort << LL_ENDL;
 				resend = FALSE;
 			}
 		}
@@ -658,6 +681,186 @@ BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient,
 	return success;
 }
 
+BOOL wait_for_packets(int hSocket, S32 timeout_ms)
+{
+	struct pollfd poll_fd;
+	poll_fd.fd = hSocket;
+	poll_fd.events = POLLIN;
+	poll_fd.revents = 0;
+	return poll(&poll_fd, 1, timeout_ms) > 0;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Batched Versions
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// One system call per datagram, used where there is no batched call
+static S32 receive_packets_loop(int hSocket, LLNetDatagram* packets, S32 count)
+{
+	S32 received = 0;
+	while (received < count)
+	{
+		LLNetDatagram& packet = packets[received];
+		packet.mSize = receive_packet(hSocket, packet.mData);
+		if (packet.mSize <= 0)
+		{
+			break;
+		}
+		packet.mIP = get_sender_ip();
+		packet.mPort = get_sender_port();
+		packet.mReceivingIF = get_receiving_interface_ip();
+		received++;
+	}
+	return received;
+}
+
+static S32 send_packets_loop(int hSocket, const LLNetDatagram* packets, S32 count)
+{
+	S32 sent = 0;
+	while (sent < count && send_packet(hSocket, packets[sent].mData, packets[sent].mSize, packets[sent].mIP, packets[sent].mPort))
+	{
+		sent++;
+	}
+	return sent;
+}
+
+#if LL_LINUX
+
+// Cleared if the kernel turns out not to implement recvmmsg()/sendmmsg()
+static bool sHaveMMsg = true;
+
+S32 receive_packets(int hSocket, LLNetDatagram* packets, S32 count)
+{
+	count = llmin(count, NET_MAX_BATCH);
+	if (count <= 0)
+	{
+		return 0;
+	}
+	if (!sHaveMMsg)
+	{
+		return receive_packets_loop(hSocket, packets, count);
+	}
+
+	struct mmsghdr msgs[NET_MAX_BATCH];
+	struct iovec iovs[NET_MAX_BATCH];
+	struct sockaddr_in from[NET_MAX_BATCH];
+	char cmsgs[NET_MAX_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	for (S32 i = 0; i < count; i++)
+	{
+		iovs[i].iov_base = packets[i].mData;
+		iovs[i].iov_len = NET_BUFFER_SIZE;
+		msgs[i].msg_hdr.msg_name = &from[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsgs[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+	}
+
+	int received = recvmmsg(hSocket, msgs, count, MSG_DONTWAIT, NULL);
+	if (received < 0)
+	{
+		if (errno == ENOSYS)
+		{
+			LL_WARNS() << "recvmmsg() not supported, receiving one packet at a time" << LL_ENDL;
+			sHaveMMsg = false;
+			return receive_packets_loop(hSocket, packets, count);
+		}
+		// nothing pending, or an error receive_packet() would also report as no data
+		return 0;
+	}
+
+	for (S32 i = 0; i < received; i++)
+	{
+		packets[i].mSize = msgs[i].msg_len;
+		packets[i].mIP = from[i].sin_addr.s_addr;
+		packets[i].mPort = ntohs(from[i].sin_port);
+		packets[i].mReceivingIF = INVALID_HOST_IP_ADDRESS;
+		get_destip(&msgs[i].msg_hdr, &packets[i].mReceivingIF);
+	}
+	return received;
+}
+
+S32 send_packets(int hSocket, const LLNetDatagram* packets, S32 count)
+{
+	count = llmin(count, NET_MAX_BATCH);
+	if (count <= 0)
+	{
+		return 0;
+	}
+	if (!sHaveMMsg)
+	{
+		return send_packets_loop(hSocket, packets, count);
+	}
+
+	struct mmsghdr msgs[NET_MAX_BATCH];
+	struct iovec iovs[NET_MAX_BATCH];
+	struct sockaddr_in to[NET_MAX_BATCH];
+
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	memset(to, 0, sizeof(to[0]) * count);
+	for (S32 i = 0; i < count; i++)
+	{
+		to[i].sin_family = AF_INET;
+		to[i].sin_addr.s_addr = packets[i].mIP;
+		to[i].sin_port = htons(packets[i].mPort);
+		iovs[i].iov_base = packets[i].mData;
+		iovs[i].iov_len = packets[i].mSize;
+		msgs[i].msg_hdr.msg_name = &to[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(to[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	// Same policy as send_packet(): retry a datagram up to three times on a
+	// full buffer or an ICMP connection refused, give up on anything else.
+	S32 sent = 0;
+	S32 send_attempts = 0;
+	while (sent < count)
+	{
+		int ret = sendmmsg(hSocket, msgs + sent, count - sent, 0);
+		if (ret > 0)
+		{
+			sent += ret;
+			send_attempts = 0;
+			continue;
+		}
+
+		if (errno == ENOSYS)
+		{
+			LL_WARNS() << "sendmmsg() not supported, sending one packet at a time" << LL_ENDL;
+			sHaveMMsg = false;
+			return sent + send_packets_loop(hSocket, packets + sent, count - sent);
+		}
+
+		if ((errno == EAGAIN || errno == ECONNREFUSED) && ++send_attempts < 3)
+		{
+			continue;
+		}
+
+		LL_INFOS() << "sendmmsg() failed: " << errno << ", " << strerror(errno) << LL_ENDL;
+		LL_INFOS() << u32_to_ip_string(packets[sent].mIP) << ":" << packets[sent].mPort << LL_ENDL;
+		break;
+	}
+	return sent;
+}
+
+#else
+
+S32 receive_packets(int hSocket, LLNetDatagram* packets, S32 count)
+{
+	return receive_packets_loop(hSocket, packets, llmin(count, NET_MAX_BATCH));
+}
+
+S32 send_packets(int hSocket, const LLNetDatagram* packets, S32 count)
+{
+	return send_packets_loop(hSocket, packets, llmin(count, NET_MAX_BATCH));
+}
+
 #endif
 
 //EOF
@@ -45,6 +45,33 @@ S32		receive_packet(int hSocket, char * receiveBuffer);
 
 BOOL	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
+// Blocks until a datagram can be read from the socket or timeout_ms passes.
+// Returns TRUE if one is pending.
+BOOL	wait_for_packets(int hSocket, S32 timeout_ms);
+
+// One datagram of a batched receive or send.
+struct LLNetDatagram
+{
+	char*	mData;			// at least NET_BUFFER_SIZE bytes when receiving
+	S32		mSize;			// bytes received, or bytes to send
+	U32		mIP;			// sender when receiving, recipient when sending
+	U32		mPort;
+	U32		mReceivingIF;	// receive only, INVALID_HOST_IP_ADDRESS if unknown
+};
+
+// Maximum number of datagrams moved by one receive_packets()/send_packets() call
+const S32 NET_MAX_BATCH = 32;
+
+// Batched versions of receive_packet() and send_packet().  On Linux these
+// use a single recvmmsg()/sendmmsg() system call for up to count (at most
+// NET_MAX_BATCH) datagrams, elsewhere they loop over the single packet calls.
+// receive_packets() returns the number of datagrams received, 0 if none
+// were pending; it does not update get_sender() and friends.
+// send_packets() returns the number of datagrams sent, stopping at the first
+// one that could not be sent.
+S32		receive_packets(int hSocket, LLNetDatagram* packets, S32 count);
+S32		send_packets(int hSocket, const LLNetDatagram* packets, S32 count);
+
 //void	get_sender(char * tmp);
 LLHost	get_sender();
 U32		get_sender_port();
@@ -33,7 +33,9 @@
 #include "patch_code.h"
 #include "llbitpack.h"
 
-U32 gPatchSize, gWordBits;
+// Set by the group and patch headers for the patches that follow them.  Each
+// thread coding or decoding patches gets its own.
+thread_local U32 gPatchSize, gWordBits;
 
 void	init_patch_coding(LLBitPack &bitpack)
 {
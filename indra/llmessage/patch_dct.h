@@ -91,4 +91,20 @@ void init_patch_decompressor(S32 size);
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph);
 void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph);
 
+// Decompresses a size*size patch into rows stride apart without touching the
+// group of patch header, so it may run on any thread.  size must be
+// NORMAL_PATCH_SIZE or LARGE_PATCH_SIZE.
+void decompress_patch(F32 *patch, const S32 *cpatch, const LLPatchHeader *ph, S32 size, S32 stride);
+
+// The inverse DCT runs on the widest kernel the CPU supports.  Setting a
+// kernel the CPU lacks fails and keeps the current one.
+enum EPatchIDCTKernel
+{
+	PATCH_IDCT_SCALAR,
+	PATCH_IDCT_SSE2,
+	PATCH_IDCT_AVX
+};
+EPatchIDCTKernel get_patch_idct_kernel();
+bool set_patch_idct_kernel(EPatchIDCTKernel kernel);
+
 #endif
@@ -30,6 +30,17 @@
 //#include "vmath.h"
 #include "v3math.h"
 #include "patch_dct.h"
+#include "llprocessor.h"
+
+#include <immintrin.h>
+
+// GCC and clang only emit AVX instructions in functions that ask for them;
+// MSVC allows the intrinsics anywhere.
+#if LL_GNUC || LL_CLANG
+#define LL_TARGET_AVX __attribute__((target("avx")))
+#else
+#define LL_TARGET_AVX
+#endif
 
 LLGroupHeader	*gGOPP;
 
@@ -38,599 +49,389 @@ void set_group_of_patch_header(LLGroupHeader *gopp)
 	gGOPP = gopp;
 }
 
-F32 gPatchDequantizeTable[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-void build_patch_dequantize_table(S32 size)
+namespace
 {
-	S32 i, j;
-	for (j = 0; j < size; j++)
+	// Dequantize, inverse cosine and zigzag tables for one patch size.  Both
+	// sizes are built once and never change, so patches can be decompressed
+	// on any thread.
+	struct LLPatchDecompressTables
 	{
-		for (i = 0; i < size; i++)
+		S32 mSize;
+		LL_ALIGN_16(F32 mDequantize[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+		LL_ALIGN_16(F32 mICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+		S32 mDeCopy[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+		LLPatchDecompressTables(S32 size)
+		:	mSize(size)
 		{
-			gPatchDequantizeTable[j*size + i] = (1.f + 2.f*(i+j));
+			buildDequantizeTable();
+			setupICosines();
+			buildDeCopyMatrix();
 		}
-	}
-}
 
-S32	gCurrentDeSize = 0;
+		void buildDequantizeTable()
+		{
+			for (S32 j = 0; j < mSize; j++)
+			{
+				for (S32 i = 0; i < mSize; i++)
+				{
+					mDequantize[j*mSize + i] = (1.f + 2.f*(i+j));
+				}
+			}
+		}
 
-F32	gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+		void setupICosines()
+		{
+			F32 oosob = F_PI*0.5f/mSize;
 
-void setup_patch_icosines(S32 size)
-{
-	S32 n, u;
-	F32 oosob = F_PI*0.5f/size;
+			for (S32 u = 0; u < mSize; u++)
+			{
+				for (S32 n = 0; n < mSize; n++)
+				{
+					mICosines[u*mSize+n] = cosf((2.f*n+1.f)*u*oosob);
+				}
+			}
+		}
 
-	for (u = 0; u < size; u++)
-	{
-		for (n = 0; n < size; n++)
+		void buildDeCopyMatrix()
 		{
-			gPatchICosines[u*size+n] = cosf((2.f*n+1.f)*u*oosob);
-		}
-	}
-}
+			S32 i, j, count;
+			BOOL	b_diag = FALSE;
+			BOOL	b_right = TRUE;
 
-S32	gDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+			i = 0;
+			j = 0;
+			count = 0;
 
-void build_decopy_matrix(S32 size)
-{
-	S32 i, j, count;
-	BOOL	b_diag = FALSE;
-	BOOL	b_right = TRUE;
+			while (  (i < mSize)
+				   &&(j < mSize))
+			{
+				mDeCopy[j*mSize + i] = count;
 
-	i = 0;
-	j = 0;
-	count = 0;
+				count++;
 
-	while (  (i < size)
-		   &&(j < size))
+				if (!b_diag)
+				{
+					if (b_right)
+					{
+						if (i < mSize - 1)
+							i++;
+						else
+							j++;
+						b_right = FALSE;
+						b_diag = TRUE;
+					}
+					else
+					{
+						if (j < mSize - 1)
+							j++;
+						else
+							i++;
+						b_right = TRUE;
+						b_diag = TRUE;
+					}
+				}
+				else
+				{
+					if (b_right)
+					{
+						i++;
+						j--;
+						if (  (i == mSize - 1)
+							||(j == 0))
+						{
+							b_diag = FALSE;
+						}
+					}
+					else
+					{
+						i--;
+						j++;
+						if (  (i == 0)
+							||(j == mSize - 1))
+						{
+							b_diag = FALSE;
+						}
+					}
+				}
+			}
+		}
+	};
+
+	const LLPatchDecompressTables* get_patch_tables(S32 size)
 	{
-		gDeCopyMatrix[j*size + i] = count;
+		static const LLPatchDecompressTables normal_tables(NORMAL_PATCH_SIZE);
+		static const LLPatchDecompressTables large_tables(LARGE_PATCH_SIZE);
+
+		if (size == NORMAL_PATCH_SIZE)
+		{
+			return &normal_tables;
+		}
+		if (size == LARGE_PATCH_SIZE)
+		{
+			return &large_tables;
+		}
+		return NULL;
+	}
 
-		count++;
+	// The IDCT is separable: a pass down the columns of the coefficients
+	// into temp, then a pass along the lines of temp back into block.
+	//
+	//   temp[n][c]  = OO_SQRT2*block[0][c] + sum(u > 0) block[u][c]*cos[u][n]
+	//   block[l][n] = (OO_SQRT2*temp[l][0] + sum(u > 0) temp[l][u]*cos[u][n])*2/size
+	//
+	// All kernels sum in the same order with separate multiplies and adds,
+	// so they give the same results.
 
-		if (!b_diag)
+	typedef void (*idct_patch_fn)(F32 *block, const LLPatchDecompressTables& tables);
+
+	void idct_patch_scalar(F32 *block, const LLPatchDecompressTables& tables)
+	{
+		F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+		const F32* pcp = tables.mICosines;
+		const S32 size = tables.mSize;
+		const F32 oosob = 2.f/size;
+		S32 n, u, column, line;
+		F32 total;
+
+		for (column = 0; column < size; column++)
 		{
-			if (b_right)
+			for (n = 0; n < size; n++)
 			{
-				if (i < size - 1)
-					i++;
-				else
-					j++;
-				b_right = FALSE;
-				b_diag = TRUE;
+				total = OO_SQRT2*block[column];
+				for (u = 1; u < size; u++)
+				{
+					total += block[u*size + column]*pcp[u*size + n];
+				}
+				temp[n*size + column] = total;
 			}
-			else
+		}
+
+		for (line = 0; line < size; line++)
+		{
+			const F32* linein = temp + line*size;
+			for (n = 0; n < size; n++)
 			{
-				if (j < size - 1)
-					j++;
-				else
-					i++;
-				b_right = TRUE;
-				b_diag = TRUE;
+				total = OO_SQRT2*linein[0];
+				for (u = 1; u < size; u++)
+				{
+					total += linein[u]*pcp[u*size + n];
+				}
+				block[line*size + n] = total*oosob;
 			}
 		}
-		else
+	}
+
+	void idct_patch_sse2(F32 *block, const LLPatchDecompressTables& tables)
+	{
+		LL_ALIGN_16(F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+		const F32* pcp = tables.mICosines;
+		const S32 size = tables.mSize;
+		const __m128 oo_sqrt2 = _mm_set1_ps(OO_SQRT2);
+		const __m128 oosob = _mm_set1_ps(2.f/size);
+
+		// Four columns at a time, one cosine broadcast per coefficient row
+		for (S32 n = 0; n < size; n++)
 		{
-			if (b_right)
+			F32* out = temp + n*size;
+			for (S32 c = 0; c < size; c += 4)
 			{
-				i++;
-				j--;
-				if (  (i == size - 1)
-					||(j == 0))
+				_mm_store_ps(out + c, _mm_mul_ps(oo_sqrt2, _mm_load_ps(block + c)));
+			}
+			for (S32 u = 1; u < size; u++)
+			{
+				const __m128 w = _mm_set1_ps(pcp[u*size + n]);
+				const F32* in = block + u*size;
+				for (S32 c = 0; c < size; c += 4)
 				{
-					b_diag = FALSE;
+					_mm_store_ps(out + c, _mm_add_ps(_mm_load_ps(out + c), _mm_mul_ps(_mm_load_ps(in + c), w)));
 				}
 			}
-			else
+		}
+
+		// Four outputs of a line at a time against four cosines of a row
+		for (S32 line = 0; line < size; line++)
+		{
+			const F32* linein = temp + line*size;
+			F32* out = block + line*size;
+			for (S32 n = 0; n < size; n += 4)
 			{
-				i--;
-				j++;
-				if (  (i == 0)
-					||(j == size - 1))
+				__m128 total = _mm_set1_ps(OO_SQRT2*linein[0]);
+				for (S32 u = 1; u < size; u++)
 				{
-					b_diag = FALSE;
+					total = _mm_add_ps(total, _mm_mul_ps(_mm_set1_ps(linein[u]), _mm_load_ps(pcp + u*size + n)));
 				}
+				_mm_store_ps(out + n, _mm_mul_ps(total, oosob));
 			}
 		}
 	}
-}
 
-void init_patch_decompressor(S32 size)
-{
-	if (size != gCurrentDeSize)
+	// As idct_patch_sse2() eight values at a time.  Multiplies and adds stay
+	// separate rather than fused so the results match the other kernels.
+	LL_TARGET_AVX void idct_patch_avx(F32 *block, const LLPatchDecompressTables& tables)
 	{
-		gCurrentDeSize = size;
-		build_patch_dequantize_table(size);
-		setup_patch_icosines(size);
-		build_decopy_matrix(size);
-	}
-}
-
-inline void idct_line(F32 *linein, F32 *lineout, S32 line)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	F32 oosob = 2.f/16.f;
-	S32	line_size = line*NORMAL_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
+		LL_ALIGN_16(F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+		const F32* pcp = tables.mICosines;
+		const S32 size = tables.mSize;
+		const __m256 oo_sqrt2 = _mm256_set1_ps(OO_SQRT2);
+		const __m256 oosob = _mm256_set1_ps(2.f/size);
 
+		for (S32 n = 0; n < size; n++)
+		{
+			F32* out = temp + n*size;
+			for (S32 c = 0; c < size; c += 8)
+			{
+				_mm256_storeu_ps(out + c, _mm256_mul_ps(oo_sqrt2, _mm256_loadu_ps(block + c)));
+			}
+			for (S32 u = 1; u < size; u++)
+			{
+				const __m256 w = _mm256_set1_ps(pcp[u*size + n]);
+				const F32* in = block + u*size;
+				for (S32 c = 0; c < size; c += 8)
+				{
+					_mm256_storeu_ps(out + c, _mm256_add_ps(_mm256_loadu_ps(out + c), _mm256_mul_ps(_mm256_loadu_ps(in + c), w)));
+				}
+			}
+		}
 
-	for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + line_size;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		*(lineout + line_size + n) = total*oosob;
-	}
-#else
-	F32 oosob = 2.f/size;
-	S32	size = gGOPP->patch_size;
-	S32	line_size = line*size;
-	S32 u;
-	for (n = 0; n < size; n++)
-	{
-		total = OO_SQRT2*linein[line_size];
-		for (u = 1; u < size; u++)
+		for (S32 line = 0; line < size; line++)
 		{
-			total += linein[line_size + u]*pcp[u*size+n];
+			const F32* linein = temp + line*size;
+			F32* out = block + line*size;
+			for (S32 n = 0; n < size; n += 8)
+			{
+				__m256 total = _mm256_set1_ps(OO_SQRT2*linein[0]);
+				for (S32 u = 1; u < size; u++)
+				{
+					total = _mm256_add_ps(total, _mm256_mul_ps(_mm256_set1_ps(linein[u]), _mm256_loadu_ps(pcp + u*size + n)));
+				}
+				_mm256_storeu_ps(out + n, _mm256_mul_ps(total, oosob));
+			}
 		}
-		lineout[line_size + n] = total*oosob;
+		_mm256_zeroupper();
 	}
-#endif
-}
-
-inline void idct_line_large_slow(F32 *linein, F32 *lineout, S32 line)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 oosob = 2.f/32.f;
-	S32	line_size = line*LARGE_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-
 
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
+	struct LLPatchIDCTKernel
 	{
-		tpcp = pcp + n;
-		tlinein = linein + line_size;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(lineout + line_size + n) = total*oosob;
-	}
-}
+		EPatchIDCTKernel mKernel;
+		idct_patch_fn mIDCTPatch;
 
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_line_large(F32 *linein, F32 *lineout, S32 line)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 oosob = 2.f/32.f;
-	S32	line_size = line*LARGE_PATCH_SIZE;
-	F32 *tlinein, *tpcp;
-	F32 *baselinein = linein + line_size;
-	F32 *baselineout = lineout + line_size;
+		LLPatchIDCTKernel()
+		{
+			LLProcessorInfo info;
+			set(info.hasAVX() ? PATCH_IDCT_AVX : PATCH_IDCT_SSE2);
+		}
 
+		void set(EPatchIDCTKernel kernel)
+		{
+			mKernel = kernel;
+			switch (kernel)
+			{
+			case PATCH_IDCT_SCALAR:
+				mIDCTPatch = idct_patch_scalar;
+				break;
+			case PATCH_IDCT_AVX:
+				mIDCTPatch = idct_patch_avx;
+				break;
+			default:
+				mIDCTPatch = idct_patch_sse2;
+				break;
+			}
+		}
+	};
 
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
+	LLPatchIDCTKernel& patch_idct_kernel()
 	{
-		tpcp = pcp++;
-		tlinein = baselinein;
-	
-		total = OO_SQRT2*(*(tlinein++));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein)*(*(tpcp));
-
-		*baselineout++ = total*oosob;
+		static LLPatchIDCTKernel kernel;
+		return kernel;
 	}
-}
 
-inline void idct_column(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
+	// Dequantizes the zigzag ordered coefficients in cpatch into block and
+	// runs the IDCT.  Returns the scale and offset that turn block into
+	// heights, or false if the patch size is not one we decode.
+	bool idct_decompress(F32 *block, const S32 *cpatch, const LLPatchHeader *ph, S32 size, F32 &mult, F32 &addval)
+	{
+		const LLPatchDecompressTables* tables = get_patch_tables(size);
+		if (!tables)
+		{
+			LL_WARNS() << "Unsupported patch size " << size << LL_ENDL;
+			return false;
+		}
 
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	F32 *tlinein, *tpcp;
+		F32		range = ph->range;
+		S32		prequant = (ph->quant_wbits >> 4) + 2;
+		S32		quantize = 1<<prequant;
+		F32		hmin = ph->dc_offset;
 
-	for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + column;
-
-		total = OO_SQRT2*(*tlinein);
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-		total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-		*(lineout + (n<<4) + column) = total;
-	}
+		F32		ooq = 1.f/(F32)quantize;
+		const F32	*dq = tables->mDequantize;
+		const S32	*decopy_matrix = tables->mDeCopy;
 
-#else
-	S32	size = gGOPP->patch_size;
-	S32 u;
-	S32 u_size;
+		mult = ooq*range;
+		addval = mult*(F32)(1<<(prequant - 1))+hmin;
 
-	for (n = 0; n < size; n++)
-	{
-		total = OO_SQRT2*linein[column];
-		for (u = 1; u < size; u++)
+		for (S32 i = 0; i < size*size; i++)
 		{
-			u_size = u*size;
-			total += linein[u_size + column]*pcp[u_size+n];
+			block[i] = cpatch[decopy_matrix[i]]*dq[i];
 		}
-		lineout[size*n + column] = total;
-	}
-#endif
-}
-
-inline void idct_column_large_slow(F32 *linein, F32 *lineout, S32 column)
-{
-	S32 n;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 *tlinein, *tpcp;
 
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
-	{
-		tpcp = pcp + n;
-		tlinein = linein + column;
-
-		total = OO_SQRT2*(*tlinein);
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-		total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(lineout + (n<<5) + column) = total;
+		patch_idct_kernel().mIDCTPatch(block, *tables);
+		return true;
 	}
 }
 
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_column_large(F32 *linein, F32 *lineout, S32 column)
+EPatchIDCTKernel get_patch_idct_kernel()
 {
-	S32 n, m;
-	F32 total;
-	F32 *pcp = gPatchICosines;
-
-	F32 *tlinein, *tpcp;
-	F32 *baselinein = linein + column;
-	F32 *baselineout = lineout + column;
-
-	for (n = 0; n < LARGE_PATCH_SIZE; n++)
-	{
-		tpcp = pcp++;
-		tlinein = baselinein;
-
-		total = OO_SQRT2*(*tlinein);
-		for (m = 1; m < NORMAL_PATCH_SIZE; m++)
-			total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-		*(baselineout + (n<<5)) = total;
-	}
+	return patch_idct_kernel().mKernel;
 }
 
-inline void idct_patch(F32 *block)
+bool set_patch_idct_kernel(EPatchIDCTKernel kernel)
 {
-	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-	idct_column(block, temp, 0);	
-	idct_column(block, temp, 1);	
-	idct_column(block, temp, 2);	
-	idct_column(block, temp, 3);	
-
-	idct_column(block, temp, 4);	
-	idct_column(block, temp, 5);	
-	idct_column(block, temp, 6);	
-	idct_column(block, temp, 7);	
-
-	idct_column(block, temp, 8);	
-	idct_column(block, temp, 9);	
-	idct_column(block, temp, 10);	
-	idct_column(block, temp, 11);	
-
-	idct_column(block, temp, 12);	
-	idct_column(block, temp, 13);	
-	idct_column(block, temp, 14);	
-	idct_column(block, temp, 15);	
-
-	idct_line(temp, block, 0);	
-	idct_line(temp, block, 1);	
-	idct_line(temp, block, 2);	
-	idct_line(temp, block, 3);	
-
-	idct_line(temp, block, 4);	
-	idct_line(temp, block, 5);	
-	idct_line(temp, block, 6);	
-	idct_line(temp, block, 7);	
-
-	idct_line(temp, block, 8);	
-	idct_line(temp, block, 9);	
-	idct_line(temp, block, 10);	
-	idct_line(temp, block, 11);	
-
-	idct_line(temp, block, 12);	
-	idct_line(temp, block, 13);	
-	idct_line(temp, block, 14);	
-	idct_line(temp, block, 15);	
-#else
-	S32 i;
-	S32	size = gGOPP->patch_size;
-	for (i = 0; i < size; i++)
-	{
-		idct_column(block, temp, i);	
-	}
-	for (i = 0; i < size; i++)
+	if (kernel == PATCH_IDCT_AVX)
 	{
-		idct_line(temp, block, i);	
+		LLProcessorInfo info;
+		if (!info.hasAVX())
+		{
+			return false;
+		}
 	}
-#endif
+
+	patch_idct_kernel().set(kernel);
+	return true;
 }
 
-inline void idct_patch_large(F32 *block)
+void init_patch_decompressor(S32 size)
 {
-	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-	idct_column_large_slow(block, temp, 0);	
-	idct_column_large_slow(block, temp, 1);	
-	idct_column_large_slow(block, temp, 2);	
-	idct_column_large_slow(block, temp, 3);	
-
-	idct_column_large_slow(block, temp, 4);	
-	idct_column_large_slow(block, temp, 5);	
-	idct_column_large_slow(block, temp, 6);	
-	idct_column_large_slow(block, temp, 7);	
-
-	idct_column_large_slow(block, temp, 8);	
-	idct_column_large_slow(block, temp, 9);	
-	idct_column_large_slow(block, temp, 10);	
-	idct_column_large_slow(block, temp, 11);	
-
-	idct_column_large_slow(block, temp, 12);	
-	idct_column_large_slow(block, temp, 13);	
-	idct_column_large_slow(block, temp, 14);	
-	idct_column_large_slow(block, temp, 15);	
-
-	idct_column_large_slow(block, temp, 16);	
-	idct_column_large_slow(block, temp, 17);	
-	idct_column_large_slow(block, temp, 18);	
-	idct_column_large_slow(block, temp, 19);	
-
-	idct_column_large_slow(block, temp, 20);	
-	idct_column_large_slow(block, temp, 21);	
-	idct_column_large_slow(block, temp, 22);	
-	idct_column_large_slow(block, temp, 23);	
-
-	idct_column_large_slow(block, temp, 24);	
-	idct_column_large_slow(block, temp, 25);	
-	idct_column_large_slow(block, temp, 26);	
-	idct_column_large_slow(block, temp, 27);	
-
-	idct_column_large_slow(block, temp, 28);	
-	idct_column_large_slow(block, temp, 29);	
-	idct_column_large_slow(block, temp, 30);	
-	idct_column_large_slow(block, temp, 31);	
-
-	idct_line_large_slow(temp, block, 0);	
-	idct_line_large_slow(temp, block, 1);	
-	idct_line_large_slow(temp, block, 2);	
-	idct_line_large_slow(temp, block, 3);	
-
-	idct_line_large_slow(temp, block, 4);	
-	idct_line_large_slow(temp, block, 5);	
-	idct_line_large_slow(temp, block, 6);	
-	idct_line_large_slow(temp, block, 7);	
-
-	idct_line_large_slow(temp, block, 8);	
-	idct_line_large_slow(temp, block, 9);	
-	idct_line_large_slow(temp, block, 10);	
-	idct_line_large_slow(temp, block, 11);	
-
-	idct_line_large_slow(temp, block, 12);	
-	idct_line_large_slow(temp, block, 13);	
-	idct_line_large_slow(temp, block, 14);	
-	idct_line_large_slow(temp, block, 15);	
-
-	idct_line_large_slow(temp, block, 16);	
-	idct_line_large_slow(temp, block, 17);	
-	idct_line_large_slow(temp, block, 18);	
-	idct_line_large_slow(temp, block, 19);	
-
-	idct_line_large_slow(temp, block, 20);	
-	idct_line_large_slow(temp, block, 21);	
-	idct_line_large_slow(temp, block, 22);	
-	idct_line_large_slow(temp, block, 23);	
-
-	idct_line_large_slow(temp, block, 24);	
-	idct_line_large_slow(temp, block, 25);	
-	idct_line_large_slow(temp, block, 26);	
-	idct_line_large_slow(temp, block, 27);	
-
-	idct_line_large_slow(temp, block, 28);	
-	idct_line_large_slow(temp, block, 29);	
-	idct_line_large_slow(temp, block, 30);	
-	idct_line_large_slow(temp, block, 31);	
+	// Builds the tables for both sizes on first use
+	get_patch_tables(size);
+	patch_idct_kernel();
 }
 
 S32	gDitherNoise = 128;
 
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 {
-	S32		i, j;
-
-	F32		block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
-	F32		*tpatch;
-
-	LLGroupHeader	*gopp = gGOPP;
-	S32		size = gopp->patch_size;
-	F32		range = ph->range;
-	S32		prequant = (ph->quant_wbits >> 4) + 2;
-	S32		quantize = 1<<prequant;
-	F32		hmin = ph->dc_offset;
-	S32		stride = gopp->stride;
-
-	F32		ooq = 1.f/(F32)quantize;
-	F32     *dq = gPatchDequantizeTable;
-	S32		*decopy_matrix = gDeCopyMatrix;
-
-	F32		mult = ooq*range;
-	F32		addval = mult*(F32)(1<<(prequant - 1))+hmin;
-
-	for (i = 0; i < size*size; i++)
-	{
-		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
-	}
+	decompress_patch(patch, cpatch, ph, gGOPP->patch_size, gGOPP->stride);
+}
 
-	if (size == 16)
-	{
-		idct_patch(block);
-	}
-	else
+void decompress_patch(F32 *patch, const S32 *cpatch, const LLPatchHeader *ph, S32 size, S32 stride)
+{
+	LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	F32 mult, addval;
+	if (!idct_decompress(block, cpatch, ph, size, mult, addval))
 	{
-		idct_patch_large(block);
+		return;
 	}
 
-	for (j = 0; j < size; j++)
+	const __m128 mult4 = _mm_set1_ps(mult);
+	const __m128 addval4 = _mm_set1_ps(addval);
+	for (S32 j = 0; j < size; j++)
 	{
-		tpatch = patch + j*stride;
-		tblock = block + j*size;
-		for (i = 0; i < size; i++)
+		F32* tpatch = patch + j*stride;
+		const F32* tblock = block + j*size;
+		for (S32 i = 0; i < size; i += 4)
 		{
-			*(tpatch++) = *(tblock++)*mult+addval;
+			_mm_storeu_ps(tpatch + i, _mm_add_ps(_mm_mul_ps(_mm_load_ps(tblock + i), mult4), addval4));
 		}
 	}
 }
@@ -640,37 +441,20 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 {
 	S32		i, j;
 
-	F32			block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+	LL_ALIGN_16(F32	block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+	F32		*tblock;
 	LLVector3	*tvec;
 
 	LLGroupHeader	*gopp = gGOPP;
 	S32		size = gopp->patch_size;
-	F32		range = ph->range;
-	S32		prequant = (ph->quant_wbits >> 4) + 2;
-	S32		quantize = 1<<prequant;
-	F32		hmin = ph->dc_offset;
 	S32		stride = gopp->stride;
+	F32		mult, addval;
 
-	F32		ooq = 1.f/(F32)quantize;
-	F32     *dq = gPatchDequantizeTable;
-	S32		*decopy_matrix = gDeCopyMatrix;
-
-	F32		mult = ooq*range;
-	F32		addval = mult*(F32)(1<<(prequant - 1))+hmin;
-
-//	BOOL	b_diag = FALSE;
-//	BOOL	b_right = TRUE;
-
-	for (i = 0; i < size*size; i++)
+	if (!idct_decompress(block, cpatch, ph, size, mult, addval))
 	{
-		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
+		return;
 	}
 
-	if (size == 16)
-		idct_patch(block);
-	else
-		idct_patch_large(block);
-
 	for (j = 0; j < size; j++)
 	{
 		tvec = v + j*stride;
@@ -681,4 +465,3 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 		}
 	}
 }
-
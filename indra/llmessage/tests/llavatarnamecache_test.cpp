@@ -99,4 +99,17 @@ namespace tut
 		valid = max_age_from_cache_control("max-age=-123", &max_age);
 		ensure("less than zero max-age is invalid", !valid);
 	}
+
+	template<> template<>
+	void avatarnamecache_object::test<3>()
+	{
+		const size_t base = 60;
+		const size_t limit = 4000;
+		U32 count = max_ids_per_name_request(base, limit);
+		ensure("batch fits the url limit", base + count * 41 <= limit);
+		ensure("batch fills the url limit", base + (count + 1) * 41 > limit);
+
+		ensure_equals("short limit still sends one id",
+					  max_ids_per_name_request(base, base + 10), 1U);
+	}
 }
@@ -176,4 +176,38 @@ namespace tut
         LL_INFOS("CoMain") << "checking count" << LL_ENDL;
         ensure_equals("coprocedure failed to update counter", counter, 5);
     }
+
+    template<> template<>
+    void coproceduremanager_object_t::test<5>()
+    {
+        Sync sync;
+        std::vector<std::string> order;
+        auto record = [&order, &sync](const std::string &name) -> LLCoprocedureManager::CoProcedure_t
+        {
+            return [&order, &sync, name](LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t & ptr, const LLUUID & id) {
+                sync.bump();
+                order.push_back(name);
+            };
+        };
+
+        // "Upload" runs one coprocedure at a time, queue everything
+        // before it gets a chance to start
+        LLCoprocedureManager &manager(LLCoprocedureManager::instance());
+        manager.initializePool("Upload");
+        manager.enqueueCoprocedure("Upload", "low", record("low"), LLCoprocedureManager::PRIORITY_LOW);
+        LLUUID cancelled = manager.enqueueCoprocedure("Upload", "cancelled", record("cancelled"));
+        manager.enqueueCoprocedure("Upload", "normal", record("normal"));
+        manager.enqueueCoprocedure("Upload", "high", record("high"), LLCoprocedureManager::PRIORITY_HIGH);
+        ensure("queued coprocedure cancelled", manager.cancelCoprocedure(cancelled));
+        ensure("unknown coprocedure not cancelled", !manager.cancelCoprocedure(LLUUID::generateNewID()));
+
+        sync.yield(3);
+        ensure_equals("coprocedures run", order.size(), size_t(3));
+        ensure_equals("high priority first", order[0], std::string("high"));
+        ensure_equals("normal priority second", order[1], std::string("normal"));
+        ensure_equals("low priority last", order[2], std::string("low"));
+        ensure_equals("cancel counted", manager.getStats()["Upload"]["cancelled"].asInteger(), 1);
+
+        manager.close("Upload");
+    }
 }  // namespace tut
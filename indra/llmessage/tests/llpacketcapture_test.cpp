@@ -0,0 +1,339 @@
+/**
+ * @file   llpacketcapture_test.cpp
+ * @brief  Test for packet capture files and their replay.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketcapture.h"
+#include "../llpacketreplay.h"
+
+#include "llapr.h"
+#include "llfile.h"
+#include "../message.h"
+#include "../message_prehash.h"
+#include "../net.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	// just what TestMessage and the message system itself send
+	const char* TEST_TEMPLATE =
+		"version 2.0\n"
+		"{\n"
+		"	TestMessage Low 1 NotTrusted Zerocoded\n"
+		"	{\n"
+		"		TestBlock1 Single\n"
+		"		{	Test1	U32	}\n"
+		"	}\n"
+		"	{\n"
+		"		NeighborBlock Multiple 4\n"
+		"		{	Test0	U32	}\n"
+		"		{	Test1	U32	}\n"
+		"		{	Test2	U32	}\n"
+		"	}\n"
+		"}\n"
+		"{\n"
+		"	PacketAck Fixed 0xFFFFFFFB NotTrusted Unencoded\n"
+		"	{\n"
+		"		Packets Variable\n"
+		"		{	ID	U32	}\n"
+		"	}\n"
+		"}\n"
+		"{\n"
+		"	StartPingCheck High 1 NotTrusted Unencoded\n"
+		"	{\n"
+		"		PingID Single\n"
+		"		{	PingID	U8	}\n"
+		"		{	OldestUnacked	U32	}\n"
+		"	}\n"
+		"}\n";
+
+	const S32 REPLAY_PACKETS = 500;
+
+	struct Handled
+	{
+		S32 mCount;
+		U32 mSum;
+	};
+
+	void process_test_message(LLMessageSystem* msg, void** user_data)
+	{
+		Handled* handled = (Handled*)user_data;
+		U32 value = 0;
+		msg->getU32Fast(_PREHASH_TestBlock1, _PREHASH_Test1, value);
+		++handled->mCount;
+		handled->mSum += value;
+	}
+
+	// answers every TestMessage with a reliable one back to its sim
+	void reply_to_test_message(LLMessageSystem* msg, void** user_data)
+	{
+		process_test_message(msg, user_data);
+		U32 value = 0;
+		msg->getU32Fast(_PREHASH_TestBlock1, _PREHASH_Test1, value);
+		LLHost sender = msg->getSender();
+
+		msg->newMessageFast(_PREHASH_TestMessage);
+		msg->nextBlockFast(_PREHASH_TestBlock1);
+		msg->addU32Fast(_PREHASH_Test1, value);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			msg->nextBlockFast(_PREHASH_NeighborBlock);
+			msg->addU32Fast(_PREHASH_Test0, 0);
+			msg->addU32Fast(_PREHASH_Test1, 0);
+			msg->addU32Fast(_PREHASH_Test2, 0);
+		}
+		msg->sendReliable(sender);
+	}
+}
+
+namespace tut
+{
+	struct LLPacketCaptureData
+	{
+		std::string mCaptureFile;
+		std::string mTemplateFile;
+
+		LLPacketCaptureData()
+		{
+			static bool init = false;
+			if (!init)
+			{
+				ll_init_apr();
+				init = true;
+			}
+			mCaptureFile = std::string(LLFile::tmpdir()) + "llpacketcapture_test.pcap";
+			mTemplateFile = std::string(LLFile::tmpdir()) + "llpacketcapture_test.msg";
+		}
+
+		~LLPacketCaptureData()
+		{
+			LLFile::remove(mCaptureFile, ENOENT);
+			LLFile::remove(mTemplateFile, ENOENT);
+		}
+
+		// template file plus a capture of REPLAY_PACKETS TestMessages
+		// from two interleaved sims, returns the sum of their values
+		U32 writeReplayFiles()
+		{
+			LLFILE* file = LLFile::fopen(mTemplateFile, "wb");
+			ensure("template written", file && fputs(TEST_TEMPLATE, file) >= 0);
+			fclose(file);
+
+			LLHost sims[2] = { LLHost(ip_string_to_u32("10.1.2.3"), 13005),
+							   LLHost(ip_string_to_u32("10.1.2.4"), 13006) };
+			LLPacketCaptureWriter writer;
+			ensure("opened for writing", writer.open(mCaptureFile));
+			U32 sum = 0;
+			for (S32 i = 0; i < REPLAY_PACKETS; ++i)
+			{
+				U8 buffer[MAX_BUFFER_SIZE];
+				S32 size = makePacket(buffer, 1 + i / 2, i);
+				writer.writePacket(sims[i % 2], buffer, size);
+				sum += i;
+			}
+			writer.close();
+			return sum;
+		}
+
+		// a reliable TestMessage carrying value, as it comes off the wire
+		S32 makePacket(U8* buffer, TPACKETID packet_id, U32 value)
+		{
+			S32 size = 0;
+			buffer[size++] = LL_RELIABLE_FLAG;
+			U32 id = htonl(packet_id);
+			memcpy(&buffer[size], &id, sizeof(id));
+			size += sizeof(id);
+			buffer[size++] = 0;				// offset
+			buffer[size++] = 0xff;			// low frequency
+			buffer[size++] = 0xff;
+			U16 number = htons(1);
+			memcpy(&buffer[size], &number, sizeof(number));
+			size += sizeof(number);
+			// TestBlock1, then four NeighborBlocks of three U32s
+			htolememcpy(&buffer[size], &value, MVT_U32, 4);
+			size += 4;
+			memset(&buffer[size], 0, 4 * 3 * 4);
+			size += 4 * 3 * 4;
+			return size;
+		}
+	};
+
+	typedef test_group<LLPacketCaptureData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llpacketcapture_test_factory("LLPacketCapture");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("write and read back");
+		LLHost first(ip_string_to_u32("10.1.2.3"), 13005);
+		LLHost second(ip_string_to_u32("192.168.0.7"), 12035);
+		U8 packets[3][MAX_BUFFER_SIZE];
+		S32 sizes[3] = { 7, MAX_BUFFER_SIZE, 200 };
+		for (S32 i = 0; i < 3; ++i)
+		{
+			for (S32 j = 0; j < sizes[i]; ++j)
+			{
+				packets[i][j] = (U8)(i * 31 + j);
+			}
+		}
+
+		LLPacketCaptureWriter writer;
+		ensure("opened for writing", writer.open(mCaptureFile));
+		writer.writePacket(first, packets[0], sizes[0]);
+		writer.writePacket(second, packets[1], sizes[1]);
+		writer.writePacket(first, packets[2], sizes[2]);
+		ensure_equals("written", writer.getPacketCount(), 3U);
+		writer.close();
+
+		LLPacketCaptureReader reader;
+		ensure("opened for reading", reader.open(mCaptureFile));
+		for (S32 i = 0; i < 3; ++i)
+		{
+			ensure("more packets", !reader.isDone());
+			U8 buffer[MAX_BUFFER_SIZE];
+			LLHost sender;
+			ensure_equals("size", reader.readPacket(buffer, sender), sizes[i]);
+			ensure("sender", sender == (i == 1 ? second : first));
+			ensure("data", !memcmp(buffer, packets[i], sizes[i]));
+		}
+		ensure("done", reader.isDone());
+		U8 buffer[MAX_BUFFER_SIZE];
+		LLHost sender;
+		ensure_equals("nothing after the end", reader.readPacket(buffer, sender), 0);
+		ensure_equals("read", reader.getPacketCount(), 3U);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("bad and truncated captures");
+		LLFILE* file = LLFile::fopen(mCaptureFile, "wb");
+		ensure("garbage written", file && fputs("not a capture at all", file) >= 0);
+		fclose(file);
+		LLPacketCaptureReader reader;
+		ensure("not a capture", !reader.open(mCaptureFile));
+
+		LLHost host(ip_string_to_u32("10.1.2.3"), 13005);
+		U8 packet[100];
+		memset(packet, 0x5a, sizeof(packet));
+		LLPacketCaptureWriter writer;
+		ensure("opened for writing", writer.open(mCaptureFile));
+		writer.writePacket(host, packet, sizeof(packet));
+		writer.writePacket(host, packet, sizeof(packet));
+		writer.close();
+
+		// lose the end of the second packet
+		llstat stat_data;
+		ensure_equals("stat", LLFile::stat(mCaptureFile, &stat_data), 0);
+		std::vector<char> data(stat_data.st_size);
+		file = LLFile::fopen(mCaptureFile, "rb");
+		ensure("read back", file && fread(&data[0], data.size(), 1, file) == 1);
+		fclose(file);
+		file = LLFile::fopen(mCaptureFile, "wb");
+		ensure("truncated", file && fwrite(&data[0], data.size() - 10, 1, file) == 1);
+		fclose(file);
+
+		ensure("truncated capture opens", reader.open(mCaptureFile));
+		U8 buffer[MAX_BUFFER_SIZE];
+		LLHost sender;
+		ensure_equals("first packet", reader.readPacket(buffer, sender), (S32)sizeof(packet));
+		ensure_equals("second packet is cut off", reader.readPacket(buffer, sender), 0);
+		ensure("done", reader.isDone());
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("replay through the message system");
+		U32 expected_sum = writeReplayFiles();
+
+		LLMessageSystem* msg = new LLMessageSystem(mTemplateFile, NET_USE_OS_ASSIGNED_PORT,
+												   1, 0, 0, false, 5.f, 100.f);
+		ensure("message system", msg->isOK());
+		gMessageSystem = msg;
+		Handled handled = { 0, 0 };
+		msg->setHandlerFuncFast(_PREHASH_TestMessage, process_test_message, (void**)&handled);
+
+		LLPacketReplay replay(msg);
+		bool ran = replay.run(mCaptureFile);
+		ensure("not replaying after the run", !msg->isReplayingPackets());
+
+		delete msg;
+		gMessageSystem = NULL;
+
+		ensure("ran", ran);
+		ensure_equals("messages", (S32)replay.getMessageCount(), REPLAY_PACKETS);
+		ensure_equals("handled", handled.mCount, REPLAY_PACKETS);
+		ensure_equals("values", handled.mSum, expected_sum);
+		LLPacketReplay::timing_map_t::const_iterator iter = replay.getTimings().find(_PREHASH_TestMessage);
+		ensure("timed", iter != replay.getTimings().end());
+		ensure_equals("timed messages", (S32)iter->second.mCount, REPLAY_PACKETS);
+		replay.logTimings();
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("replay sends nothing");
+		writeReplayFiles();
+
+		LLMessageSystem* msg = new LLMessageSystem(mTemplateFile, NET_USE_OS_ASSIGNED_PORT,
+												   1, 0, 0, false, 5.f, 100.f);
+		ensure("message system", msg->isOK());
+		gMessageSystem = msg;
+		Handled handled = { 0, 0 };
+		msg->setHandlerFuncFast(_PREHASH_TestMessage, reply_to_test_message, (void**)&handled);
+
+		LLPacketReplay replay(msg);
+		bool ran = replay.run(mCaptureFile);
+		{
+			// give any resend that slipped through a chance to go out
+			LockMessageChecker lmc(msg);
+			lmc.processAcks(0.f);
+		}
+		U32 reliable_out = msg->mReliablePacketsOut;
+		bool unacked = !msg->mCircuitInfo.mUnackedCircuitMap.empty();
+		U32 blocked = msg->mPacketRing.getBlockedSendCount();
+
+		delete msg;
+		gMessageSystem = NULL;
+
+		ensure("ran", ran);
+		ensure_equals("handled", handled.mCount, REPLAY_PACKETS);
+		ensure_equals("no reliable replies registered", reliable_out, 0U);
+		ensure("nothing waiting for an ack", !unacked);
+		ensure_equals("nothing reached the ring", blocked, 0U);
+	}
+}
@@ -0,0 +1,217 @@
+/**
+ * @file   llpacketidwindow_test.cpp
+ * @brief  Test for the sliding window of received packet ids.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketidwindow.h"
+
+#include <map>
+
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+#include "../test/testrand.h"
+
+namespace tut
+{
+	const U32 ID_RANGE = 1 << LLPacketIdWindow::ID_BITS;
+	const S32 FUZZ_COUNT = 200000;
+	const S32 BENCHMARK_PACKETS = 1000000;
+
+	struct LLPacketIdWindowData
+	{
+		LLTestRand mRand;
+		LLPacketIdWindow mWindow;
+
+		LLPacketIdWindowData()
+		:	mRand(4321)
+		{
+		}
+	};
+
+	typedef test_group<LLPacketIdWindowData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llpacketidwindow_test_factory("LLPacketIdWindow");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("add, contains and removeBefore");
+		ensure("empty", mWindow.empty());
+		ensure("nothing contained", !mWindow.contains(0));
+
+		ensure("add", mWindow.add(100));
+		ensure("add out of order", mWindow.add(98));
+		ensure("add newer", mWindow.add(105));
+		ensure("contains 98", mWindow.contains(98));
+		ensure("contains 100", mWindow.contains(100));
+		ensure("contains 105", mWindow.contains(105));
+		ensure("not 99", !mWindow.contains(99));
+		ensure("not 106", !mWindow.contains(106));
+		ensure_equals("oldest", mWindow.getOldest(), (TPACKETID)98);
+		ensure_equals("newest", mWindow.getNewest(), (TPACKETID)105);
+
+		mWindow.removeBefore(100);
+		ensure("98 removed", !mWindow.contains(98));
+		ensure("100 kept", mWindow.contains(100));
+		ensure("105 kept", mWindow.contains(105));
+
+		// past the newest forgets everything
+		mWindow.removeBefore(200);
+		ensure("100 removed", !mWindow.contains(100));
+		ensure("105 removed", !mWindow.contains(105));
+		ensure("emptied", mWindow.empty());
+
+		mWindow.add(7);
+		mWindow.clear();
+		ensure("cleared", !mWindow.contains(7));
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("window slides and wraps");
+		const TPACKETID first = ID_RANGE - 10;
+		mWindow.add(first);
+		mWindow.add(ID_RANGE - 1);
+		ensure("add across the wrap", mWindow.add(5));
+		ensure("before the wrap", mWindow.contains(first));
+		ensure("last before the wrap", mWindow.contains(ID_RANGE - 1));
+		ensure("after the wrap", mWindow.contains(5));
+		ensure_equals("newest after the wrap", mWindow.getNewest(), (TPACKETID)5);
+
+		// oldest_id after the wrap removes ids from before it
+		mWindow.removeBefore(2);
+		ensure("removed across the wrap", !mWindow.contains(first));
+		ensure("kept after the wrap", mWindow.contains(5));
+
+		// a window ahead, the old ids fall out of the back
+		const TPACKETID ahead = 5 + LLPacketIdWindow::WINDOW_SIZE;
+		mWindow.add(ahead);
+		ensure("slid out", !mWindow.contains(5));
+		ensure("too old to add", !mWindow.add(5));
+		ensure("newest kept", mWindow.contains(ahead));
+		ensure("back of the window", mWindow.add(ahead - LLPacketIdWindow::WINDOW_SIZE + 1));
+		ensure_equals("oldest", mWindow.getOldest(), (TPACKETID)(ahead - LLPacketIdWindow::WINDOW_SIZE + 1));
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("fuzz against a map of the window");
+		std::map<TPACKETID, bool> reference;
+		TPACKETID newest = ID_RANGE - 5000;
+		for (S32 i = 0; i < FUZZ_COUNT; ++i)
+		{
+			U32 action = mRand.rand(100);
+			if (action < 70)
+			{
+				// mostly in order, some late, like reliable packets
+				TPACKETID id = (newest + mRand.rand(8) - mRand.rand(action < 10 ? 3000 : 40)) % ID_RANGE;
+				mWindow.add(id);
+				reference[id] = true;
+				if (((id - newest) % ID_RANGE) < ID_RANGE / 2)
+				{
+					newest = id;
+				}
+			}
+			else if (action < 72)
+			{
+				// the other end's oldest unacked packet
+				TPACKETID oldest = (newest - mRand.rand(2000)) % ID_RANGE;
+				mWindow.removeBefore(oldest);
+				for (std::map<TPACKETID, bool>::iterator it = reference.begin(); it != reference.end(); )
+				{
+					if (((oldest - it->first) % ID_RANGE) - 1 < ID_RANGE / 2 - 1)
+					{
+						reference.erase(it++);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+			else
+			{
+				TPACKETID id = (newest - mRand.rand(5000)) % ID_RANGE;
+				bool expected = reference.count(id) != 0
+					&& ((newest - id) % ID_RANGE) < LLPacketIdWindow::WINDOW_SIZE;
+				ensure_equals("contains", mWindow.contains(id), expected);
+			}
+		}
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("duplicate suppression throughput");
+		std::map<TPACKETID, U64> reference;
+		LLTimer timer;
+		for (S32 i = 0; i < BENCHMARK_PACKETS; ++i)
+		{
+			TPACKETID id = (TPACKETID)i;
+			if (reference.find(id) == reference.end())
+			{
+				reference[id] = 0;
+			}
+			if (!(i % 1024))
+			{
+				reference.erase(reference.begin(), reference.lower_bound(id - 512));
+			}
+		}
+		F64 map_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		S32 duplicates = 0;
+		for (S32 i = 0; i < BENCHMARK_PACKETS; ++i)
+		{
+			TPACKETID id = (TPACKETID)i;
+			if (mWindow.contains(id))
+			{
+				++duplicates;
+			}
+			mWindow.add(id);
+			if (!(i % 1024))
+			{
+				mWindow.removeBefore(id - 512);
+			}
+		}
+		F64 window_time = timer.getElapsedTimeF64();
+		ensure_equals("no duplicates", duplicates, 0);
+
+		LL_INFOS() << "duplicate suppression: window " << BENCHMARK_PACKETS / llmax(window_time, 1e-9) / 1e6
+				   << " M packets/s, map " << BENCHMARK_PACKETS / llmax(map_time, 1e-9) / 1e6
+				   << " M packets/s" << LL_ENDL;
+	}
+}
@@ -0,0 +1,174 @@
+/**
+ * @file   llpacketring_test.cpp
+ * @brief  Test for batched UDP receive and send in LLPacketRing and net.cpp.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketring.h"
+#include "../net.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	// more than one batch
+	const S32 PACKET_COUNT = NET_MAX_BATCH * 3 + 5;
+
+	struct LLPacketRingData
+	{
+		S32 mReceiveSocket;
+		S32 mSendSocket;
+		int mReceivePort;
+		int mSendPort;
+		LLHost mReceiveHost;
+		LLPacketRing mRing;
+
+		LLPacketRingData()
+		:	mReceiveSocket(-1),
+			mSendSocket(-1),
+			mReceivePort(NET_USE_OS_ASSIGNED_PORT),
+			mSendPort(NET_USE_OS_ASSIGNED_PORT)
+		{
+			start_net(mReceiveSocket, mReceivePort);
+			start_net(mSendSocket, mSendPort);
+			mReceiveHost.set(ip_string_to_u32(LOOPBACK_ADDRESS_STRING), mReceivePort);
+		}
+
+		~LLPacketRingData()
+		{
+			end_net(mReceiveSocket);
+			end_net(mSendSocket);
+		}
+
+		// packet i is i+1 bytes long, each byte set to i
+		S32 makePacket(S32 i, char* buffer)
+		{
+			memset(buffer, i & 0xff, i + 1);
+			return i + 1;
+		}
+
+		// pull everything out of the ring, checking sizes, contents and sender
+		void receiveAll(LLPacketRing& ring, S32 expected)
+		{
+			char buffer[NET_BUFFER_SIZE];
+			S32 received = 0;
+			S32 size;
+			while ((size = ring.receivePacket(mReceiveSocket, buffer)) > 0)
+			{
+				ensure_equals("packet size", size, received + 1);
+				ensure_equals("packet contents", (U8) buffer[size - 1], (U8) (received & 0xff));
+				ensure_equals("sender port", ring.getLastSender().getPort(), (U32) mSendPort);
+				received++;
+			}
+			ensure_equals("packet count", received, expected);
+		}
+	};
+
+	typedef test_group<LLPacketRingData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llpacketring_test_factory("LLPacketRing");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("batched send and receive");
+		ensure("sockets open", mReceiveSocket >= 0 && mSendSocket >= 0);
+
+		char buffers[NET_MAX_BATCH][PACKET_COUNT];
+		LLNetDatagram packets[NET_MAX_BATCH];
+		for (S32 i = 0; i < PACKET_COUNT; i += NET_MAX_BATCH)
+		{
+			S32 count = llmin(NET_MAX_BATCH, PACKET_COUNT - i);
+			for (S32 j = 0; j < count; ++j)
+			{
+				packets[j].mData = buffers[j];
+				packets[j].mSize = makePacket(i + j, buffers[j]);
+				packets[j].mIP = mReceiveHost.getAddress();
+				packets[j].mPort = mReceiveHost.getPort();
+			}
+			ensure_equals("whole batch sent", send_packets(mSendSocket, packets, count), count);
+		}
+
+		receiveAll(mRing, PACKET_COUNT);
+
+		const LLPacketRing::BatchStats& stats = mRing.getBatchStats();
+		ensure_equals("stats packets", stats.mReceivedPackets, (U64) PACKET_COUNT);
+		ensure("batch limit", stats.mMaxReceiveBatch <= NET_MAX_BATCH);
+#if LL_LINUX
+		ensure("fewer receive calls than packets", stats.mReceiveCalls < (U64) PACKET_COUNT);
+#endif
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("unbatched receive");
+		mRing.setUseBatching(FALSE);
+
+		char buffer[NET_BUFFER_SIZE];
+		for (S32 i = 0; i < PACKET_COUNT; ++i)
+		{
+			S32 size = makePacket(i, buffer);
+			ensure("packet sent", send_packet(mSendSocket, buffer, size, mReceiveHost.getAddress(), mReceiveHost.getPort()));
+		}
+
+		receiveAll(mRing, PACKET_COUNT);
+		ensure_equals("no batched receives", mRing.getBatchStats().mReceiveCalls, (U64) 0);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("queued sends go out at the end of the batch");
+		LLPacketRing sender;
+		char buffer[NET_BUFFER_SIZE];
+
+		sender.beginSendBatch();
+		sender.beginSendBatch();
+		for (S32 i = 0; i < PACKET_COUNT; ++i)
+		{
+			S32 size = makePacket(i, buffer);
+			ensure("packet queued", sender.sendPacket(mSendSocket, buffer, size, mReceiveHost));
+		}
+		ensure_equals("inner batch sends nothing", sender.endSendBatch(), 0);
+		ensure_equals("full batches already sent", sender.getBatchStats().mSentPackets,
+					  (U64) (PACKET_COUNT / NET_MAX_BATCH) * NET_MAX_BATCH);
+
+		ensure_equals("no failures", sender.endSendBatch(), 0);
+		ensure_equals("all sent", sender.getBatchStats().mSentPackets, (U64) PACKET_COUNT);
+#if LL_LINUX
+		ensure("fewer send calls than packets", sender.getBatchStats().mSendCalls < (U64) PACKET_COUNT);
+#endif
+
+		receiveAll(mRing, PACKET_COUNT);
+	}
+}
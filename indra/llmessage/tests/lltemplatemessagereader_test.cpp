@@ -0,0 +1,217 @@
+/**
+ * @file   lltemplatemessagereader_test.cpp
+ * @brief  Test for decoding template messages.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltemplatemessagereader.h"
+
+#include "../llmessagetemplate.h"
+#include "../lltemplatemessagebuilder.h"
+#include "../message.h"
+#include "../message_prehash.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	const U32 TEST_MESSAGE_NUMBER = 1;
+	const S32 OBJECT_COUNT = 3;
+
+	void count_handled(LLMessageSystem*, void** user_data)
+	{
+		++*(S32*)user_data;
+	}
+
+	struct LLTemplateMessageReaderData
+	{
+		LLHost mHost;
+		LLMessageTemplate mTestTemplate;
+		LLMessageSystem::message_template_name_map_t mNameTemplates;
+		LLMessageSystem::message_template_number_map_t mNumberTemplates;
+		LLTemplateMessageReader mReader;
+		LLUUID mFullID;
+		S32 mHandled;
+
+		LLTemplateMessageReaderData()
+		:	mHost(ip_string_to_u32("127.0.0.1"), 13000),
+			mTestTemplate(_PREHASH_TestMessage, TEST_MESSAGE_NUMBER, MFT_HIGH),
+			mReader(mNumberTemplates),
+			mFullID("7d9e2b4c-1f3a-4e5b-8c6d-0a1b2c3d4e5f"),
+			mHandled(0)
+		{
+			// laid out like a small ObjectUpdate
+			LLMessageBlock* blockp = new LLMessageBlock(_PREHASH_Test0, MBT_SINGLE);
+			blockp->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+			blockp->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_VARIABLE, 1);
+			mTestTemplate.addBlock(blockp);
+			blockp = new LLMessageBlock(_PREHASH_ObjectData, MBT_VARIABLE);
+			blockp->addVariable(const_cast<char*>(_PREHASH_ID), MVT_U32, 4);
+			blockp->addVariable(const_cast<char*>(_PREHASH_FullID), MVT_LLUUID, 16);
+			blockp->addVariable(const_cast<char*>(_PREHASH_Data), MVT_VARIABLE, 2);
+			mTestTemplate.addBlock(blockp);
+			blockp = new LLMessageBlock(_PREHASH_RegionData, MBT_VARIABLE);
+			blockp->addVariable(const_cast<char*>(_PREHASH_RegionHandle), MVT_U64, 8);
+			mTestTemplate.addBlock(blockp);
+			mTestTemplate.setHandlerFunc(count_handled, (void**)&mHandled);
+			mNameTemplates[_PREHASH_TestMessage] = &mTestTemplate;
+			mNumberTemplates[TEST_MESSAGE_NUMBER] = &mTestTemplate;
+		}
+
+		// TestMessage with object_count ObjectData blocks, object i
+		// carrying i + 1 bytes of data
+		S32 makePacket(U8* buffer, S32 object_count, U32 value)
+		{
+			LLTemplateMessageBuilder builder(mNameTemplates);
+			builder.newMessage(_PREHASH_TestMessage);
+			builder.nextBlock(_PREHASH_Test0);
+			builder.addU32(_PREHASH_Test0, value);
+			builder.addString(_PREHASH_Test1, "hello");
+			for (S32 i = 0; i < object_count; ++i)
+			{
+				U8 data[32];
+				for (S32 j = 0; j <= i; ++j)
+				{
+					data[j] = (U8)(value + i + j);
+				}
+				builder.nextBlock(_PREHASH_ObjectData);
+				builder.addU32(_PREHASH_ID, value + i);
+				builder.addUUID(_PREHASH_FullID, mFullID);
+				builder.addBinaryData(_PREHASH_Data, data, i + 1);
+			}
+			buffer[PHL_FLAGS] = 0;
+			return (S32)builder.buildMessage(buffer, MAX_BUFFER_SIZE, 0);
+		}
+
+		void readPacket(const U8* buffer, S32 size)
+		{
+			ensure("valid", mReader.validateMessage(buffer, size, mHost, true));
+			ensure("decoded", mReader.readMessage(buffer, mHost));
+		}
+	};
+
+	typedef test_group<LLTemplateMessageReaderData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory lltemplatemessagereader_test_factory("LLTemplateMessageReader");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("named getters over repeated blocks");
+		U8 buffer[MAX_BUFFER_SIZE];
+		S32 size = makePacket(buffer, OBJECT_COUNT, 100);
+		readPacket(buffer, size);
+		// the reader keeps its own copy
+		memset(buffer, 0xff, sizeof(buffer));
+
+		U32 value = 0;
+		mReader.getU32(_PREHASH_Test0, _PREHASH_Test0, value);
+		ensure_equals("single block", value, 100U);
+		std::string text;
+		mReader.getString(_PREHASH_Test0, _PREHASH_Test1, text);
+		ensure_equals("string", text, std::string("hello"));
+
+		ensure_equals("repeated blocks", mReader.getNumberOfBlocks(_PREHASH_ObjectData), OBJECT_COUNT);
+		ensure_equals("no blocks", mReader.getNumberOfBlocks(_PREHASH_RegionData), 0);
+		for (S32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			mReader.getU32(_PREHASH_ObjectData, _PREHASH_ID, value, i);
+			ensure_equals("id", value, (U32)(100 + i));
+			LLUUID full_id;
+			mReader.getUUID(_PREHASH_ObjectData, _PREHASH_FullID, full_id, i);
+			ensure_equals("full id", full_id, mFullID);
+			ensure_equals("data size", mReader.getSize(_PREHASH_ObjectData, i, _PREHASH_Data), i + 1);
+			U8 data[32];
+			mReader.getBinaryData(_PREHASH_ObjectData, _PREHASH_Data, data, i + 1, i);
+			ensure_equals("data first", (S32)data[0], 100 + i);
+			ensure_equals("data last", (S32)data[i], 100 + i + i);
+		}
+
+		ensure_equals("block not in message",
+					  mReader.getSize(_PREHASH_RegionData, _PREHASH_RegionHandle), LL_BLOCK_NOT_IN_MESSAGE);
+		ensure_equals("repeat not in message",
+					  mReader.getSize(_PREHASH_ObjectData, OBJECT_COUNT, _PREHASH_Data), LL_BLOCK_NOT_IN_MESSAGE);
+		ensure_equals("variable not in block",
+					  mReader.getSize(_PREHASH_Test0, _PREHASH_Data), LL_VARIABLE_NOT_IN_BLOCK);
+
+		// the field table is the same one LLMessageFields reads
+		ensure("fields", mReader.hasFields());
+		ensure_equals("field blocks", mReader.getFieldBlockCount(1), OBJECT_COUNT);
+		ensure("no such repeat", mReader.getFields(1, OBJECT_COUNT) == NULL);
+
+		mReader.clearMessage();
+		ensure("cleared", !mReader.hasFields());
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("short packets read as zeros");
+		U8 buffer[MAX_BUFFER_SIZE];
+		S32 size = makePacket(buffer, OBJECT_COUNT, 7);
+
+		// the packet ends in the RegionData block count, then the last Data.
+		// The last Data runs off the end.
+		readPacket(buffer, size - 2);
+		ensure_equals("clamped data", mReader.getSize(_PREHASH_ObjectData, OBJECT_COUNT - 1, _PREHASH_Data),
+					  OBJECT_COUNT - 1);
+
+		// half of the last FullID and everything after it is missing
+		readPacket(buffer, size - 1 - OBJECT_COUNT - 2 - 8);
+		ensure_equals("blocks", mReader.getNumberOfBlocks(_PREHASH_ObjectData), OBJECT_COUNT);
+		U32 value = 0;
+		mReader.getU32(_PREHASH_ObjectData, _PREHASH_ID, value, OBJECT_COUNT - 1);
+		ensure_equals("id before the end", value, (U32)(7 + OBJECT_COUNT - 1));
+		LLUUID full_id = mFullID;
+		mReader.getUUID(_PREHASH_ObjectData, _PREHASH_FullID, full_id, OBJECT_COUNT - 1);
+		ensure("zeros past the end", full_id.isNull());
+		ensure_equals("empty data", mReader.getSize(_PREHASH_ObjectData, OBJECT_COUNT - 1, _PREHASH_Data), 0);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("copyToBuilder rebuilds the same message");
+		U8 buffer[MAX_BUFFER_SIZE];
+		S32 size = makePacket(buffer, OBJECT_COUNT, 55);
+		readPacket(buffer, size);
+
+		LLTemplateMessageBuilder builder(mNameTemplates);
+		builder.newMessage(_PREHASH_TestMessage);
+		mReader.copyToBuilder(builder);
+		U8 copy[MAX_BUFFER_SIZE];
+		copy[PHL_FLAGS] = 0;
+		S32 copy_size = (S32)builder.buildMessage(copy, MAX_BUFFER_SIZE, 0);
+		ensure_equals("size", copy_size, size);
+		ensure("same bytes", !memcmp(buffer + LL_PACKET_ID_SIZE, copy + LL_PACKET_ID_SIZE, size - LL_PACKET_ID_SIZE));
+	}
+}
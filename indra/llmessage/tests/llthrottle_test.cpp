@@ -0,0 +1,231 @@
+/**
+ * @file   llthrottle_test.cpp
+ * @brief  Test for LLThrottleEstimator against a simulated link.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmath.h"
+#include "../llthrottle.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	const F32 KBPS = 1024.f;
+	const F32 UPDATE_SECS = 5.f;
+	const S32 PACKET_BYTES = 1000;
+
+	// A bottleneck link with a drop-tail queue in front of it.  The
+	// simulator sends each category at the lesser of its throttle and what
+	// it has queued up, anything the link can't carry waits in the queue
+	// and what doesn't fit in the queue is lost.
+	struct SimulatedLink
+	{
+		F32 mCapacityBPS;
+		F32 mQueueBits;
+		F32 mQueueLimitBits;
+		U32 mPacketsLost;
+		F32 mDemandBPS[TC_EOF];
+
+		SimulatedLink(F32 capacity_bps)
+		:	mCapacityBPS(capacity_bps),
+			mQueueBits(0.f),
+			// about half a second of buffering
+			mQueueLimitBits(capacity_bps * 0.5f),
+			mPacketsLost(0)
+		{
+			for (S32 i = 0; i < TC_EOF; i++)
+			{
+				mDemandBPS[i] = 0.f;
+			}
+		}
+
+		// Run one estimator period over the link, returns delivered bps.
+		F32 step(LLThrottleEstimator& estimator)
+		{
+			F32 split[TC_EOF];
+			estimator.getThrottleSplit(split);
+
+			F32 offered[TC_EOF];
+			F32 offered_bps = 0.f;
+			S32 i;
+			for (i = 0; i < TC_EOF; i++)
+			{
+				offered[i] = llmin(split[i], mDemandBPS[i]);
+				offered_bps += offered[i];
+			}
+
+			F32 in_bits = offered_bps * UPDATE_SECS;
+			F32 queue_bits = llmax(0.f, mQueueBits + in_bits - mCapacityBPS * UPDATE_SECS);
+			F32 dropped_bits = llmax(0.f, queue_bits - mQueueLimitBits);
+			queue_bits -= dropped_bits;
+			F32 out_bits = in_bits + mQueueBits - queue_bits - dropped_bits;
+			mQueueBits = queue_bits;
+			mPacketsLost += (U32)(dropped_bits / (PACKET_BYTES * 8));
+
+			if (offered_bps > 0.f)
+			{
+				for (i = 0; i < TC_EOF; i++)
+				{
+					S32 packets = (S32)(out_bits * (offered[i] / offered_bps) / (PACKET_BYTES * 8));
+					for (S32 p = 0; p < packets; p++)
+					{
+						estimator.addBytesIn(i, PACKET_BYTES);
+					}
+				}
+			}
+
+			estimator.update(UPDATE_SECS, mPacketsLost);
+			return out_bits / UPDATE_SECS;
+		}
+
+		// Run for a while and return the mean estimate over the tail.
+		F32 settle(LLThrottleEstimator& estimator, S32 steps, S32 tail)
+		{
+			F32 sum = 0.f;
+			for (S32 i = 0; i < steps; i++)
+			{
+				step(estimator);
+				if (i >= steps - tail)
+				{
+					sum += estimator.getEstimatedBPS();
+				}
+			}
+			return sum / tail;
+		}
+	};
+
+	struct ThrottleEstimatorData
+	{
+		LLThrottleEstimator mEstimator;
+	};
+
+	typedef test_group<ThrottleEstimatorData> estimator_t;
+	typedef estimator_t::object estimator_object_t;
+	tut::estimator_t tut_estimator("LLThrottleEstimator");
+
+	// Slider set far too low, plenty of demand: the estimate should climb
+	// to the link.
+	template<> template<>
+	void estimator_object_t::test<1>()
+	{
+		SimulatedLink link(2000.f * KBPS);
+		for (S32 i = 0; i < TC_EOF; i++)
+		{
+			link.mDemandBPS[i] = 1000.f * KBPS;
+		}
+		mEstimator.reset(100.f * KBPS);
+
+		F32 mean_bps = link.settle(mEstimator, 80, 20);
+		ensure("climbs toward capacity", mean_bps > 0.7f * link.mCapacityBPS);
+		ensure("doesn't overshoot capacity", mean_bps < 1.3f * link.mCapacityBPS);
+	}
+
+	// Slider set far too high: the estimate should back off to the link
+	// and the losses stop.
+	template<> template<>
+	void estimator_object_t::test<2>()
+	{
+		SimulatedLink link(1000.f * KBPS);
+		for (S32 i = 0; i < TC_EOF; i++)
+		{
+			link.mDemandBPS[i] = 2000.f * KBPS;
+		}
+		mEstimator.reset(6000.f * KBPS);
+
+		F32 mean_bps = link.settle(mEstimator, 80, 20);
+		ensure("backs off toward capacity", mean_bps < 1.3f * link.mCapacityBPS);
+		ensure("doesn't collapse", mean_bps > 0.6f * link.mCapacityBPS);
+		ensure("loss settles down", mEstimator.getLossRate() < 0.05f);
+	}
+
+	// Demand that doesn't fill the link: no congestion and no probing past
+	// what's actually used.
+	template<> template<>
+	void estimator_object_t::test<3>()
+	{
+		SimulatedLink link(4000.f * KBPS);
+		link.mDemandBPS[TC_TASK] = 200.f * KBPS;
+		mEstimator.reset(1000.f * KBPS);
+
+		link.settle(mEstimator, 20, 1);
+		ensure("not congested", !mEstimator.isCongested());
+		ensure_equals("estimate holds", mEstimator.getEstimatedBPS(), 1000.f * KBPS);
+	}
+
+	// The split follows demand, sums to the estimate and never starves a
+	// quiet category.
+	template<> template<>
+	void estimator_object_t::test<4>()
+	{
+		F32 split[TC_EOF];
+		mEstimator.reset(1000.f * KBPS);
+		mEstimator.getThrottleSplit(split);
+
+		F32 total = 0.f;
+		S32 i;
+		for (i = 0; i < TC_EOF; i++)
+		{
+			total += split[i];
+		}
+		ensure("default split sums to the estimate", fabsf(total - mEstimator.getEstimatedBPS()) < 1.f);
+
+		SimulatedLink link(1500.f * KBPS);
+		link.mDemandBPS[TC_TEXTURE] = 2000.f * KBPS;
+		link.mDemandBPS[TC_TASK] = 40.f * KBPS;
+		link.mDemandBPS[TC_RESEND] = 10.f * KBPS;
+		F32 mean_bps = link.settle(mEstimator, 60, 20);
+		mEstimator.getThrottleSplit(split);
+
+		total = 0.f;
+		for (i = 0; i < TC_EOF; i++)
+		{
+			total += split[i];
+			ensure("every category keeps a share", split[i] > 0.f);
+		}
+		ensure("split sums to the estimate", fabsf(total - mEstimator.getEstimatedBPS()) < 1.f);
+		ensure("texture gets the bulk", split[TC_TEXTURE] > 0.5f * total);
+		ensure("grows while texture is held back", mean_bps > 0.7f * link.mCapacityBPS);
+		ensure("task keeps at least its demand", split[TC_TASK] >= link.mDemandBPS[TC_TASK]);
+		ensure("resend keeps headroom", split[TC_RESEND] >= link.mDemandBPS[TC_RESEND]);
+	}
+
+	// Probing never goes past the ceiling the user set.
+	template<> template<>
+	void estimator_object_t::test<5>()
+	{
+		SimulatedLink link(4000.f * KBPS);
+		for (S32 i = 0; i < TC_EOF; i++)
+		{
+			link.mDemandBPS[i] = 2000.f * KBPS;
+		}
+		mEstimator.setLimits(50.f * KBPS, 800.f * KBPS);
+		mEstimator.reset(800.f * KBPS);
+
+		link.settle(mEstimator, 40, 1);
+		ensure("not congested", !mEstimator.isCongested());
+		ensure_equals("held at the ceiling", mEstimator.getEstimatedBPS(), 800.f * KBPS);
+	}
+}
@@ -0,0 +1,262 @@
+/**
+ * @file   lludpthread_test.cpp
+ * @brief  Test for the message system's optional UDP network thread.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lludpthread.h"
+
+#include "../llmessagetemplate.h"
+#include "../message_prehash.h"
+#include "../net.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	const U32 TEST_MESSAGE_NUMBER = 1;
+	const U32 PACKET_ACK_NUMBER = 0xFFFFFFFB;
+
+	struct LLUDPThreadData
+	{
+		S32 mThreadSocket;
+		S32 mPeerSocket;
+		int mThreadPort;
+		int mPeerPort;
+		LLHost mThreadHost;
+		LLHost mPeerHost;
+		LLMessageTemplate mAckTemplate;
+		LLMessageTemplate mTestTemplate;
+		LLMessageSystem::message_template_name_map_t mNameTemplates;
+		LLMessageSystem::message_template_number_map_t mNumberTemplates;
+		LLCircuit::ack_circuit_list_t mAckCircuits;
+		LLUDPThread* mThread;
+
+		LLUDPThreadData()
+		:	mThreadSocket(-1),
+			mPeerSocket(-1),
+			mThreadPort(NET_USE_OS_ASSIGNED_PORT),
+			mPeerPort(NET_USE_OS_ASSIGNED_PORT),
+			mAckTemplate(_PREHASH_PacketAck, PACKET_ACK_NUMBER, MFT_LOW),
+			mTestTemplate(_PREHASH_TestMessage, TEST_MESSAGE_NUMBER, MFT_HIGH),
+			mThread(NULL)
+		{
+			start_net(mThreadSocket, mThreadPort);
+			start_net(mPeerSocket, mPeerPort);
+			mThreadHost.set(ip_string_to_u32(LOOPBACK_ADDRESS_STRING), mThreadPort);
+			mPeerHost.set(ip_string_to_u32(LOOPBACK_ADDRESS_STRING), mPeerPort);
+
+			LLMessageBlock* blockp = new LLMessageBlock(_PREHASH_Packets, MBT_VARIABLE);
+			blockp->addVariable(const_cast<char*>(_PREHASH_ID), MVT_U32, 4);
+			mAckTemplate.addBlock(blockp);
+			mNameTemplates[_PREHASH_PacketAck] = &mAckTemplate;
+			mNumberTemplates[PACKET_ACK_NUMBER] = &mAckTemplate;
+
+			blockp = new LLMessageBlock(_PREHASH_Test0, MBT_SINGLE);
+			blockp->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+			mTestTemplate.addBlock(blockp);
+			mNameTemplates[_PREHASH_TestMessage] = &mTestTemplate;
+			mNumberTemplates[TEST_MESSAGE_NUMBER] = &mTestTemplate;
+		}
+
+		~LLUDPThreadData()
+		{
+			delete mThread;
+			end_net(mThreadSocket);
+			end_net(mPeerSocket);
+		}
+
+		void startThread()
+		{
+			mThread = new LLUDPThread(mThreadSocket, mNameTemplates, mNumberTemplates);
+			mThread->updateAckCircuits(mAckCircuits);
+			mThread->start();
+		}
+
+		// TestMessage carrying value, with the given flags and packet id.
+		// With LL_ZERO_CODE_FLAG set the body must be all zeros.
+		S32 makePacket(U8* buffer, U8 flags, TPACKETID packet_id, U32 value)
+		{
+			buffer[PHL_FLAGS] = flags;
+			*((U32*)&buffer[PHL_PACKET_ID]) = htonl(packet_id);
+			buffer[PHL_OFFSET] = 0;
+			buffer[PHL_NAME] = (U8)TEST_MESSAGE_NUMBER;
+			if (flags & LL_ZERO_CODE_FLAG)
+			{
+				// four zero bytes, zero coded
+				buffer[PHL_NAME + 1] = 0;
+				buffer[PHL_NAME + 2] = 4;
+				return PHL_NAME + 3;
+			}
+			htolememcpy(&buffer[PHL_NAME + 1], &value, MVT_U32, 4);
+			return PHL_NAME + 5;
+		}
+
+		void sendToThread(U8* buffer, S32 size)
+		{
+			ensure("packet sent", send_packet(mPeerSocket, (const char*)buffer, size,
+											  mThreadHost.getAddress(), mThreadHost.getPort()));
+		}
+
+		// stands in for the alive circuit LLCircuit::getAckCircuits() reports
+		packet_sequence_ptr_t addPeerCircuit()
+		{
+			packet_sequence_ptr_t sequence = std::make_shared<LLAtomicU32>(0U);
+			mAckCircuits.push_back(std::make_pair(mPeerHost, sequence));
+			return sequence;
+		}
+
+		LLUDPThread::Packet* waitForPacket()
+		{
+			LLTimer timer;
+			LLUDPThread::Packet* packetp = NULL;
+			while (!(packetp = mThread->peekPacket()) && timer.getElapsedTimeF32() < 5.f)
+			{
+				ms_sleep(1);
+			}
+			ensure("packet handed over", packetp != NULL);
+			return packetp;
+		}
+
+		// Returns the size of the PacketAck received by the peer, 0 if none
+		// arrived in time.
+		S32 receiveAck(U8* buffer, F32 timeout)
+		{
+			LLTimer timer;
+			S32 size = 0;
+			while (!(size = receive_packet(mPeerSocket, (char*)buffer)) && timer.getElapsedTimeF32() < timeout)
+			{
+				wait_for_packets(mPeerSocket, 10);
+			}
+			return size;
+		}
+	};
+
+	typedef test_group<LLUDPThreadData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory lludpthread_test_factory("LLUDPThread");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("reliable message is acked on the circuit's sequence");
+		packet_sequence_ptr_t sequence = addPeerCircuit();
+		startThread();
+
+		U8 buffer[MAX_BUFFER_SIZE];
+		const TPACKETID packet_id = 42;
+		const U32 value = 0x12345678;
+		S32 size = makePacket(buffer, LL_RELIABLE_FLAG, packet_id, value);
+		sendToThread(buffer, size);
+
+		LLUDPThread::Packet* packetp = waitForPacket();
+		ensure("sender", packetp->mSender == mPeerHost);
+		ensure_equals("true size", packetp->mTrueSize, size);
+		ensure_equals("prepared size", packetp->mSize, size);
+		ensure_equals("not zero coded", packetp->mCompressedSize, 0);
+		ensure("acked", packetp->mAcked);
+		ensure_memory_matches("contents", packetp->mData, size, buffer, size);
+		mThread->popPacket();
+		ensure("queue empty", mThread->peekPacket() == NULL);
+
+		U8 ack[MAX_BUFFER_SIZE];
+		S32 ack_size = receiveAck(ack, 5.f);
+		// header, low frequency number, block count, one id
+		ensure_equals("PacketAck size", ack_size, PHL_NAME + 4 + 1 + 4);
+		ensure_equals("unreliable", ack[PHL_FLAGS], (U8)0);
+		ensure_equals("first id of the circuit", ntohl(*((U32*)&ack[PHL_PACKET_ID])), (U32)1);
+		ensure_equals("message number", ntohl(*((U32*)&ack[PHL_NAME])), PACKET_ACK_NUMBER);
+		ensure_equals("block count", ack[PHL_NAME + 4], (U8)1);
+		U32 acked_id = 0;
+		htolememcpy(&acked_id, &ack[PHL_NAME + 5], MVT_U32, 4);
+		ensure_equals("acked id", acked_id, packet_id);
+
+		// the main thread numbers its next packet after the ack
+		ensure_equals("sequence shared", sequence->CurrentValue(), (U32)1);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("zero coded unreliable message is expanded, not acked");
+		addPeerCircuit();
+		startThread();
+
+		U8 buffer[MAX_BUFFER_SIZE];
+		S32 size = makePacket(buffer, LL_ZERO_CODE_FLAG, 7, 0);
+		sendToThread(buffer, size);
+
+		LLUDPThread::Packet* packetp = waitForPacket();
+		ensure_equals("compressed size", packetp->mCompressedSize, size);
+		ensure_equals("expanded size", packetp->mSize, PHL_NAME + 5);
+		ensure_equals("flag cleared", packetp->mData[PHL_FLAGS], (U8)0);
+		ensure_equals("message number", packetp->mData[PHL_NAME], (U8)TEST_MESSAGE_NUMBER);
+		U32 value = 1;
+		htolememcpy(&value, &packetp->mData[PHL_NAME + 1], MVT_U32, 4);
+		ensure_equals("value", value, (U32)0);
+		ensure("not acked", !packetp->mAcked);
+		mThread->popPacket();
+
+		U8 ack[MAX_BUFFER_SIZE];
+		ensure_equals("no PacketAck", receiveAck(ack, 0.2f), 0);
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("appended acks stripped, no ack without a circuit");
+		startThread();
+
+		U8 buffer[MAX_BUFFER_SIZE];
+		S32 size = makePacket(buffer, LL_RELIABLE_FLAG | LL_ACK_FLAG, 9, 3);
+		S32 message_size = size;
+		for (TPACKETID id = 1; id <= 2; ++id)
+		{
+			*((U32*)&buffer[size]) = htonl(id);
+			size += sizeof(TPACKETID);
+		}
+		buffer[size++] = 2;
+		sendToThread(buffer, size);
+
+		LLUDPThread::Packet* packetp = waitForPacket();
+		ensure_equals("true size", packetp->mTrueSize, size);
+		ensure_equals("prepared size", packetp->mSize, message_size);
+		ensure("no circuit, not acked", !packetp->mAcked);
+		mThread->popPacket();
+
+		LLUDPThread::Stats stats;
+		mThread->getStats(stats);
+		ensure_equals("received", stats.mPacketsReceived, (U32)1);
+		ensure_equals("acked", stats.mPacketsAcked, (U32)0);
+	}
+}
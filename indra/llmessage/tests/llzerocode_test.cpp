@@ -0,0 +1,296 @@
+/**
+ * @file   llzerocode_test.cpp
+ * @brief  Test for zero coding of template message bodies.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llzerocode.h"
+
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+#include "../test/testrand.h"
+
+namespace tut
+{
+	// NET_BUFFER_SIZE less the packet header
+	const S32 BODY_SIZE = 0x2000 - 6;
+	const S32 FUZZ_COUNT = 20000;
+	const S32 BENCHMARK_PASSES = 2000;
+
+	struct LLZeroCodeData
+	{
+		LLTestRand mRand;
+		U8 mIn[BODY_SIZE];
+		U8 mOut[2 * BODY_SIZE];
+		U8 mRefOut[2 * BODY_SIZE];
+		U8 mRoundTrip[BODY_SIZE];
+
+		LLZeroCodeData()
+		:	mRand(12345)
+		{
+		}
+
+		// body with about zero_percent zero bytes, in runs up to max_run
+		void makeBody(U8* body, S32 size, U32 zero_percent, U32 max_run)
+		{
+			S32 i = 0;
+			while (i < size)
+			{
+				if (mRand.rand(100) < zero_percent)
+				{
+					S32 run = llmin((S32)(1 + mRand.rand(max_run)), size - i);
+					memset(body + i, 0, run);
+					i += run;
+				}
+				else
+				{
+					body[i++] = (U8)(1 + mRand.rand(255));
+				}
+			}
+		}
+
+		// The byte at a time encoder the message system used to have
+		static S32 referenceEncode(const U8* in, S32 in_size, U8* out)
+		{
+			const U8* inptr = in;
+			U8* outptr = out;
+			U8 num_zeroes = 0;
+			S32 count = in_size;
+			while (count--)
+			{
+				if (!(*inptr))
+				{
+					if (num_zeroes)
+					{
+						if (++num_zeroes > 254)
+						{
+							*outptr++ = num_zeroes;
+							num_zeroes = 0;
+						}
+					}
+					else
+					{
+						*outptr++ = 0;
+						num_zeroes = 1;
+					}
+					inptr++;
+				}
+				else
+				{
+					if (num_zeroes)
+					{
+						*outptr++ = num_zeroes;
+						num_zeroes = 0;
+					}
+					*outptr++ = *inptr++;
+				}
+			}
+			if (num_zeroes)
+			{
+				*outptr++ = num_zeroes;
+			}
+			return (S32)(outptr - out);
+		}
+
+		// The byte at a time decoder the message system used to have,
+		// returning -1 where it used to report a buffer overrun
+		static S32 referenceExpand(const U8* in, S32 in_size, U8* out, S32 out_size)
+		{
+			const U8* inptr = in;
+			U8* outptr = out;
+			S32 count = in_size;
+			while (count--)
+			{
+				if (outptr > &out[out_size - 1])
+				{
+					return -1;
+				}
+				if (!((*outptr++ = *inptr++)))
+				{
+					while (((count--)) && (!(*inptr)))
+					{
+						*outptr++ = *inptr++;
+						if (outptr > &out[out_size - 256])
+						{
+							return -1;
+						}
+						memset(outptr, 0, 255);
+						outptr += 255;
+					}
+					if (count < 0)
+					{
+						break;
+					}
+					if (outptr > &out[out_size - (*inptr)])
+					{
+						return -1;
+					}
+					memset(outptr, 0, (*inptr) - 1);
+					outptr += ((*inptr) - 1);
+					inptr++;
+				}
+			}
+			return (S32)(outptr - out);
+		}
+	};
+
+	typedef test_group<LLZeroCodeData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory llzerocode_test_factory("LLZeroCode");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("known encodings");
+		const U8 body[] = { 1, 0, 0, 0, 2 };
+		const U8 encoded[] = { 1, 0, 3, 2 };
+		ensure_equals("encoded size", ll_zero_code_encoded_size(body, sizeof(body)), (S32)sizeof(encoded));
+		ensure_equals("encode", ll_zero_code_encode(body, sizeof(body), mOut), (S32)sizeof(encoded));
+		ensure_memory_matches("encoded", mOut, sizeof(encoded), encoded, sizeof(encoded));
+		ensure_equals("expand", ll_zero_code_expand(encoded, sizeof(encoded), mRoundTrip, BODY_SIZE), (S32)sizeof(body));
+		ensure_memory_matches("expanded", mRoundTrip, sizeof(body), body, sizeof(body));
+
+		// long runs are split at 255
+		memset(mIn, 0, 300);
+		const U8 split[] = { 0, 255, 0, 45 };
+		ensure_equals("split size", ll_zero_code_encode(mIn, 300, mOut), (S32)sizeof(split));
+		ensure_memory_matches("split", mOut, sizeof(split), split, sizeof(split));
+
+		// the old wrapped encoding: 1 + 256 + 4 zeros
+		const U8 wrapped[] = { 7, 0, 0, 5, 9 };
+		ensure_equals("wrapped size", ll_zero_code_expand(wrapped, sizeof(wrapped), mRoundTrip, BODY_SIZE), 263);
+		ensure_equals("wrapped first", mRoundTrip[0], (U8)7);
+		ensure_equals("wrapped last", mRoundTrip[262], (U8)9);
+		for (S32 i = 1; i < 262; ++i)
+		{
+			ensure_equals("wrapped zeros", mRoundTrip[i], (U8)0);
+		}
+
+		// a trailing zero without a count
+		const U8 trailing[] = { 3, 0 };
+		ensure_equals("trailing size", ll_zero_code_expand(trailing, sizeof(trailing), mRoundTrip, BODY_SIZE), 2);
+		ensure_equals("trailing zero", mRoundTrip[1], (U8)0);
+
+		ensure_equals("empty", ll_zero_code_encode(mIn, 0, mOut), 0);
+		ensure_equals("empty expand", ll_zero_code_expand(mIn, 0, mRoundTrip, BODY_SIZE), 0);
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("encode fuzz against the byte at a time encoder");
+		for (S32 i = 0; i < FUZZ_COUNT; ++i)
+		{
+			// A run may not end on the last byte of the output, as with
+			// the old decoder, so leave one spare.
+			S32 size = (i % 4) ? (S32)mRand.rand(200) : (S32)mRand.rand(BODY_SIZE);
+			makeBody(mIn, size, mRand.rand(101), 1 + mRand.rand((i % 8) ? 20 : 600));
+
+			S32 ref_size = referenceEncode(mIn, size, mRefOut);
+			S32 encoded_size = ll_zero_code_encode(mIn, size, mOut);
+			ensure_equals("encoded size", encoded_size, ref_size);
+			ensure_memory_matches("encoded", mOut, encoded_size, mRefOut, ref_size);
+			ensure_equals("predicted size", ll_zero_code_encoded_size(mIn, size), ref_size);
+
+			S32 expanded_size = ll_zero_code_expand(mOut, encoded_size, mRoundTrip, BODY_SIZE);
+			ensure_equals("round trip size", expanded_size, size);
+			ensure_memory_matches("round trip", mRoundTrip, expanded_size, mIn, size);
+		}
+	}
+
+	template<> template<>
+	void object::test<3>()
+	{
+		set_test_name("expand fuzz against the byte at a time decoder");
+		for (S32 i = 0; i < FUZZ_COUNT; ++i)
+		{
+			// arbitrary input, zero heavy, with output buffers small
+			// enough for the overrun checks to trigger
+			S32 size = 1 + (S32)mRand.rand(400);
+			makeBody(mIn, size, mRand.rand(60), 1 + mRand.rand(3));
+			S32 out_size = 300 + (S32)mRand.rand(BODY_SIZE - 300);
+
+			S32 ref_size = referenceExpand(mIn, size, mRefOut, out_size);
+			S32 expanded_size = ll_zero_code_expand(mIn, size, mOut, out_size);
+			ensure_equals("expanded size", expanded_size, ref_size);
+			if (ref_size > 0)
+			{
+				ensure_memory_matches("expanded", mOut, expanded_size, mRefOut, ref_size);
+			}
+		}
+	}
+
+	template<> template<>
+	void object::test<4>()
+	{
+		set_test_name("zero coding throughput");
+		// an ObjectUpdate sized body, about a third zeros in short runs
+		const S32 size = 1200;
+		makeBody(mIn, size, 35, 6);
+		S32 encoded_size = referenceEncode(mIn, size, mRefOut);
+		memcpy(mOut, mRefOut, encoded_size);
+
+		LLTimer timer;
+		for (S32 i = 0; i < BENCHMARK_PASSES; ++i)
+		{
+			referenceExpand(mOut, encoded_size, mRoundTrip, BODY_SIZE);
+		}
+		F64 reference_expand = timer.getElapsedTimeF64();
+		timer.reset();
+		for (S32 i = 0; i < BENCHMARK_PASSES; ++i)
+		{
+			ll_zero_code_expand(mOut, encoded_size, mRoundTrip, BODY_SIZE);
+		}
+		F64 expand = timer.getElapsedTimeF64();
+		ensure_memory_matches("expanded", mRoundTrip, size, mIn, size);
+
+		timer.reset();
+		for (S32 i = 0; i < BENCHMARK_PASSES; ++i)
+		{
+			referenceEncode(mIn, size, mRefOut);
+		}
+		F64 reference_encode = timer.getElapsedTimeF64();
+		timer.reset();
+		for (S32 i = 0; i < BENCHMARK_PASSES; ++i)
+		{
+			ll_zero_code_encode(mIn, size, mOut);
+		}
+		F64 encode = timer.getElapsedTimeF64();
+
+		const F64 megabytes = (F64)size * BENCHMARK_PASSES / 1e6;
+		LL_INFOS() << "zero code expand: " << megabytes / llmax(expand, 1e-9) << " MB/s, byte at a time "
+				   << megabytes / llmax(reference_expand, 1e-9) << " MB/s" << LL_ENDL;
+		LL_INFOS() << "zero code encode: " << megabytes / llmax(encode, 1e-9) << " MB/s, byte at a time "
+				   << megabytes / llmax(reference_encode, 1e-9) << " MB/s" << LL_ENDL;
+	}
+}
@@ -0,0 +1,147 @@
+/**
+ * @file   patch_idct_test.cpp
+ * @brief  Test for the terrain patch inverse DCT kernels.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmath.h"
+#include "../patch_dct.h"
+
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	const S32 BENCHMARK_PASSES = 2000;
+	const EPatchIDCTKernel KERNELS[] = { PATCH_IDCT_SCALAR, PATCH_IDCT_SSE2, PATCH_IDCT_AVX };
+	const char* KERNEL_NAMES[] = { "scalar", "SSE2", "AVX" };
+
+	struct PatchIDCTData
+	{
+		EPatchIDCTKernel mDefaultKernel;
+		F32 mHeights[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+		S32 mCoefficients[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+		LLPatchHeader mHeader;
+
+		PatchIDCTData()
+		{
+			mDefaultKernel = get_patch_idct_kernel();
+		}
+
+		~PatchIDCTData()
+		{
+			set_patch_idct_kernel(mDefaultKernel);
+		}
+
+		// rolling terrain, compressed as the simulator does
+		void compress(S32 size, S32 prequant)
+		{
+			for (S32 j = 0; j < size; j++)
+			{
+				for (S32 i = 0; i < size; i++)
+				{
+					mHeights[j*size + i] = 20.f + 4.f*sinf(i*0.2f) + 3.f*cosf(j*0.15f);
+				}
+			}
+
+			F32 zmax, zmin;
+			init_patch_compressor(size, size, 'L');
+			prescan_patch(mHeights, &mHeader, zmax, zmin);
+			compress_patch(mHeights, mCoefficients, &mHeader, prequant);
+		}
+	};
+	typedef test_group<PatchIDCTData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory patch_idct_test_factory("PatchIDCT");
+}
+
+namespace tut
+{
+	template<> template<>
+	void object::test<1>()
+	{
+		set_test_name("kernels match the scalar IDCT and round trip terrain");
+		for (S32 size = NORMAL_PATCH_SIZE; size <= LARGE_PATCH_SIZE; size += NORMAL_PATCH_SIZE)
+		{
+			compress(size, size == NORMAL_PATCH_SIZE ? 8 : 10);
+
+			F32 reference[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+			ensure("scalar kernel", set_patch_idct_kernel(PATCH_IDCT_SCALAR));
+			decompress_patch(reference, mCoefficients, &mHeader, size, size);
+			for (S32 i = 0; i < size*size; i++)
+			{
+				ensure_approximately_equals("round trip", reference[i], mHeights[i], 2);
+			}
+
+			for (S32 k = 1; k < (S32)LL_ARRAY_SIZE(KERNELS); k++)
+			{
+				if (!set_patch_idct_kernel(KERNELS[k]))
+				{
+					continue;
+				}
+
+				// rows further apart than the patch, as on a surface
+				const S32 stride = size + 3;
+				F32 out[LARGE_PATCH_SIZE*(LARGE_PATCH_SIZE + 3)];
+				decompress_patch(out, mCoefficients, &mHeader, size, stride);
+				for (S32 j = 0; j < size; j++)
+				{
+					ensure_memory_matches(KERNEL_NAMES[k], out + j*stride, size*sizeof(F32),
+										  reference + j*size, size*sizeof(F32));
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void object::test<2>()
+	{
+		set_test_name("IDCT throughput");
+		compress(NORMAL_PATCH_SIZE, 8);
+
+		F32 out[NORMAL_PATCH_SIZE*NORMAL_PATCH_SIZE];
+		for (S32 k = 0; k < (S32)LL_ARRAY_SIZE(KERNELS); k++)
+		{
+			if (!set_patch_idct_kernel(KERNELS[k]))
+			{
+				continue;
+			}
+
+			LLTimer timer;
+			for (S32 i = 0; i < BENCHMARK_PASSES; ++i)
+			{
+				decompress_patch(out, mCoefficients, &mHeader, NORMAL_PATCH_SIZE, NORMAL_PATCH_SIZE);
+			}
+			F64 elapsed = timer.getElapsedTimeF64();
+			LL_INFOS() << "patch IDCT " << KERNEL_NAMES[k] << ": "
+					   << BENCHMARK_PASSES / llmax(elapsed, 1e-9) << " patches/s" << LL_ENDL;
+		}
+	}
+}
@@ -445,7 +445,7 @@ void AISAPI::FetchItem(const LLUUID &itemId, ITEM_TYPE type, completion_t callba
 	LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
 		_1, getFn, url, itemId, LLSD(), callback, FETCHITEM));
 
-	EnqueueAISCommand("FetchItem", proc);
+	EnqueueAISCommand("FetchItem", proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 /*static*/
@@ -496,7 +496,7 @@ void AISAPI::FetchCategoryChildren(const LLUUID &catId, ITEM_TYPE type, bool rec
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
         _1, getFn, url, catId, body, callback, FETCHCATEGORYCHILDREN));
 
-    EnqueueAISCommand("FetchCategoryChildren", proc);
+    EnqueueAISCommand("FetchCategoryChildren", proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 // some folders can be requested by name, like
@@ -549,7 +549,7 @@ void AISAPI::FetchCategoryChildren(const std::string &identifier, bool recursive
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
         _1, getFn, url, LLUUID::null, body, callback, FETCHCATEGORYCHILDREN));
 
-    EnqueueAISCommand("FetchCategoryChildren", proc);
+    EnqueueAISCommand("FetchCategoryChildren", proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 /*static*/
@@ -600,7 +600,7 @@ void AISAPI::FetchCategoryCategories(const LLUUID &catId, ITEM_TYPE type, bool r
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
         _1, getFn, url, catId, body, callback, FETCHCATEGORYCATEGORIES));
 
-    EnqueueAISCommand("FetchCategoryCategories", proc);
+    EnqueueAISCommand("FetchCategoryCategories", proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 void AISAPI::FetchCategorySubset(const LLUUID& catId,
@@ -677,7 +677,7 @@ void AISAPI::FetchCategorySubset(const LLUUID& catId,
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro,
                                                          _1, getFn, url, catId, body, callback, FETCHCATEGORYSUBSET));
 
-    EnqueueAISCommand("FetchCategorySubset", proc);
+    EnqueueAISCommand("FetchCategorySubset", proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 /*static*/
@@ -751,7 +751,7 @@ void AISAPI::FetchCategoryLinks(const LLUUID &catId, completion_t callback)
     LLCoprocedureManager::CoProcedure_t proc(
         boost::bind(&AISAPI::InvokeAISCommandCoro, _1, getFn, url, LLUUID::null, body, callback, FETCHCATEGORYLINKS));
 
-    EnqueueAISCommand("FetchCategoryLinks", proc);
+    EnqueueAISCommand("FetchCategoryLinks", proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 /*static*/
@@ -784,18 +784,21 @@ void AISAPI::FetchOrphans(completion_t callback)
     LLCoprocedureManager::CoProcedure_t proc(boost::bind(&AISAPI::InvokeAISCommandCoro ,
                                                          _1 , getFn , url , LLUUID::null , LLSD() , callback , FETCHORPHANS));
 
-    EnqueueAISCommand("FetchOrphans" , proc);
+    EnqueueAISCommand("FetchOrphans" , proc, LLCoprocedureManager::PRIORITY_LOW);
 }
 
 /*static*/
-void AISAPI::EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc)
+void AISAPI::EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc,
+                               LLCoprocedureManager::EPriority priority)
 {
     LLCoprocedureManager &inst = LLCoprocedureManager::instance();
     S32 pending_in_pool = inst.countPending("AIS");
     std::string procFullName = "AIS(" + procName + ")";
-    if (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES)
+    if (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES || priority > LLCoprocedureManager::PRIORITY_LOW)
     {
-        inst.enqueueCoprocedure("AIS", procFullName, proc);
+        // Only fetches wait out here, anything else goes straight in
+        // and the pool runs it ahead of them
+        inst.enqueueCoprocedure("AIS", procFullName, proc, priority);
     }
     else
     {
@@ -824,7 +827,7 @@ void AISAPI::onIdle(void *userdata)
         while (pending_in_pool < MAX_SIMULTANEOUS_COROUTINES && !sPostponedQuery.empty())
         {
             ais_query_item_t &item = sPostponedQuery.front();
-            inst.enqueueCoprocedure("AIS", item.first, item.second);
+            inst.enqueueCoprocedure("AIS", item.first, item.second, LLCoprocedureManager::PRIORITY_LOW);
             sPostponedQuery.pop_front();
             pending_in_pool++;
         }
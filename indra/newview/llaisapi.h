@@ -92,7 +92,10 @@ private:
     typedef boost::function < LLSD (LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t, LLCore::HttpRequest::ptr_t,
         const std::string, LLSD, LLCore::HttpOptions::ptr_t, LLCore::HttpHeaders::ptr_t) > invokationFn_t;
 
-    static void EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc);
+    // Background fetches go in at low priority so they don't hold up
+    // edits and appearance updates queued behind them
+    static void EnqueueAISCommand(const std::string &procName, LLCoprocedureManager::CoProcedure_t proc,
+                                  LLCoprocedureManager::EPriority priority = LLCoprocedureManager::PRIORITY_NORMAL);
     static void onIdle(void *userdata); // launches postponed AIS commands
     static void onUpdateReceived(const LLSD& update, COMMAND_TYPE type, const LLSD& request_body);
 
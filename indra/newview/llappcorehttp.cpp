@@ -29,8 +29,10 @@
 #include "llappcorehttp.h"
 
 #include "llappviewer.h"
+#include "llcallbacklist.h"
 #include "llviewercontrol.h"
 #include "llexception.h"
+#include "llfile.h"
 #include "stringize.h"
 
 #include <openssl/x509_vfy.h>
@@ -63,64 +65,66 @@ static const struct
 	U32							mMax;
 	U32							mRate;
 	bool						mPipelined;
+	U32							mStreams;		// HTTP/2 streams per connection, 0 for none
+	U32							mAdaptive;		// Adaptive in-flight ceiling, 0 for fixed limits
 	std::string					mKey;
 	const char *				mUsage;
 } init_data[LLAppCoreHttp::AP_COUNT] =
 {
 	{ // AP_DEFAULT
-		8,		8,		8,		0,		false,
+		8,		8,		8,		0,		false,		0,		0,
 		"",
 		"other"
 	},
 	// <FS:Beq> Avoid stall in texture fetch due to asset fetching. [Drake]
 	{ // AP_ASSET
-		12,		1,		16,		0,		true,
+		12,		1,		16,		0,		true,		8,		64,
 		"AssetFetchConcurrency",
 		"asset fetch"
 	},
 	// </FS:Beq>
 	{ // AP_TEXTURE
-		8,		1,		12,		0,		true,
+		8,		1,		12,		0,		true,		32,		64,
 		"TextureFetchConcurrency",
 		"texture fetch"
 	},
 	{ // AP_MESH1
-		32,		1,		128,	0,		false,
+		32,		1,		128,	0,		false,		0,		128,
 		"MeshMaxConcurrentRequests",
 		"mesh fetch"
 	},
 	{ // AP_MESH2
-		8,		1,		32,		0,		true,	
+		8,		1,		32,		0,		true,		16,		64,
 		"Mesh2MaxConcurrentRequests",
 		"mesh2 fetch"
 	},
 	{ // AP_LARGE_MESH
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,		0,		0,
 		"",
 		"large mesh fetch"
 	},
 	{ // AP_UPLOADS 
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,		0,		0,
 		"",
 		"asset upload"
 	},
 	{ // AP_LONG_POLL
-		32,		32,		32,		0,		false,
+		32,		32,		32,		0,		false,		0,		0,
 		"",
 		"long poll"
 	},
 	{ // AP_INVENTORY
-		4,		1,		4,		0,		false,
+		4,		1,		4,		0,		false,		0,		0,
 		"",
 		"inventory"
 	},
 	{ // AP_MATERIALS
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,		0,		0,
 		"RenderMaterials",
 		"material manager requests"
 	},
 	{ // AP_AGENT
-		2,		1,		32,		0,		false,
+		2,		1,		32,		0,		false,		0,		0,
 		"Agent",
 		"Agent requests"
 	}
@@ -142,6 +146,7 @@ LLAppCoreHttp::LLAppCoreHttp()
 	  mStopHandle(LLCORE_HTTP_HANDLE_INVALID),
 	  mStopRequested(0.0),
 	  mStopped(false),
+	  mWarmupPending(0),
 	  mPipelined(true)
 {}
 
@@ -238,6 +243,51 @@ void LLAppCoreHttp::init()
 															LLCore::HttpRequest::GLOBAL_POLICY_ID,
 															trace_level, NULL);
 	}
+
+	// Let duplicate GETs from different subsystems share one download
+	status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_COALESCE_REQUESTS,
+														LLCore::HttpRequest::GLOBAL_POLICY_ID,
+														gSavedSettings.getBOOL("HttpCoalesceRequests") ? 1L : 0L,
+														NULL);
+	if (! status)
+	{
+		LL_WARNS("Init") << "Failed to set HTTP request coalescing.  Reason:  " << status.toString()
+						 << LL_ENDL;
+	}
+
+	// DNS and TLS session caches are always shared between classes,
+	// open connections only if asked.
+	status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_SHARE_CONNECTIONS,
+														LLCore::HttpRequest::GLOBAL_POLICY_ID,
+														gSavedSettings.getBOOL("HttpShareConnections") ? 1L : 0L,
+														NULL);
+	if (! status)
+	{
+		LL_WARNS("Init") << "Failed to set HTTP connection sharing.  Reason:  " << status.toString()
+						 << LL_ENDL;
+	}
+
+	// Keep TLS sessions over restarts so the first connections
+	// after login can resume rather than handshake from scratch.
+	// The file holds session secrets, so drop any left behind once
+	// the option is turned off.
+	const std::string tls_session_file(gDirUtilp->getExpandedFilename(LL_PATH_USER_SETTINGS, "tls_sessions.dat"));
+	if (gSavedSettings.getBOOL("HttpPersistTlsSessions"))
+	{
+		status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_TLS_SESSION_FILE,
+															LLCore::HttpRequest::GLOBAL_POLICY_ID,
+															tls_session_file,
+															NULL);
+		if (! status)
+		{
+			LL_WARNS("Init") << "Failed to set TLS session file.  Reason:  " << status.toString()
+							 << LL_ENDL;
+		}
+	}
+	else
+	{
+		LLFile::remove(tls_session_file, ENOENT);
+	}
 	
 	// Setup default policy and constrain if directed to
 	mHttpClasses[AP_DEFAULT].mPolicy = LLCore::HttpRequest::DEFAULT_POLICY_ID;
@@ -313,16 +363,6 @@ void LLAppCoreHttp::init()
 }
 
 
-void setting_changed()
-{
-	LLAppViewer::instance()->getAppCoreHttp().refreshSettings(false);
-}
-
-void ssl_verification_changed()
-{
-    LLCore::HttpOptions::setDefaultSSLVerifyPeer(!gSavedSettings.getBOOL("NoVerifySSLCert"));
-}
-
 namespace
 {
     // The NoOpDeletor is used when wrapping LLAppCoreHttp in a smart pointer below for
@@ -337,6 +377,77 @@ namespace
     { /*NoOp*/ }
 }
 
+void LLAppCoreHttp::warmupConnections(const std::string & url)
+{
+	static LLCachedControl<U32> warmup_count(gSavedSettings, "HttpConnectionWarmup", 2);
+	if (! mRequest || mStopped || url.empty() || ! warmup_count)
+	{
+		return;
+	}
+
+	LLCore::HttpOptions::ptr_t options(new LLCore::HttpOptions);
+	options->setHeadersOnly(true);
+	options->setRetries(0);
+	options->setTimeout(15);
+
+	static const EAppPolicy warmup_policies[] = { AP_ASSET, AP_TEXTURE, AP_MESH2 };
+	U32 issued(0);
+	for (int i(0); i < LL_ARRAY_SIZE(warmup_policies); ++i)
+	{
+		const HttpClass & http_class(mHttpClasses[warmup_policies[i]]);
+		const U32 per_class(llmin(U32(warmup_count), http_class.mConnLimit));
+		for (U32 n(0); n < per_class; ++n)
+		{
+			LLCore::HttpHandle handle = mRequest->requestGet(http_class.mPolicy,
+															 0U,
+															 url,
+															 options,
+															 LLCore::HttpHeaders::ptr_t(),
+															 LLCore::HttpHandler::ptr_t(this, NoOpDeletor));
+			if (LLCORE_HTTP_HANDLE_INVALID != handle)
+			{
+				++issued;
+			}
+		}
+	}
+	LL_INFOS("Init") << "Warming up " << issued << " HTTP connections for asset fetches" << LL_ENDL;
+
+	// Nothing else pumps this request queue before shutdown, so
+	// drain the replies from idle until they have all arrived.
+	if (issued && ! mWarmupPending)
+	{
+		gIdleCallbacks.addFunction(warmupIdle, this);
+	}
+	mWarmupPending += issued;
+}
+
+
+// static
+void LLAppCoreHttp::warmupIdle(void * user_data)
+{
+	LLAppCoreHttp * self(static_cast<LLAppCoreHttp *>(user_data));
+	if (self->mRequest && ! self->mStopped)
+	{
+		self->mRequest->update(0);
+	}
+	if (! self->mRequest || self->mStopped || ! self->mWarmupPending)
+	{
+		self->mWarmupPending = 0;
+		gIdleCallbacks.deleteFunction(warmupIdle, user_data);
+	}
+}
+
+
+void setting_changed()
+{
+	LLAppViewer::instance()->getAppCoreHttp().refreshSettings(false);
+}
+
+void ssl_verification_changed()
+{
+    LLCore::HttpOptions::setDefaultSSLVerifyPeer(!gSavedSettings.getBOOL("NoVerifySSLCert"));
+}
+
 void LLAppCoreHttp::requestStop()
 {
 	llassert_always(mRequest);
@@ -351,6 +462,12 @@ void LLAppCoreHttp::requestStop()
 
 void LLAppCoreHttp::cleanup()
 {
+	if (mWarmupPending)
+	{
+		gIdleCallbacks.deleteFunction(warmupIdle, this);
+		mWarmupPending = 0;
+	}
+
     LLCore::HTTPStats::instance().dumpStats();
 
 	if (LLCORE_HTTP_HANDLE_INVALID == mStopHandle)
@@ -425,6 +542,38 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 				}
 			}
 
+			if (init_data[i].mStreams && gSavedSettings.getBOOL("HttpMultiplexing"))
+			{
+				// Ask for HTTP/2, classes fall back to their usual
+				// HTTP/1.1 behavior against servers that don't have it.
+				status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAMS,
+																	mHttpClasses[app_policy].mPolicy,
+																	init_data[i].mStreams,
+																	NULL);
+				if (! status)
+				{
+					LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+									 << " HTTP/2 streams.  Reason:  " << status.toString()
+									 << LL_ENDL;
+				}
+			}
+
+			if (init_data[i].mAdaptive && gSavedSettings.getBOOL("HttpAdaptiveConcurrency"))
+			{
+				// Concurrency settings below become the starting point,
+				// llcorehttp moves the limit from there up to this ceiling.
+				status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_ADAPTIVE_CONCURRENCY,
+																	mHttpClasses[app_policy].mPolicy,
+																	init_data[i].mAdaptive,
+																	NULL);
+				if (! status)
+				{
+					LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+									 << " adaptive concurrency.  Reason:  " << status.toString()
+									 << LL_ENDL;
+				}
+			}
+
 		}
 
 		// Init- or run-time settings.  Must use the queued request API.
@@ -593,7 +742,15 @@ LLCore::HttpStatus LLAppCoreHttp::sslVerify(const std::string &url,
 
 
 
-void LLAppCoreHttp::onCompleted(LLCore::HttpHandle, LLCore::HttpResponse *)
+void LLAppCoreHttp::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse *)
 {
-	mStopped = true;
+	if (handle == mStopHandle)
+	{
+		mStopped = true;
+	}
+	else if (mWarmupPending)
+	{
+		// Connection warmup reply, nothing to do with it.
+		--mWarmupPending;
+	}
 }
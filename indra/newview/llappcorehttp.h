@@ -228,7 +228,8 @@ public:
 	// notification that the stop has completed.
 	void cleanup();
 
-	// Notification when the stop request is complete.
+	// Notification when the stop request or a connection
+	// warmup request is complete.
 	virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response);
 
 	// Retrieve a policy class identifier for desired
@@ -246,9 +247,17 @@ public:
 
 	// Apply initial or new settings from the environment.
 	void refreshSettings(bool initial);
+
+	// Open connections to the asset host ahead of the first
+	// fetches.  Issues 'HttpConnectionWarmup' headers-only requests
+	// to 'url' in each of the asset, texture and mesh classes.
+	void warmupConnections(const std::string & url);
 	
 private:
 	static const F64			MAX_THREAD_WAIT_TIME;
+
+	// Idle callback pumping mRequest while warmup replies are outstanding.
+	static void warmupIdle(void * user_data);
 	
 private:
 
@@ -269,6 +278,7 @@ private:
 	LLCore::HttpHandle			mStopHandle;
 	F64							mStopRequested;
 	bool						mStopped;
+	U32							mWarmupPending;			// Warmup requests without a reply yet
 	HttpClass					mHttpClasses[AP_COUNT];
 	bool						mPipelined;				// Global setting
 	boost::signals2::connection	mPipelinedSignal;		// Signal for 'HttpPipelining' setting
@@ -2277,6 +2277,11 @@ bool LLAppViewer::cleanup()
 	//#endif // LL_WINDOWS
 
 	LLVolumeMgr* volume_manager = LLPrimitive::getVolumeManager();
+	LLVolumeMgr::Stats volume_stats;
+	volume_manager->getStats(volume_stats);
+	LL_INFOS() << "Volume cache: " << volume_stats.mHits << " hits, " << volume_stats.mMisses << " misses, "
+			   << volume_stats.mEvictions << " evictions, " << volume_stats.mDedupeHits << " duplicates dropped ("
+			   << volume_stats.mDedupeBytes << " bytes)" << LL_ENDL;
 	if (!volume_manager->cleanup())
 	{
 		LL_WARNS() << "Remaining references in the volume manager!" << LL_ENDL;
@@ -3445,6 +3450,7 @@ bool LLAppViewer::initConfiguration()
 	//LLVolumeMgr::initClass();
 	LLVolumeMgr* volume_manager = new LLVolumeMgr();
 	volume_manager->useMutex();	// LLApp and LLMutex magic must be manually enabled
+	volume_manager->setMemoryBudget((size_t) gSavedSettings.getU32("RenderVolumeCacheBudget") * 1024 * 1024);
 	LLPrimitive::setVolumeManager(volume_manager);
 
 	// Note: this is where we used to initialize gFeatureManagerp.
@@ -5319,11 +5325,15 @@ void LLAppViewer::saveFinalSnapshot()
 
 void LLAppViewer::loadNameCache()
 {
-	// display names cache
+	// display names cache, fall back to the LLSD one older viewers wrote
 	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
+		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.bin");
+	if (!LLFile::isfile(filename))
+	{
+		filename = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
+	}
 	LL_INFOS("AvNameCache") << filename << LL_ENDL;
-	llifstream name_cache_stream(filename.c_str());
+	llifstream name_cache_stream(filename.c_str(), std::ios::in | std::ios::binary);
 	if(name_cache_stream.is_open())
 	{
 		if ( ! LLAvatarNameCache::getInstance()->importFile(name_cache_stream))
@@ -5349,11 +5359,13 @@ void LLAppViewer::saveNameCache()
 {
 	// display names cache
 	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
-	llofstream name_cache_stream(filename.c_str());
+		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.bin");
+	llofstream name_cache_stream(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
 	if(name_cache_stream.is_open())
 	{
 		LLAvatarNameCache::getInstance()->exportFile(name_cache_stream);
+		// Superseded by the binary cache
+		LLFile::remove(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml"), ENOENT);
     }
 
     // real names cache
@@ -6256,6 +6268,10 @@ void LLAppViewer::disconnectViewer()
 		// cleanupSingleton().
 		LLExperienceCache::instance().cleanup();
 	}
+	if (LLGroupMgr::instanceExists())
+	{
+		LLGroupMgr::instance().savePropertiesCache();
+	}
 
 	// close inventory interface, close all windows
 	LLSidepanelInventory::cleanup();
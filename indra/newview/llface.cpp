@@ -2211,12 +2211,23 @@ BOOL LLFace::getGeometryVolume(const LLVolume& volume,
 			LLVector4a tmp;
 
 			
+			// transform in small batches so the vertex buffer is only ever written to
+			const U32 XFORM_BATCH_SIZE = 64;
+			LLVector4a xform[XFORM_BATCH_SIZE];
+
 			while (src < end)
 			{	
-				mat_vert.affineTransform(*src++, res0);
-				tmp.setSelectWithMask(mask, texIdx, res0);
-				tmp.store4a((F32*) dst);
-				dst += 4;
+				U32 batch = llmin((U32) (end - src), XFORM_BATCH_SIZE);
+				mat_vert.affineTransform(src, xform, batch);
+				src += batch;
+
+				for (U32 i = 0; i < batch; ++i)
+				{
+					tmp.setSelectWithMask(mask, texIdx, xform[i]);
+					tmp.store4a((F32*) dst);
+					dst += 4;
+				}
+				res0 = xform[batch - 1];
 			}
 			
 			while (dst < end_f32)
@@ -2248,16 +2259,7 @@ BOOL LLFace::getGeometryVolume(const LLVolume& volume,
 
 			mVertexBuffer->getNormalStrider(norm, mGeomIndex, mGeomCount, map_range);
 			F32* normals = (F32*) norm.get();
-			LLVector4a* src = vf.mNormals;
-			LLVector4a* end = src+num_vertices;
-			
-			while (src < end)
-			{	
-				LLVector4a normal;
-				mat_normal.rotate(*src++, normal);
-				normal.store4a(normals);
-				normals += 4;
-			}
+			mat_normal.rotate(vf.mNormals, (LLVector4a*) normals, num_vertices);
 
 			if (map_range)
 			{
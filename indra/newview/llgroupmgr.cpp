@@ -65,6 +65,10 @@
 #include <boost/regex.hpp>
 #include "llcorehttputil.h"
 #include "lluiusage.h"
+#include "llcallbacklist.h"
+#include "lldir.h"
+#include "llsdserialize.h"
+#include "llviewernetwork.h"
 
 // [SL:KB] - Patch: Chat-GroupSessionEject | Checked: 2012-02-04 (Catznip-3.2.1)
 #include "llimview.h"
@@ -88,6 +92,10 @@
 
 const U32 MAX_CACHED_GROUPS = 20;
 
+// On-disk group properties
+const size_t MAX_CACHED_GROUP_PROPERTIES = 500;
+const F64 GROUP_PROPERTIES_MAX_AGE = 30.0 * 24.0 * 60.0 * 60.0; // seconds
+
 //
 // LLRoleActionSet
 //
@@ -258,6 +266,7 @@ LLGroupMgrGroupData::LLGroupMgrGroupData(const LLUUID& id) :
 	mRoleDataComplete(false),
 	mRoleMemberDataComplete(false),
 	mGroupPropertiesDataComplete(false),
+	mGroupPropertiesFromCache(false),
 	mPendingRoleMemberRequest(false),
 	mAccessTime(0.0f),
 	mPendingBanRequest(false)
@@ -851,7 +860,9 @@ void LLGroupMgrGroupData::banMemberById(const LLUUID& participant_uuid)
 //
 
 LLGroupMgr::LLGroupMgr():
-    mMemberRequestInFlight(false)
+    mMemberRequestInFlight(false),
+    mPropertiesCacheLoaded(false),
+    mPropertiesCacheDirty(false)
 {
 }
 
@@ -1140,8 +1151,11 @@ void LLGroupMgr::processGroupPropertiesReply(LLMessageSystem* msg, void** data)
 	group_datap->mRoleCount = num_group_roles + 1; // Add the everyone role.
 	
 	group_datap->mGroupPropertiesDataComplete = true;
+	group_datap->mGroupPropertiesFromCache = false;
 	group_datap->mChanged = TRUE;
 
+	LLGroupMgr::getInstance()->cacheGroupProperties(group_datap);
+
     properties_request_map_t::iterator request = LLGroupMgr::getInstance()->mPropRequests.find(group_id);
     if (request != LLGroupMgr::getInstance()->mPropRequests.end())
     {
@@ -1546,6 +1560,146 @@ void LLGroupMgr::addPendingPropertyRequest(const LLUUID& id)
     LLGroupMgr::getInstance()->mPropRequests[id] = gFrameTime;
 }
 
+static std::string group_properties_cache_filename()
+{
+	// Group ids only mean something on the grid they came from
+	const std::string grid_id = utf8str_tolower(LLDir::getScrubbedFileName(LLGridManager::getInstance()->getGridId()));
+	return gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "group_properties." + grid_id + ".llsd");
+}
+
+void LLGroupMgr::loadPropertiesCache()
+{
+	if (mPropertiesCacheLoaded)
+	{
+		return;
+	}
+	mPropertiesCacheLoaded = true;
+
+	std::string filename = group_properties_cache_filename();
+	llifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		return;
+	}
+
+	LLSD data;
+	if (!LLSDSerialize::deserialize(data, file, LLSDSerialize::SIZE_UNLIMITED))
+	{
+		LL_WARNS("GrpMgr") << "Unable to parse " << filename << LL_ENDL;
+		return;
+	}
+
+	F64 oldest = LLDate::now().secondsSinceEpoch() - GROUP_PROPERTIES_MAX_AGE;
+	for (LLSD::map_const_iterator it = data.beginMap(); it != data.endMap(); ++it)
+	{
+		if (it->second["fetched"].asReal() >= oldest)
+		{
+			mPropertiesCache[LLUUID(it->first)] = it->second;
+		}
+	}
+	LL_DEBUGS("GrpMgr") << "Loaded " << mPropertiesCache.size() << " cached group profiles" << LL_ENDL;
+}
+
+void LLGroupMgr::savePropertiesCache()
+{
+	if (!mPropertiesCacheDirty)
+	{
+		return;
+	}
+
+	if (mPropertiesCache.size() > MAX_CACHED_GROUP_PROPERTIES)
+	{
+		// Keep the most recently fetched
+		std::vector<std::pair<F64, LLUUID> > by_age;
+		for (properties_cache_t::const_iterator it = mPropertiesCache.begin(); it != mPropertiesCache.end(); ++it)
+		{
+			by_age.push_back(std::make_pair(it->second["fetched"].asReal(), it->first));
+		}
+		std::sort(by_age.begin(), by_age.end());
+		for (size_t i = 0; i < by_age.size() - MAX_CACHED_GROUP_PROPERTIES; ++i)
+		{
+			mPropertiesCache.erase(by_age[i].second);
+		}
+	}
+
+	LLSD data = LLSD::emptyMap();
+	for (properties_cache_t::const_iterator it = mPropertiesCache.begin(); it != mPropertiesCache.end(); ++it)
+	{
+		data[it->first.asString()] = it->second;
+	}
+
+	llofstream file(group_properties_cache_filename().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+	{
+		LLSDSerialize::serialize(data, file, LLSDSerialize::LLSD_BINARY);
+	}
+	mPropertiesCacheDirty = false;
+}
+
+void LLGroupMgr::cacheGroupProperties(const LLGroupMgrGroupData* group_datap)
+{
+	loadPropertiesCache();
+
+	LLSD& props = mPropertiesCache[group_datap->getID()];
+	props["name"] = group_datap->mName;
+	props["charter"] = group_datap->mCharter;
+	props["show_in_list"] = (bool)group_datap->mShowInList;
+	props["insignia_id"] = group_datap->mInsigniaID;
+	props["founder_id"] = group_datap->mFounderID;
+	props["membership_fee"] = group_datap->mMembershipFee;
+	props["open_enrollment"] = (bool)group_datap->mOpenEnrollment;
+	props["allow_publish"] = (bool)group_datap->mAllowPublish;
+	props["mature_publish"] = (bool)group_datap->mMaturePublish;
+	props["owner_role"] = group_datap->mOwnerRole;
+	props["member_count"] = group_datap->mMemberCount;
+	props["role_count"] = group_datap->mRoleCount;
+	props["fetched"] = LLDate::now().secondsSinceEpoch();
+	mPropertiesCacheDirty = true;
+}
+
+bool LLGroupMgr::applyCachedProperties(const LLUUID& group_id)
+{
+	LLGroupMgrGroupData* group_datap = getGroupData(group_id);
+	if (group_datap
+		&& (group_datap->isGroupPropertiesDataComplete() || group_datap->isGroupPropertiesFromCache()))
+	{
+		return false;
+	}
+	// Only make room for the group when something is waiting to show it,
+	// creating it early could evict another group from mGroups.
+	if (!group_datap
+		&& mObservers.find(group_id) == mObservers.end()
+		&& mParticularObservers.find(group_id) == mParticularObservers.end())
+	{
+		return false;
+	}
+
+	loadPropertiesCache();
+	properties_cache_t::const_iterator it = mPropertiesCache.find(group_id);
+	if (it == mPropertiesCache.end())
+	{
+		return false;
+	}
+
+	const LLSD& props = it->second;
+	group_datap = createGroupData(group_id);
+	group_datap->mName = props["name"].asString();
+	group_datap->mCharter = props["charter"].asString();
+	group_datap->mShowInList = props["show_in_list"].asBoolean();
+	group_datap->mInsigniaID = props["insignia_id"].asUUID();
+	group_datap->mFounderID = props["founder_id"].asUUID();
+	group_datap->mMembershipFee = props["membership_fee"].asInteger();
+	group_datap->mOpenEnrollment = props["open_enrollment"].asBoolean();
+	group_datap->mAllowPublish = props["allow_publish"].asBoolean();
+	group_datap->mMaturePublish = props["mature_publish"].asBoolean();
+	group_datap->mOwnerRole = props["owner_role"].asUUID();
+	group_datap->mMemberCount = props["member_count"].asInteger();
+	group_datap->mRoleCount = props["role_count"].asInteger();
+	group_datap->mGroupPropertiesFromCache = true;
+	group_datap->mChanged = TRUE;
+	return true;
+}
+
 void LLGroupMgr::notifyObservers(LLGroupChange gc)
 {
 	for (group_map_t::iterator gi = mGroups.begin(); gi != mGroups.end(); ++gi)
@@ -1639,6 +1793,13 @@ void LLGroupMgr::sendGroupPropertiesRequest(const LLUUID& group_id)
     }
     LLGroupMgr::getInstance()->addPendingPropertyRequest(group_id);
 
+	// Show what we had last time while the request revalidates it.
+	// Observers hear about it next frame rather than from inside this call.
+	if (applyCachedProperties(group_id))
+	{
+		doOnIdleOneTime([]() { LLGroupMgr::getInstance()->notifyObservers(GC_PROPERTIES); });
+	}
+
 	LLMessageSystem* msg = gMessageSystem;
 	msg->newMessage("GroupProfileRequest");
 	msg->nextBlock("AgentData");
@@ -263,6 +263,9 @@ public:
 	bool isRoleMemberDataComplete() const { return mRoleMemberDataComplete; }
 	bool isGroupPropertiesDataComplete() const { return mGroupPropertiesDataComplete; }
 // [/SL:KB]
+	// Properties were filled in from the on-disk cache and the
+	// GroupProfileRequest reply has not replaced them yet.
+	bool isGroupPropertiesFromCache() const { return mGroupPropertiesFromCache; }
 //	bool isMemberDataComplete() { return mMemberDataComplete; }
 //	bool isRoleDataComplete() { return mRoleDataComplete; }
 //	bool isRoleMemberDataComplete() { return mRoleMemberDataComplete; }
@@ -337,6 +340,7 @@ private:
 	bool				mRoleDataComplete;
 	bool				mRoleMemberDataComplete;
 	bool				mGroupPropertiesDataComplete;
+	bool				mGroupPropertiesFromCache;
 
 	bool				mPendingRoleMemberRequest;
 	F32					mAccessTime;
@@ -445,6 +449,10 @@ public:
 	void clearGroups();
 	void clearGroupData(const LLUUID& group_id);
 
+	// Profiles of groups seen before are kept on disk so that panels
+	// can show them while sendGroupPropertiesRequest() is in flight.
+	void savePropertiesCache();
+
 private:
     void groupMembersRequestCoro(std::string url, LLUUID groupId);
     void processCapGroupMembersRequest(const LLSD& content);
@@ -461,6 +469,10 @@ private:
 	bool hasPendingPropertyRequest(const LLUUID& id);
 	void addPendingPropertyRequest(const LLUUID& id);
 
+	void loadPropertiesCache();
+	void cacheGroupProperties(const LLGroupMgrGroupData* group_datap);
+	bool applyCachedProperties(const LLUUID& group_id);
+
 	typedef std::multimap<LLUUID,LLGroupMgrObserver*> observer_multimap_t;
 	observer_multimap_t mObservers;
 
@@ -471,6 +483,12 @@ private:
 	typedef std::map<LLUUID, U64MicrosecondsImplicit> properties_request_map_t;
 	properties_request_map_t mPropRequests;
 
+	// Group id -> last properties reply, loaded on first request
+	typedef std::map<LLUUID, LLSD> properties_cache_t;
+	properties_cache_t mPropertiesCache;
+	bool mPropertiesCacheLoaded;
+	bool mPropertiesCacheDirty;
+
 	typedef std::set<LLParticularGroupObserver*> observer_set_t;
 	typedef std::map<LLUUID,observer_set_t> observer_map_t;
 	observer_map_t mParticularObservers;
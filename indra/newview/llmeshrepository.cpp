@@ -226,6 +226,8 @@
 //     sHTTPLargeRequestCount          "
 //     sHTTPRetryCount                 "
 //     sHTTPErrorCount                 "
+//     sHTTPMergedCount                "
+//     sHTTPPrefetchCount              "
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
 //     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
@@ -361,6 +363,7 @@ const S32 REQUEST2_LOW_WATER_MIN = 16;
 const S32 REQUEST2_LOW_WATER_MAX = 50;
 
 const U32 LARGE_MESH_FETCH_THRESHOLD = 1U << 21;		// Size at which requests goes to narrow/slow queue
+const U32 MESH_RANGE_MERGE_GAP = 16384;					// Unwanted bytes worth reading to save a GET
 const long SMALL_MESH_XFER_TIMEOUT = 120L;				// Seconds to complete xfer, small mesh downloads
 const long LARGE_MESH_XFER_TIMEOUT = 600L;				// Seconds to complete xfer, large downloads
 
@@ -396,6 +399,8 @@ U32 LLMeshRepository::sHTTPRequestCount = 0;
 U32 LLMeshRepository::sHTTPLargeRequestCount = 0;
 U32 LLMeshRepository::sHTTPRetryCount = 0;
 U32 LLMeshRepository::sHTTPErrorCount = 0;
+U32 LLMeshRepository::sHTTPMergedCount = 0;
+U32 LLMeshRepository::sHTTPPrefetchCount = 0;
 U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
@@ -585,6 +590,7 @@ S32 LLMeshRepoThread::sRequestWaterLevel = 0;
 //     LLMeshSkinInfoHandler
 //     LLMeshDecompositionHandler
 //     LLMeshPhysicsShapeHandler
+//     LLMeshMergedHandler
 //   LLMeshUploadThread
 
 class LLMeshHandlerBase : public LLCore::HttpHandler,
@@ -685,9 +691,10 @@ class LLMeshSkinInfoHandler : public LLMeshHandlerBase
 {
 public:
 	LOG_CLASS(LLMeshSkinInfoHandler);
-	LLMeshSkinInfoHandler(const LLUUID& id, U32 offset, U32 requested_bytes)
+	LLMeshSkinInfoHandler(const LLUUID& id, U32 offset, U32 requested_bytes, bool prefetch = false)
 		: LLMeshHandlerBase(offset, requested_bytes),
-		  mMeshID(id)
+		  mMeshID(id),
+		  mPrefetch(prefetch)
 	{}
 	virtual ~LLMeshSkinInfoHandler();
 
@@ -695,12 +702,17 @@ protected:
 	LLMeshSkinInfoHandler(const LLMeshSkinInfoHandler &);		// Not defined
 	void operator=(const LLMeshSkinInfoHandler &);				// Not defined
 
+	// Prefetches only report failure if a real request has
+	// been folded into them.  Returns true in that case.
+	bool endPrefetch();
+
 public:
 	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
 	virtual void processFailure(LLCore::HttpStatus status);
 
 public:
 	LLUUID mMeshID;
+	bool mPrefetch;
 };
 
 
@@ -756,6 +768,35 @@ public:
 };
 
 
+// Subclass for one GET covering several ranges of the same mesh
+// asset.  Hands each part its slice of the body, or the failure.
+// Parts that never hear back (cancellation) clean up in their own
+// destructors as usual.
+//
+// Thread:  repo
+class LLMeshMergedHandler : public LLMeshHandlerBase
+{
+public:
+	LOG_CLASS(LLMeshMergedHandler);
+	LLMeshMergedHandler(U32 offset, U32 requested_bytes)
+		: LLMeshHandlerBase(offset, requested_bytes)
+	{}
+	virtual ~LLMeshMergedHandler()
+	{}
+
+protected:
+	LLMeshMergedHandler(const LLMeshMergedHandler &);			// Not defined
+	void operator=(const LLMeshMergedHandler &);				// Not defined
+
+public:
+	virtual void processData(LLCore::BufferArray * body, S32 body_offset, U8 * data, S32 data_size);
+	virtual void processFailure(LLCore::HttpStatus status);
+
+public:
+	std::vector<LLMeshHandlerBase::ptr_t> mParts;
+};
+
+
 void log_upload_error(LLCore::HttpStatus status, const LLSD& content,
 					  const char * const stage, const std::string & model_name)
 {
@@ -884,9 +925,12 @@ LLMeshRepoThread::~LLMeshRepoThread()
 {
 	LL_INFOS(LOG_MESH) << "Small GETs issued:  " << LLMeshRepository::sHTTPRequestCount
 					   << ", Large GETs issued:  " << LLMeshRepository::sHTTPLargeRequestCount
+					   << ", GETs saved by merging:  " << LLMeshRepository::sHTTPMergedCount
+					   << ", Skin prefetches:  " << LLMeshRepository::sHTTPPrefetchCount
 					   << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
 					   << LL_ENDL;
 
+	mRangePlan.clear();
 	mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
@@ -1176,6 +1220,13 @@ void LLMeshRepoThread::run()
             }
         }
 
+		// LOD and skin fetches above only planned their ranges, send
+		// them now that requests for the same asset can be merged.
+		if (!mRangePlan.empty())
+		{
+			issuePlannedRanges();
+		}
+
 		// For dev purposes only.  A dynamic change could make this false
 		// and that shouldn't assert.
 		// llassert_always(mHttpRequestSet.size() <= sRequestHighWater);
@@ -1393,8 +1444,157 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
 }
 
 
+void LLMeshRepoThread::planByteRange(const LLUUID & mesh_id, const std::string & url, int legacy_cap_version,
+									 const LLMeshHandlerBase::ptr_t & handler)
+{
+	RangePlan & plan(mRangePlan[mesh_id]);
+	if (plan.mHandlers.empty())
+	{
+		plan.mUrl = url;
+		plan.mLegacyCapVersion = legacy_cap_version;
+	}
+	plan.mHandlers.push_back(handler);
+	mHttpRequestSet.insert(handler);
+}
+
+
+void LLMeshRepoThread::prefetchSkinInfo(const LLUUID & mesh_id, S32 offset, S32 size)
+{
+	range_plan_map::iterator plan(mRangePlan.find(mesh_id));
+	if (plan == mRangePlan.end() || offset < 0)
+	{
+		return;
+	}
+
+	// Only worth it if it shares a GET with something already planned
+	bool adjacent(false);
+	for (const LLMeshHandlerBase::ptr_t & handler : plan->second.mHandlers)
+	{
+		const S32 start(handler->mOffset), end(handler->mOffset + handler->mRequestedBytes);
+		if (offset + size + S32(MESH_RANGE_MERGE_GAP) >= start && offset <= end + S32(MESH_RANGE_MERGE_GAP))
+		{
+			adjacent = true;
+		}
+		if (handler->mOffset == U32(offset))
+		{
+			// Already coming
+			return;
+		}
+	}
+	if (! adjacent)
+	{
+		return;
+	}
+
+	{
+		// Cached skins start with a zlib header, empty reserved space is zeros
+		LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
+		if (file.getSize() >= offset + size)
+		{
+			U8 probe[4] = { 0, 0, 0, 0 };
+			file.seek(offset);
+			file.read(probe, sizeof(probe));
+			if (probe[0] || probe[1] || probe[2] || probe[3])
+			{
+				return;
+			}
+		}
+	}
+
+	{
+		LLMutexLock locker(mMutex);
+		if (! mSkinPrefetches.insert(skin_prefetch_map::value_type(mesh_id, false)).second)
+		{
+			return;
+		}
+	}
+	LLMeshHandlerBase::ptr_t handler(new LLMeshSkinInfoHandler(mesh_id, offset, size, true));
+	plan->second.mHandlers.push_back(handler);
+	mHttpRequestSet.insert(handler);
+	++LLMeshRepository::sHTTPPrefetchCount;
+}
+
+
+namespace
+{
+	bool handler_offset_less(const LLMeshHandlerBase::ptr_t & lhs, const LLMeshHandlerBase::ptr_t & rhs)
+	{
+		return lhs->mOffset < rhs->mOffset;
+	}
+}
+
+void LLMeshRepoThread::issuePlannedRanges()
+{
+	for (range_plan_map::value_type & entry : mRangePlan)
+	{
+		RangePlan & plan(entry.second);
+		std::vector<LLMeshHandlerBase::ptr_t> & handlers(plan.mHandlers);
+		std::sort(handlers.begin(), handlers.end(), handler_offset_less);
+
+		// Walk the ranges in order, extending a run while the next
+		// one starts within the gap and the total stays small.
+		size_t first(0);
+		while (first < handlers.size())
+		{
+			const U32 start(handlers[first]->mOffset);
+			U32 end(start + handlers[first]->mRequestedBytes);
+			size_t last(first);
+			while (last + 1 < handlers.size())
+			{
+				const LLMeshHandlerBase::ptr_t & next(handlers[last + 1]);
+				const U32 next_end(llmax(end, next->mOffset + next->mRequestedBytes));
+				if (next->mOffset > end + MESH_RANGE_MERGE_GAP || next_end - start >= LARGE_MESH_FETCH_THRESHOLD)
+				{
+					break;
+				}
+				end = next_end;
+				++last;
+			}
+
+			LLMeshHandlerBase::ptr_t handler;
+			if (first == last)
+			{
+				handler = handlers[first];
+			}
+			else
+			{
+				boost::shared_ptr<LLMeshMergedHandler> merged(new LLMeshMergedHandler(start, end - start));
+				merged->mParts.assign(handlers.begin() + first, handlers.begin() + last + 1);
+				for (const LLMeshHandlerBase::ptr_t & part : merged->mParts)
+				{
+					mHttpRequestSet.erase(part);
+				}
+				handler = merged;
+				mHttpRequestSet.insert(handler);
+			}
+
+			LLCore::HttpHandle handle = getByteRange(plan.mUrl, plan.mLegacyCapVersion, start, end - start, handler);
+			if (LLCORE_HTTP_HANDLE_INVALID == handle)
+			{
+				// Only expected during shutdown, don't bother retrying
+				LL_WARNS(LOG_MESH) << "HTTP GET request failed for mesh " << entry.first
+								   << ".  Reason:  " << mHttpStatus.toString()
+								   << " (" << mHttpStatus.toTerseString() << ")"
+								   << LL_ENDL;
+				handler->mProcessed = true;
+				handler->processFailure(mHttpStatus);
+				mHttpRequestSet.erase(handler);
+			}
+			else
+			{
+				handler->mHttpHandle = handle;
+				LLMeshRepository::sHTTPMergedCount += U32(last - first);
+			}
+			first = last + 1;
+		}
+	}
+	mRangePlan.clear();
+}
+
+
 bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
 {
+	static LLCachedControl<bool> merge_ranges(gSavedSettings, "MeshMergeRangeRequests", true);
 	
 	if (!mHeaderMutex)
 	{
@@ -1467,7 +1667,22 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
 			constructUrl(mesh_id, &http_url, &legacy_cap_version);
 			// </FS:Ansariel> [UDP Assets]
 
-			if (!http_url.empty())
+			if (!http_url.empty() && can_retry && merge_ranges)
+			{
+				{
+					LLMutexLock locker(mMutex);
+					skin_prefetch_map::iterator prefetch = mSkinPrefetches.find(mesh_id);
+					if (prefetch != mSkinPrefetches.end())
+					{
+						// Already on its way with a LOD, let that answer
+						prefetch->second = true;
+						return true;
+					}
+				}
+				LLMeshHandlerBase::ptr_t handler(new LLMeshSkinInfoHandler(mesh_id, offset, size));
+				planByteRange(mesh_id, http_url, legacy_cap_version, handler);
+			}
+			else if (!http_url.empty())
 			{
                 LLMeshHandlerBase::ptr_t handler(new LLMeshSkinInfoHandler(mesh_id, offset, size));
 				// <FS:Ansariel> [UDP Assets]
@@ -1834,6 +2049,8 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 //return false if failed to get mesh lod.
 bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
 {
+	static LLCachedControl<bool> merge_ranges(gSavedSettings, "MeshMergeRangeRequests", true);
+
 	if (!mHeaderMutex)
 	{
 		return false;
@@ -1858,6 +2075,8 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 		S32 version = header["version"].asInteger();
 		S32 offset = header_size + header[header_lod[lod]]["offset"].asInteger();
 		S32 size = header[header_lod[lod]]["size"].asInteger();
+		S32 skin_offset = header_size + header["skin"]["offset"].asInteger();
+		S32 skin_size = header["skin"]["size"].asInteger();
 		mHeaderMutex->unlock();
 				
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
@@ -1919,6 +2138,17 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh body for ID " << mid << " - was retrieved from the simulator." << LL_ENDL;
 
                 LLMeshHandlerBase::ptr_t handler(new LLMeshLODHandler(mesh_params, lod, offset, size));
+				if (can_retry && merge_ranges)
+				{
+					planByteRange(mesh_id, http_url, legacy_cap_version, handler);
+					if (skin_size > 0 && version <= MAX_MESH_VERSION)
+					{
+						// Rigged mesh, skin info will be wanted too
+						prefetchSkinInfo(mesh_id, skin_offset, skin_size);
+					}
+					return true;
+				}
+
 				// <FS:Ansariel> [UDP Assets]
 				//LLCore::HttpHandle handle = getByteRange(http_url, offset, size, handler);
 				LLCore::HttpHandle handle = getByteRange(http_url, legacy_cap_version, offset, size, handler);
@@ -3187,6 +3417,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 		LLCore::BufferArray * body(response->getBody());
 		S32 body_offset(0);
 		U8 * data(NULL);
+		U8 * owned_data(NULL);
 		S32 data_size(body ? body->size() : 0);
 
 		if (data_size > 0)
@@ -3239,14 +3470,19 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 				goto common_exit;
 			}
 			
-			// *TODO: Try to get rid of data copying and add interfaces
-			// that support BufferArray directly.  Introduce a two-phase
-			// handler, optional first that takes a body, fallback second
-			// that requires a temporary allocation and data copy.
+			// Bodies of known length arrive in a single block so the
+			// handlers can parse and inflate them in place.  Anything
+			// scattered across blocks (chunked replies, oversized
+			// bodies) still needs a temporary allocation and copy.
 			body_offset = mOffset - offset;
-			data = new(std::nothrow) U8[data_size - body_offset];
+			data = static_cast<U8 *>(body->getContiguous(body_offset, data_size - body_offset));
 			if (data)
 			{
+				LLMeshRepository::sBytesReceived += data_size;
+			}
+			else if ((owned_data = new(std::nothrow) U8[data_size - body_offset]))
+			{
+				data = owned_data;
 				body->read(body_offset, (char *) data, data_size - body_offset);
 				LLMeshRepository::sBytesReceived += data_size;
 			}
@@ -3259,7 +3495,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
 
 		processData(body, body_offset, data, data_size - body_offset);
 
-		delete [] data;
+		delete [] owned_data;
 	}
 
 	// Release handler
@@ -3490,11 +3726,35 @@ LLMeshSkinInfoHandler::~LLMeshSkinInfoHandler()
 	if (!mProcessed)
     {
         LL_WARNS(LOG_MESH) << "deleting unprocessed request handler (may be ok on exit)" << LL_ENDL;
+		if (mPrefetch && !LLApp::isExiting() && endPrefetch())
+		{
+			LLMutexLock lock(gMeshRepo.mThread->mMutex);
+			gMeshRepo.mThread->mSkinUnavailableQ.emplace_back(mMeshID);
+		}
     }
 }
 
+bool LLMeshSkinInfoHandler::endPrefetch()
+{
+	LLMutexLock lock(gMeshRepo.mThread->mMutex);
+	LLMeshRepoThread::skin_prefetch_map::iterator iter = gMeshRepo.mThread->mSkinPrefetches.find(mMeshID);
+	if (iter == gMeshRepo.mThread->mSkinPrefetches.end())
+	{
+		return false;
+	}
+	bool requested = iter->second;
+	gMeshRepo.mThread->mSkinPrefetches.erase(iter);
+	return requested;
+}
+
 void LLMeshSkinInfoHandler::processFailure(LLCore::HttpStatus status)
 {
+	if (mPrefetch && !endPrefetch())
+	{
+		// Nobody asked for it yet, a later request will fetch it again
+		return;
+	}
+
 	LL_WARNS(LOG_MESH) << "Error during mesh skin info handling.  ID:  " << mMeshID
 					   << ", Reason:  " << status.toString()
 					   << " (" << status.toTerseString() << ").  Not retrying."
@@ -3506,6 +3766,9 @@ void LLMeshSkinInfoHandler::processFailure(LLCore::HttpStatus status)
 void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
 										U8 * data, S32 data_size)
 {
+	// Delivered skin info satisfies any request folded into a prefetch
+	bool requested(!mPrefetch || endPrefetch());
+
 	if ((!MESH_SKIN_INFO_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
 		&& gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
@@ -3531,8 +3794,11 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
 		LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mMeshID
 						   << ", Unknown reason.  Not retrying."
 						   << LL_ENDL;
-		LLMutexLock lock(gMeshRepo.mThread->mMutex);
-		gMeshRepo.mThread->mSkinUnavailableQ.emplace_back(mMeshID);
+		if (requested)
+		{
+			LLMutexLock lock(gMeshRepo.mThread->mMutex);
+			gMeshRepo.mThread->mSkinUnavailableQ.emplace_back(mMeshID);
+		}
 	}
 }
 
@@ -3635,6 +3901,35 @@ void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S3
 	}
 }
 
+void LLMeshMergedHandler::processFailure(LLCore::HttpStatus status)
+{
+	for (const LLMeshHandlerBase::ptr_t & part : mParts)
+	{
+		part->mProcessed = true;
+		part->processFailure(status);
+	}
+}
+
+void LLMeshMergedHandler::processData(LLCore::BufferArray * body, S32 body_offset,
+									  U8 * data, S32 data_size)
+{
+	for (const LLMeshHandlerBase::ptr_t & part : mParts)
+	{
+		const S32 part_offset(part->mOffset - mOffset);
+		part->mProcessed = true;
+		if (data && part_offset + S32(part->mRequestedBytes) <= data_size)
+		{
+			part->processData(body, body_offset + part_offset, data + part_offset, part->mRequestedBytes);
+		}
+		else
+		{
+			LL_WARNS(LOG_MESH) << "Merged mesh response too short for part at offset " << part->mOffset
+							   << ", size " << part->mRequestedBytes << LL_ENDL;
+			part->processFailure(LLCore::HttpStatus(LLCore::HttpStatus::LLCORE, LLCore::HE_INV_CONTENT_RANGE_HDR));
+		}
+	}
+}
+
 LLMeshRepository::LLMeshRepository()
 : mMeshMutex(NULL),
   mDecompThread(NULL),
@@ -194,6 +194,8 @@ private:
     LLFrameTimer mTimer;
 };
 
+class LLMeshHandlerBase;
+
 class LLMeshRepoThread : public LLThread
 {
 public:
@@ -328,6 +330,23 @@ public:
 	typedef std::set<LLCore::HttpHandler::ptr_t> http_request_set;
 	http_request_set					mHttpRequestSet;			// Outstanding HTTP requests
 
+	// Ranged GETs for one mesh asset collected during a pass of run()
+	// so that neighbouring LOD and skin blocks go out as one request.
+	// Handlers are already counted in mHttpRequestSet.
+	struct RangePlan
+	{
+		std::string mUrl;
+		int mLegacyCapVersion;
+		std::vector<boost::shared_ptr<LLMeshHandlerBase> > mHandlers;
+	};
+	typedef boost::unordered_map<LLUUID, RangePlan> range_plan_map;
+	range_plan_map						mRangePlan;					// Repo thread only
+
+	// Skin info fetched along with a LOD before anyone asked for it.
+	// Value is true once a real request has been folded into it.
+	typedef boost::unordered_map<LLUUID, bool> skin_prefetch_map;
+	skin_prefetch_map					mSkinPrefetches;			// Protected by mMutex
+
 	// <FS:Ansariel> [UDP Assets]
 	std::string mLegacyGetMeshCapability;
 	std::string mLegacyGetMesh2Capability;
@@ -407,6 +426,21 @@ private:
 	// </FS:Ansariel> [UDP Assets]
 									size_t offset, size_t len, 
 									const LLCore::HttpHandler::ptr_t &handler);
+
+	// Hold a ranged GET until the end of the current pass so it can
+	// be merged with others for the same asset.  Issued (or failed)
+	// by issuePlannedRanges().
+	//
+	// Threads:  Repo thread only
+	void planByteRange(const LLUUID & mesh_id, const std::string & url, int legacy_cap_version,
+					   const boost::shared_ptr<LLMeshHandlerBase> & handler);
+	void issuePlannedRanges();
+
+	// Add a rigged mesh's skin info to a planned LOD fetch when it sits
+	// close enough to ride along.
+	//
+	// Threads:  Repo thread only
+	void prefetchSkinInfo(const LLUUID & mesh_id, S32 offset, S32 size);
 };
 
 
@@ -569,6 +603,8 @@ public:
 	static U32 sHTTPLargeRequestCount;			// Http GETs issued for large requests
 	static U32 sHTTPRetryCount;					// Total request retries whether successful or failed
 	static U32 sHTTPErrorCount;					// Requests ending in error
+	static U32 sHTTPMergedCount;				// Http GETs saved by merging ranges of one asset
+	static U32 sHTTPPrefetchCount;				// Skin info blocks fetched along with a LOD
 	static U32 sLODPending;
 	static U32 sLODProcessing;
 	static U32 sCacheBytesRead;
@@ -798,6 +798,7 @@ BOOL LLSpatialGroup::changeLOD()
 
 void LLSpatialGroup::handleInsertion(const TreeNode* node, LLViewerOctreeEntry* entry)
 {
+	mSpatialPartition->dirtyLinearOctree();
 	addObject((LLDrawable*)entry->getDrawable());
 	unbound();
 	setState(OBJECT_DIRTY);
@@ -806,11 +807,13 @@ void LLSpatialGroup::handleInsertion(const TreeNode* node, LLViewerOctreeEntry*
 void LLSpatialGroup::handleRemoval(const TreeNode* node, LLViewerOctreeEntry* entry)
 {
 	removeObject((LLDrawable*)entry->getDrawable(), TRUE);
-	LLViewerOctreeGroup::handleRemoval(node, entry);
+	LLOcclusionCullingGroup::handleRemoval(node, entry);
 }
 
 void LLSpatialGroup::handleDestruction(const TreeNode* node)
 {
+	mSpatialPartition->dirtyLinearOctree();
+
 	if(isDead())
 	{
 		return;
@@ -841,6 +844,8 @@ void LLSpatialGroup::handleChildAddition(const OctreeNode* parent, OctreeNode* c
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL
 
+	mSpatialPartition->dirtyLinearOctree();
+
 	if (child->getListenerCount() == 0)
 	{
 		new LLSpatialGroup(child, getSpatialPartition());
@@ -1492,17 +1497,17 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
     if (LLPipeline::sShadowRender)
     {
         LLOctreeCullShadow culler(&camera);
-        culler.traverse(mOctree);
+        cullOctree(culler);
     }
     else if (mInfiniteFarClip || !LLPipeline::sUseFarClip)
     {
         LLOctreeCullNoFarClip culler(&camera);
-        culler.traverse(mOctree);
+        cullOctree(culler);
     }
     else
     {
         LLOctreeCull culler(&camera);
-        culler.traverse(mOctree);
+        cullOctree(culler);
     }
 	
 	return 0;
@@ -3343,7 +3348,19 @@ void renderRaycast(LLDrawable* drawablep)
 
                         if (!face.getOctree())
 						{
+							// <FS:ND> Create a debug log for octree insertions if requested.
+							static LLCachedControl<bool> debugOctree(gSavedSettings,"FSCreateOctreeLog");
+							bool _debugOT( debugOctree );
+							if( _debugOT )
+								nd::octree::debug::gOctreeDebug += 1;
+							// </FS:ND>
+
 							((LLVolumeFace*) &face)->createOctree(); 
+
+							// <FS:ND> Reset octree log
+							if( _debugOT )
+								nd::octree::debug::gOctreeDebug -= 1;
+							// </FS:ND>
 						}
 
 						LLRenderOctreeRaycast render(start, dir, &t);
@@ -894,6 +894,17 @@ bool idle_startup()
 				msg->mPacketRing.setUseOutThrottle(TRUE);
 				msg->mPacketRing.setOutBandwidth(outBandwidth);
 			}
+
+			if (gSavedSettings.getBOOL("MessageSystemNetworkThread"))
+			{
+				msg->startNetworkThread();
+			}
+
+			std::string capture_file = gSavedSettings.getString("MessageSystemCaptureFile");
+			if (!capture_file.empty())
+			{
+				msg->startPacketCapture(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, capture_file));
+			}
 		}
 
 		LL_INFOS("AppInit") << "Message System Initialized." << LL_ENDL;
@@ -2114,6 +2125,14 @@ bool idle_startup()
 	{
 		display_startup();
 
+		// Get connections to the asset server open while the rest
+		// of login goes on
+		LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(gFirstSimHandle);
+		if (regionp)
+		{
+			LLAppViewer::instance()->getAppCoreHttp().warmupConnections(regionp->getViewerAssetUrl());
+		}
+
         // These textures are not warrantied to be cached, so needs
         // to hapen with caps granted
         gTextureList.doPrefetchImages();
@@ -868,6 +868,25 @@ BOOL LLSurface::idleUpdate(F32 max_update_time)
 	return did_update;
 }
 
+// Patch coordinates of a patch header
+static void get_patch_ids(const LLPatchHeader &ph, BOOL b_large_patch, S32 &i, S32 &j)
+{
+// <FS:CR> Aurora Sim
+	//i = ph.patchids >> 5;
+	//j = ph.patchids & 0x1F;
+	if (b_large_patch)
+	{
+		i = ph.patchids >> 16; //x
+		j = ph.patchids & 0xFFFF; //y
+	}
+	else
+	{
+		i = ph.patchids >> 5; //x
+		j = ph.patchids & 0x1F; //y
+	}
+// </FS:CR> Aurora Sim
+}
+
 void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch) 
 {
 
@@ -891,20 +910,7 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL
 			break;
 		}
 
-// <FS:CR> Aurora Sim
-		//i = ph.patchids >> 5;
-		//j = ph.patchids & 0x1F;
-		if (b_large_patch)
-		{
-			i = ph.patchids >> 16; //x
-			j = ph.patchids & 0xFFFF; //y
-		}
-		else
-		{
-			i = ph.patchids >> 5; //x
-			j = ph.patchids & 0x1F; //y
-		}
-// </FS:CR> Aurora Sim
+		get_patch_ids(ph, b_large_patch, i, j);
 
 		if ((i >= mPatchesPerEdge) || (j >= mPatchesPerEdge))
 		{
@@ -926,29 +932,94 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL
 		decode_patch(bitpack, patch);
 		decompress_patch(patchp->getDataZ(), patch, &ph);
 
-		// Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
-		patchp->updateNorthEdge();
-		patchp->updateEastEdge();
-		if (patchp->getNeighborPatch(WEST))
+		onPatchDecoded(patchp);
+	}
+}
+
+//static
+BOOL LLSurface::decodeDCTPatches(LLBitPack &bitpack, BOOL b_large_patch, decoded_patch_list_t &patches, S32 &patch_size)
+{
+	LLGroupHeader goph;
+	LLPatchHeader ph;
+	S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+	decode_patch_group_header(bitpack, &goph);
+	patch_size = goph.patch_size;
+	if (patch_size != NORMAL_PATCH_SIZE && patch_size != LARGE_PATCH_SIZE)
+	{
+		LL_WARNS() << "Received invalid terrain packet - patch size " << patch_size << LL_ENDL;
+		return FALSE;
+	}
+	init_patch_decompressor(patch_size);
+
+	while (1)
+	{
+		decode_patch_header(bitpack, &ph, b_large_patch);
+		if (ph.quant_wbits == END_OF_PATCHES)
 		{
-			patchp->getNeighborPatch(WEST)->updateEastEdge();
+			break;
 		}
-		if (patchp->getNeighborPatch(SOUTHWEST))
+
+		patches.push_back(DecodedPatch());
+		DecodedPatch &decoded = patches.back();
+		get_patch_ids(ph, b_large_patch, decoded.mX, decoded.mY);
+
+		decode_patch(bitpack, patch);
+		decompress_patch(decoded.mHeights, patch, &ph, patch_size, patch_size);
+	}
+	return TRUE;
+}
+
+void LLSurface::applyDecodedPatches(const decoded_patch_list_t &patches, S32 patch_size)
+{
+	for (decoded_patch_list_t::const_iterator iter = patches.begin(); iter != patches.end(); ++iter)
+	{
+		const DecodedPatch &decoded = *iter;
+		if ((decoded.mX >= mPatchesPerEdge) || (decoded.mY >= mPatchesPerEdge))
 		{
-			patchp->getNeighborPatch(SOUTHWEST)->updateEastEdge();
-			patchp->getNeighborPatch(SOUTHWEST)->updateNorthEdge();
+			LL_WARNS() << "Received invalid terrain packet - patch header patch ID incorrect!"
+				<< " patches per edge " << mPatchesPerEdge
+				<< " i " << decoded.mX
+				<< " j " << decoded.mY
+				<< LL_ENDL;
+			return;
 		}
-		if (patchp->getNeighborPatch(SOUTH))
+
+		LLSurfacePatch *patchp = &mPatchList[decoded.mY*mPatchesPerEdge + decoded.mX];
+		F32 *dataz = patchp->getDataZ();
+		for (S32 row = 0; row < patch_size; row++)
 		{
-			patchp->getNeighborPatch(SOUTH)->updateNorthEdge();
+			memcpy(dataz + row*mGridsPerEdge, decoded.mHeights + row*patch_size, patch_size*sizeof(F32));		/* Flawfinder: ignore */
 		}
 
-		// Dirty patch statistics, and flag that the patch has data.
-		patchp->dirtyZ();
-		patchp->setHasReceivedData();
+		onPatchDecoded(patchp);
 	}
 }
 
+void LLSurface::onPatchDecoded(LLSurfacePatch *patchp)
+{
+	// Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
+	patchp->updateNorthEdge();
+	patchp->updateEastEdge();
+	if (patchp->getNeighborPatch(WEST))
+	{
+		patchp->getNeighborPatch(WEST)->updateEastEdge();
+	}
+	if (patchp->getNeighborPatch(SOUTHWEST))
+	{
+		patchp->getNeighborPatch(SOUTHWEST)->updateEastEdge();
+		patchp->getNeighborPatch(SOUTHWEST)->updateNorthEdge();
+	}
+	if (patchp->getNeighborPatch(SOUTH))
+	{
+		patchp->getNeighborPatch(SOUTH)->updateNorthEdge();
+	}
+
+	// Dirty patch statistics, and flag that the patch has data.
+	patchp->dirtyZ();
+	patchp->setHasReceivedData();
+}
+
 
 // Retrurns TRUE if "position" is within the bounds of surface.
 // "position" is region-local
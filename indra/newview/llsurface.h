@@ -41,6 +41,7 @@
 #include "llvowater.h"
 #include "llpatchvertexarray.h"
 #include "llviewertexture.h"
+#include "patch_dct.h"
 
 class LLTimer;
 class LLUUID;
@@ -88,6 +89,22 @@ public:
 	void rebuildWater();
 // </FS:CR> Aurora Sim
 	virtual void decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch);
+
+	// A land patch decoded away from the surface, see decodeDCTPatches()
+	struct DecodedPatch
+	{
+		S32 mX;
+		S32 mY;
+		F32 mHeights[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+	};
+	typedef std::vector<DecodedPatch> decoded_patch_list_t;
+
+	// Decodes a whole land layer packet, group header included, into
+	// patch_size rows of patch_size heights per patch.  Touches no surface,
+	// so it may run on a worker thread.  Returns FALSE for a malformed packet.
+	static BOOL decodeDCTPatches(LLBitPack &bitpack, BOOL b_large_patch, decoded_patch_list_t &patches, S32 &patch_size);
+	// Applies the result of decodeDCTPatches() as decompressDCTPatch() would
+	void applyDecodedPatches(const decoded_patch_list_t &patches, S32 patch_size);
 	virtual void updatePatchVisibilities(LLAgent &agent);
 
 	inline F32 getZ(const U32 k) const				{ return mSurfaceZ[k]; }
@@ -188,6 +205,9 @@ protected:
 	
 	LLSurfacePatch *getPatch(const S32 x, const S32 y) const;
 
+	// Neighbor edges and statistics for a patch whose heights just changed
+	void onPatchDecoded(LLSurfacePatch *patchp);
+
 protected:
 	LLVector3d	mOriginGlobal;		// In absolute frame
 	LLSurfacePatch *mPatchList;		// Array of all patches
@@ -757,8 +757,9 @@ void LLGLTexMemBar::draw()
 											 color, LLFontGL::LEFT, LLFontGL::TOP);
 	
 	// Mesh status line
-	text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
+	text = llformat("Mesh: Reqs(Tot/Htp/Big/Mrg): %u/%u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
 					LLMeshRepository::sMeshRequestCount, LLMeshRepository::sHTTPRequestCount, LLMeshRepository::sHTTPLargeRequestCount,
+					LLMeshRepository::sHTTPMergedCount,
 					LLMeshRepository::sHTTPRetryCount, LLMeshRepository::sHTTPErrorCount,
 					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites,
 					LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater);
@@ -60,6 +60,7 @@
 #include "llvosky.h"
 #include "llvotree.h"
 #include "llvovolume.h"
+#include "llvolumemgr.h"
 #include "llworld.h"
 #include "pipeline.h"
 #include "llviewerjoystick.h"
@@ -386,6 +387,12 @@ static bool handleVolumeLODChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleVolumeCacheBudgetChanged(const LLSD& newvalue)
+{
+	LLPrimitive::getVolumeManager()->setMemoryBudget((size_t) newvalue.asInteger() * 1024 * 1024);
+	return true;
+}
+
 static bool handleAvatarLODChanged(const LLSD& newvalue)
 {
 	LLVOAvatar::sLODFactor = llclamp((F32) newvalue.asReal(), 0.f, MAX_AVATAR_LOD_FACTOR);
@@ -701,6 +708,39 @@ bool handleVelocityInterpolate(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleMessageSystemNetworkThreadChanged(const LLSD& newvalue)
+{
+	if (gMessageSystem)
+	{
+		if (newvalue.asBoolean())
+		{
+			gMessageSystem->startNetworkThread();
+		}
+		else
+		{
+			gMessageSystem->stopNetworkThread();
+		}
+	}
+	return true;
+}
+
+static bool handleMessageSystemCaptureFileChanged(const LLSD& newvalue)
+{
+	if (gMessageSystem)
+	{
+		std::string capture_file = newvalue.asString();
+		if (capture_file.empty())
+		{
+			gMessageSystem->stopPacketCapture();
+		}
+		else
+		{
+			gMessageSystem->startPacketCapture(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, capture_file));
+		}
+	}
+	return true;
+}
+
 bool handleForceShowGrid(const LLSD& newvalue)
 {
 	// <FS:Ansariel> [FS Login Panel]
@@ -1247,6 +1287,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "WindLightUseAtmosShaders", handleSetShaderChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderGammaFull", handleSetShaderChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderVolumeLODFactor", handleVolumeLODChanged);
+    setting_setup_signal_listener(gSavedSettings, "RenderVolumeCacheBudget", handleVolumeCacheBudgetChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderAvatarLODFactor", handleAvatarLODChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderAvatarPhysicsLODFactor", handleAvatarPhysicsLODChanged);
     setting_setup_signal_listener(gSavedSettings, "RenderTerrainLODFactor", handleTerrainLODChanged);
@@ -1361,6 +1402,8 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "AudioLevelMic", handleVoiceClientPrefsChanged);
     setting_setup_signal_listener(gSavedSettings, "LipSyncEnabled", handleVoiceClientPrefsChanged);	
     setting_setup_signal_listener(gSavedSettings, "VelocityInterpolate", handleVelocityInterpolate);
+    setting_setup_signal_listener(gSavedSettings, "MessageSystemNetworkThread", handleMessageSystemNetworkThreadChanged);
+    setting_setup_signal_listener(gSavedSettings, "MessageSystemCaptureFile", handleMessageSystemCaptureFileChanged);
     setting_setup_signal_listener(gSavedSettings, "QAMode", show_debug_menus);
     setting_setup_signal_listener(gSavedSettings, "UseDebugMenus", show_debug_menus);
     setting_setup_signal_listener(gSavedSettings, "AgentPause", toggle_agent_pause);
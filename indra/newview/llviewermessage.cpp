@@ -49,6 +49,7 @@
 #include "llfilesystem.h"
 #include "llxfermanager.h"
 #include "mean_collision_data.h"
+#include "message_fields.h"
 
 #include "llagent.h"
 #include "llagentbenefits.h"
@@ -2923,19 +2924,20 @@ void process_chat_from_simulator(LLMessageSystem *msg, void **user_data)
 	LLUUID		from_id;
 	LLUUID		owner_id;
 	LLViewerObject*	chatter;
+	LLMsgChatFromSimulator chat_msg(msg);
 
-	msg->getString("ChatData", "FromName", from_name);
+	chat_msg.getChatDataFromName(from_name);
 	
-	msg->getUUID("ChatData", "SourceID", from_id);
+	chat_msg.getChatDataSourceID(from_id);
 	chat.mFromID = from_id;
 	
 	// Object owner for objects
-	msg->getUUID("ChatData", "OwnerID", owner_id);
+	chat_msg.getChatDataOwnerID(owner_id);
 
-	msg->getU8Fast(_PREHASH_ChatData, _PREHASH_SourceType, source_temp);
+	chat_msg.getChatDataSourceType(source_temp);
 	chat.mSourceType = (EChatSourceType)source_temp;
 
-	msg->getU8("ChatData", "ChatType", type_temp);
+	chat_msg.getChatDataChatType(type_temp);
 	chat.mChatType = (EChatType)type_temp;
 
 	// NaCL - Antispam Registry
@@ -2968,7 +2970,7 @@ void process_chat_from_simulator(LLMessageSystem *msg, void **user_data)
 	}
 	// NaCl End
 
-	msg->getU8Fast(_PREHASH_ChatData, _PREHASH_Audible, audible_temp);
+	chat_msg.getChatDataAudible(audible_temp);
 	chat.mAudible = (EChatAudible)audible_temp;
 	
 	chat.mTime = LLFrameTimer::getElapsedSeconds();
@@ -3084,7 +3086,7 @@ void process_chat_from_simulator(LLMessageSystem *msg, void **user_data)
 		std::string verb;
 
 		color.setVec(1.f,1.f,1.f,1.f);
-		msg->getStringFast(_PREHASH_ChatData, _PREHASH_Message, mesg);
+		chat_msg.getChatDataMessage(mesg);
 
 		// NaCl - Newline flood protection
 		static LLCachedControl<bool> useAntiSpam(gSavedSettings, "UseAntiSpam");
@@ -51,6 +51,7 @@
 #include "lltree_common.h"
 #include "llxfermanager.h"
 #include "message.h"
+#include "message_fields.h"
 #include "object_flags.h"
 
 #include "llaudiosourcevo.h"
@@ -158,6 +159,58 @@ const S32 MAX_OBJECT_BINARY_DATA_SIZE = 60 + 16;
 const F64 INVENTORY_UPDATE_WAIT_TIME_DESYNC = 5; // seconds
 const F64 INVENTORY_UPDATE_WAIT_TIME_OUTDATED = 1;
 
+// Quantized values in a terse 16 update: position, velocity, acceleration,
+// rotation and angular velocity
+const S32 TERSE16_VALUES = 16;
+
+static LL_ALIGN_16(const F32 TERSE_MOTION_LOW[LLViewerObject::TERSE_MOTION_VALUES]) =
+{
+	-128.f, -128.f, -128.f,			// velocity
+	-64.f, -64.f, -64.f,			// acceleration
+	-1.f, -1.f, -1.f, -1.f,			// rotation
+	-64.f, -64.f, -64.f,			// angular velocity
+	0.f, 0.f, 0.f
+};
+static LL_ALIGN_16(const F32 TERSE_MOTION_HIGH[LLViewerObject::TERSE_MOTION_VALUES]) =
+{
+	128.f, 128.f, 128.f,
+	64.f, 64.f, 64.f,
+	1.f, 1.f, 1.f, 1.f,
+	64.f, 64.f, 64.f,
+	1.f, 1.f, 1.f
+};
+
+static void dequantize_terse16(F32* dst, const U8* data, F32 size, F32 max_height)
+{
+	LL_ALIGN_16(U16 quantized[TERSE16_VALUES]);
+#ifdef LL_BIG_ENDIAN
+	for (S32 i = 0; i < TERSE16_VALUES; ++i)
+	{
+		htolememcpy(&quantized[i], &data[i * sizeof(U16)], MVT_U16, sizeof(U16));
+	}
+#else
+	memcpy(quantized, data, sizeof(quantized));		/* Flawfinder: ignore */
+#endif
+
+	LL_ALIGN_16(F32 low[TERSE16_VALUES]) =
+	{
+		-0.5f*size, -0.5f*size, MIN_HEIGHT,
+		-size, -size, -size,
+		-size, -size, -size,
+		-1.f, -1.f, -1.f, -1.f,
+		-size, -size, -size
+	};
+	LL_ALIGN_16(F32 high[TERSE16_VALUES]) =
+	{
+		1.5f*size, 1.5f*size, max_height,
+		size, size, size,
+		size, size, size,
+		1.f, 1.f, 1.f, 1.f,
+		size, size, size
+	};
+	LLVector4a::dequantize16(dst, quantized, TERSE16_VALUES, low, high, TERSE16_VALUES);
+}
+
 // static
 LLViewerObject *LLViewerObject::createObject(const LLUUID &id, const LLPCode pcode, LLViewerRegion *regionp, S32 flags)
 {
@@ -1190,6 +1243,31 @@ U32 LLViewerObject::extractSpatialExtents(LLDataPackerBinaryBuffer *dp, LLVector
 	return parent_id;
 }
 
+//static
+void LLViewerObject::dequantizeTerseMotion(F32* dst, const U16* src, S32 blocks)
+{
+	LLVector4a::dequantize16(dst, src, blocks * TERSE_MOTION_VALUES,
+							 TERSE_MOTION_LOW, TERSE_MOTION_HIGH, TERSE_MOTION_VALUES);
+}
+
+//static
+S32 LLViewerObject::getTerseMotionOffset(const U8* data, S32 size)
+{
+	// LocalID, State, then whether there is a collision plane for an avatar
+	S32 offset = sizeof(U32) + sizeof(U8);
+	if (size <= offset)
+	{
+		return -1;
+	}
+	if (data[offset++])
+	{
+		offset += sizeof(LLVector4);
+	}
+	// Pos
+	offset += sizeof(LLVector3);
+	return offset + TERSE_MOTION_QUANTIZED * (S32)sizeof(U16) <= size ? offset : -1;
+}
+
 U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 					 void **user_data,
 					 U32 block_num,
@@ -1268,10 +1346,6 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 	// This needs to match the largest size below. See switch(length)
 	U8  data[MAX_OBJECT_BINARY_DATA_SIZE]; 
 
-#ifdef LL_BIG_ENDIAN
-	U16 valswizzle[4];
-#endif
-	U16	*val;
 // <FS:CR> Aurora Sim
 	//const F32 size = LLWorld::getInstance()->getRegionWidthInMeters();	
 	const F32 size = mRegionp->getWidth();	
@@ -1326,20 +1400,21 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				F32    gain;
 				F32    cutoff;
 				U8     sound_flags;
+				LLMsgObjectUpdate update_msg(mesgsys);
 
-				mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_CRC, crc, block_num);
-				mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_ParentID, parent_id, block_num);
-				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_Sound, audio_uuid, block_num );
+				update_msg.getObjectDataCRC(crc, block_num);
+				update_msg.getObjectDataParentID(parent_id, block_num);
+				update_msg.getObjectDataSound(audio_uuid, block_num);
 				// HACK: Owner id only valid if non-null sound id or particle system
-				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_OwnerID, owner_id, block_num );
-				mesgsys->getF32Fast( _PREHASH_ObjectData, _PREHASH_Gain, gain, block_num );
-				mesgsys->getF32Fast(  _PREHASH_ObjectData, _PREHASH_Radius, cutoff, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Flags, sound_flags, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Material, material, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_ClickAction, click_action, block_num); 
-				mesgsys->getVector3Fast(_PREHASH_ObjectData, _PREHASH_Scale, new_scale, block_num );
-				length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ObjectData);
-				mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
+				update_msg.getObjectDataOwnerID(owner_id, block_num);
+				update_msg.getObjectDataGain(gain, block_num);
+				update_msg.getObjectDataRadius(cutoff, block_num);
+				update_msg.getObjectDataFlags(sound_flags, block_num);
+				update_msg.getObjectDataMaterial(material, block_num);
+				update_msg.getObjectDataClickAction(click_action, block_num); 
+				update_msg.getObjectDataScale(new_scale, block_num);
+				length = update_msg.getObjectDataObjectDataSize(block_num);
+				update_msg.getObjectDataObjectData(data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
 
 				mTotalCRC = crc;
                 // Might need to update mSourceMuted here to properly pick up new radius
@@ -1413,62 +1488,19 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				case 32:
 					this_update_precision = 16;
 					test_pos_parent.quantize16(-0.5f*size, 1.5f*size, MIN_HEIGHT, MAX_HEIGHT);
-
-					// This is a terse 16 update, so treat data as an array of U16's.
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*3;
-					new_pos_parent.mV[VX] = U16_to_F32(val[VX], -0.5f*size, 1.5f*size);
-					new_pos_parent.mV[VY] = U16_to_F32(val[VY], -0.5f*size, 1.5f*size);
-					new_pos_parent.mV[VZ] = U16_to_F32(val[VZ], MIN_HEIGHT, MAX_HEIGHT);
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*3;
-					setVelocity(LLVector3(U16_to_F32(val[VX], -size, size),
-													   U16_to_F32(val[VY], -size, size),
-													   U16_to_F32(val[VZ], -size, size)));
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*3;
-					setAcceleration(LLVector3(U16_to_F32(val[VX], -size, size),
-														   U16_to_F32(val[VY], -size, size),
-														   U16_to_F32(val[VZ], -size, size)));
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Quat, 4); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*4;
-					new_rot.mQ[VX] = U16_to_F32(val[VX], -1.f, 1.f);
-					new_rot.mQ[VY] = U16_to_F32(val[VY], -1.f, 1.f);
-					new_rot.mQ[VZ] = U16_to_F32(val[VZ], -1.f, 1.f);
-					new_rot.mQ[VW] = U16_to_F32(val[VW], -1.f, 1.f);
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					new_angv.setVec(U16_to_F32(val[VX], -size, size),
-										U16_to_F32(val[VY], -size, size),
-										U16_to_F32(val[VZ], -size, size));
+					{
+						// This is a terse 16 update, so treat data as an array of U16's.
+						LL_ALIGN_16(F32 motion[TERSE16_VALUES]);
+						dequantize_terse16(motion, &data[count], size, MAX_HEIGHT);
+						new_pos_parent.set(motion[0], motion[1], motion[2]);
+						setVelocity(LLVector3(motion[3], motion[4], motion[5]));
+						setAcceleration(LLVector3(motion[6], motion[7], motion[8]));
+						new_rot.mQ[VX] = motion[9];
+						new_rot.mQ[VY] = motion[10];
+						new_rot.mQ[VZ] = motion[11];
+						new_rot.mQ[VW] = motion[12];
+						new_angv.setVec(motion[13], motion[14], motion[15]);
+					}
 					if (new_angv.isExactlyZero())
 					{
 						// reset rotation time
@@ -1516,24 +1548,24 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				//
 
 				U32 flags;
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, block_num);
+				update_msg.getObjectDataUpdateFlags(flags, block_num);
 				// clear all but local flags
 				mFlags &= FLAGS_LOCAL;
 				mFlags |= flags;
 
 				U8 state;
-				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_State, state, block_num );
+				update_msg.getObjectDataState(state, block_num);
 				mAttachmentState = state;
 
 				// ...new objects that should come in selected need to be added to the selected list
 				mCreateSelected = ((flags & FLAGS_CREATE_SELECTED) != 0);
 
 				// Set all name value pairs
-				S32 nv_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_NameValue);
+				S32 nv_size = update_msg.getObjectDataNameValueSize(block_num);
 				if (nv_size > 0)
 				{
 					std::string name_value_list;
-					mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_NameValue, name_value_list, block_num);
+					update_msg.getObjectDataNameValue(name_value_list, block_num);
 					setNameValueList(name_value_list);
 				}
 
@@ -1544,7 +1576,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 
 				// Check for appended generic data
-				S32 data_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Data);
+				S32 data_size = update_msg.getObjectDataDataSize(block_num);
 				if (data_size <= 0)
 				{
 					mData = NULL;
@@ -1553,10 +1585,10 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				{
 					// ...has generic data
 					mData = new U8[data_size];
-					mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, mData, data_size, block_num);
+					update_msg.getObjectDataData(mData, data_size, block_num);
 				}
 
-				S32 text_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Text);
+				S32 text_size = update_msg.getObjectDataTextSize(block_num);
 				if (text_size > 1)
 				{
 					// Setup object text
@@ -1566,10 +1598,10 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 					}
 
 					std::string temp_string;
-					mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_Text, temp_string, block_num );
+					update_msg.getObjectDataText(temp_string, block_num);
 					
 					LLColor4U coloru;
-					mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_TextColor, coloru.mV, 4, block_num);
+					update_msg.getObjectDataTextColor(coloru.mV, 4, block_num);
 
 					// alpha was flipped so that it zero encoded better
 					coloru.mV[3] = 255 - coloru.mV[3];
@@ -1598,7 +1630,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 
 				std::string media_url;
-				mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_MediaURL, media_url, block_num);
+				update_msg.getObjectDataMediaURL(media_url, block_num);
                 retval |= checkMediaURL(media_url);
                 
 				//
@@ -1614,11 +1646,11 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 
 				// Unpack extra parameters
-				S32 size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ExtraParams);
+				S32 size = update_msg.getObjectDataExtraParamsSize(block_num);
 				if (size > 0)
 				{
 					U8 *buffer = new U8[size];
-					mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ExtraParams, buffer, size, block_num);
+					update_msg.getObjectDataExtraParams(buffer, size, block_num);
 					LLDataPackerBinaryBuffer dp(buffer, size);
 
 					U8 num_parameters;
@@ -1711,61 +1743,18 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 					// this is a terse 16 update
 					this_update_precision = 16;
 					test_pos_parent.quantize16(-0.5f*size, 1.5f*size, MIN_HEIGHT, MAX_HEIGHT);
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*3;
-					new_pos_parent.mV[VX] = U16_to_F32(val[VX], -0.5f*size, 1.5f*size);
-					new_pos_parent.mV[VY] = U16_to_F32(val[VY], -0.5f*size, 1.5f*size);
-					new_pos_parent.mV[VZ] = U16_to_F32(val[VZ], MIN_HEIGHT, MAX_HEIGHT);
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*3;
-					setVelocity(U16_to_F32(val[VX], -size, size),
-								U16_to_F32(val[VY], -size, size),
-								U16_to_F32(val[VZ], -size, size));
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*3;
-					setAcceleration(U16_to_F32(val[VX], -size, size),
-									U16_to_F32(val[VY], -size, size),
-									U16_to_F32(val[VZ], -size, size));
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Quat, 8); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					count += sizeof(U16)*4;
-					new_rot.mQ[VX] = U16_to_F32(val[VX], -1.f, 1.f);
-					new_rot.mQ[VY] = U16_to_F32(val[VY], -1.f, 1.f);
-					new_rot.mQ[VZ] = U16_to_F32(val[VZ], -1.f, 1.f);
-					new_rot.mQ[VW] = U16_to_F32(val[VW], -1.f, 1.f);
-
-#ifdef LL_BIG_ENDIAN
-					htolememcpy(valswizzle, &data[count], MVT_U16Vec3, 6); 
-					val = valswizzle;
-#else
-					val = (U16 *) &data[count];
-#endif
-					new_angv.set(U16_to_F32(val[VX], -size, size),
-										U16_to_F32(val[VY], -size, size),
-										U16_to_F32(val[VZ], -size, size));
+					{
+						LL_ALIGN_16(F32 motion[TERSE16_VALUES]);
+						dequantize_terse16(motion, &data[count], size, MAX_HEIGHT);
+						new_pos_parent.set(motion[0], motion[1], motion[2]);
+						setVelocity(motion[3], motion[4], motion[5]);
+						setAcceleration(motion[6], motion[7], motion[8]);
+						new_rot.mQ[VX] = motion[9];
+						new_rot.mQ[VY] = motion[10];
+						new_rot.mQ[VZ] = motion[11];
+						new_rot.mQ[VW] = motion[12];
+						new_angv.set(motion[13], motion[14], motion[15]);
+					}
 					setAngularVelocity(new_angv);
 					break;
 
@@ -1817,8 +1806,6 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 		U8     sound_flags = 0;
 		F32		cutoff = 0;
 
-		U16 val[4];
-
 		U8		state;
 
 		dp->unpackU8(state, "State");
@@ -1841,33 +1828,29 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 				test_pos_parent = getPosition();
 				dp->unpackVector3(new_pos_parent, "Pos");
-				dp->unpackU16(val[VX], "VelX");
-				dp->unpackU16(val[VY], "VelY");
-				dp->unpackU16(val[VZ], "VelZ");
-				setVelocity(U16_to_F32(val[VX], -128.f, 128.f),
-							U16_to_F32(val[VY], -128.f, 128.f),
-							U16_to_F32(val[VZ], -128.f, 128.f));
-				dp->unpackU16(val[VX], "AccX");
-				dp->unpackU16(val[VY], "AccY");
-				dp->unpackU16(val[VZ], "AccZ");
-				setAcceleration(U16_to_F32(val[VX], -64.f, 64.f),
-								U16_to_F32(val[VY], -64.f, 64.f),
-								U16_to_F32(val[VZ], -64.f, 64.f));
-
-				dp->unpackU16(val[VX], "ThetaX");
-				dp->unpackU16(val[VY], "ThetaY");
-				dp->unpackU16(val[VZ], "ThetaZ");
-				dp->unpackU16(val[VS], "ThetaS");
-				new_rot.mQ[VX] = U16_to_F32(val[VX], -1.f, 1.f);
-				new_rot.mQ[VY] = U16_to_F32(val[VY], -1.f, 1.f);
-				new_rot.mQ[VZ] = U16_to_F32(val[VZ], -1.f, 1.f);
-				new_rot.mQ[VS] = U16_to_F32(val[VS], -1.f, 1.f);
-				dp->unpackU16(val[VX], "AccX");
-				dp->unpackU16(val[VY], "AccY");
-				dp->unpackU16(val[VZ], "AccZ");
-				new_angv.set(U16_to_F32(val[VX], -64.f, 64.f),
-									U16_to_F32(val[VY], -64.f, 64.f),
-									U16_to_F32(val[VZ], -64.f, 64.f));
+
+				// The object list normally expands the motion of every block
+				// of the message at once, and this only steps over it
+				LL_ALIGN_16(U16 quantized[TERSE_MOTION_VALUES]) = { 0 };
+				LL_ALIGN_16(F32 decoded[TERSE_MOTION_VALUES]);
+				const F32* motion = gObjectList.getTerseMotion(block_num);
+				if (motion)
+				{
+					dp->unpackBinaryDataFixed((U8*)quantized, TERSE_MOTION_QUANTIZED * sizeof(U16), "Motion");
+				}
+				else
+				{
+					dp->unpackU16s(quantized, TERSE_MOTION_QUANTIZED, "Motion");
+					dequantizeTerseMotion(decoded, quantized, 1);
+					motion = decoded;
+				}
+				setVelocity(motion[0], motion[1], motion[2]);
+				setAcceleration(motion[3], motion[4], motion[5]);
+				new_rot.mQ[VX] = motion[6];
+				new_rot.mQ[VY] = motion[7];
+				new_rot.mQ[VZ] = motion[8];
+				new_rot.mQ[VS] = motion[9];
+				new_angv.set(motion[10], motion[11], motion[12]);
 				setAngularVelocity(new_angv);
 			}
 			break;
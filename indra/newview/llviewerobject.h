@@ -171,6 +171,16 @@ public:
 										const EObjectUpdateType update_type,
 										LLDataPacker *dp);
 
+	// Compressed terse updates carry velocity, acceleration, rotation and
+	// angular velocity as TERSE_MOTION_QUANTIZED U16s, padded to
+	// TERSE_MOTION_VALUES per block.  dequantizeTerseMotion() expands the
+	// motion of blocks updates at once, see
+	// LLViewerObjectList::decodeTerseMotion().
+	static const S32 TERSE_MOTION_QUANTIZED = 13;
+	static const S32 TERSE_MOTION_VALUES = 16;
+	static void		dequantizeTerseMotion(F32* dst, const U16* src, S32 blocks);
+	static S32		getTerseMotionOffset(const U8* data, S32 size);
+
 
 	virtual BOOL    isActive() const; // Whether this object needs to do an idleUpdate.
 	BOOL			onActiveList() const				{return mOnActiveList;}
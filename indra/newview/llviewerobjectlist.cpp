@@ -29,6 +29,7 @@
 #include "llviewerobjectlist.h"
 
 #include "message.h"
+#include "message_fields.h"
 #include "llfasttimer.h"
 #include "llrender.h"
 #include "llwindow.h"		// decBusyCount()
@@ -517,6 +518,17 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 	LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
 	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
 
+	// Only the view of the message being handled reads its fields
+	// directly, the others fall back to the named getters.
+	LLMsgObjectUpdate full_msg(mesgsys);
+	LLMsgObjectUpdateCompressed compressed_msg(mesgsys);
+	LLMsgImprovedTerseObjectUpdate terse_msg(mesgsys);
+
+	if (compressed && update_type == OUT_TERSE_IMPROVED)
+	{
+		decodeTerseMotion(terse_msg, num_objects);
+	}
+
 	for (i = 0; i < num_objects; i++)
 	{
 		BOOL justCreated = FALSE;
@@ -526,15 +538,24 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		{
 			compressed_dp.reset();
 
-			S32 uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+			S32 uncompressed_length;
+			if (update_type == OUT_TERSE_IMPROVED)
+			{
+				uncompressed_length = terse_msg.getObjectDataDataSize(i);
+				terse_msg.getObjectDataData(compressed_dpbuffer, 0, i, 2048);
+			}
+			else
+			{
+				uncompressed_length = compressed_msg.getObjectDataDataSize(i);
+				compressed_msg.getObjectDataData(compressed_dpbuffer, 0, i, 2048);
+			}
             LL_DEBUGS("ObjectUpdate") << "got binary data from message to compressed_dpbuffer" << LL_ENDL;
-			mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i, 2048);
 			compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
 
 			if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
 			{
 				U32 flags = 0;
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+				compressed_msg.getObjectDataUpdateFlags(flags, i);
 
 				compressed_dp.unpackUUID(fullid, "ID");
 				compressed_dp.unpackU32(local_id, "LocalID");
@@ -575,7 +596,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		}
 		else if (update_type != OUT_FULL) // !compressed, !OUT_FULL ==> OUT_FULL_CACHED only?
 		{
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			full_msg.getObjectDataID(local_id, i);
 
 			getUUIDFromLocal(fullid,
 							local_id,
@@ -594,8 +615,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		else // OUT_FULL only?
 		{
 			update_cache = true;
-			mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			full_msg.getObjectDataFullID(fullid, i);
+			full_msg.getObjectDataID(local_id, i);
 			LL_DEBUGS("ObjectUpdate") << "Full Update, obj " << local_id << ", global ID " << fullid << " from " << mesgsys->getSender() << LL_ENDL;
 		}
 		objectp = findObject(fullid);
@@ -757,9 +778,64 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		objectp->setLastUpdateType(update_type);
 	}
 
+	mTerseMotionDecoded.clear();
+
 	LLVOAvatar::cullAvatarsByPixelArea();
 }
 
+void LLViewerObjectList::decodeTerseMotion(const LLMsgImprovedTerseObjectUpdate& msg, S32 num_objects)
+{
+	const S32 values = LLViewerObject::TERSE_MOTION_VALUES;
+	mTerseQuantized.resize(num_objects * values);
+	mTerseMotion.resize(num_objects * values);
+	mTerseMotionDecoded.assign(num_objects, false);
+
+	U8 data[2048];
+	for (S32 i = 0; i < num_objects; ++i)
+	{
+		U16* quantized = &mTerseQuantized[i * values];
+		memset(quantized, 0, values * sizeof(U16));
+
+		S32 size = llmin(msg.getObjectDataDataSize(i), (S32)sizeof(data));
+		if (size <= 0)
+		{
+			continue;
+		}
+		msg.getObjectDataData(data, 0, i, sizeof(data));
+
+		S32 offset = LLViewerObject::getTerseMotionOffset(data, size);
+		if (offset < 0)
+		{
+			continue;
+		}
+
+		// Wire order is little endian, like LLDataPackerBinaryBuffer::unpackU16()
+#ifdef LL_BIG_ENDIAN
+		for (S32 j = 0; j < LLViewerObject::TERSE_MOTION_QUANTIZED; ++j)
+		{
+			htolememcpy(&quantized[j], &data[offset + j * sizeof(U16)], MVT_U16, sizeof(U16));
+		}
+#else
+		memcpy(quantized, &data[offset], LLViewerObject::TERSE_MOTION_QUANTIZED * sizeof(U16));		/* Flawfinder: ignore */
+#endif
+		mTerseMotionDecoded[i] = true;
+	}
+
+	if (num_objects > 0)
+	{
+		LLViewerObject::dequantizeTerseMotion(&mTerseMotion[0], &mTerseQuantized[0], num_objects);
+	}
+}
+
+const F32* LLViewerObjectList::getTerseMotion(U32 block) const
+{
+	if (block >= mTerseMotionDecoded.size() || !mTerseMotionDecoded[block])
+	{
+		return NULL;
+	}
+	return &mTerseMotion[block * LLViewerObject::TERSE_MOTION_VALUES];
+}
+
 void LLViewerObjectList::processCompressedObjectUpdate(LLMessageSystem *mesgsys,
 											 void **user_data,
 											 const EObjectUpdateType update_type)
@@ -31,6 +31,7 @@
 #include <set>
 
 // common includes
+#include "llalignedarray.h"
 #include "llstring.h"
 #include "lltrace.h"
 
@@ -41,6 +42,7 @@
 
 class LLCamera;
 class LLNetMap;
+class LLMsgImprovedTerseObjectUpdate;
 class LLDebugBeacon;
 class LLVOCacheEntry;
 
@@ -90,6 +92,13 @@ public:
 	void processObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type, bool compressed=false);
 	void processCompressedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
 	void processCachedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
+
+	// Expands the quantized motion of every block of a compressed terse
+	// update at once.  getTerseMotion() then returns the block's
+	// TERSE_MOTION_VALUES floats while the message is processed, or NULL
+	// if the block could not be decoded.
+	void decodeTerseMotion(const LLMsgImprovedTerseObjectUpdate& msg, S32 num_objects);
+	const F32* getTerseMotion(U32 block) const;
 	void updateApparentAngles(LLAgent &agent);
 	void update(LLAgent &agent);
 
@@ -243,6 +252,11 @@ protected:
 
 	S32 mCurLazyUpdateIndex;
 
+	// Motion of the terse update being processed, see decodeTerseMotion()
+	LLAlignedArray<U16, 16> mTerseQuantized;
+	LLAlignedArray<F32, 16> mTerseMotion;
+	std::vector<bool> mTerseMotionDecoded;
+
 	static U32 sSimulatorMachineIndex;
 	static std::map<U64, U32> sIPAndPortToIndex;
 
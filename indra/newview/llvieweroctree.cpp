@@ -898,9 +898,40 @@ BOOL LLOcclusionCullingGroup::isAnyRecentlyVisible() const
 	return (LLDrawable::getCurrentFrame() - mAnyVisible) < MIN_VIS_FRAME_RANGE ;
 }
 
+//virtual 
+void LLOcclusionCullingGroup::handleInsertion(const TreeNode* node, LLViewerOctreeEntry* obj)
+{
+	mSpatialPartition->dirtyLinearOctree();
+	LLViewerOctreeGroup::handleInsertion(node, obj);
+}
+
+//virtual 
+void LLOcclusionCullingGroup::handleRemoval(const TreeNode* node, LLViewerOctreeEntry* obj)
+{
+	//base class may destroy *this*, so mark the partition first
+	mSpatialPartition->dirtyLinearOctree();
+	LLViewerOctreeGroup::handleRemoval(node, obj);
+}
+
+//virtual 
+void LLOcclusionCullingGroup::handleDestruction(const TreeNode* node)
+{
+	mSpatialPartition->dirtyLinearOctree();
+	LLViewerOctreeGroup::handleDestruction(node);
+}
+
+//virtual 
+void LLOcclusionCullingGroup::handleChildRemoval(const OctreeNode* parent, const OctreeNode* child)
+{
+	mSpatialPartition->dirtyLinearOctree();
+	LLViewerOctreeGroup::handleChildRemoval(parent, child);
+}
+
 //virtual 
 void LLOcclusionCullingGroup::handleChildAddition(const OctreeNode* parent, OctreeNode* child)
 {
+	mSpatialPartition->dirtyLinearOctree();
+
 	if (child->getListenerCount() == 0)
 	{
 		new LLOcclusionCullingGroup(child, mSpatialPartition);
@@ -1318,7 +1349,9 @@ LLViewerOctreePartition::LLViewerOctreePartition() :
 	mOcclusionEnabled(TRUE), 
 	mDrawableType(0),
 	mLODSeed(0),
-	mLODPeriod(1)
+	mLODPeriod(1),
+	mLinearOctreeDirty(true),
+	mLinearOctreeFrame(0)
 {
 	LLVector4a center, size;
 	center.splat(0.f);
@@ -1334,10 +1367,38 @@ LLViewerOctreePartition::~LLViewerOctreePartition()
 
 void LLViewerOctreePartition::cleanup()
 {
+    mLinearOctree.clear();
     delete mOctree;
     mOctree = nullptr;
 }
 
+const OctreeLinear* LLViewerOctreePartition::getLinearOctree()
+{
+	if (mLinearOctreeDirty)
+	{
+		U32 frame = LLDrawable::getCurrentFrame();
+		if (frame == mLinearOctreeFrame && !mLinearOctree.isEmpty())
+		{
+			//already rebuilt this frame, the snapshot may reference
+			//destroyed nodes so the caller walks mOctree instead
+			return NULL;
+		}
+
+		LL_PROFILE_ZONE_SCOPED_CATEGORY_OCTREE;
+		mLinearOctree.build(mOctree);
+		mLinearOctreeDirty = false;
+		mLinearOctreeFrame = frame;
+	}
+	return &mLinearOctree;
+}
+
+//static
+bool LLViewerOctreePartition::useLinearOctree()
+{
+	static LLCachedControl<bool> use_linear_octree(gSavedSettings, "RenderLinearOctreeCull");
+	return use_linear_octree;
+}
+
 BOOL LLViewerOctreePartition::isOcclusionEnabled()
 {
 	return mOcclusionEnabled || LLPipeline::sUseOcclusion > 2;
@@ -1386,10 +1447,60 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 	}
 }
 	
+bool LLViewerOctreeCull::batchGroupBounds(const LLViewerOctreeGroup* group, S32 mode, S32& res)
+{
+	if (!mBatch || mBatchSlot >= mBatch->mCount || mBatch->mGroups[mBatchSlot] != group)
+	{
+		return false;
+	}
+
+	if (mBatch->mMode != mode)
+	{
+		LL_ALIGN_16(F32 data[6][SiblingBatch::MAX_SIBLINGS]);
+		const F32* center[3] = { data[0], data[1], data[2] };
+		const F32* radius[3] = { data[3], data[4], data[5] };
+		for (U32 i = 0; i < mBatch->mCount; i++)
+		{
+			const LLViewerOctreeGroup* sibling = mBatch->mGroups[i];
+			for (U32 j = 0; j < 3; j++)
+			{
+				data[j][i] = sibling->mBounds[0][j];
+				data[j + 3][i] = sibling->mBounds[1][j];
+			}
+		}
+
+		switch (mode)
+		{
+		case BATCH_AGENT:
+			mCamera->AABBInFrustumBatch(center, radius, mBatch->mCount, &mBatch->mVisible, &mBatch->mPartial);
+			break;
+		case BATCH_AGENT_NO_FAR_CLIP:
+			mCamera->AABBInFrustumNoFarClipBatch(center, radius, mBatch->mCount, &mBatch->mVisible, &mBatch->mPartial);
+			break;
+		case BATCH_REGION:
+			mCamera->AABBInRegionFrustumBatch(center, radius, mBatch->mCount, &mBatch->mVisible, &mBatch->mPartial);
+			break;
+		default:
+			mCamera->AABBInRegionFrustumNoFarClipBatch(center, radius, mBatch->mCount, &mBatch->mVisible, &mBatch->mPartial);
+			break;
+		}
+		mBatch->mMode = mode;
+	}
+
+	U32 bit = 1 << mBatchSlot;
+	res = (mBatch->mVisible & bit) ? ((mBatch->mPartial & bit) ? 1 : 2) : 0;
+	return true;
+}
+
 //------------------------------------------
 //agent space group culling
 S32 LLViewerOctreeCull::AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
 {
+	S32 res;
+	if (batchGroupBounds(group, BATCH_AGENT_NO_FAR_CLIP, res))
+	{
+		return res;
+	}
 	return mCamera->AABBInFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
 }
 
@@ -1400,6 +1511,11 @@ S32 LLViewerOctreeCull::AABBSphereIntersectGroupExtents(const LLViewerOctreeGrou
 
 S32 LLViewerOctreeCull::AABBInFrustumGroupBounds(const LLViewerOctreeGroup* group)
 {
+	S32 res;
+	if (batchGroupBounds(group, BATCH_AGENT, res))
+	{
+		return res;
+	}
 	return mCamera->AABBInFrustum(group->mBounds[0], group->mBounds[1]);
 }
 //------------------------------------------
@@ -1426,11 +1542,21 @@ S32 LLViewerOctreeCull::AABBInFrustumObjectBounds(const LLViewerOctreeGroup* gro
 //local regional space group culling
 S32 LLViewerOctreeCull::AABBInRegionFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
 {
+	S32 res;
+	if (batchGroupBounds(group, BATCH_REGION_NO_FAR_CLIP, res))
+	{
+		return res;
+	}
 	return mCamera->AABBInRegionFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
 }
 
 S32 LLViewerOctreeCull::AABBInRegionFrustumGroupBounds(const LLViewerOctreeGroup* group)
 {
+	S32 res;
+	if (batchGroupBounds(group, BATCH_REGION, res))
+	{
+		return res;
+	}
 	return mCamera->AABBInRegionFrustum(group->mBounds[0], group->mBounds[1]);
 }
 
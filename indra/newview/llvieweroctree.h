@@ -50,6 +50,7 @@ typedef LLTreeNode<LLViewerOctreeEntry> TreeNode;
 typedef LLOctreeNode<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeNode;
 typedef LLOctreeRoot<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeRoot;
 typedef LLOctreeTraveler<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeTraveler;
+typedef LLOctreeLinear<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>> OctreeLinear;
 
 #if LL_OCTREE_PARANOIA_CHECK
 #define assert_octree_valid(x) x->validate()
@@ -312,7 +313,11 @@ public:
 	U32  getLastOcclusionIssuedTime();
 
 	//virtual 
+	void handleInsertion(const TreeNode* node, LLViewerOctreeEntry* obj);
+	void handleRemoval(const TreeNode* node, LLViewerOctreeEntry* obj);
+	void handleDestruction(const TreeNode* node);
 	void handleChildAddition(const OctreeNode* parent, OctreeNode* child);
+	void handleChildRemoval(const OctreeNode* parent, const OctreeNode* child);
 
 	//virtual
 	BOOL isRecentlyVisible() const;
@@ -351,10 +356,25 @@ public:
 	virtual S32 cull(LLCamera &camera, bool do_occlusion) = 0;
 	BOOL isOcclusionEnabled();
 
+	// Breadth first snapshot of mOctree for culling.  Rebuilt at most once
+	// per frame, returns NULL if the tree changed after this frame's build.
+	const OctreeLinear* getLinearOctree();
+	void dirtyLinearOctree()	{ mLinearOctreeDirty = true; }
+
+	// Run culler over mOctree, through the linear snapshot when
+	// RenderLinearOctreeCull is set and the snapshot is current
+	template <class CULLER> void cullOctree(CULLER& culler);
+
 protected:
     // MUST call from destructor of any derived classes (SL-17276)
     void cleanup();
 
+	static bool useLinearOctree();
+
+	OctreeLinear     mLinearOctree;
+	bool             mLinearOctreeDirty;
+	U32              mLinearOctreeFrame;	// frame mLinearOctree was last built
+
 public:	
 	U32              mPartitionType;
 	U32              mDrawableType;
@@ -369,11 +389,44 @@ class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
 	LLViewerOctreeCull(LLCamera* camera)
-		: mCamera(camera), mRes(0) { }
+		: mCamera(camera), mRes(0), mBatch(NULL), mBatchSlot(0) { }
 	
 	virtual void traverse(const OctreeNode* n);
 
+	// Same as culler.traverse(partition->mOctree), but walks the partition's
+	// linear snapshot.  CULLER is the concrete culler type, its hooks are
+	// called directly instead of through the vtable.
+	template <class CULLER> static void traverseLinear(CULLER& culler, const OctreeLinear& tree);
+
 protected:
+	template <class CULLER> static void traverseLinearNode(CULLER& culler, const OctreeLinear& tree, U32 index);
+	template <class CULLER> static void traverseLinearChildren(CULLER& culler, const OctreeLinear& tree, const OctreeLinear::Node& node);
+	template <class CULLER> static void visitLinear(CULLER& culler, const OctreeLinear::Node& node, LLViewerOctreeGroup* group);
+
+	// Group bounds frustum results for one set of siblings in the linear
+	// snapshot.  The first group bounds check on any sibling tests all of
+	// them with one LLCamera batch call, later siblings reuse the bits.
+	struct SiblingBatch
+	{
+		enum { MAX_SIBLINGS = 8 };
+
+		const LLViewerOctreeGroup* mGroups[MAX_SIBLINGS];
+		U32 mCount;
+		S32 mMode;		// eBatchMode that filled mVisible and mPartial, -1 if none yet
+		U32 mVisible;
+		U32 mPartial;
+	};
+
+	typedef enum
+	{
+		BATCH_AGENT = 0,
+		BATCH_AGENT_NO_FAR_CLIP,
+		BATCH_REGION,
+		BATCH_REGION_NO_FAR_CLIP
+	} eBatchMode;
+
+	bool batchGroupBounds(const LLViewerOctreeGroup* group, S32 mode, S32& res);
+
 	virtual bool earlyFail(LLViewerOctreeGroup* group);	
 	
 	//agent space group cull
@@ -408,6 +461,8 @@ protected:
 protected:
 	LLCamera *mCamera;
 	S32 mRes;
+	SiblingBatch* mBatch;	// siblings of the node being traversed, NULL outside traverseLinear
+	U32 mBatchSlot;			// index of that node in mBatch
 };
 
 //scan the octree, output the info of each node for debug use.
@@ -421,4 +476,106 @@ public:
 	static BOOL sInDebug;
 };
 
+template <class CULLER>
+void LLViewerOctreePartition::cullOctree(CULLER& culler)
+{
+	const OctreeLinear* linear = useLinearOctree() ? getLinearOctree() : NULL;
+	if (linear)
+	{
+		LLViewerOctreeCull::traverseLinear(culler, *linear);
+	}
+	else
+	{
+		culler.traverse(mOctree);
+	}
+}
+
+template <class CULLER>
+void LLViewerOctreeCull::traverseLinear(CULLER& culler, const OctreeLinear& tree)
+{
+	LL_PROFILE_ZONE_SCOPED;
+	if (!tree.isEmpty())
+	{
+		traverseLinearNode(culler, tree, 0);
+	}
+}
+
+//mirrors traverse(const OctreeNode*), reading child and element counts
+//from the snapshot instead of the octree nodes
+template <class CULLER>
+void LLViewerOctreeCull::traverseLinearNode(CULLER& culler, const OctreeLinear& tree, U32 index)
+{
+	const OctreeLinear::Node& node = tree.getNode(index);
+	LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) node.mListener;
+
+	if (culler.CULLER::earlyFail(group))
+	{
+		return;
+	}
+
+	if (culler.mRes == 2 || 
+		(culler.mRes && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK)))
+	{	//fully in, just add everything
+		visitLinear(culler, node, group);
+		traverseLinearChildren(culler, tree, node);
+	}
+	else
+	{
+		culler.mRes = culler.CULLER::frustumCheck(group);
+				
+		if (culler.mRes)
+		{ //at least partially in, run on down
+			visitLinear(culler, node, group);
+			traverseLinearChildren(culler, tree, node);
+		}
+
+		culler.mRes = 0;
+	}
+}
+
+template <class CULLER>
+void LLViewerOctreeCull::traverseLinearChildren(CULLER& culler, const OctreeLinear& tree, const OctreeLinear::Node& node)
+{
+	if (node.mChildCount == 0)
+	{
+		return;
+	}
+
+	SiblingBatch batch;
+	batch.mCount = llmin(node.mChildCount, (U32) SiblingBatch::MAX_SIBLINGS);
+	batch.mMode = -1;
+	for (U32 i = 0; i < batch.mCount; i++)
+	{
+		batch.mGroups[i] = (const LLViewerOctreeGroup*) tree.getNode(node.mFirstChild + i).mListener;
+	}
+
+	for (U32 i = 0; i < node.mChildCount; i++)
+	{
+		//the child's own children replace mBatch while it is traversed
+		culler.mBatch = &batch;
+		culler.mBatchSlot = i;
+		traverseLinearNode(culler, tree, node.mFirstChild + i);
+	}
+
+	culler.mBatch = NULL;
+}
+
+//same as visit(const OctreeNode*) and checkObjects(), using the counts in the snapshot
+template <class CULLER>
+void LLViewerOctreeCull::visitLinear(CULLER& culler, const OctreeLinear::Node& node, LLViewerOctreeGroup* group)
+{
+	culler.CULLER::preprocess(group);
+
+	if (node.mElementCount == 0) //no elements
+	{
+		return;
+	}
+
+	//leaf nodes were already checked against their tightest bounding box
+	if (node.mChildCount == 0 || culler.mRes != 1 || culler.CULLER::frustumCheckObjects(group))
+	{
+		culler.CULLER::processGroup(group);
+	}
+}
+
 #endif
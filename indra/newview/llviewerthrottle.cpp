@@ -30,6 +30,7 @@
 #include "llviewercontrol.h"
 #include "message.h"
 #include "llagent.h"
+#include "llviewerregion.h"
 #include "llframetimer.h"
 #include "llviewerstats.h"
 #include "lldatapacker.h"
@@ -51,6 +52,7 @@ const F32 STEP_FRACTIONAL = 0.1f;
 const LLUnit<F32, LLUnits::Percent> TIGHTEN_THROTTLE_THRESHOLD(3.0f); // packet loss % per s
 const LLUnit<F32, LLUnits::Percent> EASE_THROTTLE_THRESHOLD(0.5f); // packet loss % per s
 const F32 DYNAMIC_UPDATE_DURATION = 5.0f; // seconds
+const F32 ADAPTIVE_CHANGE_THRESHOLD = 0.05f; // don't resend the throttle for less than a 5% change in any category
 
 LLViewerThrottle gViewerThrottle;
 
@@ -294,6 +296,9 @@ void LLViewerThrottle::resetDynamicThrottle()
 
 	mCurrentBandwidth = mMaxBandwidth*MAX_FRACTIONAL;
 	mCurrent = getThrottleGroup(mCurrentBandwidth / 1024.0f);
+
+	// Restart the adaptive estimate from the new setting
+	mEstimatorHost.invalidate();
 }
 
 void LLViewerThrottle::updateDynamicThrottle()
@@ -304,6 +309,15 @@ void LLViewerThrottle::updateDynamicThrottle()
 	}
 	mUpdateTimer.reset();
 
+	static LLCachedControl<bool> adaptive_throttle(gSavedSettings, "NetworkThrottleAdaptive");
+	LLViewerRegion* regionp = gAgent.getRegion();
+	LLCircuitData* cdp = (adaptive_throttle && regionp) ? gMessageSystem->mCircuitInfo.findCircuit(regionp->getHost()) : NULL;
+	if (cdp)
+	{
+		updateAdaptiveThrottle(cdp->getThrottleEstimator(), regionp->getHost());
+		return;
+	}
+
 	LLUnit<F32, LLUnits::Percent> mean_packets_lost = LLViewerStats::instance().getRecording().getMean(LLStatViewer::PACKETS_LOST_PERCENT);
 	if (mean_packets_lost > TIGHTEN_THROTTLE_THRESHOLD)
 	{
@@ -332,3 +346,44 @@ void LLViewerThrottle::updateDynamicThrottle()
 		LL_INFOS() << "Easing network throttle to " << mCurrentBandwidth << LL_ENDL;
 	}
 }
+
+// Follow the agent region circuit's measured capacity rather than stepping
+// the user's setting up and down on packet loss.  The setting is both the
+// starting point and the most the estimate may probe up to.
+void LLViewerThrottle::updateAdaptiveThrottle(LLThrottleEstimator& estimator, const LLHost& host)
+{
+	if (host != mEstimatorHost)
+	{
+		mEstimatorHost = host;
+		estimator.setLimits(MIN_BANDWIDTH * 1024.f, mMaxBandwidth);
+		estimator.reset(mMaxBandwidth);
+		return;
+	}
+
+	F32 split[TC_EOF];
+	estimator.getThrottleSplit(split);
+
+	BOOL changed = FALSE;
+	S32 i;
+	for (i = 0; i < TC_EOF; i++)
+	{
+		// Throttle groups are in kbps
+		split[i] /= 1024.f;
+		if (fabsf(split[i] - mCurrent.mThrottles[i]) > mCurrent.mThrottles[i] * ADAPTIVE_CHANGE_THRESHOLD + 1.f)
+		{
+			changed = TRUE;
+		}
+	}
+	if (!changed)
+	{
+		return;
+	}
+
+	mCurrent = LLViewerThrottleGroup(split);
+	mCurrentBandwidth = mCurrent.getTotal() * 1024.f;
+	mCurrent.sendToSim();
+	LL_INFOS() << "Adapting network throttle to " << mCurrentBandwidth
+		<< " delivered " << estimator.getDeliveredBPS()
+		<< " loss " << estimator.getLossRate()
+		<< (estimator.isCongested() ? " congested" : "") << LL_ENDL;
+}
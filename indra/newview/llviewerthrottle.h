@@ -32,6 +32,7 @@
 #include "llstring.h"
 #include "llframetimer.h"
 #include "llthrottle.h"
+#include "llhost.h"
 
 class LLViewerThrottleGroup
 {
@@ -69,6 +70,7 @@ public:
 
 	void updateDynamicThrottle();
 	void resetDynamicThrottle();
+	void updateAdaptiveThrottle(LLThrottleEstimator& estimator, const LLHost& host);
 
 	LLViewerThrottleGroup getThrottleGroup(const F32 bandwidth_kbps);
 
@@ -83,6 +85,8 @@ protected:
 	
 	LLFrameTimer mUpdateTimer;
 	F32 mThrottleFrac;
+
+	LLHost mEstimatorHost;	// Circuit whose estimate we're following
 };
 
 extern LLViewerThrottle gViewerThrottle;
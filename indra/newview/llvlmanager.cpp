@@ -35,6 +35,11 @@
 #include "llframetimer.h"
 #include "llsurface.h"
 #include "llbitpack.h"
+#include "llviewercontrol.h"
+#include "llworld.h"
+#include "workqueue.h"
+
+#include <atomic>
 
 const	char	LAND_LAYER_CODE					= 'L';
 const	char	WIND_LAYER_CODE					= '7';
@@ -51,6 +56,37 @@ const	char	AURORA_CLOUD_LAYER_CODE			= ':';
 
 LLVLManager gVLManager;
 
+// A land layer packet decoded on the general thread pool.  The worker only
+// touches the job, the main thread applies it once mDone is set.
+class LLVLDecodeJob
+{
+public:
+	LLVLDecodeJob(const LLVLData *datap, BOOL b_large_patch)
+	:	mRegionHandle(datap->mRegionp->getHandle()),
+		mLargePatch(b_large_patch),
+		mData(datap->mData, datap->mData + datap->mSize),
+		mPatchSize(0),
+		mValid(FALSE),
+		mDone(false)
+	{
+	}
+
+	void decode()
+	{
+		LLBitPack bit_pack(mData.data(), (S32)mData.size());
+		mValid = LLSurface::decodeDCTPatches(bit_pack, mLargePatch, mPatches, mPatchSize);
+		mDone = true;
+	}
+
+	U64 mRegionHandle;
+	BOOL mLargePatch;
+	std::vector<U8> mData;
+	LLSurface::decoded_patch_list_t mPatches;
+	S32 mPatchSize;
+	BOOL mValid;
+	std::atomic<bool> mDone;
+};
+
 LLVLManager::~LLVLManager()
 {
 	S32 i;
@@ -101,12 +137,32 @@ void LLVLManager::addLayerData(LLVLData *vl_datap, const S32Bytes mesg_size)
 void LLVLManager::unpackData(const S32 num_packets)
 {
 	static LLFrameTimer decode_timer;
+	static LLCachedControl<bool> decode_on_worker(gSavedSettings, "TerrainDecodeOnWorker");
 	
 	S32 i;
 	for (i = 0; i < mPacketData.size(); i++)
 	{
 		LLVLData *datap = mPacketData[i];
 
+		if (LAND_LAYER_CODE == datap->mType || AURORA_LAND_LAYER_CODE == datap->mType)
+		{
+			const BOOL b_large_patch = AURORA_LAND_LAYER_CODE == datap->mType;
+			if (decode_on_worker && queueLandDecode(datap, b_large_patch))
+			{
+				continue;
+			}
+			if (!mLandDecodes.empty())
+			{
+				// Decodes of earlier packets are still pending, decode this
+				// one here but apply it after them so that older terrain
+				// never lands on top of newer.
+				std::shared_ptr<LLVLDecodeJob> job = std::make_shared<LLVLDecodeJob>(datap, b_large_patch);
+				job->decode();
+				mLandDecodes.push_back(job);
+				continue;
+			}
+		}
+
 		LLBitPack bit_pack(datap->mData, datap->mSize);
 		LLGroupHeader goph;
 
@@ -146,6 +202,39 @@ void LLVLManager::unpackData(const S32 num_packets)
 	}
 	mPacketData.clear();
 
+	applyLandDecodes();
+}
+
+BOOL LLVLManager::queueLandDecode(LLVLData *datap, BOOL b_large_patch)
+{
+	LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+	if (!general_queue)
+	{
+		return FALSE;
+	}
+
+	std::shared_ptr<LLVLDecodeJob> job = std::make_shared<LLVLDecodeJob>(datap, b_large_patch);
+	if (!general_queue->tryPost([job]() { job->decode(); }))
+	{
+		return FALSE;
+	}
+	mLandDecodes.push_back(job);
+	return TRUE;
+}
+
+void LLVLManager::applyLandDecodes()
+{
+	while (!mLandDecodes.empty() && mLandDecodes.front()->mDone)
+	{
+		std::shared_ptr<LLVLDecodeJob> job = mLandDecodes.front();
+		mLandDecodes.pop_front();
+
+		LLViewerRegion *regionp = LLWorld::getInstance()->getRegionFromHandle(job->mRegionHandle);
+		if (regionp && job->mValid)
+		{
+			regionp->getLand().applyDecodedPatches(job->mPatches, job->mPatchSize);
+		}
+	}
 }
 
 void LLVLManager::resetBitCounts()
@@ -175,6 +264,20 @@ S32Bytes LLVLManager::getTotalBytes() const
 
 void LLVLManager::cleanupData(LLViewerRegion *regionp)
 {
+	// Decodes still running keep their job alive until they finish
+	const U64 handle = regionp->getHandle();
+	for (std::deque<std::shared_ptr<LLVLDecodeJob> >::iterator iter = mLandDecodes.begin(); iter != mLandDecodes.end(); )
+	{
+		if ((*iter)->mRegionHandle == handle)
+		{
+			iter = mLandDecodes.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
 	S32 cur = 0;
 	while (cur < mPacketData.size())
 	{
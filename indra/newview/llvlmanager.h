@@ -31,7 +31,11 @@
 
 #include "stdtypes.h"
 
+#include <deque>
+#include <memory>
+
 class LLVLData;
+class LLVLDecodeJob;
 class LLViewerRegion;
 
 class LLVLManager
@@ -53,8 +57,14 @@ public:
 
 	void cleanupData(LLViewerRegion *regionp);
 protected:
+	// Hands a land layer packet to the general thread pool, FALSE if it
+	// has to be decoded here instead
+	BOOL queueLandDecode(LLVLData *datap, BOOL b_large_patch);
+	// Applies finished land decodes in the order their packets arrived
+	void applyLandDecodes();
 
 	std::vector<LLVLData *> mPacketData;
+	std::deque<std::shared_ptr<LLVLDecodeJob> > mLandDecodes;
 	U32Bits mLandBits;
 	U32Bits mWindBits;
 	U32Bits mCloudBits;
@@ -629,6 +629,8 @@ LLVOCacheGroup::~LLVOCacheGroup()
 //virtual
 void LLVOCacheGroup::handleChildAddition(const OctreeNode* parent, OctreeNode* child)
 {
+	mSpatialPartition->dirtyLinearOctree();
+
 	if (child->getListenerCount() == 0)
 	{
 		new LLVOCacheGroup(child, mSpatialPartition);
@@ -896,7 +898,7 @@ void LLVOCachePartition::selectBackObjects(LLCamera &camera, F32 pixel_threshold
 	LLVector3 region_agent = mRegionp->getOriginAgent();
 	
 	LLVOCacheOctreeBackCull culler(&camera, region_agent, mRegionp, pixel_threshold, use_occlusion);
-	culler.traverse(mOctree);
+	cullOctree(culler);
 
 	mBackSlectionEnabled--;
 	if(!mRegionp->getNumOfVisibleGroups())
@@ -965,7 +967,7 @@ S32 LLVOCachePartition::cull(LLCamera &camera, bool do_occlusion)
 	mFrontCull = TRUE;
 	LLVOCacheOctreeCull culler(&camera, mRegionp, region_agent, do_occlusion && use_object_cache_occlusion, 
 		LLVOCacheEntry::getSquaredPixelThreshold(mFrontCull), this);
-	culler.traverse(mOctree);	
+	cullOctree(culler);
 
 	if(!sNeedsOcclusionCheck)
 	{
@@ -5288,20 +5288,9 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 
             if (rebuild_face_octrees)
 			{
+                // the octree and raycast BVH are rebuilt lazily on first use
                 dst_face.destroyOctree();
-				// <FS:ND> Create a debug log for octree insertions if requested.
-				static LLCachedControl<bool> debugOctree(gSavedSettings,"FSCreateOctreeLog");
-				bool _debugOT( debugOctree );
-				if( _debugOT )
-					nd::octree::debug::gOctreeDebug += 1;
-				// </FS:ND>
-
-                dst_face.createOctree();
-
-				// <FS:ND> Reset octree log
-				if( _debugOT )
-					nd::octree::debug::gOctreeDebug -= 1;
-				// </FS:ND>
+                dst_face.destroyBVH();
 			}
 		}
 	}
@@ -0,0 +1,46 @@
+/**
+ * @file   testrand.h
+ * @brief  Seeded pseudo random values for tests that need repeatable input.
+ *
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Copyright (c) 2022, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_TESTRAND_H)
+#define LL_TESTRAND_H
+
+#include "stdtypes.h"
+
+// Small linear congruential generator.  Unlike ll_rand() it is seeded
+// per instance, so a test sees the same sequence on every run and
+// platform, whatever else has drawn random numbers before it.
+class LLTestRand
+{
+public:
+	LLTestRand(U32 seed = 1): mSeed(seed) {}
+
+	// value in [0, range)
+	U32 rand(U32 range)
+	{
+		return next() % range;
+	}
+
+	// value in [-scale, scale)
+	F32 frand(F32 scale = 1.f)
+	{
+		return ((F32) next() / (F32) (1 << 23) - 1.f) * scale;
+	}
+
+private:
+	// next 24 bit value
+	U32 next()
+	{
+		mSeed = mSeed * 1664525 + 1013904223;
+		return mSeed >> 8;
+	}
+
+	U32 mSeed;
+};
+
+#endif /* ! defined(LL_TESTRAND_H) */
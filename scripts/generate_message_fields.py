@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""\
+@file generate_message_fields.py
+@brief Generates the typed message accessors in message_fields.h/.cpp
+
+$LicenseInfo:firstyear=2022&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2022, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+"""generate_message_fields writes indra/llmessage/message_fields.h and
+message_fields.cpp from message_template.msg.  For each message named on
+the command line, or the default hot messages if none are, it emits an
+LLMessageFields subclass with a typed getter per variable, which reads the
+variable by its block and variable index instead of looking up its name.
+
+Rerun it whenever one of those messages changes in the template; until
+then the accessors for the changed message fall back to the named getters.
+"""
+
+import sys
+import os.path
+
+# Look for indra/lib/python in all possible parent directories, as
+# template_verifier.py does.
+def add_indra_lib_path():
+    root = os.path.realpath(__file__)
+    dir = os.path.dirname(root)
+    if dir not in sys.path:
+        sys.path.insert(0, dir)
+
+    while root != os.path.sep:
+        root = os.path.dirname(root)
+        dir = os.path.join(root, 'indra', 'lib', 'python')
+        if os.path.isdir(dir):
+            if dir not in sys.path:
+                sys.path.insert(0, dir)
+            break
+    else:
+        print("This script is not inside a valid installation.", file=sys.stderr)
+        sys.exit(1)
+
+add_indra_lib_path()
+
+import optparse
+import re
+
+from indra.ipc import llmessage
+
+DEFAULT_MESSAGES = [
+    'ObjectUpdate',
+    'ObjectUpdateCompressed',
+    'ImprovedTerseObjectUpdate',
+    'ChatFromSimulator',
+    ]
+
+# template type -> (EMsgVariableType, C++ type, LLMessageFields getter)
+TYPES = {
+    'U8': ('MVT_U8', 'U8', 'getU8'),
+    'U16': ('MVT_U16', 'U16', 'getU16'),
+    'U32': ('MVT_U32', 'U32', 'getU32'),
+    'U64': ('MVT_U64', 'U64', 'getU64'),
+    'S8': ('MVT_S8', 'S8', 'getS8'),
+    'S16': ('MVT_S16', 'S16', 'getS16'),
+    'S32': ('MVT_S32', 'S32', 'getS32'),
+    'F32': ('MVT_F32', 'F32', 'getF32'),
+    'F64': ('MVT_F64', 'F64', 'getF64'),
+    'LLVector3': ('MVT_LLVector3', 'LLVector3', 'getVector3'),
+    'LLVector3d': ('MVT_LLVector3d', 'LLVector3d', 'getVector3d'),
+    'LLVector4': ('MVT_LLVector4', 'LLVector4', 'getVector4'),
+    'LLQuaternion': ('MVT_LLQuaternion', 'LLQuaternion', 'getQuat'),
+    'LLUUID': ('MVT_LLUUID', 'LLUUID', 'getUUID'),
+    'BOOL': ('MVT_BOOL', 'BOOL', 'getBOOL'),
+    'IPADDR': ('MVT_IP_ADDR', 'U32', 'getIPAddr'),
+    'IPPORT': ('MVT_IP_PORT', 'U16', 'getIPPort'),
+    'Fixed': ('MVT_FIXED', None, None),
+    'Variable': ('MVT_VARIABLE', None, None),
+    # no S64 getters in LLMessageSystem
+    'S64': ('MVT_S64', None, None),
+    }
+
+LICENSE = """\
+ * $LicenseInfo:firstyear=2022&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2022, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+"""
+
+def header(filename, brief):
+    return ("/**\n"
+            " * @file %s\n"
+            " * @brief %s\n"
+            " *\n"
+            " * Generated by scripts/generate_message_fields.py from\n"
+            " * message_template.msg, do not edit.\n"
+            " *\n"
+            "%s"
+            " */\n\n") % (filename, brief, LICENSE)
+
+def constant_name(name):
+    """ObjectUpdateCompressed -> OBJECT_UPDATE_COMPRESSED"""
+    return re.sub(r'(?<=[a-z0-9])(?=[A-Z])', '_', name).upper()
+
+def check_prehash(names, prehash):
+    missing = sorted(name for name in names if name not in prehash)
+    if missing:
+        raise ValueError("not in message_prehash.h: %s" % ", ".join(missing))
+
+def generate_class(message):
+    cls = 'LLMsg' + message.name
+    lines = []
+    lines.append("class %s : public LLMessageFields" % cls)
+    lines.append("{")
+    lines.append("public:")
+    lines.append("\t%s(LLMessageSystem* msg) : LLMessageFields(msg, sLayout) {}" % cls)
+    for block_index, block in enumerate(message.blocks):
+        lines.append("")
+        lines.append("\t// %s, %s" % (block.name, block.repeat))
+        lines.append("\tS32 getNumberOf%sBlocks() const { return getNumberOfBlocks(%d); }"
+                     % (block.name, block_index))
+        for var_index, var in enumerate(block.variables):
+            getter = 'get%s%s' % (block.name, var.name)
+            index = "%d, %d" % (block_index, var_index)
+            if var.type in ('Fixed', 'Variable'):
+                lines.append("\tS32 %sSize(S32 blocknum = 0) const { return getSize(%s, blocknum); }"
+                             % (getter, index))
+                lines.append("\tvoid %s(void* datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX) const"
+                             " { getBinaryData(%s, datap, size, blocknum, max_size); }"
+                             % (getter, index))
+                lines.append("\tvoid %s(S32 buffer_size, char* buffer, S32 blocknum = 0) const"
+                             " { getString(%s, buffer_size, buffer, blocknum); }"
+                             % (getter, index))
+                lines.append("\tvoid %s(std::string& value, S32 blocknum = 0) const"
+                             " { getString(%s, value, blocknum); }"
+                             % (getter, index))
+            elif TYPES[var.type][1]:
+                mvt, cpp_type, base_getter = TYPES[var.type]
+                lines.append("\tvoid %s(%s& value, S32 blocknum = 0) const { %s(%s, value, blocknum); }"
+                             % (getter, cpp_type, base_getter, index))
+    lines.append("")
+    lines.append("private:")
+    lines.append("\tstatic const LLMessageFieldLayout sLayout;")
+    lines.append("};")
+    return "\n".join(lines)
+
+def generate_layout(message):
+    cls = 'LLMsg' + message.name
+    prefix = constant_name(message.name)
+    blocks = []
+    variables = []
+    for block in message.blocks:
+        blocks.append("\t\t{ &_PREHASH_%s, %d, %d }"
+                      % (block.name, len(variables), len(block.variables)))
+        for var in block.variables:
+            size = int(var.size) if var.type in ('Fixed', 'Variable') else 0
+            variables.append("\t\t{ &_PREHASH_%s, %s, %d }"
+                             % (var.name, TYPES[var.type][0], size))
+    lines = []
+    lines.append("\tconst LLMessageFieldLayout::Block %s_BLOCKS[] =" % prefix)
+    lines.append("\t{")
+    lines.append(",\n".join(blocks))
+    lines.append("\t};")
+    lines.append("")
+    lines.append("\tconst LLMessageFieldLayout::Variable %s_VARIABLES[] =" % prefix)
+    lines.append("\t{")
+    lines.append(",\n".join(variables))
+    lines.append("\t};")
+    definition = ("const LLMessageFieldLayout %s::sLayout =\n"
+                  "{\n"
+                  "\t&_PREHASH_%s,\n"
+                  "\t%s_BLOCKS,\n"
+                  "\t%d,\n"
+                  "\t%s_VARIABLES\n"
+                  "};") % (cls, message.name, prefix, len(message.blocks), prefix)
+    return "\n".join(lines), definition
+
+def main():
+    parser = optparse.OptionParser(
+        usage="%prog [options] [MESSAGE ...]",
+        description=__doc__)
+    source = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+    parser.add_option('-t', '--template', dest='template',
+                      default=os.path.join(source, 'scripts', 'messages', 'message_template.msg'),
+                      help="message template to read [default: %default]")
+    parser.add_option('-o', '--output', dest='output',
+                      default=os.path.join(source, 'indra', 'llmessage'),
+                      help="directory to write message_fields.h/.cpp to [default: %default]")
+    options, args = parser.parse_args()
+    names = args or DEFAULT_MESSAGES
+
+    with open(options.template) as f:
+        template = llmessage.parseTemplateFile(f)
+    with open(os.path.join(options.output, 'message_prehash.h')) as f:
+        prehash = set(re.findall(r'_PREHASH_(\w+);', f.read()))
+
+    messages = []
+    for name in names:
+        if name not in template.messages:
+            print("No message %s in %s" % (name, options.template), file=sys.stderr)
+            return 1
+        message = template.messages[name]
+        used = [message.name]
+        for block in message.blocks:
+            used.append(block.name)
+            used.extend(var.name for var in block.variables)
+        check_prehash(used, prehash)
+        messages.append(message)
+
+    with open(os.path.join(options.output, 'message_fields.h'), 'w') as f:
+        f.write(header('message_fields.h', 'Typed accessors for template messages'))
+        f.write("#ifndef LL_MESSAGE_FIELDS_H\n#define LL_MESSAGE_FIELDS_H\n\n")
+        f.write('#include "llmessagefields.h"\n\n')
+        f.write("\n\n".join(generate_class(message) for message in messages))
+        f.write("\n\n#endif // LL_MESSAGE_FIELDS_H\n")
+
+    layouts = [generate_layout(message) for message in messages]
+    with open(os.path.join(options.output, 'message_fields.cpp'), 'w') as f:
+        f.write(header('message_fields.cpp', 'Typed accessors for template messages'))
+        f.write('#include "linden_common.h"\n\n')
+        f.write('#include "message_fields.h"\n\n')
+        f.write('#include "message_prehash.h"\n\n')
+        f.write("namespace\n{\n")
+        f.write("\n\n".join(blocks for blocks, definition in layouts))
+        f.write("\n}\n\n")
+        f.write("\n\n".join(definition for blocks, definition in layouts))
+        f.write("\n")
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())